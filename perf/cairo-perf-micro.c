@@ -565,6 +565,7 @@ const cairo_perf_case_t perf_cases[] = {
     { FUNC(tessellate), 100, 100},
     { FUNC(subimage_copy), 16, 512},
     { FUNC(hash_table), 16, 16},
+    { FUNC(scaled_font_map), 16, 16},
     { FUNC(pattern_create_radial), 16, 16},
     { FUNC(zrusin), 415, 415},
     { FUNC(world_map), 800, 800},
@@ -589,6 +590,8 @@ const cairo_perf_case_t perf_cases[] = {
     { FUNC(spiral), 512, 512 },
     { FUNC(wave), 500, 500 },
     { FUNC(fill_clip), 16, 512 },
+    { FUNC(antialias), 64, 512 },
+    { FUNC(hairline), 64, 512 },
     { FUNC(tiger), 16, 1024 },
     { NULL }
 };
@@ -215,6 +215,7 @@ CAIRO_PERF_DECL (tessellate);
 CAIRO_PERF_DECL (text);
 CAIRO_PERF_DECL (glyphs);
 CAIRO_PERF_DECL (hash_table);
+CAIRO_PERF_DECL (scaled_font_map);
 CAIRO_PERF_DECL (pattern_create_radial);
 CAIRO_PERF_DECL (zrusin);
 CAIRO_PERF_DECL (world_map);
@@ -245,6 +246,8 @@ CAIRO_PERF_DECL (pixel);
 CAIRO_PERF_DECL (a1_pixel);
 CAIRO_PERF_DECL (sierpinski);
 CAIRO_PERF_DECL (fill_clip);
+CAIRO_PERF_DECL (antialias);
+CAIRO_PERF_DECL (hairline);
 CAIRO_PERF_DECL (tiger);
 
 #endif
@@ -0,0 +1,162 @@
+/*
+ * Copyright © 2026 the cairo authors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Compares the cost of filling with the sampling scan converter used
+ * for the default antialiasing against the exact-area converter used
+ * for GOOD and BEST, on the shapes where their costs differ most:
+ * smooth curves, long thin slivers and paths with many crossings.
+ */
+
+#include "cairo-perf.h"
+
+static uint32_t state;
+
+static double
+uniform_random (double minval, double maxval)
+{
+    static uint32_t const poly = 0x9a795537U;
+    uint32_t n = 32;
+    while (n-->0)
+	state = 2*state < state ? (2*state ^ poly) : 2*state;
+    return minval + state * (maxval - minval) / 4294967296.0;
+}
+
+static cairo_time_t
+do_antialias_curves (cairo_t *cr, int width, int height, int loops)
+{
+    state = 0xc0ffee;
+    cairo_perf_timer_start ();
+
+    while (loops--) {
+	double xm = uniform_random (0, width);
+	double ym = uniform_random (0, height);
+
+	cairo_move_to (cr, xm, ym);
+	cairo_curve_to (cr,
+			uniform_random (0, width), uniform_random (0, height),
+			uniform_random (0, width), uniform_random (0, height),
+			uniform_random (0, width), uniform_random (0, height));
+	cairo_curve_to (cr,
+			uniform_random (0, width), uniform_random (0, height),
+			uniform_random (0, width), uniform_random (0, height),
+			xm, ym);
+	cairo_close_path (cr);
+
+	cairo_fill (cr);
+    }
+
+    cairo_perf_timer_stop ();
+
+    return cairo_perf_timer_elapsed ();
+}
+
+static cairo_time_t
+do_antialias_slivers (cairo_t *cr, int width, int height, int loops)
+{
+    int count;
+
+    state = 0xc0ffee;
+    for (count = 0; count < 200; count++) {
+	double x = uniform_random (0, width);
+	double y = uniform_random (0, height);
+
+	cairo_move_to (cr, x, y);
+	cairo_line_to (cr, uniform_random (0, width), uniform_random (0, height));
+	cairo_line_to (cr, x + uniform_random (-1, 1), y + uniform_random (-1, 1));
+	cairo_close_path (cr);
+    }
+
+    cairo_perf_timer_start ();
+
+    while (loops--)
+	cairo_fill_preserve (cr);
+
+    cairo_perf_timer_stop ();
+
+    cairo_new_path (cr);
+
+    return cairo_perf_timer_elapsed ();
+}
+
+static cairo_time_t
+do_antialias_star (cairo_t *cr, int width, int height, int loops)
+{
+    int n;
+
+    /* A {97/48} star polygon: every pixel row it covers is crossed
+     * by dozens of edges that intersect within the row. */
+    for (n = 0; n < 97; n++) {
+	double theta = 2 * M_PI * n * 48 / 97;
+	cairo_line_to (cr,
+		       width / 2. * (1 + .95 * sin (theta)),
+		       height / 2. * (1 - .95 * cos (theta)));
+    }
+    cairo_close_path (cr);
+
+    cairo_perf_timer_start ();
+
+    while (loops--)
+	cairo_fill_preserve (cr);
+
+    cairo_perf_timer_stop ();
+
+    cairo_new_path (cr);
+
+    return cairo_perf_timer_elapsed ();
+}
+
+cairo_bool_t
+antialias_enabled (cairo_perf_t *perf)
+{
+    return cairo_perf_can_run (perf, "antialias", NULL);
+}
+
+void
+antialias (cairo_perf_t *perf, cairo_t *cr, int width, int height)
+{
+    static const struct {
+	const char *name;
+	cairo_antialias_t antialias;
+    } modes[] = {
+	{ "default", CAIRO_ANTIALIAS_DEFAULT },
+	{ "good", CAIRO_ANTIALIAS_GOOD },
+	{ "best", CAIRO_ANTIALIAS_BEST },
+    };
+    char name[64];
+    unsigned int i;
+
+    cairo_set_source_rgb (cr, 1., 1., 1.);
+
+    for (i = 0; i < ARRAY_LENGTH (modes); i++) {
+	cairo_set_antialias (cr, modes[i].antialias);
+
+	snprintf (name, sizeof (name), "antialias-%s-curves", modes[i].name);
+	cairo_perf_run (perf, name, do_antialias_curves, NULL);
+
+	snprintf (name, sizeof (name), "antialias-%s-slivers", modes[i].name);
+	cairo_perf_run (perf, name, do_antialias_slivers, NULL);
+
+	snprintf (name, sizeof (name), "antialias-%s-star", modes[i].name);
+	cairo_perf_run (perf, name, do_antialias_star, NULL);
+    }
+}
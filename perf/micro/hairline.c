@@ -0,0 +1,118 @@
+/*
+ * Copyright © 2026 the cairo authors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Compares stroking a dense one pixel wide polyline, such as a plot
+ * of a noisy signal, with CAIRO_ANTIALIAS_FAST, which sweeps the
+ * segments straight into spans, against the other modes, which build
+ * the stroke polygon first and scan convert that.
+ */
+
+#include "cairo-perf.h"
+
+static uint32_t state;
+
+static double
+uniform_random (double minval, double maxval)
+{
+    static uint32_t const poly = 0x9a795537U;
+    uint32_t n = 32;
+    while (n-->0)
+	state = 2*state < state ? (2*state ^ poly) : 2*state;
+    return minval + state * (maxval - minval) / 4294967296.0;
+}
+
+static void
+do_hairline_polyline (cairo_t *cr, int width, int height, int step)
+{
+    int x;
+
+    state = 0xc0ffee;
+    cairo_move_to (cr, 0, uniform_random (.1, .9) * height);
+    for (x = step; x <= width; x += step)
+	cairo_line_to (cr, x, uniform_random (.1, .9) * height);
+}
+
+static cairo_time_t
+do_hairline_stroke (cairo_t *cr, int width, int height, int loops, int step)
+{
+    do_hairline_polyline (cr, width, height, step);
+
+    cairo_perf_timer_start ();
+
+    while (loops--)
+	cairo_stroke_preserve (cr);
+
+    cairo_perf_timer_stop ();
+
+    cairo_new_path (cr);
+
+    return cairo_perf_timer_elapsed ();
+}
+
+/* One sample every other pixel. */
+static cairo_time_t
+do_hairline_sparse (cairo_t *cr, int width, int height, int loops)
+{
+    return do_hairline_stroke (cr, width, height, loops, 2);
+}
+
+/* One sample per pixel. */
+static cairo_time_t
+do_hairline_dense (cairo_t *cr, int width, int height, int loops)
+{
+    return do_hairline_stroke (cr, width, height, loops, 1);
+}
+
+cairo_bool_t
+hairline_enabled (cairo_perf_t *perf)
+{
+    return cairo_perf_can_run (perf, "hairline", NULL);
+}
+
+void
+hairline (cairo_perf_t *perf, cairo_t *cr, int width, int height)
+{
+    static const struct {
+	const char *name;
+	cairo_antialias_t antialias;
+    } modes[] = {
+	{ "fast", CAIRO_ANTIALIAS_FAST },
+	{ "default", CAIRO_ANTIALIAS_DEFAULT },
+	{ "best", CAIRO_ANTIALIAS_BEST },
+    };
+    char name[64];
+    unsigned int i;
+
+    cairo_set_source_rgb (cr, 1., 1., 1.);
+    cairo_set_line_width (cr, 1.);
+
+    for (i = 0; i < ARRAY_LENGTH (modes); i++) {
+	cairo_set_antialias (cr, modes[i].antialias);
+
+	snprintf (name, sizeof (name), "hairline-%s-sparse", modes[i].name);
+	cairo_perf_run (perf, name, do_hairline_sparse, NULL);
+
+	snprintf (name, sizeof (name), "hairline-%s-dense", modes[i].name);
+	cairo_perf_run (perf, name, do_hairline_dense, NULL);
+    }
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright © 2026 the cairo authors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "cairo-perf.h"
+
+#if CAIRO_HAS_REAL_PTHREAD
+#include <pthread.h>
+#endif
+
+/*
+ * Measures how cairo_scaled_font_create() scales when several threads
+ * look up the same set of (live) scaled fonts at once, as happens when
+ * many threads render text.  The total amount of work is fixed, so with
+ * perfect scaling the time halves each time the thread count doubles.
+ */
+
+#define ITER 20000
+#define NUM_FONTS 16
+#define MAX_THREADS 8
+
+typedef struct {
+    cairo_font_face_t *font_face;
+    cairo_font_options_t *options;
+    cairo_matrix_t font_matrix[NUM_FONTS];
+    cairo_matrix_t ctm;
+    int iterations;
+} lookup_closure_t;
+
+static void *
+lookup_fonts (void *arg)
+{
+    const lookup_closure_t *closure = arg;
+    int i;
+
+    for (i = 0; i < closure->iterations; i++) {
+	cairo_scaled_font_t *scaled_font;
+
+	scaled_font = cairo_scaled_font_create (closure->font_face,
+						&closure->font_matrix[i % NUM_FONTS],
+						&closure->ctm,
+						closure->options);
+	cairo_scaled_font_destroy (scaled_font);
+    }
+
+    return NULL;
+}
+
+static cairo_time_t
+do_scaled_font_map (cairo_t *cr, int num_threads, int loops)
+{
+#if CAIRO_HAS_REAL_PTHREAD
+    pthread_t threads[MAX_THREADS];
+#endif
+    cairo_scaled_font_t *live[NUM_FONTS];
+    lookup_closure_t closure;
+    int i;
+
+    closure.font_face = cairo_get_font_face (cr);
+    closure.options = cairo_font_options_create ();
+    cairo_matrix_init_identity (&closure.ctm);
+    closure.iterations = ITER / num_threads;
+
+    /* Keep every font referenced so the lookups all hit. */
+    for (i = 0; i < NUM_FONTS; i++) {
+	cairo_matrix_init_scale (&closure.font_matrix[i], 8 + i, 8 + i);
+	live[i] = cairo_scaled_font_create (closure.font_face,
+					    &closure.font_matrix[i],
+					    &closure.ctm,
+					    closure.options);
+    }
+
+    cairo_perf_timer_start ();
+
+    while (loops--) {
+#if CAIRO_HAS_REAL_PTHREAD
+	for (i = 1; i < num_threads; i++)
+	    pthread_create (&threads[i], NULL, lookup_fonts, &closure);
+	lookup_fonts (&closure);
+	for (i = 1; i < num_threads; i++)
+	    pthread_join (threads[i], NULL);
+#else
+	for (i = 0; i < num_threads; i++)
+	    lookup_fonts (&closure);
+#endif
+    }
+
+    cairo_perf_timer_stop ();
+
+    for (i = 0; i < NUM_FONTS; i++)
+	cairo_scaled_font_destroy (live[i]);
+    cairo_font_options_destroy (closure.options);
+
+    return cairo_perf_timer_elapsed ();
+}
+
+#define DECL_THREADS(n) \
+static cairo_time_t \
+do_scaled_font_map_##n (cairo_t *cr, int width, int height, int loops) \
+{ \
+    return do_scaled_font_map (cr, n, loops); \
+}
+DECL_THREADS(1)
+DECL_THREADS(2)
+DECL_THREADS(4)
+DECL_THREADS(8)
+
+cairo_bool_t
+scaled_font_map_enabled (cairo_perf_t *perf)
+{
+    return cairo_perf_can_run (perf, "scaled-font-map", NULL);
+}
+
+void
+scaled_font_map (cairo_perf_t *perf, cairo_t *cr, int width, int height)
+{
+    cairo_perf_run (perf, "scaled-font-map-1", do_scaled_font_map_1, NULL);
+    cairo_perf_run (perf, "scaled-font-map-2", do_scaled_font_map_2, NULL);
+    cairo_perf_run (perf, "scaled-font-map-4", do_scaled_font_map_4, NULL);
+    cairo_perf_run (perf, "scaled-font-map-8", do_scaled_font_map_8, NULL);
+}
@@ -0,0 +1,1129 @@
+/* -*- Mode: c; tab-width: 8; c-basic-offset: 4; indent-tabs-mode: t; -*- */
+/* cairo - a vector graphics library with display and print output
+ *
+ * Copyright © 2026 the cairo authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ *
+ * The Initial Developer of the Original Code is the cairo authors.
+ */
+
+/* An exact-area scan converter.
+ *
+ * Rather than sampling the polygon on a grid of subpixel rows like
+ * tor, each pixel row is swept from top to bottom, keeping the edges
+ * crossing it in a list ordered by x.  The list only changes where an
+ * edge starts or stops, or where two neighbours cross (as in
+ * Bentley-Ottmann, within the row), so only the edges around such an
+ * event are revisited.  Between events the edges are straight and
+ * keep their order, and the fill rule decides whether each one bounds
+ * the filled area; the area to the right of each edge, for as long
+ * as its role is unchanged, is swept into an accumulator holding the
+ * change in coverage from one pixel to the next (as in stb_truetype
+ * or font-rs), and a running sum over the row yields the coverage of
+ * each pixel.  Applying the fill rule between events keeps the result
+ * exact for overlapping and self-intersecting polygons as well.
+ */
+
+#include "cairoint.h"
+#include "cairo-spans-private.h"
+#include "cairo-error-private.h"
+#include "cairo-combsort-inline.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+/* After this many crossings within a row, the rest of the row is
+ * only split into slices of SLICE_HEIGHT, within which the edges are
+ * ordered as at the middle of the slice and crossings are ignored.
+ * Each crossing costs a few heap operations, so the limit is only
+ * reached by pathological polygons; it bounds their work while the
+ * slices remain finer than tor's grid. */
+#define MAX_ROW_CROSSINGS 1024
+#define SLICE_HEIGHT (1. / 64)
+
+/* Coverage slots are grouped into chunks of this many, so that runs
+ * of untouched slots can be skipped when blitting. */
+#define CHUNK_BITS 5
+#define CHUNK_SIZE (1 << CHUNK_BITS)
+
+struct edge {
+    struct edge *next;
+
+    /* The vertical extent of the edge, clipped to the converter. */
+    double ytop, ybot;
+
+    /* The x coordinate at ytop, and its change per unit of y. */
+    double xtop, dxdy;
+
+    int dir;
+
+    /* The neighbours of the edge in the current row, and the winding
+     * number to its left. */
+    struct edge *left, *right;
+    cairo_bool_t in_row;
+    int winding;
+
+    /* Where the edge crosses its right neighbour, and its position in
+     * the queue of crossings (0 if it is not queued). */
+    double ycross;
+    int queued;
+
+    /* Whether the edge currently bounds the filled area on its left
+     * (+1) or on its right (-1), and since when within the row. */
+    int role;
+    double yrole;
+};
+
+/* An edge with its x coordinate, for sorting the row's list. */
+struct intercept {
+    struct edge *edge;
+    double x;
+};
+
+struct analytic_scan_converter {
+    int num_edges;
+    struct edge *edges;
+
+    /* Edges starting in each pixel row. */
+    struct edge **y_buckets;
+    struct edge *y_buckets_embedded[64];
+
+    /* Edges crossing the current row, ordered by x at its top. */
+    struct edge **active;
+    struct edge **pending;
+    struct edge **merged;
+    int num_active;
+
+    /* The list of the edges at the current position within the row,
+     * and the edges starting and stopping within it, by y. */
+    struct edge *head;
+    struct edge **starts;
+    struct edge **stops;
+    struct edge **roots;
+    struct intercept *intercepts;
+    int num_intercepts;
+
+    /* The edges that cross their right neighbour within the row,
+     * as a binary heap ordered by ycross, from index 1. */
+    struct edge **crossings;
+    int num_crossings;
+    cairo_bool_t slicing;
+
+    /* The change in coverage from the previous pixel for each pixel
+     * of the row.  Slot 0 collects everything left of the clip, and
+     * slot x - xmin + 1 holds pixel x.  Only the slots in [lo, hi]
+     * within the marked chunks have been touched. */
+    float *cover;
+    uint8_t *chunks;
+    int lo, hi;
+
+    cairo_half_open_span_t *spans;
+    cairo_half_open_span_t spans_embedded[64];
+
+    /* Clip box. */
+    int xmin, xmax;
+    int ymin, ymax;
+};
+
+static inline double
+edge_x (const struct edge *e, double y)
+{
+    return e->xtop + (y - e->ytop) * e->dxdy;
+}
+
+static inline int
+edge_compare_x (const struct edge *a, const struct edge *b)
+{
+    if (a->xtop < b->xtop)
+	return -1;
+    return a->xtop > b->xtop;
+}
+
+CAIRO_COMBSORT_DECLARE (_edge_sort, struct edge *, edge_compare_x)
+
+static inline int
+edge_compare_ytop (const struct edge *a, const struct edge *b)
+{
+    if (a->ytop < b->ytop)
+	return -1;
+    return a->ytop > b->ytop;
+}
+
+CAIRO_COMBSORT_DECLARE (_edge_sort_by_ytop, struct edge *, edge_compare_ytop)
+
+static inline int
+edge_compare_ybot (const struct edge *a, const struct edge *b)
+{
+    if (a->ybot < b->ybot)
+	return -1;
+    return a->ybot > b->ybot;
+}
+
+CAIRO_COMBSORT_DECLARE (_edge_sort_by_ybot, struct edge *, edge_compare_ybot)
+
+/* Orders edges by x, and coincident ones by where they go next.  The
+ * list is ordered from the previous row, so this is usually linear. */
+static void
+intercepts_sort (struct intercept *ic, int n)
+{
+    int i, j;
+
+    for (i = 1; i < n; i++) {
+	struct intercept t = ic[i];
+
+	for (j = i;
+	     j > 0 && (ic[j-1].x > t.x ||
+		       (ic[j-1].x == t.x && ic[j-1].edge->dxdy > t.edge->dxdy));
+	     j--)
+	{
+	    ic[j] = ic[j-1];
+	}
+	ic[j] = t;
+    }
+}
+
+static inline int
+intercept_compare_x (struct intercept a, struct intercept b)
+{
+    if (a.x < b.x)
+	return -1;
+    return a.x > b.x;
+}
+
+CAIRO_COMBSORT_DECLARE (_intercept_sort, struct intercept, intercept_compare_x)
+
+inline static void
+row_add (struct analytic_scan_converter *c, int x, double v)
+{
+    int i;
+
+    if (x >= c->xmax - c->xmin)
+	return;
+
+    i = x < 0 ? 0 : x + 1;
+    c->cover[i] += v;
+    c->chunks[i >> CHUNK_BITS] = 1;
+    if (i < c->lo)
+	c->lo = i;
+    if (i > c->hi)
+	c->hi = i;
+}
+
+/* Adds v to the pixels in [x1, x2). */
+static void
+row_add_run (struct analytic_scan_converter *c, int x1, int x2, double v)
+{
+    int width = c->xmax - c->xmin;
+
+    if (x1 < 0) {
+	row_add (c, -1, (MIN (x2, 0) - x1) * v);
+	x1 = 0;
+    }
+    if (x2 > width)
+	x2 = width;
+    if (x1 >= x2)
+	return;
+
+    if (x1 + 1 < c->lo)
+	c->lo = x1 + 1;
+    if (x2 > c->hi)
+	c->hi = x2;
+    memset (c->chunks + ((x1 + 1) >> CHUNK_BITS), 1,
+	    (x2 >> CHUNK_BITS) - ((x1 + 1) >> CHUNK_BITS) + 1);
+    for (; x1 < x2; x1++)
+	c->cover[x1 + 1] += v;
+}
+
+/* Sweeps the area to the right of the segment from x0 to x1, spanning
+ * the signed height d within the current row, into the accumulator. */
+static void
+row_add_segment (struct analytic_scan_converter *c,
+		 double x0, double x1, double d)
+{
+    double xl, xr;
+    int il, ir;
+
+    x0 -= c->xmin;
+    x1 -= c->xmin;
+    if (x0 < x1) {
+	xl = x0;
+	xr = x1;
+    } else {
+	xl = x1;
+	xr = x0;
+    }
+
+    il = floor (xl);
+    ir = ceil (xr);
+    if (ir <= il + 1) {
+	/* Within a single pixel, the covered fraction of which depends
+	 * only on the midpoint of the segment. */
+	double xm = .5 * (x0 + x1) - il;
+
+	row_add (c, il, d - d * xm);
+	row_add (c, il + 1, d * xm);
+    } else {
+	double s = 1. / (xr - xl);
+	double fl = xl - il;
+	double fr = xr - ir + 1;
+	double al = .5 * s * (1 - fl) * (1 - fl);
+	double ar = .5 * s * fr * fr;
+
+	row_add (c, il, d * al);
+	if (ir == il + 2) {
+	    row_add (c, il + 1, d * (1 - al - ar));
+	} else {
+	    double a1 = s * (1.5 - fl);
+
+	    row_add (c, il + 1, d * (a1 - al));
+	    row_add_run (c, il + 2, ir - 1, d * s);
+	    row_add (c, ir - 1, d * (1 - a1 - (ir - il - 3) * s - ar));
+	}
+	row_add (c, ir, d * ar);
+    }
+}
+
+/* Sweeps the part of the edge between y1 and y2 with its current
+ * role. */
+static void
+edge_flush (struct analytic_scan_converter *c,
+	    const struct edge *e,
+	    double y1, double y2)
+{
+    if (y2 > y1)
+	row_add_segment (c, edge_x (e, y1), edge_x (e, y2), e->role * (y2 - y1));
+}
+
+/* Updates the role of the edge from its winding number, flushing the
+ * part swept with its previous role up to y. */
+static void
+edge_set_role (struct analytic_scan_converter *c,
+	       struct edge *e,
+	       unsigned int mask,
+	       double y)
+{
+    int inside = (e->winding & mask) != 0;
+    int role = 0;
+
+    if (inside != (((e->winding + e->dir) & mask) != 0))
+	role = inside ? -1 : 1;
+
+    if (role != e->role) {
+	if (e->role)
+	    edge_flush (c, e, e->yrole, y);
+	e->role = role;
+	e->yrole = y;
+    }
+}
+
+/* Moves the edge to index i of the crossings heap, up or down as
+ * needed to keep it ordered. */
+static void
+crossings_place (struct analytic_scan_converter *c, struct edge *e, int i)
+{
+    struct edge **heap = c->crossings;
+    int parent, child;
+
+    while (i > 1 && heap[parent = i >> 1]->ycross > e->ycross) {
+	heap[i] = heap[parent];
+	heap[i]->queued = i;
+	i = parent;
+    }
+
+    while ((child = 2 * i) <= c->num_crossings) {
+	if (child < c->num_crossings &&
+	    heap[child + 1]->ycross < heap[child]->ycross)
+	{
+	    child++;
+	}
+	if (heap[child]->ycross >= e->ycross)
+	    break;
+
+	heap[i] = heap[child];
+	heap[i]->queued = i;
+	i = child;
+    }
+
+    heap[i] = e;
+    e->queued = i;
+}
+
+static void
+crossings_remove (struct analytic_scan_converter *c, struct edge *e)
+{
+    struct edge *last = c->crossings[c->num_crossings--];
+    int i = e->queued;
+
+    e->queued = 0;
+    if (last != e)
+	crossings_place (c, last, i);
+}
+
+/* Queues where the edge crosses its right neighbour, if it does so
+ * before either stops or the row ends. */
+static void
+edge_schedule_crossing (struct analytic_scan_converter *c,
+			struct edge *l,
+			double y, double y1)
+{
+    struct edge *r = l->right;
+    double yc;
+
+    if (l->queued)
+	crossings_remove (c, l);
+
+    if (c->slicing || r == NULL || l->dxdy <= r->dxdy)
+	return;
+
+    yc = y + (edge_x (r, y) - edge_x (l, y)) / (l->dxdy - r->dxdy);
+    if (yc < y)
+	yc = y;
+    if (yc >= y1 || yc >= l->ybot || yc >= r->ybot)
+	return;
+
+    l->ycross = yc;
+    crossings_place (c, l, ++c->num_crossings);
+}
+
+/* Links the sorted intercepts into the row's list, and assigns their
+ * winding numbers and roles from y. */
+static void
+row_link (struct analytic_scan_converter *c,
+	  int n,
+	  unsigned int mask,
+	  double y)
+{
+    struct intercept *ic = c->intercepts;
+    struct edge *left = NULL;
+    int winding = 0;
+    int i;
+
+    c->num_intercepts = n;
+    c->head = n ? ic[0].edge : NULL;
+    for (i = 0; i < n; i++) {
+	struct edge *e = ic[i].edge;
+
+	e->left = left;
+	e->right = i + 1 < n ? ic[i+1].edge : NULL;
+	e->in_row = TRUE;
+	e->winding = winding;
+	edge_set_role (c, e, mask, y);
+
+	winding += e->dir;
+	left = e;
+    }
+}
+
+/* Reorders the row's list as at the middle of the slice from y to b,
+ * ignoring where the edges cross within it. */
+static void
+row_slice (struct analytic_scan_converter *c,
+	   unsigned int mask,
+	   double y, double b)
+{
+    struct intercept *ic = c->intercepts;
+    double ym = .5 * (y + b);
+    struct edge *e;
+    int n = 0;
+
+    for (e = c->head; e; e = e->right) {
+	ic[n].edge = e;
+	ic[n].x = edge_x (e, ym);
+	n++;
+    }
+    if (n > 1)
+	_intercept_sort (ic, n);
+
+    row_link (c, n, mask, y);
+}
+
+static inline cairo_bool_t
+edge_is_left_of (const struct edge *a, const struct edge *e, double y)
+{
+    double x = edge_x (a, y);
+
+    return x < e->xtop || (x == e->xtop && a->dxdy <= e->dxdy);
+}
+
+/* Finds an edge of the list near where one starting at y belongs,
+ * by bisecting the intercepts it was last linked from.  Those are only
+ * roughly in order by now, which is enough for a starting point. */
+static struct edge *
+row_find (struct analytic_scan_converter *c, struct edge *e, double y)
+{
+    const struct intercept *ic = c->intercepts;
+    int lo = 0, hi = c->num_intercepts, i;
+
+    while (lo < hi) {
+	int mid = (lo + hi) / 2;
+
+	if (edge_is_left_of (ic[mid].edge, e, y))
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+
+    for (i = lo; i > 0; i--) {
+	if (ic[i-1].edge->in_row)
+	    return ic[i-1].edge;
+    }
+    return NULL;
+}
+
+/* Inserts an edge starting at y into the row's list, searching from
+ * its rough position. */
+static void
+row_insert (struct analytic_scan_converter *c, struct edge *e, double y)
+{
+    struct edge *l = row_find (c, e, y), *r;
+
+    if (l != NULL && ! edge_is_left_of (l, e, y)) {
+	do
+	    l = l->left;
+	while (l != NULL && ! edge_is_left_of (l, e, y));
+    } else {
+	r = l ? l->right : c->head;
+	while (r != NULL && edge_is_left_of (r, e, y)) {
+	    l = r;
+	    r = r->right;
+	}
+    }
+
+    r = l ? l->right : c->head;
+    e->left = l;
+    e->right = r;
+    if (l)
+	l->right = e;
+    else
+	c->head = e;
+    if (r)
+	r->left = e;
+
+    e->in_row = TRUE;
+    e->winding = INT_MIN;
+}
+
+static void
+row_remove (struct analytic_scan_converter *c, struct edge *e)
+{
+    if (e->left)
+	e->left->right = e->right;
+    else
+	c->head = e->right;
+    if (e->right)
+	e->right->left = e->left;
+    if (e->queued)
+	crossings_remove (c, e);
+    e->in_row = FALSE;
+}
+
+/* Brings the winding numbers right of a change in the list up to
+ * date, stopping as soon as they agree with the old ones.  Edges
+ * inserted next to each other have no winding number yet, so start
+ * from the first of them. */
+static void
+row_propagate (struct analytic_scan_converter *c,
+	       struct edge *e,
+	       unsigned int mask,
+	       double y)
+{
+    while (e->left && e->left->winding == INT_MIN)
+	e = e->left;
+
+    for (; e; e = e->right) {
+	int winding = e->left ? e->left->winding + e->left->dir : 0;
+
+	if (winding == e->winding)
+	    break;
+
+	e->winding = winding;
+	edge_set_role (c, e, mask, y);
+    }
+}
+
+/* Swaps the edge with its right neighbour where they cross. */
+static void
+row_cross (struct analytic_scan_converter *c,
+	   struct edge *l,
+	   unsigned int mask,
+	   double y, double y1)
+{
+    struct edge *r = l->right;
+    struct edge *prev = l->left;
+    struct edge *next = r->right;
+
+    r->left = prev;
+    r->right = l;
+    l->left = r;
+    l->right = next;
+    if (prev)
+	prev->right = r;
+    else
+	c->head = r;
+    if (next)
+	next->left = l;
+
+    r->winding = l->winding;
+    l->winding = r->winding + r->dir;
+    edge_set_role (c, r, mask, y);
+    edge_set_role (c, l, mask, y);
+
+    if (prev)
+	edge_schedule_crossing (c, prev, y, y1);
+    edge_schedule_crossing (c, r, y, y1);
+    edge_schedule_crossing (c, l, y, y1);
+}
+
+/* Accumulates the coverage of the pixel row starting at y0.  Returns
+ * TRUE if the following rows are identical for as long as no edges
+ * start or stop. */
+static cairo_bool_t
+render_row (struct analytic_scan_converter *c,
+	    unsigned int mask,
+	    double y0)
+{
+    struct intercept *ic = c->intercepts;
+    struct edge **starts = c->pending;
+    struct edge **stops = c->merged;
+    struct edge **roots = c->roots;
+    double y1 = y0 + 1, yslice = y1;
+    cairo_bool_t is_vertical = TRUE;
+    int num_starts = 0, num_stops = 0, num_row_crossings = 0;
+    int i, j, n;
+    struct edge *e;
+
+    n = 0;
+    for (i = 0; i < c->num_active; i++) {
+	e = c->active[i];
+
+	e->role = 0;
+	if (e->ytop > y0) {
+	    starts[num_starts++] = e;
+	} else {
+	    ic[n].edge = e;
+	    ic[n].x = edge_x (e, y0);
+	    n++;
+	}
+	if (e->ybot < y1)
+	    stops[num_stops++] = e;
+	is_vertical &= e->dxdy == 0;
+    }
+
+    if (num_starts > 1)
+	_edge_sort_by_ytop (starts, num_starts);
+    if (num_stops > 1)
+	_edge_sort_by_ybot (stops, num_stops);
+
+    intercepts_sort (ic, n);
+    c->slicing = FALSE;
+    row_link (c, n, mask, y0);
+    for (e = c->head; e && e->right; e = e->right)
+	edge_schedule_crossing (c, e, y0, y1);
+
+    i = j = 0;
+    for (;;) {
+	double y = y1;
+	int num_roots = 0, k;
+
+	if (c->num_crossings)
+	    y = c->crossings[1]->ycross;
+	if (c->slicing && yslice < y)
+	    y = yslice;
+	if (i < num_stops && stops[i]->ybot < y)
+	    y = stops[i]->ybot;
+	if (j < num_starts && starts[j]->ytop < y)
+	    y = starts[j]->ytop;
+	if (y >= y1)
+	    break;
+
+	if (c->num_crossings && c->crossings[1]->ycross == y) {
+	    e = c->crossings[1];
+	    crossings_remove (c, e);
+	    if (++num_row_crossings <= MAX_ROW_CROSSINGS) {
+		row_cross (c, e, mask, y, y1);
+		continue;
+	    }
+
+	    /* Too many crossings: order the edges within each slice
+	     * as at its middle, as though sampling it, from here on. */
+	    while (c->num_crossings)
+		crossings_remove (c, c->crossings[1]);
+	    c->slicing = TRUE;
+	    yslice = y;
+	}
+
+	if (c->slicing && yslice == y) {
+	    yslice = MIN (y + SLICE_HEIGHT, y1);
+	    row_slice (c, mask, y, yslice);
+	}
+
+	for (; i < num_stops && stops[i]->ybot == y; i++) {
+	    e = stops[i];
+	    if (e->role)
+		edge_flush (c, e, e->yrole, y);
+	    e->role = 0;
+	    row_remove (c, e);
+	    if (e->right)
+		roots[num_roots++] = e->right;
+	    else if (e->left)
+		roots[num_roots++] = e->left;
+	}
+
+	for (; j < num_starts && starts[j]->ytop == y; j++) {
+	    e = starts[j];
+	    row_insert (c, e, y);
+	    roots[num_roots++] = e;
+	}
+
+	for (k = 0; k < num_roots; k++) {
+	    if (roots[k]->in_row)
+		row_propagate (c, roots[k], mask, y);
+	}
+	for (k = 0; k < num_roots; k++) {
+	    e = roots[k];
+	    if (! e->in_row)
+		continue;
+
+	    if (e->left)
+		edge_schedule_crossing (c, e->left, y, y1);
+	    edge_schedule_crossing (c, e, y, y1);
+	}
+    }
+
+    /* Carry the order at the bottom of the row over to the next. */
+    n = 0;
+    for (e = c->head; e; e = e->right) {
+	if (e->role) {
+	    edge_flush (c, e, e->yrole, y1);
+	    e->role = 0;
+	}
+	e->in_row = FALSE;
+	if (e->ybot > y1)
+	    c->active[n++] = e;
+    }
+    c->num_active = n;
+    c->head = NULL;
+
+    return num_starts == 0 && num_stops == 0 && is_vertical;
+}
+
+
+static void
+active_list_merge_edges (struct analytic_scan_converter *c,
+			 struct edge *edges,
+			 double y)
+{
+    struct edge **pending = c->pending;
+    struct edge **merged = c->merged;
+    int num_pending = 0;
+    int i, j, n;
+
+    for (; edges; edges = edges->next)
+	pending[num_pending++] = edges;
+    if (num_pending > 1)
+	_edge_sort (pending, num_pending);
+
+    i = j = n = 0;
+    while (i < c->num_active && j < num_pending) {
+	if (edge_x (c->active[i], y) <= pending[j]->xtop)
+	    merged[n++] = c->active[i++];
+	else
+	    merged[n++] = pending[j++];
+    }
+    while (i < c->num_active)
+	merged[n++] = c->active[i++];
+    while (j < num_pending)
+	merged[n++] = pending[j++];
+
+    c->merged = c->active;
+    c->active = merged;
+    c->num_active = n;
+}
+
+static void
+active_list_prune (struct analytic_scan_converter *c, double y)
+{
+    int i, n = 0;
+
+    for (i = 0; i < c->num_active; i++) {
+	if (c->active[i]->ybot > y)
+	    c->active[n++] = c->active[i];
+    }
+    c->num_active = n;
+}
+
+static inline int
+coverage_to_alpha (float v)
+{
+    if (v <= 0)
+	return 0;
+    if (v >= 1)
+	return CAIRO_SPANS_UNIT_COVERAGE;
+    return v * CAIRO_SPANS_UNIT_COVERAGE + .5f;
+}
+
+static cairo_status_t
+blit_row (struct analytic_scan_converter *c,
+	  cairo_span_renderer_t *renderer,
+	  int y, int height)
+{
+    cairo_half_open_span_t *spans = c->spans;
+    unsigned num_spans = 0;
+    float cover = 0;
+    int last = 0;
+    int i, end;
+
+    if (c->lo > c->hi)
+	return CAIRO_STATUS_SUCCESS;
+
+    /* Past the last touched slot the coverage stays the same, and
+     * the first pixel inherits whatever was left of the clip. */
+    end = MAX (c->hi, 1);
+    if (c->lo == 0)
+	cover = c->cover[0];
+    for (i = MAX (c->lo, 1); i <= end; i++) {
+	int alpha;
+
+	if (! c->chunks[i >> CHUNK_BITS]) {
+	    i |= CHUNK_SIZE - 1;
+	    continue;
+	}
+
+	if (c->cover[i] == 0 && i > 1)
+	    continue;
+
+	cover += c->cover[i];
+	alpha = coverage_to_alpha (cover);
+	if (alpha != last) {
+	    spans[num_spans].x = c->xmin + i - 1;
+	    spans[num_spans].coverage = alpha;
+	    last = alpha;
+	    ++num_spans;
+	}
+    }
+
+    if (last) {
+	spans[num_spans].x = c->xmax;
+	spans[num_spans].coverage = 0;
+	++num_spans;
+    }
+
+    for (i = c->lo >> CHUNK_BITS; i <= c->hi >> CHUNK_BITS; i++) {
+	if (c->chunks[i]) {
+	    memset (c->cover + (i << CHUNK_BITS), 0, CHUNK_SIZE * sizeof (float));
+	    c->chunks[i] = 0;
+	}
+    }
+    c->lo = INT_MAX;
+    c->hi = -1;
+
+    if (num_spans == 0)
+	return CAIRO_STATUS_SUCCESS;
+
+    return renderer->render_rows (renderer, y, height, spans, num_spans);
+}
+
+static cairo_status_t
+analytic_scan_converter_render (struct analytic_scan_converter *c,
+				unsigned int winding_mask,
+				cairo_span_renderer_t *renderer)
+{
+    int i, j, h = c->ymax - c->ymin;
+    cairo_status_t status;
+
+    if (c->num_edges == 0 || c->xmin >= c->xmax)
+	return CAIRO_STATUS_SUCCESS;
+
+    for (i = 0; i < h; i = j) {
+	j = i + 1;
+
+	if (c->y_buckets[i])
+	    active_list_merge_edges (c, c->y_buckets[i], c->ymin + i);
+
+	if (c->num_active == 0) {
+	    while (j < h && c->y_buckets[j] == NULL)
+		j++;
+	    continue;
+	}
+
+	if (render_row (c, winding_mask, c->ymin + i)) {
+	    double ybot = c->ymax;
+	    int k;
+
+	    for (k = 0; k < c->num_active; k++) {
+		if (c->active[k]->ybot < ybot)
+		    ybot = c->active[k]->ybot;
+	    }
+
+	    while (j < h && c->y_buckets[j] == NULL && c->ymin + j + 1 <= ybot)
+		j++;
+	}
+
+	status = blit_row (c, renderer, c->ymin + i, j - i);
+	if (unlikely (status))
+	    return status;
+
+	active_list_prune (c, c->ymin + j);
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static void
+analytic_scan_converter_add_edge (struct analytic_scan_converter *c,
+				  const cairo_edge_t *edge)
+{
+    const cairo_point_t *p1, *p2;
+    struct edge *e;
+    double ytop, ybot;
+    int y;
+
+    ytop = MAX (_cairo_fixed_to_double (edge->top), c->ymin);
+    ybot = MIN (_cairo_fixed_to_double (edge->bottom), c->ymax);
+    if (ybot <= ytop)
+	return;
+
+    e = c->edges + c->num_edges++;
+    e->ytop = ytop;
+    e->ybot = ybot;
+    e->in_row = FALSE;
+    e->queued = 0;
+    e->role = 0;
+    if (edge->line.p2.y > edge->line.p1.y) {
+	e->dir = edge->dir;
+	p1 = &edge->line.p1;
+	p2 = &edge->line.p2;
+    } else {
+	e->dir = -edge->dir;
+	p1 = &edge->line.p2;
+	p2 = &edge->line.p1;
+    }
+
+    e->dxdy = (double) (p2->x - p1->x) / (p2->y - p1->y);
+    e->xtop = _cairo_fixed_to_double (p1->x) +
+	      (ytop - _cairo_fixed_to_double (p1->y)) * e->dxdy;
+
+    y = floor (ytop) - c->ymin;
+    e->next = c->y_buckets[y];
+    c->y_buckets[y] = e;
+}
+
+/* Grows the edge storage to make room for @num_edges more edges,
+ * keeping those already added and rethreading them into the row
+ * buckets at their new addresses. */
+static cairo_status_t
+analytic_scan_converter_allocate_edges (struct analytic_scan_converter *c,
+					int num_edges)
+{
+    struct edge *edges;
+    size_t size;
+    char *ptr;
+    int i, y;
+
+    if (num_edges == 0)
+	return CAIRO_STATUS_SUCCESS;
+
+    if (unlikely (num_edges > INT_MAX - c->num_edges))
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    num_edges += c->num_edges;
+
+    size = sizeof (struct edge) +
+	   sizeof (struct intercept) +
+	   5 * sizeof (struct edge *);
+    ptr = _cairo_malloc_ab_plus_c (num_edges, size, sizeof (struct edge *));
+    if (unlikely (ptr == NULL))
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+    edges = (struct edge *) ptr;
+    if (c->num_edges) {
+	memcpy (edges, c->edges, c->num_edges * sizeof (struct edge));
+	memset (c->y_buckets, 0, (c->ymax - c->ymin) * sizeof (struct edge *));
+	for (i = 0; i < c->num_edges; i++) {
+	    y = floor (edges[i].ytop) - c->ymin;
+	    edges[i].next = c->y_buckets[y];
+	    c->y_buckets[y] = &edges[i];
+	}
+    }
+    free (c->edges);
+
+    c->edges = edges;
+    ptr += num_edges * sizeof (struct edge);
+    c->intercepts = (struct intercept *) ptr;
+    ptr += num_edges * sizeof (struct intercept);
+    c->active = (struct edge **) ptr;
+    ptr += num_edges * sizeof (struct edge *);
+    c->pending = (struct edge **) ptr;
+    ptr += num_edges * sizeof (struct edge *);
+    c->merged = (struct edge **) ptr;
+    ptr += num_edges * sizeof (struct edge *);
+    c->roots = (struct edge **) ptr;
+    ptr += num_edges * sizeof (struct edge *);
+    c->crossings = (struct edge **) ptr;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_analytic_scan_converter_init (struct analytic_scan_converter *c,
+			       int xmin, int ymin,
+			       int xmax, int ymax)
+{
+    int max_num_spans, num_chunks;
+    unsigned h;
+
+    memset (c, 0, sizeof (*c));
+
+    c->xmin = xmin;
+    c->xmax = xmax;
+    c->ymin = ymin;
+    c->ymax = ymax;
+    c->lo = INT_MAX;
+    c->hi = -1;
+
+    h = ymax > ymin ? ymax - ymin : 0;
+    c->y_buckets = c->y_buckets_embedded;
+    if (h > ARRAY_LENGTH (c->y_buckets_embedded)) {
+	c->y_buckets = _cairo_malloc_ab (h, sizeof (struct edge *));
+	if (unlikely (c->y_buckets == NULL))
+	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    }
+    memset (c->y_buckets, 0, h * sizeof (struct edge *));
+
+    c->spans = c->spans_embedded;
+    if (xmax <= xmin)
+	return CAIRO_STATUS_SUCCESS;
+
+    max_num_spans = xmax - xmin + 1;
+    if (max_num_spans > ARRAY_LENGTH (c->spans_embedded)) {
+	c->spans = _cairo_malloc_ab (max_num_spans,
+				     sizeof (cairo_half_open_span_t));
+	if (unlikely (c->spans == NULL))
+	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    }
+
+    num_chunks = ((xmax - xmin) >> CHUNK_BITS) + 1;
+    c->cover = calloc (num_chunks, CHUNK_SIZE * sizeof (float) + 1);
+    if (unlikely (c->cover == NULL))
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    c->chunks = (uint8_t *) (c->cover + (num_chunks << CHUNK_BITS));
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static void
+_analytic_scan_converter_fini (struct analytic_scan_converter *c)
+{
+    if (c->y_buckets != c->y_buckets_embedded)
+	free (c->y_buckets);
+    if (c->spans != c->spans_embedded)
+	free (c->spans);
+    free (c->cover);
+    free (c->edges);
+}
+
+struct _cairo_analytic_scan_converter {
+    cairo_scan_converter_t base;
+
+    struct analytic_scan_converter converter[1];
+    cairo_fill_rule_t fill_rule;
+};
+
+typedef struct _cairo_analytic_scan_converter cairo_analytic_scan_converter_t;
+
+static void
+_cairo_analytic_scan_converter_destroy (void *converter)
+{
+    cairo_analytic_scan_converter_t *self = converter;
+    _analytic_scan_converter_fini (self->converter);
+    free (self);
+}
+
+cairo_status_t
+_cairo_analytic_scan_converter_add_polygon (void		*converter,
+					    const cairo_polygon_t *polygon)
+{
+    cairo_analytic_scan_converter_t *self = converter;
+    cairo_status_t status;
+    int i;
+
+    status = analytic_scan_converter_allocate_edges (self->converter,
+						     polygon->num_edges);
+    if (unlikely (status))
+	return status;
+
+    for (i = 0; i < polygon->num_edges; i++)
+	analytic_scan_converter_add_edge (self->converter, &polygon->edges[i]);
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_cairo_analytic_scan_converter_generate (void			*converter,
+					 cairo_span_renderer_t	*renderer)
+{
+    cairo_analytic_scan_converter_t *self = converter;
+
+    return analytic_scan_converter_render (self->converter,
+					   self->fill_rule == CAIRO_FILL_RULE_WINDING ? ~0 : 1,
+					   renderer);
+}
+
+cairo_scan_converter_t *
+_cairo_analytic_scan_converter_create (int			xmin,
+				       int			ymin,
+				       int			xmax,
+				       int			ymax,
+				       cairo_fill_rule_t	fill_rule)
+{
+    cairo_analytic_scan_converter_t *self;
+    cairo_status_t status;
+
+    self = malloc (sizeof (struct _cairo_analytic_scan_converter));
+    if (unlikely (self == NULL)) {
+	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	goto bail_nomem;
+    }
+
+    self->base.destroy = _cairo_analytic_scan_converter_destroy;
+    self->base.generate = _cairo_analytic_scan_converter_generate;
+
+    status = _analytic_scan_converter_init (self->converter,
+					    xmin, ymin, xmax, ymax);
+    if (unlikely (status))
+	goto bail;
+
+    self->fill_rule = fill_rule;
+
+    return &self->base;
+
+ bail:
+    self->base.destroy (&self->base);
+ bail_nomem:
+    return _cairo_scan_converter_create_in_error (status);
+}
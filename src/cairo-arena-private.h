@@ -0,0 +1,102 @@
+/* -*- Mode: c; tab-width: 8; c-basic-offset: 4; indent-tabs-mode: t; -*- */
+/* cairo - a vector graphics library with display and print output
+ *
+ * Copyright © 2026 the cairo authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ *
+ * The Initial Developer of the Original Code is the cairo authors.
+ */
+
+#ifndef CAIRO_ARENA_PRIVATE_H
+#define CAIRO_ARENA_PRIVATE_H
+
+#include "cairo-compiler-private.h"
+#include "cairo-types-private.h"
+
+CAIRO_BEGIN_DECLS
+
+/* A bump allocator for objects that share a lifetime, such as the
+ * commands of a recording surface. Allocations cannot be freed
+ * individually; all the memory is released at once by
+ * _cairo_arena_fini().
+ */
+
+#define CAIRO_ARENA_ALIGN(size) (((size) + sizeof (double) - 1) & ~(sizeof (double) - 1))
+
+typedef struct _cairo_arena_chunk cairo_arena_chunk_t;
+struct _cairo_arena_chunk {
+    cairo_arena_chunk_t *next;
+    size_t size;
+    size_t used;
+    double data[1]; /* ensure the natural alignment of the contents */
+};
+
+typedef struct _cairo_arena {
+    cairo_arena_chunk_t *chunks;
+    size_t chunk_size;
+} cairo_arena_t;
+
+cairo_private void
+_cairo_arena_init (cairo_arena_t *arena);
+
+cairo_private void
+_cairo_arena_fini (cairo_arena_t *arena);
+
+cairo_private void *
+_cairo_arena_alloc_from_new_chunk (cairo_arena_t *arena, size_t size);
+
+/* Returns @size bytes, aligned for any of cairo's types, or %NULL if
+ * out of memory. */
+static inline void *
+_cairo_arena_alloc (cairo_arena_t *arena, size_t size)
+{
+    cairo_arena_chunk_t *chunk = arena->chunks;
+    void *ptr;
+
+    size = CAIRO_ARENA_ALIGN (size);
+    if (unlikely (chunk == NULL || size > chunk->size - chunk->used))
+	return _cairo_arena_alloc_from_new_chunk (arena, size);
+
+    ptr = (char *) chunk->data + chunk->used;
+    chunk->used += size;
+    return ptr;
+}
+
+/* Allocates an array of @n elements of @size bytes, taking care not to
+ * overflow, like _cairo_malloc_ab(). */
+static inline void *
+_cairo_arena_alloc_ab (cairo_arena_t *arena, unsigned int n, unsigned int size)
+{
+    if (size != 0 && n >= INT32_MAX / size)
+	return NULL;
+
+    return _cairo_arena_alloc (arena, (size_t) n * size);
+}
+
+CAIRO_END_DECLS
+
+#endif /* CAIRO_ARENA_PRIVATE_H */
@@ -0,0 +1,101 @@
+/* -*- Mode: c; tab-width: 8; c-basic-offset: 4; indent-tabs-mode: t; -*- */
+/* cairo - a vector graphics library with display and print output
+ *
+ * Copyright © 2026 the cairo authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ *
+ * The Initial Developer of the Original Code is the cairo authors.
+ */
+
+#include "cairoint.h"
+
+#include "cairo-arena-private.h"
+#include "cairo-error-private.h"
+
+#define CAIRO_ARENA_MIN_CHUNK_SIZE (4 * 1024)
+#define CAIRO_ARENA_MAX_CHUNK_SIZE (256 * 1024)
+
+void
+_cairo_arena_init (cairo_arena_t *arena)
+{
+    arena->chunks = NULL;
+    arena->chunk_size = CAIRO_ARENA_MIN_CHUNK_SIZE;
+}
+
+void
+_cairo_arena_fini (cairo_arena_t *arena)
+{
+    cairo_arena_chunk_t *chunk = arena->chunks;
+
+    while (chunk != NULL) {
+	cairo_arena_chunk_t *next = chunk->next;
+	free (chunk);
+	chunk = next;
+    }
+}
+
+void *
+_cairo_arena_alloc_from_new_chunk (cairo_arena_t *arena, size_t size)
+{
+    cairo_arena_chunk_t *chunk;
+    size_t chunk_size;
+
+    /* Grow the chunks geometrically as the arena fills, so that large
+     * recordings need few of them. A large allocation gets a chunk of
+     * its own, linked behind the current chunk so that the remainder
+     * of that is not wasted. */
+    chunk_size = arena->chunk_size;
+    if (size > chunk_size / 4) {
+	chunk_size = size;
+    } else if (arena->chunk_size < CAIRO_ARENA_MAX_CHUNK_SIZE) {
+	arena->chunk_size *= 2;
+    }
+
+    if (chunk_size > (size_t) -1 - sizeof (cairo_arena_chunk_t)) {
+	_cairo_error_throw (CAIRO_STATUS_NO_MEMORY);
+	return NULL;
+    }
+
+    chunk = _cairo_malloc (offsetof (cairo_arena_chunk_t, data) + chunk_size);
+    if (unlikely (chunk == NULL)) {
+	_cairo_error_throw (CAIRO_STATUS_NO_MEMORY);
+	return NULL;
+    }
+
+    chunk->size = chunk_size;
+    chunk->used = size;
+
+    if (size == chunk_size && arena->chunks != NULL) {
+	chunk->next = arena->chunks->next;
+	arena->chunks->next = chunk;
+    } else {
+	chunk->next = arena->chunks;
+	arena->chunks = chunk;
+    }
+
+    return chunk->data;
+}
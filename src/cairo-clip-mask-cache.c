@@ -0,0 +1,235 @@
+/* -*- Mode: c; tab-width: 8; c-basic-offset: 4; indent-tabs-mode: t; -*- */
+/* cairo - a vector graphics library with display and print output
+ *
+ * Copyright © 2026 the cairo authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ *
+ * The Initial Developer of the Original Code is the cairo authors.
+ */
+
+/* A small cache of rasterised clip masks attached to each target.
+ *
+ * Compositing through a clip that cannot be reduced to boxes renders
+ * the clip into a scratch alpha surface.  Every draw between setting
+ * a clip and restoring it would otherwise repeat that work, so the
+ * compositors keep the last few masks they generated for a target,
+ * keyed on the contents of the clip and the extents of the mask.
+ * The masks are treated as read-only once cached.
+ *
+ * The cache lives as long as the target, long after the clips it was
+ * filled for have gone, so it is kept small: two alpha masks of at
+ * most 512x512 pixels, 512KiB per target.  Larger clips are rendered
+ * afresh for each draw, as before.
+ */
+
+#include "cairoint.h"
+
+#include "cairo-clip-inline.h"
+#include "cairo-clip-private.h"
+#include "cairo-surface-private.h"
+
+#define CLIP_MASK_CACHE_SIZE 2
+#define CLIP_MASK_CACHE_MAX_AREA (512 * 512)
+
+struct clip_mask {
+    const void *owner;
+    cairo_clip_t *clip;
+    cairo_rectangle_int_t extents;
+    cairo_surface_t *surface;
+};
+
+typedef struct _cairo_clip_mask_cache {
+    cairo_matrix_t device_transform;
+    int num_masks;
+    struct clip_mask masks[CLIP_MASK_CACHE_SIZE];
+} cairo_clip_mask_cache_t;
+
+static const cairo_user_data_key_t clip_mask_cache_key;
+
+static inline cairo_bool_t
+rectangle_equal (const cairo_rectangle_int_t *a,
+		 const cairo_rectangle_int_t *b)
+{
+    return a->x == b->x && a->y == b->y &&
+	   a->width == b->width && a->height == b->height;
+}
+
+static void
+clip_mask_fini (struct clip_mask *mask)
+{
+    _cairo_clip_destroy (mask->clip);
+    cairo_surface_destroy (mask->surface);
+}
+
+static void
+clip_mask_cache_flush (cairo_clip_mask_cache_t *cache)
+{
+    while (cache->num_masks)
+	clip_mask_fini (&cache->masks[--cache->num_masks]);
+}
+
+static void
+clip_mask_cache_destroy (void *closure)
+{
+    cairo_clip_mask_cache_t *cache = closure;
+
+    clip_mask_cache_flush (cache);
+    free (cache);
+}
+
+/* The cache is dropped whenever the device transform of the target
+ * changes, as the clips of later draws will no longer line up with
+ * those of earlier ones. */
+static cairo_clip_mask_cache_t *
+clip_mask_cache_get (cairo_surface_t *target)
+{
+    cairo_clip_mask_cache_t *cache;
+
+    cache = cairo_surface_get_user_data (target, &clip_mask_cache_key);
+    if (cache != NULL &&
+	memcmp (&cache->device_transform, &target->device_transform,
+		sizeof (cairo_matrix_t)))
+    {
+	clip_mask_cache_flush (cache);
+	cache->device_transform = target->device_transform;
+    }
+
+    return cache;
+}
+
+/**
+ * _cairo_clip_mask_cache_lookup:
+ * @target: the surface being drawn to
+ * @owner: identifies how the mask was rendered, usually the compositor
+ * @clip: the clip
+ * @extents: the area of @target covered by the mask
+ *
+ * Looks for a mask of @clip over @extents previously stored for
+ * @target by _cairo_clip_mask_cache_insert().  The caller must not
+ * modify the mask.
+ *
+ * Return value: a new reference to the cached mask, or %NULL.
+ **/
+cairo_surface_t *
+_cairo_clip_mask_cache_lookup (cairo_surface_t *target,
+			       const void *owner,
+			       const cairo_clip_t *clip,
+			       const cairo_rectangle_int_t *extents)
+{
+    cairo_clip_mask_cache_t *cache;
+    int i;
+
+    if (clip == NULL)
+	return NULL;
+
+    cache = clip_mask_cache_get (target);
+    if (cache == NULL)
+	return NULL;
+
+    for (i = 0; i < cache->num_masks; i++) {
+	struct clip_mask *mask = &cache->masks[i];
+
+	if (mask->owner == owner &&
+	    rectangle_equal (&mask->extents, extents) &&
+	    rectangle_equal (&mask->clip->extents, &clip->extents) &&
+	    _cairo_clip_equal (mask->clip, clip))
+	{
+	    /* move to the front to keep the list in MRU order */
+	    if (i) {
+		struct clip_mask tmp = *mask;
+
+		memmove (cache->masks + 1, cache->masks, i * sizeof (tmp));
+		cache->masks[0] = tmp;
+	    }
+
+	    return cairo_surface_reference (cache->masks[0].surface);
+	}
+    }
+
+    return NULL;
+}
+
+/**
+ * _cairo_clip_mask_cache_insert:
+ * @target: the surface being drawn to
+ * @owner: identifies how the mask was rendered, usually the compositor
+ * @clip: the clip
+ * @extents: the area of @target covered by the mask
+ * @surface: the mask
+ *
+ * Stores a reference to @surface for later draws to @target through an
+ * equal clip, evicting the least recently used mask if the cache is
+ * full.  Failures are silently ignored; the mask is simply not cached.
+ **/
+void
+_cairo_clip_mask_cache_insert (cairo_surface_t *target,
+			       const void *owner,
+			       const cairo_clip_t *clip,
+			       const cairo_rectangle_int_t *extents,
+			       cairo_surface_t *surface)
+{
+    cairo_clip_mask_cache_t *cache;
+    struct clip_mask *mask;
+
+    if (clip == NULL || _cairo_clip_is_all_clipped (clip))
+	return;
+
+    if (unlikely (surface->status))
+	return;
+
+    if ((unsigned) extents->width * extents->height > CLIP_MASK_CACHE_MAX_AREA)
+	return;
+
+    cache = clip_mask_cache_get (target);
+    if (cache == NULL) {
+	cache = malloc (sizeof (cairo_clip_mask_cache_t));
+	if (unlikely (cache == NULL))
+	    return;
+
+	cache->device_transform = target->device_transform;
+	cache->num_masks = 0;
+	if (cairo_surface_set_user_data (target, &clip_mask_cache_key,
+					 cache, clip_mask_cache_destroy))
+	{
+	    free (cache);
+	    return;
+	}
+    }
+
+    if (cache->num_masks == CLIP_MASK_CACHE_SIZE)
+	clip_mask_fini (&cache->masks[--cache->num_masks]);
+
+    memmove (cache->masks + 1, cache->masks,
+	     cache->num_masks * sizeof (struct clip_mask));
+    cache->num_masks++;
+
+    mask = &cache->masks[0];
+    mask->owner = owner;
+    mask->clip = _cairo_clip_copy (clip);
+    mask->extents = *extents;
+    mask->surface = cairo_surface_reference (surface);
+}
@@ -146,6 +146,19 @@ _cairo_clip_get_image (const cairo_clip_t *clip,
 		       cairo_surface_t *target,
 		       const cairo_rectangle_int_t *extents);
 
+cairo_private cairo_surface_t *
+_cairo_clip_mask_cache_lookup (cairo_surface_t *target,
+			       const void *owner,
+			       const cairo_clip_t *clip,
+			       const cairo_rectangle_int_t *extents);
+
+cairo_private void
+_cairo_clip_mask_cache_insert (cairo_surface_t *target,
+			       const void *owner,
+			       const cairo_clip_t *clip,
+			       const cairo_rectangle_int_t *extents,
+			       cairo_surface_t *surface);
+
 cairo_private cairo_status_t
 _cairo_clip_combine_with_surface (const cairo_clip_t *clip,
 				  cairo_surface_t *dst,
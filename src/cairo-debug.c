@@ -35,6 +35,8 @@
 
 #include "cairoint.h"
 #include "cairo-image-surface-private.h"
+#include "cairo-path-cache-private.h"
+#include "cairo-thread-pool-private.h"
 
 /**
  * cairo_debug_reset_static_data:
@@ -64,6 +66,8 @@ cairo_debug_reset_static_data (void)
 {
     CAIRO_MUTEX_INITIALIZE ();
 
+    _cairo_thread_pool_reset_static_data ();
+
     _cairo_scaled_font_map_destroy ();
 
     _cairo_toy_font_face_reset_static_data ();
@@ -84,8 +88,12 @@ cairo_debug_reset_static_data (void)
 
     _cairo_clip_reset_static_data ();
 
+    _cairo_path_cache_reset_static_data ();
+
     _cairo_image_reset_static_data ();
 
+    _cairo_image_compositor_reset_static_data ();
+
 #if CAIRO_HAS_DRM_SURFACE
     _cairo_drm_device_reset_static_data ();
 #endif
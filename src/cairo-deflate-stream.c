@@ -89,7 +89,8 @@ _cairo_deflate_stream_write (cairo_output_stream_t *base,
     unsigned int count;
     const unsigned char *p = data;
 
-    while (length) {
+    /* Complete any partially filled input buffer first... */
+    if (stream->zlib_stream.avail_in) {
         count = length;
         if (count > BUFFER_SIZE - stream->zlib_stream.avail_in)
             count = BUFFER_SIZE - stream->zlib_stream.avail_in;
@@ -102,6 +103,17 @@ _cairo_deflate_stream_write (cairo_output_stream_t *base,
             cairo_deflate_stream_deflate (stream, FALSE);
     }
 
+    /* ...then hand large writes to zlib directly, rather than staging
+     * them through input_buf, and only buffer the small ones. */
+    if (length >= BUFFER_SIZE) {
+        stream->zlib_stream.next_in = (Bytef *) p;
+        stream->zlib_stream.avail_in = length;
+        cairo_deflate_stream_deflate (stream, FALSE);
+    } else if (length) {
+        memcpy (stream->input_buf, p, length);
+        stream->zlib_stream.avail_in = length;
+    }
+
     return _cairo_output_stream_get_status (stream->output);
 }
 
@@ -116,8 +128,26 @@ _cairo_deflate_stream_close (cairo_output_stream_t *base)
     return _cairo_output_stream_get_status (stream->output);
 }
 
+static int
+_cairo_deflate_clamp_level (int level)
+{
+    if (level < 0)
+	return CAIRO_DEFLATE_LEVEL_DEFAULT;
+    if (level > 9)
+	return 9;
+    return level;
+}
+
 cairo_output_stream_t *
 _cairo_deflate_stream_create (cairo_output_stream_t *output)
+{
+    return _cairo_deflate_stream_create_with_level (output,
+						    CAIRO_DEFLATE_LEVEL_DEFAULT);
+}
+
+cairo_output_stream_t *
+_cairo_deflate_stream_create_with_level (cairo_output_stream_t *output,
+					 int			level)
 {
     cairo_deflate_stream_t *stream;
 
@@ -140,7 +170,8 @@ _cairo_deflate_stream_create (cairo_output_stream_t *output)
     stream->zlib_stream.zfree  = Z_NULL;
     stream->zlib_stream.opaque  = Z_NULL;
 
-    if (deflateInit (&stream->zlib_stream, Z_DEFAULT_COMPRESSION) != Z_OK) {
+    if (deflateInit (&stream->zlib_stream,
+		     _cairo_deflate_clamp_level (level)) != Z_OK) {
 	free (stream);
 	return (cairo_output_stream_t *) &_cairo_output_stream_nil;
     }
@@ -153,4 +184,50 @@ _cairo_deflate_stream_create (cairo_output_stream_t *output)
     return &stream->base;
 }
 
+cairo_status_t
+_cairo_deflate_compress (const unsigned char	 *data,
+			 unsigned long		  length,
+			 int			  level,
+			 unsigned char		**compressed_out,
+			 unsigned long		 *compressed_length_out)
+{
+    z_stream zlib_stream;
+    unsigned char *compressed;
+    unsigned long bound;
+    int ret;
+
+    zlib_stream.zalloc = Z_NULL;
+    zlib_stream.zfree  = Z_NULL;
+    zlib_stream.opaque = Z_NULL;
+
+    if (deflateInit (&zlib_stream, _cairo_deflate_clamp_level (level)) != Z_OK)
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+    /* With an output buffer of deflateBound() bytes, zlib is guaranteed
+     * to finish in a single call. */
+    bound = deflateBound (&zlib_stream, length);
+    compressed = _cairo_malloc (bound);
+    if (unlikely (compressed == NULL)) {
+	deflateEnd (&zlib_stream);
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    }
+
+    zlib_stream.next_in = (Bytef *) data;
+    zlib_stream.avail_in = length;
+    zlib_stream.next_out = compressed;
+    zlib_stream.avail_out = bound;
+
+    ret = deflate (&zlib_stream, Z_FINISH);
+    deflateEnd (&zlib_stream);
+    if (unlikely (ret != Z_STREAM_END)) {
+	free (compressed);
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    }
+
+    *compressed_out = compressed;
+    *compressed_length_out = bound - zlib_stream.avail_out;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
 #endif /* CAIRO_HAS_DEFLATE_STREAM */
@@ -323,36 +323,21 @@ _cairo_hash_table_manage (cairo_hash_table_t *hash_table)
     return CAIRO_STATUS_SUCCESS;
 }
 
-/**
- * _cairo_hash_table_lookup:
- * @hash_table: a hash table
- * @key: the key of interest
- *
- * Performs a lookup in @hash_table looking for an entry which has a
- * key that matches @key, (as determined by the keys_equal() function
- * passed to _cairo_hash_table_create).
- *
- * Return value: the matching entry, of %NULL if no match was found.
- **/
-void *
-_cairo_hash_table_lookup (cairo_hash_table_t *hash_table,
-			  cairo_hash_entry_t *key)
+static cairo_hash_entry_t *
+_cairo_hash_table_probe (cairo_hash_table_t *hash_table,
+			 cairo_hash_entry_t *key)
 {
     cairo_hash_entry_t *entry;
     unsigned long table_size, i, idx, step;
     unsigned long hash = key->hash;
 
-    entry = hash_table->cache[hash & 31];
-    if (entry && entry->hash == hash && hash_table->keys_equal (key, entry))
-	return entry;
-
     table_size = *hash_table->table_size;
     idx = hash % table_size;
 
     entry = hash_table->entries[idx];
     if (ENTRY_IS_LIVE (entry)) {
 	if (entry->hash == hash && hash_table->keys_equal (key, entry))
-		goto insert_cache;
+		return entry;
     } else if (ENTRY_IS_FREE (entry))
 	return NULL;
 
@@ -366,19 +351,63 @@ _cairo_hash_table_lookup (cairo_hash_table_t *hash_table,
 	entry = hash_table->entries[idx];
 	if (ENTRY_IS_LIVE (entry)) {
 	    if (entry->hash == hash && hash_table->keys_equal (key, entry))
-		    goto insert_cache;
+		    return entry;
 	} else if (ENTRY_IS_FREE (entry))
 	    return NULL;
     } while (++i < table_size);
 
     ASSERT_NOT_REACHED;
     return NULL;
+}
+
+/**
+ * _cairo_hash_table_lookup:
+ * @hash_table: a hash table
+ * @key: the key of interest
+ *
+ * Performs a lookup in @hash_table looking for an entry which has a
+ * key that matches @key, (as determined by the keys_equal() function
+ * passed to _cairo_hash_table_create).
+ *
+ * Return value: the matching entry, of %NULL if no match was found.
+ **/
+void *
+_cairo_hash_table_lookup (cairo_hash_table_t *hash_table,
+			  cairo_hash_entry_t *key)
+{
+    cairo_hash_entry_t *entry;
+    unsigned long hash = key->hash;
+
+    entry = hash_table->cache[hash & 31];
+    if (entry && entry->hash == hash && hash_table->keys_equal (key, entry))
+	return entry;
+
+    entry = _cairo_hash_table_probe (hash_table, key);
+    if (entry != NULL)
+	hash_table->cache[hash & 31] = entry;
 
-insert_cache:
-    hash_table->cache[hash & 31] = entry;
     return entry;
 }
 
+/**
+ * _cairo_hash_table_lookup_shared:
+ * @hash_table: a hash table
+ * @key: the key of interest
+ *
+ * As _cairo_hash_table_lookup(), but without updating the lookup
+ * cache, so that it never writes to @hash_table.  This allows several
+ * threads to search the table at once, as long as they exclude any
+ * writers.
+ *
+ * Return value: the matching entry, of %NULL if no match was found.
+ **/
+void *
+_cairo_hash_table_lookup_shared (cairo_hash_table_t *hash_table,
+				 cairo_hash_entry_t *key)
+{
+    return _cairo_hash_table_probe (hash_table, key);
+}
+
 /**
  * _cairo_hash_table_random_entry:
  * @hash_table: a hash table
@@ -44,6 +44,7 @@
 #include "cairoint.h"
 
 #include "cairo-image-surface-private.h"
+#include "cairo-image-spans-simd-private.h"
 
 #include "cairo-compositor-private.h"
 #include "cairo-spans-compositor-private.h"
@@ -809,30 +810,190 @@ check_composite_glyphs (const cairo_composite_rectangles_t *extents,
 }
 
 #if HAS_PIXMAN_GLYPHS
-static pixman_glyph_cache_t *global_glyph_cache;
+/* The pixman glyph cache is not thread-safe, so every glyph run used to
+ * be composited under one global mutex.  Instead we keep a small number
+ * of independent caches, each with its own lock, and route each thread
+ * to a shard by hashing its thread id.  A thread therefore keeps
+ * hitting the same (warm) cache, while concurrent threads mostly land
+ * on different ones.  A glyph may end up cached in more than one shard,
+ * up to one copy per shard; each scaled glyph records the shards that
+ * hold it, so that evicting it only visits those.
+ */
+#define GLYPH_CACHE_SHARD_BITS 3
+#define GLYPH_CACHE_NUM_SHARDS (1 << GLYPH_CACHE_SHARD_BITS)
+
+typedef struct _glyph_cache_shard {
+    cairo_mutex_t mutex;
+    pixman_glyph_cache_t *cache;
+
+    /* threads holding or waiting for the mutex */
+    cairo_atomic_int_t users;
+
+    /* protected by mutex */
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long lock_waits;
+} glyph_cache_shard_t;
+
+static glyph_cache_shard_t glyph_cache_shards[GLYPH_CACHE_NUM_SHARDS];
+static cairo_atomic_int_t glyph_cache_shards_initialized;
+
+static void
+glyph_cache_shards_init (void)
+{
+    int i;
+
+    if (likely (_cairo_atomic_int_get (&glyph_cache_shards_initialized)))
+	return;
+
+    CAIRO_MUTEX_LOCK (_cairo_glyph_cache_mutex);
+    if (! _cairo_atomic_int_get (&glyph_cache_shards_initialized)) {
+	for (i = 0; i < GLYPH_CACHE_NUM_SHARDS; i++) {
+	    memset (&glyph_cache_shards[i], 0, sizeof (glyph_cache_shard_t));
+	    CAIRO_MUTEX_INIT (glyph_cache_shards[i].mutex);
+	}
+	_cairo_atomic_int_cmpxchg (&glyph_cache_shards_initialized, 0, 1);
+    }
+    CAIRO_MUTEX_UNLOCK (_cairo_glyph_cache_mutex);
+}
+
+static uint64_t
+glyph_cache_thread_id (void)
+{
+#if CAIRO_MUTEX_IMPL_WIN32
+    return GetCurrentThreadId ();
+#elif CAIRO_MUTEX_IMPL_PTHREAD
+    pthread_t self = pthread_self ();
+    uint64_t id = 0;
+
+    /* pthread_t is opaque; hash whatever it holds */
+    memcpy (&id, &self, MIN (sizeof (id), sizeof (self)));
+    return id;
+#else
+    return 0;
+#endif
+}
+
+static int
+glyph_cache_shard_for_thread (void)
+{
+    uint64_t id = glyph_cache_thread_id ();
+
+    /* thread ids are often aligned pointers; mix in the high bits */
+    id ^= id >> 29;
+    id *= 0xbf58476d1ce4e5b9ull;
+    id ^= id >> 32;
+
+    return (uint32_t) id >> (32 - GLYPH_CACHE_SHARD_BITS);
+}
+
+static void
+glyph_cache_shard_mark (cairo_scaled_glyph_t *scaled_glyph, int shard)
+{
+    int old;
+
+    do {
+	old = _cairo_atomic_int_get (&scaled_glyph->image_shards);
+	if (old & (1 << shard))
+	    return;
+    } while (! _cairo_atomic_int_cmpxchg (&scaled_glyph->image_shards,
+					  old, old | 1 << shard));
+}
 
-static inline pixman_glyph_cache_t *
-get_glyph_cache (void)
+static void
+glyph_cache_shard_lock (glyph_cache_shard_t *shard)
 {
-    if (!global_glyph_cache)
-	global_glyph_cache = pixman_glyph_cache_create ();
+    cairo_bool_t contended;
+
+    _cairo_atomic_int_inc (&shard->users);
+    contended = _cairo_atomic_int_get (&shard->users) > 1;
 
-    return global_glyph_cache;
+    CAIRO_MUTEX_LOCK (shard->mutex);
+    if (contended)
+	shard->lock_waits++;
+}
+
+static void
+glyph_cache_shard_unlock (glyph_cache_shard_t *shard)
+{
+    CAIRO_MUTEX_UNLOCK (shard->mutex);
+    _cairo_atomic_int_dec (&shard->users);
 }
 
 void
 _cairo_image_scaled_glyph_fini (cairo_scaled_font_t *scaled_font,
 				cairo_scaled_glyph_t *scaled_glyph)
 {
-    CAIRO_MUTEX_LOCK (_cairo_glyph_cache_mutex);
+    int shards, i;
+
+    if (! _cairo_atomic_int_get (&glyph_cache_shards_initialized))
+	return;
 
-    if (global_glyph_cache) {
-	pixman_glyph_cache_remove (
-	    global_glyph_cache, scaled_font,
-	    (void *)_cairo_scaled_glyph_index (scaled_glyph));
+    shards = _cairo_atomic_int_get (&scaled_glyph->image_shards);
+    for (i = 0; i < GLYPH_CACHE_NUM_SHARDS; i++) {
+	glyph_cache_shard_t *shard = &glyph_cache_shards[i];
+
+	if ((shards & (1 << i)) == 0)
+	    continue;
+
+	glyph_cache_shard_lock (shard);
+	if (shard->cache) {
+	    pixman_glyph_cache_remove (
+		shard->cache, scaled_font,
+		(void *)_cairo_scaled_glyph_index (scaled_glyph));
+	}
+	glyph_cache_shard_unlock (shard);
     }
+}
 
-    CAIRO_MUTEX_UNLOCK (_cairo_glyph_cache_mutex);
+void
+_cairo_image_glyph_cache_get_stats (cairo_image_glyph_cache_stats_t *stats)
+{
+    int i;
+
+    memset (stats, 0, sizeof (*stats));
+    stats->num_shards = GLYPH_CACHE_NUM_SHARDS;
+
+    if (! _cairo_atomic_int_get (&glyph_cache_shards_initialized))
+	return;
+
+    for (i = 0; i < GLYPH_CACHE_NUM_SHARDS; i++) {
+	glyph_cache_shard_t *shard = &glyph_cache_shards[i];
+
+	CAIRO_MUTEX_LOCK (shard->mutex);
+	stats->hits += shard->hits;
+	stats->misses += shard->misses;
+	stats->lock_waits += shard->lock_waits;
+	CAIRO_MUTEX_UNLOCK (shard->mutex);
+    }
+}
+
+void
+_cairo_image_compositor_reset_static_data (void)
+{
+    int i;
+
+    if (! _cairo_atomic_int_get (&glyph_cache_shards_initialized))
+	return;
+
+    if (getenv ("CAIRO_DEBUG_GLYPH_CACHE") != NULL) {
+	cairo_image_glyph_cache_stats_t stats;
+
+	_cairo_image_glyph_cache_get_stats (&stats);
+	fprintf (stderr,
+		 "glyph cache: %d shards, %lu hits, %lu misses, %lu lock waits\n",
+		 stats.num_shards, stats.hits, stats.misses, stats.lock_waits);
+    }
+
+    for (i = 0; i < GLYPH_CACHE_NUM_SHARDS; i++) {
+	glyph_cache_shard_t *shard = &glyph_cache_shards[i];
+
+	if (shard->cache)
+	    pixman_glyph_cache_destroy (shard->cache);
+	shard->cache = NULL;
+	CAIRO_MUTEX_FINI (shard->mutex);
+    }
+    glyph_cache_shards_initialized = 0;
 }
 
 static cairo_int_status_t
@@ -846,6 +1007,8 @@ composite_glyphs (void				*_dst,
 		  cairo_composite_glyphs_info_t *info)
 {
     cairo_int_status_t status = CAIRO_INT_STATUS_SUCCESS;
+    glyph_cache_shard_t *shard;
+    int shard_index;
     pixman_glyph_cache_t *glyph_cache;
     pixman_glyph_t pglyphs_stack[CAIRO_STACK_ARRAY_LENGTH (pixman_glyph_t)];
     pixman_glyph_t *pglyphs = pglyphs_stack;
@@ -854,9 +1017,15 @@ composite_glyphs (void				*_dst,
 
     TRACE ((stderr, "%s\n", __FUNCTION__));
 
-    CAIRO_MUTEX_LOCK (_cairo_glyph_cache_mutex);
+    glyph_cache_shards_init ();
+
+    shard_index = glyph_cache_shard_for_thread ();
+    shard = &glyph_cache_shards[shard_index];
+    glyph_cache_shard_lock (shard);
 
-    glyph_cache = get_glyph_cache();
+    if (shard->cache == NULL)
+	shard->cache = pixman_glyph_cache_create ();
+    glyph_cache = shard->cache;
     if (unlikely (glyph_cache == NULL)) {
 	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
 	goto out_unlock;
@@ -878,18 +1047,21 @@ composite_glyphs (void				*_dst,
 	const void *glyph;
 
 	glyph = pixman_glyph_cache_lookup (glyph_cache, info->font, (void *)index);
-	if (!glyph) {
+	if (glyph) {
+	    shard->hits++;
+	} else {
 	    cairo_scaled_glyph_t *scaled_glyph;
 	    cairo_image_surface_t *glyph_surface;
 
 	    /* This call can actually end up recursing, so we have to
 	     * drop the mutex around it.
 	     */
-	    CAIRO_MUTEX_UNLOCK (_cairo_glyph_cache_mutex);
+	    glyph_cache_shard_unlock (shard);
 	    status = _cairo_scaled_glyph_lookup (info->font, index,
 						 CAIRO_SCALED_GLYPH_INFO_SURFACE,
 						 &scaled_glyph);
-	    CAIRO_MUTEX_LOCK (_cairo_glyph_cache_mutex);
+	    glyph_cache_shard_lock (shard);
+	    shard->misses++;
 
 	    if (unlikely (status))
 		goto out_thaw;
@@ -903,6 +1075,7 @@ composite_glyphs (void				*_dst,
 		status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
 		goto out_thaw;
 	    }
+	    glyph_cache_shard_mark (scaled_glyph, shard_index);
 	}
 
 	pg->x = _cairo_lround (info->glyphs[i].x);
@@ -941,7 +1114,7 @@ out_thaw:
 	free(pglyphs);
 
 out_unlock:
-    CAIRO_MUTEX_UNLOCK (_cairo_glyph_cache_mutex);
+    glyph_cache_shard_unlock (shard);
     return status;
 }
 #else
@@ -951,6 +1124,17 @@ _cairo_image_scaled_glyph_fini (cairo_scaled_font_t *scaled_font,
 {
 }
 
+void
+_cairo_image_glyph_cache_get_stats (cairo_image_glyph_cache_stats_t *stats)
+{
+    memset (stats, 0, sizeof (*stats));
+}
+
+void
+_cairo_image_compositor_reset_static_data (void)
+{
+}
+
 static cairo_int_status_t
 composite_one_glyph (void				*_dst,
 		     cairo_operator_t			 op,
@@ -2159,6 +2343,74 @@ lerp8x4 (uint32_t src, uint8_t a, uint32_t dst)
 			mul8x2_8 (dst >> G_SHIFT, ~a)) << G_SHIFT);
 }
 
+/* Vector kernels for the runs below, selected once for the running CPU
+ * in _cairo_image_spans_compositor_get().  Short runs are not worth the
+ * call, so only hand over rows of at least SPANS_SIMD_MIN pixels and
+ * finish the remainder with the scalar code.
+ */
+static const cairo_image_spans_simd_t *spans_simd;
+#define SPANS_SIMD_MIN 8
+
+static inline void
+lerp32_solid_row (uint32_t *d, uint32_t pixel, uint8_t a, int len)
+{
+    if (spans_simd && len >= SPANS_SIMD_MIN) {
+	int n = spans_simd->lerp32_solid (d, pixel, a, len);
+	d += n, len -= n;
+    }
+    while (len--) {
+	*d = lerp8x4 (pixel, a, *d);
+	d++;
+    }
+}
+
+static inline void
+lerp32_row (uint32_t *d, const uint32_t *s, uint8_t a, int len)
+{
+    if (spans_simd && len >= SPANS_SIMD_MIN) {
+	int n = spans_simd->lerp32 (d, s, a, len);
+	d += n, s += n, len -= n;
+    }
+    while (len--) {
+	*d = lerp8x4 (*s, a, *d);
+	s++, d++;
+    }
+}
+
+static inline void
+lerp8_opaque_row (uint8_t *d, uint8_t pixel, uint8_t a, int len)
+{
+    uint8_t s;
+
+    if (spans_simd && len >= SPANS_SIMD_MIN) {
+	int n = spans_simd->lerp8_opaque (d, pixel, a, len);
+	d += n, len -= n;
+    }
+    s = mul8_8 (a, pixel);
+    a = ~a;
+    while (len--) {
+	uint8_t t = mul8_8 (*d, a);
+	*d++ = t + s;
+    }
+}
+
+static inline void
+lerp8_row (uint8_t *d, uint8_t pixel, uint8_t a, int len)
+{
+    uint16_t p, ia;
+
+    if (spans_simd && len >= SPANS_SIMD_MIN) {
+	int n = spans_simd->lerp8 (d, pixel, a, len);
+	d += n, len -= n;
+    }
+    p = (uint16_t)a * pixel + 0x7f;
+    ia = ~a;
+    while (len--) {
+	uint16_t t = *d*ia + p;
+	*d++ = (t + (t>>8)) >> 8;
+    }
+}
+
 static cairo_status_t
 _fill_a8_lerp_opaque_spans (void *abstract_renderer, int y, int h,
 			    const cairo_half_open_span_t *spans, unsigned num_spans)
@@ -2177,13 +2429,7 @@ _fill_a8_lerp_opaque_spans (void *abstract_renderer, int y, int h,
 		if (a == 0xff) {
 		    memset(d + spans[0].x, r->u.fill.pixel, len);
 		} else {
-		    uint8_t s = mul8_8(a, r->u.fill.pixel);
-		    uint8_t *dst = d + spans[0].x;
-		    a = ~a;
-		    while (len--) {
-			uint8_t t = mul8_8(*dst, a);
-			*dst++ = t + s;
-		    }
+		    lerp8_opaque_row (d + spans[0].x, r->u.fill.pixel, a, len);
 		}
 	    }
 	    spans++;
@@ -2201,15 +2447,10 @@ _fill_a8_lerp_opaque_spans (void *abstract_renderer, int y, int h,
 			yy++;
 		    } while (--hh);
 		} else {
-		    uint8_t s = mul8_8(a, r->u.fill.pixel);
-		    a = ~a;
 		    do {
 			int len = spans[1].x - spans[0].x;
 			uint8_t *d = r->u.fill.data + r->u.fill.stride*yy + spans[0].x;
-			while (len--) {
-			    uint8_t t = mul8_8(*d, a);
-			    *d++ = t + s;
-			}
+			lerp8_opaque_row (d, r->u.fill.pixel, a, len);
 			yy++;
 		    } while (--hh);
 		}
@@ -2245,9 +2486,8 @@ _fill_xrgb32_lerp_opaque_spans (void *abstract_renderer, int y, int h,
 			while (len-- > 0)
 			    *d++ = r->u.fill.pixel;
 		    }
-		} else while (len-- > 0) {
-		    *d = lerp8x4 (r->u.fill.pixel, a, *d);
-		    d++;
+		} else {
+		    lerp32_solid_row (d, r->u.fill.pixel, a, len);
 		}
 	    }
 	    spans++;
@@ -2276,10 +2516,7 @@ _fill_xrgb32_lerp_opaque_spans (void *abstract_renderer, int y, int h,
 		    do {
 			int len = spans[1].x - spans[0].x;
 			uint32_t *d = (uint32_t *)(r->u.fill.data + r->u.fill.stride*yy + spans[0].x*4);
-			while (len--) {
-			    *d = lerp8x4 (r->u.fill.pixel, a, *d);
-			    d++;
-			}
+			lerp32_solid_row (d, r->u.fill.pixel, a, len);
 			yy++;
 		    } while (--hh);
 		}
@@ -2306,12 +2543,7 @@ _fill_a8_lerp_spans (void *abstract_renderer, int y, int h,
 	    if (a) {
 		int len = spans[1].x - spans[0].x;
 		uint8_t *d = r->u.fill.data + r->u.fill.stride*y + spans[0].x;
-		uint16_t p = (uint16_t)a * r->u.fill.pixel + 0x7f;
-		uint16_t ia = ~a;
-		while (len--) {
-		    uint16_t t = *d*ia + p;
-		    *d++ = (t + (t>>8)) >> 8;
-		}
+		lerp8_row (d, r->u.fill.pixel, a, len);
 	    }
 	    spans++;
 	} while (--num_spans > 1);
@@ -2320,15 +2552,10 @@ _fill_a8_lerp_spans (void *abstract_renderer, int y, int h,
 	    uint8_t a = mul8_8 (spans[0].coverage, r->bpp);
 	    if (a) {
 		int yy = y, hh = h;
-		uint16_t p = (uint16_t)a * r->u.fill.pixel + 0x7f;
-		uint16_t ia = ~a;
 		do {
 		    int len = spans[1].x - spans[0].x;
 		    uint8_t *d = r->u.fill.data + r->u.fill.stride*yy + spans[0].x;
-		    while (len--) {
-			uint16_t t = *d*ia + p;
-			*d++ = (t + (t>>8)) >> 8;
-		    }
+		    lerp8_row (d, r->u.fill.pixel, a, len);
 		    yy++;
 		} while (--hh);
 	    }
@@ -2354,10 +2581,7 @@ _fill_xrgb32_lerp_spans (void *abstract_renderer, int y, int h,
 	    if (a) {
 		int len = spans[1].x - spans[0].x;
 		uint32_t *d = (uint32_t*)(r->u.fill.data + r->u.fill.stride*y + spans[0].x*4);
-		while (len--) {
-		    *d = lerp8x4 (r->u.fill.pixel, a, *d);
-		    d++;
-		}
+		lerp32_solid_row (d, r->u.fill.pixel, a, len);
 	    }
 	    spans++;
 	} while (--num_spans > 1);
@@ -2369,10 +2593,7 @@ _fill_xrgb32_lerp_spans (void *abstract_renderer, int y, int h,
 		do {
 		    int len = spans[1].x - spans[0].x;
 		    uint32_t *d = (uint32_t *)(r->u.fill.data + r->u.fill.stride*yy + spans[0].x*4);
-		    while (len--) {
-			*d = lerp8x4 (r->u.fill.pixel, a, *d);
-			d++;
-		    }
+		    lerp32_solid_row (d, r->u.fill.pixel, a, len);
 		    yy++;
 		} while (--hh);
 	    }
@@ -2407,10 +2628,7 @@ _blit_xrgb32_lerp_spans (void *abstract_renderer, int y, int h,
 		    else
 			memcpy(d, s, len*4);
 		} else {
-		    while (len--) {
-			*d = lerp8x4 (*s, a, *d);
-			s++, d++;
-		    }
+		    lerp32_row (d, s, a, len);
 		}
 	    }
 	    spans++;
@@ -2430,10 +2648,7 @@ _blit_xrgb32_lerp_spans (void *abstract_renderer, int y, int h,
 			else
 			    memcpy(d, s, len * 4);
 		    } else {
-			while (len--) {
-			    *d = lerp8x4 (*s, a, *d);
-			    s++, d++;
-			}
+			lerp32_row (d, s, a, len);
 		    }
 		    yy++;
 		} while (--hh);
@@ -3102,6 +3317,27 @@ span_renderer_fini (cairo_abstract_span_renderer_t *_r,
 }
 #endif
 
+static cairo_surface_t *
+create_band_surface (cairo_surface_t *_dst)
+{
+    cairo_image_surface_t *dst = (cairo_image_surface_t *) _dst;
+    cairo_surface_t *surface;
+
+    /* A second pixman image sharing the pixels, so that each band
+     * has its own image state to validate. */
+    surface = _cairo_image_surface_create_with_pixman_format (dst->data,
+							       dst->pixman_format,
+							       dst->width,
+							       dst->height,
+							       dst->stride);
+    if (unlikely (surface->status))
+	return surface;
+
+    surface->content = dst->base.content;
+    surface->is_clear = dst->base.is_clear;
+    return surface;
+}
+
 const cairo_compositor_t *
 _cairo_image_spans_compositor_get (void)
 {
@@ -3131,6 +3367,9 @@ _cairo_image_spans_compositor_get (void)
 	//spans.check_span_renderer = check_span_renderer;
 	spans.renderer_init = span_renderer_init;
 	spans.renderer_fini = span_renderer_fini;
+	spans.create_band_surface = create_band_surface;
+
+	spans_simd = _cairo_image_spans_simd_get ();
     }
 
     return &spans.base;
@@ -61,6 +61,10 @@
 #define PIXMAN_HAS_ATOMIC_OPS 1
 #endif
 
+#if CAIRO_HAS_REAL_PTHREAD && ! PIXMAN_HAS_ATOMIC_OPS
+#include <pthread.h>
+#endif
+
 #if PIXMAN_HAS_ATOMIC_OPS
 static pixman_image_t *__pixman_transparent_image;
 static pixman_image_t *__pixman_black_image;
@@ -162,21 +166,6 @@ _pixman_white_image (void)
     return image;
 }
 
-static uint32_t
-hars_petruska_f54_1_random (void)
-{
-#define rol(x,k) ((x << k) | (x >> (32-k)))
-    static uint32_t x;
-    return x = (x ^ rol (x, 5) ^ rol (x, 24)) + 0x37798849;
-#undef rol
-}
-
-static struct {
-    cairo_color_t color;
-    pixman_image_t *image;
-} cache[16];
-static int n_cached;
-
 #else  /* !PIXMAN_HAS_ATOMIC_OPS */
 static pixman_image_t *
 _pixman_transparent_image (void)
@@ -201,15 +190,150 @@ _pixman_white_image (void)
 #endif /* !PIXMAN_HAS_ATOMIC_OPS */
 
 
+/* A direct-mapped cache of solid images, hashed by color. It is
+ * lock-free: a lookup takes the entry out of its slot while it
+ * inspects it, so that an entry is only ever owned by one thread and
+ * can be freed by whoever replaces it. A concurrent lookup of the same
+ * color just misses and creates a new image.
+ *
+ * As pixman images can only be shared between threads if pixman's
+ * reference counting is atomic, we otherwise keep a separate cache
+ * for each thread.
+ */
+#if PIXMAN_HAS_ATOMIC_OPS || CAIRO_HAS_REAL_PTHREAD
+#define HAS_SOLID_CACHE 1
+#define SOLID_CACHE_SIZE 256
+
+typedef struct _solid_cache_entry {
+    uint64_t key;
+    pixman_image_t *image;
+} solid_cache_entry_t;
+
+static inline uint64_t
+solid_color_key (const cairo_color_t *color)
+{
+    return (uint64_t) color->red_short << 48 |
+	   (uint64_t) color->green_short << 32 |
+	   (uint64_t) color->blue_short << 16 |
+	   color->alpha_short;
+}
+
+static inline unsigned int
+solid_cache_hash (uint64_t key)
+{
+    key ^= key >> 29;
+    key *= 0xbf58476d1ce4e5b9ull;
+    key ^= key >> 32;
+    return key & (SOLID_CACHE_SIZE - 1);
+}
+
+static solid_cache_entry_t *
+solid_cache_take (solid_cache_entry_t **slot)
+{
+    solid_cache_entry_t *entry;
+
+    do {
+	entry = _cairo_atomic_ptr_get ((void **) slot);
+	if (entry == NULL)
+	    return NULL;
+    } while (! _cairo_atomic_ptr_cmpxchg (slot, entry, NULL));
+
+    return entry;
+}
+
+static void
+solid_cache_entry_destroy (solid_cache_entry_t *entry)
+{
+    pixman_image_unref (entry->image);
+    free (entry);
+}
+
+static void
+solid_cache_put (solid_cache_entry_t **slot, solid_cache_entry_t *entry)
+{
+    solid_cache_entry_t *old;
+
+    /* Replace whatever was put there meanwhile */
+    while (! _cairo_atomic_ptr_cmpxchg (slot, NULL, entry)) {
+	old = solid_cache_take (slot);
+	if (old != NULL)
+	    solid_cache_entry_destroy (old);
+    }
+}
+
+static void
+solid_cache_clear (solid_cache_entry_t **slots)
+{
+    int i;
+
+    for (i = 0; i < SOLID_CACHE_SIZE; i++) {
+	solid_cache_entry_t *entry = solid_cache_take (&slots[i]);
+	if (entry != NULL)
+	    solid_cache_entry_destroy (entry);
+    }
+}
+
+#if PIXMAN_HAS_ATOMIC_OPS
+static solid_cache_entry_t *solid_cache[SOLID_CACHE_SIZE];
+
+static solid_cache_entry_t **
+solid_cache_get (void)
+{
+    return solid_cache;
+}
+#else
+static pthread_key_t solid_cache_tls;
+static pthread_once_t solid_cache_once = PTHREAD_ONCE_INIT;
+static cairo_bool_t solid_cache_tls_valid;
+
+static void
+solid_cache_tls_destroy (void *slots)
+{
+    solid_cache_clear (slots);
+    free (slots);
+}
+
+static void
+solid_cache_tls_init (void)
+{
+    solid_cache_tls_valid =
+	pthread_key_create (&solid_cache_tls, solid_cache_tls_destroy) == 0;
+}
+
+static solid_cache_entry_t **
+solid_cache_get (void)
+{
+    solid_cache_entry_t **slots;
+
+    pthread_once (&solid_cache_once, solid_cache_tls_init);
+    if (unlikely (! solid_cache_tls_valid))
+	return NULL;
+
+    slots = pthread_getspecific (solid_cache_tls);
+    if (slots == NULL) {
+	slots = calloc (SOLID_CACHE_SIZE, sizeof (solid_cache_entry_t *));
+	if (slots != NULL && pthread_setspecific (solid_cache_tls, slots)) {
+	    free (slots);
+	    slots = NULL;
+	}
+    }
+
+    return slots;
+}
+#endif
+#endif /* PIXMAN_HAS_ATOMIC_OPS || CAIRO_HAS_REAL_PTHREAD */
+
 pixman_image_t *
 _pixman_image_for_color (const cairo_color_t *cairo_color)
 {
     pixman_color_t color;
     pixman_image_t *image;
+#if HAS_SOLID_CACHE
+    solid_cache_entry_t **slots, **slot = NULL, *entry = NULL;
+    uint64_t key = 0;
+#endif
 
 #if PIXMAN_HAS_ATOMIC_OPS
-    int i;
-
     if (CAIRO_COLOR_IS_CLEAR (cairo_color))
 	return _pixman_transparent_image ();
 
@@ -228,12 +352,18 @@ _pixman_image_for_color (const cairo_color_t *cairo_color)
 	    return _pixman_white_image ();
 	}
     }
+#endif
 
-    CAIRO_MUTEX_LOCK (_cairo_image_solid_cache_mutex);
-    for (i = 0; i < n_cached; i++) {
-	if (_cairo_color_equal (&cache[i].color, cairo_color)) {
-	    image = pixman_image_ref (cache[i].image);
-	    goto UNLOCK;
+#if HAS_SOLID_CACHE
+    slots = solid_cache_get ();
+    if (likely (slots != NULL)) {
+	key = solid_color_key (cairo_color);
+	slot = &slots[solid_cache_hash (key)];
+	entry = solid_cache_take (slot);
+	if (entry != NULL && entry->key == key) {
+	    image = pixman_image_ref (entry->image);
+	    solid_cache_put (slot, entry);
+	    return image;
 	}
     }
 #endif
@@ -244,33 +374,119 @@ _pixman_image_for_color (const cairo_color_t *cairo_color)
     color.alpha = cairo_color->alpha_short;
 
     image = pixman_image_create_solid_fill (&color);
-#if PIXMAN_HAS_ATOMIC_OPS
-    if (image == NULL)
-	goto UNLOCK;
+#if HAS_SOLID_CACHE
+    if (slot == NULL)
+	return image;
 
-    if (n_cached < ARRAY_LENGTH (cache)) {
-	i = n_cached++;
-    } else {
-	i = hars_petruska_f54_1_random () % ARRAY_LENGTH (cache);
-	pixman_image_unref (cache[i].image);
+    if (unlikely (image == NULL)) {
+	if (entry != NULL)
+	    solid_cache_put (slot, entry);
+	return NULL;
     }
-    cache[i].image = pixman_image_ref (image);
-    cache[i].color = *cairo_color;
 
-UNLOCK:
-    CAIRO_MUTEX_UNLOCK (_cairo_image_solid_cache_mutex);
+    /* Evict the previous occupant of the slot in favour of the new color */
+    if (entry == NULL) {
+	entry = malloc (sizeof (solid_cache_entry_t));
+	if (unlikely (entry == NULL))
+	    return image;
+    } else {
+	pixman_image_unref (entry->image);
+    }
+    entry->key = key;
+    entry->image = pixman_image_ref (image);
+    solid_cache_put (slot, entry);
 #endif
     return image;
 }
 
+/* The derived data that is costly to compute for a source (filter
+ * kernels, color ramps, rasterized meshes) is kept in a few small caches
+ * shared by all threads.  Each holds the last few entries computed under
+ * its own mutex: once it is full, every insertion replaces the oldest.
+ */
+typedef struct _image_source_cache {
+    cairo_mutex_t *mutex;
+    void (*destroy) (void *entry);
+    int size;
+    int count;
+    int next;
+    void **entries;
+} image_source_cache_t;
+
+#define IMAGE_SOURCE_CACHE_INIT(entries, mutex, destroy) \
+    { &(mutex), (destroy), ARRAY_LENGTH (entries), 0, 0, (entries) }
+
+/* Calls @match on each entry, with the mutex held, until it returns
+ * TRUE, and returns whether it did.  The entry is only valid while the
+ * mutex is held, so @match must take what it needs from it there. */
+static cairo_bool_t
+image_source_cache_lookup (image_source_cache_t *cache,
+			   cairo_bool_t (*match) (void *entry, void *closure),
+			   void *closure)
+{
+    cairo_bool_t found = FALSE;
+    int i;
+
+    CAIRO_MUTEX_LOCK (*cache->mutex);
+    for (i = 0; i < cache->count && ! found; i++)
+	found = match (cache->entries[i], closure);
+    CAIRO_MUTEX_UNLOCK (*cache->mutex);
+
+    return found;
+}
+
+/* Hands @entry over to the cache, evicting the oldest entry if full. */
+static void
+image_source_cache_insert (image_source_cache_t *cache, void *entry)
+{
+    void *evicted = NULL;
+    int i;
+
+    CAIRO_MUTEX_LOCK (*cache->mutex);
+    if (cache->count < cache->size) {
+	i = cache->count++;
+    } else {
+	i = cache->next;
+	cache->next = (i + 1) % cache->size;
+	evicted = cache->entries[i];
+    }
+    cache->entries[i] = entry;
+    CAIRO_MUTEX_UNLOCK (*cache->mutex);
+
+    if (evicted != NULL)
+	cache->destroy (evicted);
+}
+
+static void
+image_source_cache_reset (image_source_cache_t *cache)
+{
+    CAIRO_MUTEX_LOCK (*cache->mutex);
+    while (cache->count)
+	cache->destroy (cache->entries[--cache->count]);
+    cache->next = 0;
+    CAIRO_MUTEX_UNLOCK (*cache->mutex);
+}
+
+static void
+_pixman_reset_convolution_cache (void);
+
+static void
+_pixman_reset_gradient_lut_cache (void);
+
+static void
+_pixman_reset_mesh_cache (void);
 
 void
 _cairo_image_reset_static_data (void)
 {
-#if PIXMAN_HAS_ATOMIC_OPS
-    while (n_cached)
-	pixman_image_unref (cache[--n_cached].image);
+#if HAS_SOLID_CACHE
+    /* (only the calling thread's cache, when they are per-thread) */
+    solid_cache_entry_t **slots = solid_cache_get ();
+    if (slots != NULL)
+	solid_cache_clear (slots);
+#endif
 
+#if PIXMAN_HAS_ATOMIC_OPS
     if (__pixman_transparent_image) {
 	pixman_image_unref (__pixman_transparent_image);
 	__pixman_transparent_image = NULL;
@@ -286,6 +502,341 @@ _cairo_image_reset_static_data (void)
 	__pixman_white_image = NULL;
     }
 #endif
+
+    _pixman_reset_convolution_cache ();
+    _pixman_reset_gradient_lut_cache ();
+    _pixman_reset_mesh_cache ();
+}
+
+/* Rather than have pixman search the color stops for every pixel, linear
+ * and the common concentric radial gradients are rendered from a
+ * precomputed color ramp. The ramps are shared between patterns with
+ * the same stops through a small cache, so redrawing the same gradient
+ * (even from a copy of the pattern) only costs the table lookups.
+ *
+ * The ramp rounds t to one of its entries and interpolates in floating
+ * point, so its colors may differ from pixman's by a level or two. It
+ * is therefore only used when the pattern's filter asks for speed over
+ * quality (CAIRO_FILTER_FAST), while an entry spans no more than a pixel
+ * in device space, and never for hard stops, whose edge would be moved
+ * by the rounding.
+ */
+#define GRADIENT_LUT_SIZE 1024
+#define GRADIENT_LUT_CACHE_SIZE 16
+#define GRADIENT_LUT_MAX_AREA (512 * 512) /* limit the temporary image */
+
+struct gradient_lut {
+    cairo_reference_count_t ref_count;
+    unsigned long hash;
+    cairo_gradient_pattern_t key; /* only n_stops and a copy of the stops */
+    uint32_t colors[GRADIENT_LUT_SIZE];
+};
+
+static void
+gradient_lut_destroy (struct gradient_lut *lut)
+{
+    if (! _cairo_reference_count_dec_and_test (&lut->ref_count))
+	return;
+
+    free (lut->key.stops);
+    free (lut);
+}
+
+static void
+gradient_lut_cache_destroy (void *entry)
+{
+    gradient_lut_destroy (entry);
+}
+
+static void *gradient_lut_cache_entries[GRADIENT_LUT_CACHE_SIZE];
+static image_source_cache_t gradient_lut_cache =
+    IMAGE_SOURCE_CACHE_INIT (gradient_lut_cache_entries,
+			     _cairo_image_gradient_lut_cache_mutex,
+			     gradient_lut_cache_destroy);
+
+struct gradient_lut_match {
+    const cairo_gradient_pattern_t *pattern;
+    unsigned long hash;
+    struct gradient_lut *lut;
+};
+
+static cairo_bool_t
+gradient_lut_match (void *entry, void *closure)
+{
+    struct gradient_lut *lut = entry;
+    struct gradient_lut_match *match = closure;
+
+    if (lut->hash != match->hash ||
+	! _cairo_gradient_color_stops_equal (&lut->key, match->pattern))
+    {
+	return FALSE;
+    }
+
+    _cairo_reference_count_inc (&lut->ref_count);
+    match->lut = lut;
+    return TRUE;
+}
+
+static uint32_t
+gradient_lut_color (const cairo_color_stop_t *c0,
+		    const cairo_color_stop_t *c1,
+		    double f)
+{
+    double a, r, g, b;
+
+    a = c0->alpha + f * (c1->alpha - c0->alpha);
+    r = a * (c0->red + f * (c1->red - c0->red));
+    g = a * (c0->green + f * (c1->green - c0->green));
+    b = a * (c0->blue + f * (c1->blue - c0->blue));
+
+    return (uint32_t) (a * 255. + .5) << 24 |
+	   (uint32_t) (r * 255. + .5) << 16 |
+	   (uint32_t) (g * 255. + .5) << 8 |
+	   (uint32_t) (b * 255. + .5);
+}
+
+static struct gradient_lut *
+gradient_lut_create (const cairo_gradient_pattern_t *pattern,
+		     unsigned long hash)
+{
+    const cairo_gradient_stop_t *stops = pattern->stops;
+    unsigned int n_stops = pattern->n_stops;
+    struct gradient_lut *lut;
+    unsigned int i, k;
+
+    lut = malloc (sizeof (struct gradient_lut));
+    if (unlikely (lut == NULL))
+	return NULL;
+
+    lut->key.stops = _cairo_malloc_ab (n_stops, sizeof (cairo_gradient_stop_t));
+    if (unlikely (lut->key.stops == NULL)) {
+	free (lut);
+	return NULL;
+    }
+    memcpy (lut->key.stops, stops, n_stops * sizeof (cairo_gradient_stop_t));
+    lut->key.n_stops = n_stops;
+    lut->hash = hash;
+    CAIRO_REFERENCE_COUNT_INIT (&lut->ref_count, 1);
+
+    k = 0;
+    for (i = 0; i < GRADIENT_LUT_SIZE; i++) {
+	double t = i / (GRADIENT_LUT_SIZE - 1.);
+
+	if (t <= stops[0].offset) {
+	    lut->colors[i] = gradient_lut_color (&stops[0].color,
+						 &stops[0].color, 0);
+	} else if (t >= stops[n_stops - 1].offset) {
+	    lut->colors[i] = gradient_lut_color (&stops[n_stops - 1].color,
+						 &stops[n_stops - 1].color, 0);
+	} else {
+	    double f;
+
+	    while (t >= stops[k + 1].offset)
+		k++;
+
+	    f = (t - stops[k].offset) / (stops[k + 1].offset - stops[k].offset);
+	    lut->colors[i] = gradient_lut_color (&stops[k].color,
+						 &stops[k + 1].color, f);
+	}
+    }
+
+    return lut;
+}
+
+static struct gradient_lut *
+gradient_lut_get (const cairo_gradient_pattern_t *pattern)
+{
+    struct gradient_lut_match match;
+    struct gradient_lut *lut;
+
+    match.pattern = pattern;
+    match.hash = _cairo_gradient_color_stops_hash (_CAIRO_HASH_INIT_VALUE,
+						   pattern);
+    if (image_source_cache_lookup (&gradient_lut_cache,
+				   gradient_lut_match, &match))
+	return match.lut;
+
+    lut = gradient_lut_create (pattern, match.hash);
+    if (unlikely (lut == NULL))
+	return NULL;
+
+    _cairo_reference_count_inc (&lut->ref_count);
+    image_source_cache_insert (&gradient_lut_cache, lut);
+
+    return lut;
+}
+
+static void
+_pixman_reset_gradient_lut_cache (void)
+{
+    image_source_cache_reset (&gradient_lut_cache);
+}
+
+static inline uint32_t
+gradient_lut_lookup (const uint32_t *colors, double t, cairo_extend_t extend)
+{
+    switch (extend) {
+    case CAIRO_EXTEND_NONE:
+	if (! (t >= 0. && t <= 1.))
+	    return 0;
+	break;
+    case CAIRO_EXTEND_REPEAT:
+	t -= floor (t);
+	break;
+    case CAIRO_EXTEND_REFLECT:
+	t = fmod (fabs (t), 2.);
+	if (t > 1.)
+	    t = 2. - t;
+	break;
+    case CAIRO_EXTEND_PAD:
+    default:
+	break;
+    }
+
+    /* also catches the NaNs and infinities */
+    if (! (t > 0.))
+	t = 0.;
+    else if (t > 1.)
+	t = 1.;
+
+    return colors[(int) (t * (GRADIENT_LUT_SIZE - 1) + .5)];
+}
+
+static cairo_bool_t
+gradient_can_use_lut (const cairo_gradient_pattern_t *pattern,
+		      const cairo_rectangle_int_t *extents)
+{
+    const cairo_matrix_t *m = &pattern->base.matrix;
+    double rate; /* the largest change in t per device pixel */
+    unsigned int i;
+
+    if (pattern->base.filter != CAIRO_FILTER_FAST)
+	return FALSE;
+
+    if (pattern->n_stops == 0)
+	return FALSE;
+
+    if ((int64_t) extents->width * extents->height > GRADIENT_LUT_MAX_AREA)
+	return FALSE;
+
+    for (i = 1; i < pattern->n_stops; i++) {
+	if (pattern->stops[i].offset == pattern->stops[i - 1].offset)
+	    return FALSE;
+    }
+
+    if (pattern->base.type == CAIRO_PATTERN_TYPE_LINEAR) {
+	const cairo_linear_pattern_t *linear = (const cairo_linear_pattern_t *) pattern;
+	double dx = linear->pd2.x - linear->pd1.x;
+	double dy = linear->pd2.y - linear->pd1.y;
+
+	if (dx == 0. && dy == 0.)
+	    return FALSE;
+
+	rate = hypot (m->xx * dx + m->yx * dy, m->xy * dx + m->yy * dy) /
+	       (dx * dx + dy * dy);
+    } else {
+	const cairo_radial_pattern_t *radial = (const cairo_radial_pattern_t *) pattern;
+
+	/* For concentric circles there is a single t for every point,
+	 * otherwise leave the general case to pixman. */
+	if (radial->cd1.center.x != radial->cd2.center.x ||
+	    radial->cd1.center.y != radial->cd2.center.y ||
+	    radial->cd1.radius == radial->cd2.radius)
+	{
+	    return FALSE;
+	}
+
+	/* bounded by the Frobenius norm of the matrix */
+	rate = sqrt (m->xx * m->xx + m->xy * m->xy +
+		     m->yx * m->yx + m->yy * m->yy) /
+	       fabs (radial->cd2.radius - radial->cd1.radius);
+    }
+
+    return rate * (GRADIENT_LUT_SIZE - 1) >= 1.;
+}
+
+static pixman_image_t *
+_pixman_image_for_gradient_lut (const cairo_gradient_pattern_t *pattern,
+				const cairo_rectangle_int_t *extents,
+				int *tx, int *ty)
+{
+    const cairo_matrix_t *m = &pattern->base.matrix;
+    cairo_extend_t extend = pattern->base.extend;
+    struct gradient_lut *lut;
+    pixman_image_t *image;
+    uint8_t *data;
+    int width, height, stride, x, y;
+
+    TRACE ((stderr, "%s\n", __FUNCTION__));
+
+    lut = gradient_lut_get (pattern);
+    if (unlikely (lut == NULL))
+	return NULL;
+
+    *tx = -extents->x;
+    *ty = -extents->y;
+    width = extents->width;
+    height = extents->height;
+
+    image = pixman_image_create_bits (PIXMAN_a8r8g8b8, width, height, NULL, 0);
+    if (unlikely (image == NULL)) {
+	gradient_lut_destroy (lut);
+	return NULL;
+    }
+
+    data = (uint8_t *) pixman_image_get_data (image);
+    stride = pixman_image_get_stride (image);
+
+    if (pattern->base.type == CAIRO_PATTERN_TYPE_LINEAR) {
+	const cairo_linear_pattern_t *linear = (const cairo_linear_pattern_t *) pattern;
+	double dx, dy, scale, dt;
+
+	/* t is the projection onto the gradient vector, which is
+	 * linear in device space and so only needs a step per pixel. */
+	dx = linear->pd2.x - linear->pd1.x;
+	dy = linear->pd2.y - linear->pd1.y;
+	scale = 1. / (dx * dx + dy * dy);
+	dx *= scale;
+	dy *= scale;
+	dt = m->xx * dx + m->yx * dy;
+
+	for (y = 0; y < height; y++) {
+	    uint32_t *row = (uint32_t *) (data + y * stride);
+	    double px = extents->x + .5, py = extents->y + y + .5;
+	    double t;
+
+	    cairo_matrix_transform_point (m, &px, &py);
+	    t = (px - linear->pd1.x) * dx + (py - linear->pd1.y) * dy;
+	    for (x = 0; x < width; x++) {
+		row[x] = gradient_lut_lookup (lut->colors, t, extend);
+		t += dt;
+	    }
+	}
+    } else {
+	const cairo_radial_pattern_t *radial = (const cairo_radial_pattern_t *) pattern;
+	double r1 = radial->cd1.radius;
+	double scale = 1. / (radial->cd2.radius - r1);
+
+	/* the circle through a point at distance d is r(t) = d */
+	for (y = 0; y < height; y++) {
+	    uint32_t *row = (uint32_t *) (data + y * stride);
+	    double px = extents->x + .5, py = extents->y + y + .5;
+
+	    cairo_matrix_transform_point (m, &px, &py);
+	    px -= radial->cd1.center.x;
+	    py -= radial->cd1.center.y;
+	    for (x = 0; x < width; x++) {
+		double t = (sqrt (px * px + py * py) - r1) * scale;
+
+		row[x] = gradient_lut_lookup (lut->colors, t, extend);
+		px += m->xx;
+		py += m->yx;
+	    }
+	}
+    }
+
+    gradient_lut_destroy (lut);
+    return image;
 }
 
 static pixman_image_t *
@@ -305,6 +856,9 @@ _pixman_image_for_gradient (const cairo_gradient_pattern_t *pattern,
 
     TRACE ((stderr, "%s\n", __FUNCTION__));
 
+    if (gradient_can_use_lut (pattern, extents))
+	return _pixman_image_for_gradient_lut (pattern, extents, ix, iy);
+
     if (pattern->n_stops > ARRAY_LENGTH(pixman_stops_static)) {
 	pixman_stops = _cairo_malloc_ab (pattern->n_stops,
 					 sizeof(pixman_gradient_stop_t));
@@ -387,31 +941,179 @@ _pixman_image_for_gradient (const cairo_gradient_pattern_t *pattern,
     return pixman_image;
 }
 
+static void
+_defer_free_cleanup (pixman_image_t *pixman_image,
+		     void *closure)
+{
+    cairo_surface_destroy (closure);
+}
+
+/* Rasterizing a mesh is expensive, and documents tend to paint the same
+ * shading over and over (e.g. on every redraw of a page). Keep the last
+ * few rasterizations, keyed by a copy of the pattern (which includes
+ * its matrix) and the extents they cover.  The cache outlives the
+ * patterns, so it is kept small: at most 4 MiB of pixels, released by
+ * cairo_debug_reset_static_data().
+ */
+#define MESH_CACHE_SIZE 4
+#define MESH_CACHE_MAX_AREA (512 * 512)
+
+struct mesh_cache_entry {
+    unsigned long hash;
+    cairo_pattern_t *pattern;
+    cairo_rectangle_int_t extents;
+    cairo_surface_t *image;
+};
+
+struct mesh_cache_match {
+    const cairo_mesh_pattern_t *pattern;
+    unsigned long hash;
+    const cairo_rectangle_int_t *extents;
+    cairo_surface_t *image;
+};
+
+static void
+mesh_cache_entry_destroy (void *abstract_entry)
+{
+    struct mesh_cache_entry *entry = abstract_entry;
+
+    cairo_pattern_destroy (entry->pattern);
+    cairo_surface_destroy (entry->image);
+    free (entry);
+}
+
+static void *mesh_cache_entries[MESH_CACHE_SIZE];
+static image_source_cache_t mesh_cache =
+    IMAGE_SOURCE_CACHE_INIT (mesh_cache_entries,
+			     _cairo_image_mesh_cache_mutex,
+			     mesh_cache_entry_destroy);
+
+static void
+_pixman_reset_mesh_cache (void)
+{
+    image_source_cache_reset (&mesh_cache);
+}
+
+static cairo_bool_t
+mesh_cache_match (void *abstract_entry, void *closure)
+{
+    struct mesh_cache_entry *entry = abstract_entry;
+    struct mesh_cache_match *match = closure;
+
+    if (entry->hash != match->hash ||
+	entry->extents.x != match->extents->x ||
+	entry->extents.y != match->extents->y ||
+	entry->extents.width != match->extents->width ||
+	entry->extents.height != match->extents->height ||
+	! _cairo_pattern_equal (entry->pattern, &match->pattern->base))
+    {
+	return FALSE;
+    }
+
+    match->image = cairo_surface_reference (entry->image);
+    return TRUE;
+}
+
+static cairo_surface_t *
+mesh_cache_lookup (const cairo_mesh_pattern_t *pattern,
+		   unsigned long hash,
+		   const cairo_rectangle_int_t *extents)
+{
+    struct mesh_cache_match match;
+
+    match.pattern = pattern;
+    match.hash = hash;
+    match.extents = extents;
+    match.image = NULL;
+    image_source_cache_lookup (&mesh_cache, mesh_cache_match, &match);
+
+    return match.image;
+}
+
+static void
+mesh_cache_insert (const cairo_mesh_pattern_t *pattern,
+		   unsigned long hash,
+		   const cairo_rectangle_int_t *extents,
+		   cairo_surface_t *image)
+{
+    struct mesh_cache_entry *entry;
+    cairo_status_t status;
+
+    entry = malloc (sizeof (struct mesh_cache_entry));
+    if (unlikely (entry == NULL))
+	return;
+
+    status = _cairo_pattern_create_copy (&entry->pattern, &pattern->base);
+    if (unlikely (status)) {
+	free (entry);
+	return;
+    }
+
+    entry->hash = hash;
+    entry->extents = *extents;
+    entry->image = cairo_surface_reference (image);
+    image_source_cache_insert (&mesh_cache, entry);
+}
+
 static pixman_image_t *
 _pixman_image_for_mesh (const cairo_mesh_pattern_t *pattern,
 			const cairo_rectangle_int_t *extents,
 			int *tx, int *ty)
 {
-    pixman_image_t *image;
-    int width, height;
+    cairo_image_surface_t *image;
+    pixman_image_t *pixman_image;
+    cairo_bool_t cacheable;
+    unsigned long hash = 0;
 
     TRACE ((stderr, "%s\n", __FUNCTION__));
 
     *tx = -extents->x;
     *ty = -extents->y;
-    width = extents->width;
-    height = extents->height;
 
-    image = pixman_image_create_bits (PIXMAN_a8r8g8b8, width, height, NULL, 0);
-    if (unlikely (image == NULL))
+    cacheable = (int64_t) extents->width * extents->height <= MESH_CACHE_MAX_AREA;
+    image = NULL;
+    if (cacheable) {
+	hash = _cairo_pattern_hash (&pattern->base);
+	image = (cairo_image_surface_t *) mesh_cache_lookup (pattern, hash, extents);
+    }
+
+    if (image == NULL) {
+	image = (cairo_image_surface_t *)
+	    _cairo_image_surface_create_with_pixman_format (NULL,
+							    PIXMAN_a8r8g8b8,
+							    extents->width,
+							    extents->height,
+							    0);
+	if (unlikely (image->base.status)) {
+	    cairo_surface_destroy (&image->base);
+	    return NULL;
+	}
+
+	_cairo_mesh_pattern_rasterize (pattern,
+				       image->data,
+				       image->width, image->height,
+				       image->stride,
+				       *tx, *ty);
+
+	if (cacheable)
+	    mesh_cache_insert (pattern, hash, extents, &image->base);
+    }
+
+    /* The cached pixels are shared, so hand out a separate pixman image */
+    pixman_image = pixman_image_create_bits (image->pixman_format,
+					     image->width,
+					     image->height,
+					     (uint32_t *) image->data,
+					     image->stride);
+    if (unlikely (pixman_image == NULL)) {
+	cairo_surface_destroy (&image->base);
 	return NULL;
+    }
 
-    _cairo_mesh_pattern_rasterize (pattern,
-				   pixman_image_get_data (image),
-				   width, height,
-				   pixman_image_get_stride (image),
-				   *tx, *ty);
-    return image;
+    pixman_image_set_destroy_function (pixman_image,
+				       _defer_free_cleanup,
+				       image);
+    return pixman_image;
 }
 
 struct acquire_source_cleanup {
@@ -432,13 +1134,6 @@ _acquire_source_cleanup (pixman_image_t *pixman_image,
     free (data);
 }
 
-static void
-_defer_free_cleanup (pixman_image_t *pixman_image,
-		     void *closure)
-{
-    cairo_surface_destroy (closure);
-}
-
 static uint16_t
 expand_channel (uint16_t v, uint32_t bits)
 {
@@ -886,6 +1581,109 @@ create_separable_convolution (int *n_values,
     return params;
 }
 
+/* The kernel tables are costly to compute, but a viewer redrawing at the
+ * same zoom level will keep asking for the same ones. So keep the last
+ * few around; as pixman copies the parameters, they are handed out under
+ * the cache mutex and never need to be referenced by the caller.
+ */
+#define CONVOLUTION_CACHE_SIZE 8
+
+struct convolution {
+    kernel_t xfilter, yfilter;
+    double sx, sy;
+    pixman_fixed_t *params;
+    int n_params;
+};
+
+struct convolution_match {
+    struct convolution key;
+    pixman_image_t *pixman_image;
+};
+
+static void
+convolution_destroy (void *entry)
+{
+    struct convolution *convolution = entry;
+
+    free (convolution->params);
+    free (convolution);
+}
+
+static void *convolution_cache_entries[CONVOLUTION_CACHE_SIZE];
+static image_source_cache_t convolution_cache =
+    IMAGE_SOURCE_CACHE_INIT (convolution_cache_entries,
+			     _cairo_image_convolution_cache_mutex,
+			     convolution_destroy);
+
+static cairo_bool_t
+convolution_match (void *entry, void *closure)
+{
+    struct convolution *convolution = entry;
+    struct convolution_match *match = closure;
+
+    if (convolution->xfilter != match->key.xfilter ||
+	convolution->yfilter != match->key.yfilter ||
+	convolution->sx != match->key.sx ||
+	convolution->sy != match->key.sy)
+    {
+	return FALSE;
+    }
+
+    pixman_image_set_filter (match->pixman_image,
+			     PIXMAN_FILTER_SEPARABLE_CONVOLUTION,
+			     convolution->params,
+			     convolution->n_params);
+    return TRUE;
+}
+
+static void
+_pixman_image_set_separable_convolution (pixman_image_t *pixman_image,
+					 kernel_t xfilter,
+					 double sx,
+					 kernel_t yfilter,
+					 double sy)
+{
+    struct convolution_match match;
+    struct convolution *convolution;
+    pixman_fixed_t *params;
+    int n_params;
+
+    match.key.xfilter = xfilter;
+    match.key.yfilter = yfilter;
+    match.key.sx = sx;
+    match.key.sy = sy;
+    match.pixman_image = pixman_image;
+    if (image_source_cache_lookup (&convolution_cache,
+				   convolution_match, &match))
+	return;
+
+    params = create_separable_convolution (&n_params,
+					   xfilter, sx,
+					   yfilter, sy);
+    pixman_image_set_filter (pixman_image,
+			     PIXMAN_FILTER_SEPARABLE_CONVOLUTION,
+			     params, n_params);
+    if (unlikely (params == NULL))
+	return;
+
+    convolution = malloc (sizeof (struct convolution));
+    if (unlikely (convolution == NULL)) {
+	free (params);
+	return;
+    }
+
+    *convolution = match.key;
+    convolution->params = params;
+    convolution->n_params = n_params;
+    image_source_cache_insert (&convolution_cache, convolution);
+}
+
+static void
+_pixman_reset_convolution_cache (void)
+{
+    image_source_cache_reset (&convolution_cache);
+}
+
 /* ========================================================================== */
 
 static cairo_bool_t
@@ -947,6 +1745,8 @@ _pixman_image_set_properties (pixman_image_t *pixman_image,
 	       value could be raised if 2-pass filtering is done */
 	    if (dx > 16.0) dx = 16.0;
 	    if (dy > 16.0) dy = 16.0;
+	    /* (larger downscales of images are first reduced using
+	       a mipmap, see _pixman_image_for_mipmap) */
 	    /* Match the bilinear filter for scales > .75: */
 	    if (dx < 1.0/0.75) dx = 1.0;
 	    if (dy < 1.0/0.75) dy = 1.0;
@@ -987,13 +1787,9 @@ _pixman_image_set_properties (pixman_image_t *pixman_image,
 	}
 
 	if (pixman_filter == PIXMAN_FILTER_SEPARABLE_CONVOLUTION) {
-	    int n_params;
-	    pixman_fixed_t *params;
-	    params = create_separable_convolution
-		(&n_params, kernel, dx, kernel, dy);
-	    pixman_image_set_filter (pixman_image, pixman_filter,
-				     params, n_params);
-	    free (params);
+	    _pixman_image_set_separable_convolution (pixman_image,
+						     kernel, dx,
+						     kernel, dy);
 	} else {
 	    pixman_image_set_filter (pixman_image, pixman_filter, NULL, 0);
 	}
@@ -1213,6 +2009,275 @@ done:
     return pixman_image;
 }
 
+/* ========================================================================== */
+
+/* Heavy downscales with the GOOD and BEST filters would need a larger
+ * convolution than we allow in _pixman_image_set_properties(). Instead
+ * we sample from a box-filtered mipmap of the source, cached as a
+ * snapshot of the image (so that it is discarded as soon as the image is
+ * modified), and only leave the remaining reduction to the convolution.
+ * The same source may be sampled from several threads at once, so the
+ * snapshot is found or attached under _cairo_image_mipmap_mutex and its
+ * levels are built under its own mutex.
+ */
+#define MIPMAP_MIN_SCALE 16.
+#define MIPMAP_MAX_LEVELS 16
+
+struct mipmap {
+    cairo_surface_t base;
+    cairo_mutex_t mutex;
+    int num_levels;
+    cairo_image_surface_t *levels[MIPMAP_MAX_LEVELS];
+};
+
+static cairo_status_t
+mipmap_finish (void *abstract_surface)
+{
+    struct mipmap *mipmap = abstract_surface;
+    int n;
+
+    CAIRO_MUTEX_LOCK (mipmap->mutex);
+    for (n = 0; n < mipmap->num_levels; n++)
+	cairo_surface_destroy (&mipmap->levels[n]->base);
+    mipmap->num_levels = 0;
+    CAIRO_MUTEX_UNLOCK (mipmap->mutex);
+
+    CAIRO_MUTEX_FINI (mipmap->mutex);
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static const cairo_surface_backend_t mipmap_backend  = {
+    CAIRO_INTERNAL_SURFACE_TYPE_NULL,
+    mipmap_finish,
+};
+
+static cairo_bool_t
+mipmap_format_supported (pixman_format_code_t format)
+{
+    switch ((int) format) {
+    case PIXMAN_a8r8g8b8:
+    case PIXMAN_x8r8g8b8:
+    case PIXMAN_a8b8g8r8:
+    case PIXMAN_x8b8g8r8:
+    case PIXMAN_a8:
+	return TRUE;
+    default:
+	return FALSE;
+    }
+}
+
+/* Returns the number of halvings that can be applied to the source before
+ * the pattern's own filter takes over, or 0 if the mipmap is not used. */
+static int
+mipmap_level_for_pattern (const cairo_pattern_t *pattern,
+			  const cairo_image_surface_t *source)
+{
+    int width = source->width, height = source->height;
+    double dx, dy, scale;
+    int level;
+
+    if (pattern->filter != CAIRO_FILTER_GOOD &&
+	pattern->filter != CAIRO_FILTER_BEST)
+	return 0;
+
+    if (! mipmap_format_supported (source->pixman_format))
+	return 0;
+
+    /* see _pixman_image_set_properties() */
+    dx = hypot (pattern->matrix.xx, pattern->matrix.xy);
+    dy = hypot (pattern->matrix.yx, pattern->matrix.yy);
+    if (! (MAX (dx, dy) > MIPMAP_MIN_SCALE))
+	return 0;
+
+    scale = MIN (dx, dy);
+    for (level = 0; level < MIPMAP_MAX_LEVELS && scale >= 2.; level++) {
+	if (width == 1 && height == 1)
+	    break;
+
+	/* an odd size would change the period of the repeat */
+	if ((width & 1 || height & 1) &&
+	    (pattern->extend == CAIRO_EXTEND_REPEAT ||
+	     pattern->extend == CAIRO_EXTEND_REFLECT))
+	    break;
+
+	width = (width + 1) / 2;
+	height = (height + 1) / 2;
+	scale /= 2.;
+    }
+
+    return level;
+}
+
+/* Average each 2x2 block of premultiplied pixels, replicating the last
+ * row and column of odd-sized sources. */
+static void
+mipmap_downsample_8888 (const cairo_image_surface_t *src,
+			cairo_image_surface_t *dst)
+{
+    int x, y;
+
+    for (y = 0; y < dst->height; y++) {
+	const uint32_t *s0, *s1;
+	uint32_t *d;
+
+	s0 = (const uint32_t *) (src->data + 2 * y * src->stride);
+	s1 = s0;
+	if (2 * y + 1 < src->height)
+	    s1 = (const uint32_t *) ((const uint8_t *) s0 + src->stride);
+	d = (uint32_t *) (dst->data + y * dst->stride);
+
+	for (x = 0; x < dst->width; x++) {
+	    int x0 = 2 * x, x1 = x0 + 1 < src->width ? x0 + 1 : x0;
+	    uint32_t rb, ag;
+
+	    rb = (s0[x0] & 0x00ff00ff) + (s0[x1] & 0x00ff00ff) +
+		 (s1[x0] & 0x00ff00ff) + (s1[x1] & 0x00ff00ff) +
+		 0x00020002;
+	    ag = ((s0[x0] >> 8) & 0x00ff00ff) + ((s0[x1] >> 8) & 0x00ff00ff) +
+		 ((s1[x0] >> 8) & 0x00ff00ff) + ((s1[x1] >> 8) & 0x00ff00ff) +
+		 0x00020002;
+	    d[x] = ((rb >> 2) & 0x00ff00ff) | (((ag >> 2) & 0x00ff00ff) << 8);
+	}
+    }
+}
+
+static void
+mipmap_downsample_a8 (const cairo_image_surface_t *src,
+		      cairo_image_surface_t *dst)
+{
+    int x, y;
+
+    for (y = 0; y < dst->height; y++) {
+	const uint8_t *s0, *s1;
+	uint8_t *d;
+
+	s0 = src->data + 2 * y * src->stride;
+	s1 = 2 * y + 1 < src->height ? s0 + src->stride : s0;
+	d = dst->data + y * dst->stride;
+
+	for (x = 0; x < dst->width; x++) {
+	    int x0 = 2 * x, x1 = x0 + 1 < src->width ? x0 + 1 : x0;
+
+	    d[x] = (s0[x0] + s0[x1] + s1[x0] + s1[x1] + 2) >> 2;
+	}
+    }
+}
+
+/* Returns a reference to the given level of the mipmap of @source,
+ * building it and the levels above on first use, or %NULL. */
+static cairo_image_surface_t *
+mipmap_get_level (cairo_image_surface_t *source, int level)
+{
+    struct mipmap *mipmap;
+    cairo_image_surface_t *image = NULL;
+
+    CAIRO_MUTEX_LOCK (_cairo_image_mipmap_mutex);
+    mipmap = (struct mipmap *) _cairo_surface_has_snapshot (&source->base,
+							    &mipmap_backend);
+    if (mipmap == NULL) {
+	mipmap = malloc (sizeof (*mipmap));
+	if (unlikely (mipmap == NULL)) {
+	    CAIRO_MUTEX_UNLOCK (_cairo_image_mipmap_mutex);
+	    return NULL;
+	}
+
+	_cairo_surface_init (&mipmap->base, &mipmap_backend, NULL,
+			     source->base.content);
+	CAIRO_MUTEX_INIT (mipmap->mutex);
+	mipmap->num_levels = 0;
+
+	/* the source holds its own reference; ours is dropped below */
+	_cairo_surface_attach_snapshot (&source->base, &mipmap->base, NULL);
+    } else {
+	cairo_surface_reference (&mipmap->base);
+    }
+    CAIRO_MUTEX_UNLOCK (_cairo_image_mipmap_mutex);
+
+    CAIRO_MUTEX_LOCK (mipmap->mutex);
+    while (mipmap->num_levels < level) {
+	cairo_image_surface_t *src, *dst;
+
+	src = source;
+	if (mipmap->num_levels)
+	    src = mipmap->levels[mipmap->num_levels - 1];
+
+	dst = (cairo_image_surface_t *)
+	    _cairo_image_surface_create_with_pixman_format (NULL,
+							    src->pixman_format,
+							    (src->width + 1) / 2,
+							    (src->height + 1) / 2,
+							    0);
+	if (unlikely (dst->base.status)) {
+	    cairo_surface_destroy (&dst->base);
+	    break;
+	}
+
+	if (PIXMAN_FORMAT_BPP (src->pixman_format) == 32)
+	    mipmap_downsample_8888 (src, dst);
+	else
+	    mipmap_downsample_a8 (src, dst);
+
+	dst->base.is_clear = FALSE;
+	mipmap->levels[mipmap->num_levels++] = dst;
+    }
+    if (mipmap->num_levels >= level)
+	image = (cairo_image_surface_t *)
+	    cairo_surface_reference (&mipmap->levels[level - 1]->base);
+    CAIRO_MUTEX_UNLOCK (mipmap->mutex);
+
+    cairo_surface_destroy (&mipmap->base);
+
+    return image;
+}
+
+static pixman_image_t *
+_pixman_image_for_mipmap (cairo_image_surface_t *source,
+			  const cairo_surface_pattern_t *pattern,
+			  int level,
+			  const cairo_rectangle_int_t *extents,
+			  int *ix, int *iy)
+{
+    cairo_surface_pattern_t level_pattern;
+    cairo_image_surface_t *image;
+    pixman_image_t *pixman_image;
+    cairo_matrix_t scale;
+
+    image = mipmap_get_level (source, level);
+    if (image == NULL)
+	return NULL;
+
+    pixman_image = pixman_image_create_bits (image->pixman_format,
+					     image->width,
+					     image->height,
+					     (uint32_t *) image->data,
+					     image->stride);
+    if (unlikely (pixman_image == NULL)) {
+	cairo_surface_destroy (&image->base);
+	return NULL;
+    }
+
+    /* keep the level alive even if the source is modified meanwhile */
+    pixman_image_set_destroy_function (pixman_image,
+				       _defer_free_cleanup,
+				       image);
+
+    /* map from source pixels to pixels of the level */
+    _cairo_pattern_init_static_copy (&level_pattern.base, &pattern->base);
+    cairo_matrix_init_scale (&scale, 1. / (1 << level), 1. / (1 << level));
+    cairo_matrix_multiply (&level_pattern.base.matrix,
+			   &pattern->base.matrix, &scale);
+
+    if (! _pixman_image_set_properties (pixman_image,
+					&level_pattern.base, extents,
+					ix, iy)) {
+	pixman_image_unref (pixman_image);
+	pixman_image = NULL;
+    }
+
+    return pixman_image;
+}
+
 static pixman_image_t *
 _pixman_image_for_surface (cairo_image_surface_t *dst,
 			   const cairo_surface_pattern_t *pattern,
@@ -1240,6 +2305,7 @@ _pixman_image_for_surface (cairo_image_surface_t *dst,
 	cairo_surface_t *defer_free = NULL;
 	cairo_image_surface_t *source = (cairo_image_surface_t *) pattern->surface;
 	cairo_surface_type_t type;
+	int level;
 
 	if (_cairo_surface_is_snapshot (&source->base)) {
 	    defer_free = _cairo_surface_snapshot_get_target (&source->base);
@@ -1279,6 +2345,16 @@ _pixman_image_for_surface (cairo_image_surface_t *dst,
 		}
 	    }
 
+	    level = mipmap_level_for_pattern (&pattern->base, source);
+	    if (level) {
+		pixman_image = _pixman_image_for_mipmap (source, pattern, level,
+							 extents, ix, iy);
+		if (pixman_image) {
+		    cairo_surface_destroy (defer_free);
+		    return pixman_image;
+		}
+	    }
+
 #if PIXMAN_HAS_ATOMIC_OPS
 	    /* avoid allocating a 'pattern' image if we can reuse the original */
 	    if (extend == CAIRO_EXTEND_NONE &&
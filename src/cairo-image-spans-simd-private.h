@@ -0,0 +1,66 @@
+/* -*- Mode: c; tab-width: 8; c-basic-offset: 4; indent-tabs-mode: t; -*- */
+/* cairo - a vector graphics library with display and print output
+ *
+ * Copyright © 2026 the cairo authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ *
+ * The Initial Developer of the Original Code is the cairo authors.
+ */
+
+#ifndef CAIRO_IMAGE_SPANS_SIMD_PRIVATE_H
+#define CAIRO_IMAGE_SPANS_SIMD_PRIVATE_H
+
+#include "cairo-compiler-private.h"
+#include "cairo-types-private.h"
+
+CAIRO_BEGIN_DECLS
+
+/* Vectorised row kernels for the inplace span renderers in
+ * cairo-image-compositor.c.  Each kernel processes a prefix of the row
+ * whose length is a multiple of its vector width and returns the
+ * number of pixels it consumed; the caller finishes the row with the
+ * scalar code.  The results are bit-identical to the scalar kernels.
+ *
+ *   lerp32_solid:   d = lerp8x4 (pixel, a, d)
+ *   lerp32:         d = lerp8x4 (s, a, d)
+ *   lerp8_opaque:   d = mul8_8 (d, ~a) + mul8_8 (a, pixel)
+ *   lerp8:          the 16-bit lerp of _fill_a8_lerp_spans
+ */
+typedef struct _cairo_image_spans_simd {
+    int (*lerp32_solid) (uint32_t *d, uint32_t pixel, uint8_t a, int len);
+    int (*lerp32) (uint32_t *d, const uint32_t *s, uint8_t a, int len);
+    int (*lerp8_opaque) (uint8_t *d, uint8_t pixel, uint8_t a, int len);
+    int (*lerp8) (uint8_t *d, uint8_t pixel, uint8_t a, int len);
+} cairo_image_spans_simd_t;
+
+/* Returns the best set of kernels for the running CPU, or NULL. */
+cairo_private const cairo_image_spans_simd_t *
+_cairo_image_spans_simd_get (void);
+
+CAIRO_END_DECLS
+
+#endif /* CAIRO_IMAGE_SPANS_SIMD_PRIVATE_H */
@@ -0,0 +1,290 @@
+/* -*- Mode: c; tab-width: 8; c-basic-offset: 4; indent-tabs-mode: t; -*- */
+/* cairo - a vector graphics library with display and print output
+ *
+ * Copyright © 2026 the cairo authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ *
+ * The Initial Developer of the Original Code is the cairo authors.
+ */
+
+#include "cairoint.h"
+
+#include "cairo-image-spans-simd-private.h"
+
+#if defined(__SSE2__)
+#define HAVE_SPANS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if HAVE_SPANS_SSE2 && defined(__GNUC__) && \
+    (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define HAVE_SPANS_AVX2 1
+#include <immintrin.h>
+#define AVX2 __attribute__((target("avx2")))
+#endif
+
+static inline uint8_t
+mul8_8 (uint8_t a, uint8_t b)
+{
+    uint16_t t = a * (uint16_t)b + 0x7f;
+    return ((t >> 8) + t) >> 8;
+}
+
+#if HAVE_SPANS_SSE2
+/* x * a / 255 on unpacked 16-bit channels, rounded as mul8_8() */
+static inline __m128i
+mul8_sse2 (__m128i x, __m128i a)
+{
+    __m128i t = _mm_add_epi16 (_mm_mullo_epi16 (x, a), _mm_set1_epi16 (0x7f));
+    return _mm_srli_epi16 (_mm_add_epi16 (t, _mm_srli_epi16 (t, 8)), 8);
+}
+
+static int
+lerp32_solid_sse2 (uint32_t *d, uint32_t pixel, uint8_t a, int len)
+{
+    const __m128i zero = _mm_setzero_si128 ();
+    __m128i ia = _mm_set1_epi16 (255 - a);
+    __m128i s;
+    int n;
+
+    s = _mm_unpacklo_epi8 (_mm_set1_epi32 (pixel), zero);
+    s = mul8_sse2 (s, _mm_set1_epi16 (a));
+    s = _mm_packus_epi16 (s, s);
+
+    for (n = 0; n + 4 <= len; n += 4) {
+	__m128i v = _mm_loadu_si128 ((__m128i *) (d + n));
+	__m128i lo = mul8_sse2 (_mm_unpacklo_epi8 (v, zero), ia);
+	__m128i hi = mul8_sse2 (_mm_unpackhi_epi8 (v, zero), ia);
+
+	v = _mm_adds_epu8 (_mm_packus_epi16 (lo, hi), s);
+	_mm_storeu_si128 ((__m128i *) (d + n), v);
+    }
+
+    return n;
+}
+
+static int
+lerp32_sse2 (uint32_t *d, const uint32_t *s, uint8_t a, int len)
+{
+    const __m128i zero = _mm_setzero_si128 ();
+    __m128i va = _mm_set1_epi16 (a);
+    __m128i ia = _mm_set1_epi16 (255 - a);
+    int n;
+
+    for (n = 0; n + 4 <= len; n += 4) {
+	__m128i vs = _mm_loadu_si128 ((__m128i *) (s + n));
+	__m128i vd = _mm_loadu_si128 ((__m128i *) (d + n));
+
+	vs = _mm_packus_epi16 (mul8_sse2 (_mm_unpacklo_epi8 (vs, zero), va),
+			       mul8_sse2 (_mm_unpackhi_epi8 (vs, zero), va));
+	vd = _mm_packus_epi16 (mul8_sse2 (_mm_unpacklo_epi8 (vd, zero), ia),
+			       mul8_sse2 (_mm_unpackhi_epi8 (vd, zero), ia));
+	_mm_storeu_si128 ((__m128i *) (d + n), _mm_adds_epu8 (vs, vd));
+    }
+
+    return n;
+}
+
+static int
+lerp8_opaque_sse2 (uint8_t *d, uint8_t pixel, uint8_t a, int len)
+{
+    const __m128i zero = _mm_setzero_si128 ();
+    __m128i ia = _mm_set1_epi16 (255 - a);
+    __m128i s = _mm_set1_epi8 (mul8_8 (a, pixel));
+    int n;
+
+    for (n = 0; n + 16 <= len; n += 16) {
+	__m128i v = _mm_loadu_si128 ((__m128i *) (d + n));
+
+	v = _mm_packus_epi16 (mul8_sse2 (_mm_unpacklo_epi8 (v, zero), ia),
+			      mul8_sse2 (_mm_unpackhi_epi8 (v, zero), ia));
+	_mm_storeu_si128 ((__m128i *) (d + n), _mm_add_epi8 (v, s));
+    }
+
+    return n;
+}
+
+/* Mirrors the 16-bit arithmetic (including wrap-around) of
+ * _fill_a8_lerp_spans exactly. */
+static inline __m128i
+lerp8_sse2_16 (__m128i x, __m128i ia, __m128i p)
+{
+    __m128i t = _mm_add_epi16 (_mm_mullo_epi16 (x, ia), p);
+    return _mm_srli_epi16 (_mm_add_epi16 (t, _mm_srli_epi16 (t, 8)), 8);
+}
+
+static int
+lerp8_sse2 (uint8_t *d, uint8_t pixel, uint8_t a, int len)
+{
+    const __m128i zero = _mm_setzero_si128 ();
+    __m128i ia = _mm_set1_epi16 ((uint16_t) ~a);
+    __m128i p = _mm_set1_epi16 ((uint16_t) (a * pixel + 0x7f));
+    int n;
+
+    for (n = 0; n + 16 <= len; n += 16) {
+	__m128i v = _mm_loadu_si128 ((__m128i *) (d + n));
+
+	v = _mm_packus_epi16 (lerp8_sse2_16 (_mm_unpacklo_epi8 (v, zero), ia, p),
+			      lerp8_sse2_16 (_mm_unpackhi_epi8 (v, zero), ia, p));
+	_mm_storeu_si128 ((__m128i *) (d + n), v);
+    }
+
+    return n;
+}
+
+static const cairo_image_spans_simd_t spans_sse2 = {
+    lerp32_solid_sse2,
+    lerp32_sse2,
+    lerp8_opaque_sse2,
+    lerp8_sse2,
+};
+#endif
+
+#if HAVE_SPANS_AVX2
+/* The AVX2 unpack and pack instructions work within each 128-bit lane,
+ * so unpacking into lo/hi and packing them back preserves pixel order. */
+static inline AVX2 __m256i
+mul8_avx2 (__m256i x, __m256i a)
+{
+    __m256i t = _mm256_add_epi16 (_mm256_mullo_epi16 (x, a), _mm256_set1_epi16 (0x7f));
+    return _mm256_srli_epi16 (_mm256_add_epi16 (t, _mm256_srli_epi16 (t, 8)), 8);
+}
+
+static AVX2 int
+lerp32_solid_avx2 (uint32_t *d, uint32_t pixel, uint8_t a, int len)
+{
+    const __m256i zero = _mm256_setzero_si256 ();
+    __m256i ia = _mm256_set1_epi16 (255 - a);
+    __m256i s;
+    int n;
+
+    s = _mm256_unpacklo_epi8 (_mm256_set1_epi32 (pixel), zero);
+    s = mul8_avx2 (s, _mm256_set1_epi16 (a));
+    s = _mm256_packus_epi16 (s, s);
+
+    for (n = 0; n + 8 <= len; n += 8) {
+	__m256i v = _mm256_loadu_si256 ((__m256i *) (d + n));
+	__m256i lo = mul8_avx2 (_mm256_unpacklo_epi8 (v, zero), ia);
+	__m256i hi = mul8_avx2 (_mm256_unpackhi_epi8 (v, zero), ia);
+
+	v = _mm256_adds_epu8 (_mm256_packus_epi16 (lo, hi), s);
+	_mm256_storeu_si256 ((__m256i *) (d + n), v);
+    }
+
+    return n;
+}
+
+static AVX2 int
+lerp32_avx2 (uint32_t *d, const uint32_t *s, uint8_t a, int len)
+{
+    const __m256i zero = _mm256_setzero_si256 ();
+    __m256i va = _mm256_set1_epi16 (a);
+    __m256i ia = _mm256_set1_epi16 (255 - a);
+    int n;
+
+    for (n = 0; n + 8 <= len; n += 8) {
+	__m256i vs = _mm256_loadu_si256 ((__m256i *) (s + n));
+	__m256i vd = _mm256_loadu_si256 ((__m256i *) (d + n));
+
+	vs = _mm256_packus_epi16 (mul8_avx2 (_mm256_unpacklo_epi8 (vs, zero), va),
+				  mul8_avx2 (_mm256_unpackhi_epi8 (vs, zero), va));
+	vd = _mm256_packus_epi16 (mul8_avx2 (_mm256_unpacklo_epi8 (vd, zero), ia),
+				  mul8_avx2 (_mm256_unpackhi_epi8 (vd, zero), ia));
+	_mm256_storeu_si256 ((__m256i *) (d + n), _mm256_adds_epu8 (vs, vd));
+    }
+
+    return n;
+}
+
+static AVX2 int
+lerp8_opaque_avx2 (uint8_t *d, uint8_t pixel, uint8_t a, int len)
+{
+    const __m256i zero = _mm256_setzero_si256 ();
+    __m256i ia = _mm256_set1_epi16 (255 - a);
+    __m256i s = _mm256_set1_epi8 (mul8_8 (a, pixel));
+    int n;
+
+    for (n = 0; n + 32 <= len; n += 32) {
+	__m256i v = _mm256_loadu_si256 ((__m256i *) (d + n));
+
+	v = _mm256_packus_epi16 (mul8_avx2 (_mm256_unpacklo_epi8 (v, zero), ia),
+				 mul8_avx2 (_mm256_unpackhi_epi8 (v, zero), ia));
+	_mm256_storeu_si256 ((__m256i *) (d + n), _mm256_add_epi8 (v, s));
+    }
+
+    return n;
+}
+
+static inline AVX2 __m256i
+lerp8_avx2_16 (__m256i x, __m256i ia, __m256i p)
+{
+    __m256i t = _mm256_add_epi16 (_mm256_mullo_epi16 (x, ia), p);
+    return _mm256_srli_epi16 (_mm256_add_epi16 (t, _mm256_srli_epi16 (t, 8)), 8);
+}
+
+static AVX2 int
+lerp8_avx2 (uint8_t *d, uint8_t pixel, uint8_t a, int len)
+{
+    const __m256i zero = _mm256_setzero_si256 ();
+    __m256i ia = _mm256_set1_epi16 ((uint16_t) ~a);
+    __m256i p = _mm256_set1_epi16 ((uint16_t) (a * pixel + 0x7f));
+    int n;
+
+    for (n = 0; n + 32 <= len; n += 32) {
+	__m256i v = _mm256_loadu_si256 ((__m256i *) (d + n));
+
+	v = _mm256_packus_epi16 (lerp8_avx2_16 (_mm256_unpacklo_epi8 (v, zero), ia, p),
+				 lerp8_avx2_16 (_mm256_unpackhi_epi8 (v, zero), ia, p));
+	_mm256_storeu_si256 ((__m256i *) (d + n), v);
+    }
+
+    return n;
+}
+
+static const cairo_image_spans_simd_t spans_avx2 = {
+    lerp32_solid_avx2,
+    lerp32_avx2,
+    lerp8_opaque_avx2,
+    lerp8_avx2,
+};
+#endif
+
+const cairo_image_spans_simd_t *
+_cairo_image_spans_simd_get (void)
+{
+#if HAVE_SPANS_AVX2
+    __builtin_cpu_init ();
+    if (__builtin_cpu_supports ("avx2"))
+	return &spans_avx2;
+#endif
+
+#if HAVE_SPANS_SSE2
+    return &spans_sse2;
+#else
+    return NULL;
+#endif
+}
@@ -102,6 +102,20 @@ _cairo_image_spans_compositor_get (void);
 
 #define _cairo_image_default_compositor_get _cairo_image_spans_compositor_get
 
+/* Counters for the glyph caches used by composite_glyphs().  Set
+ * CAIRO_DEBUG_GLYPH_CACHE to have them printed by
+ * cairo_debug_reset_static_data().
+ */
+typedef struct _cairo_image_glyph_cache_stats {
+    int num_shards;
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long lock_waits;
+} cairo_image_glyph_cache_stats_t;
+
+cairo_private void
+_cairo_image_glyph_cache_get_stats (cairo_image_glyph_cache_stats_t *stats);
+
 cairo_private cairo_int_status_t
 _cairo_image_surface_paint (void			*abstract_surface,
 			    cairo_operator_t		 op,
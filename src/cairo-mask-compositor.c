@@ -310,9 +310,14 @@ get_clip_source (const cairo_mask_compositor_t *compositor,
     cairo_rectangle_int_t r;
     cairo_surface_t *surface;
 
-    surface = _cairo_clip_get_image (clip, dst, bounds);
-    if (unlikely (surface->status))
-	return surface;
+    surface = _cairo_clip_mask_cache_lookup (dst, compositor, clip, bounds);
+    if (surface == NULL) {
+	surface = _cairo_clip_get_image (clip, dst, bounds);
+	if (unlikely (surface->status))
+	    return surface;
+
+	_cairo_clip_mask_cache_insert (dst, compositor, clip, bounds, surface);
+    }
 
     _cairo_pattern_init_for_surface (&pattern, surface);
     pattern.base.filter = CAIRO_FILTER_NEAREST;
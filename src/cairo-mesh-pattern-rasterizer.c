@@ -38,6 +38,7 @@
 
 #include "cairo-array-private.h"
 #include "cairo-pattern-private.h"
+#include "cairo-thread-pool-private.h"
 
 /*
  * Rasterizer for mesh patterns.
@@ -441,6 +442,7 @@ intersect_interval (double a, double b, double c, double d)
  * Input: data is the base pointer of the image
  *        width, height are the dimensions of the image
  *        stride is the stride in bytes between adjacent rows
+ *        ymin, ymax delimit the rows that may be modified
  *        x, y are the coordinates of the pixel to be colored
  *        r,g,b,a are the color components of the color to be set
  *
@@ -450,14 +452,15 @@ intersect_interval (double a, double b, double c, double d)
  * stored in the image is assumed to be in CAIRO_FORMAT_ARGB32 (8 bpc,
  * premultiplied).
  *
- * If the pixel to be set is outside the image, this function does
- * nothing.
+ * If the pixel to be set is outside the image or the rows
+ * [ymin, ymax), this function does nothing.
  */
 static inline void
 draw_pixel (unsigned char *data, int width, int height, int stride,
+	    int ymin, int ymax,
 	    int x, int y, uint16_t r, uint16_t g, uint16_t b, uint16_t a)
 {
-    if (likely (0 <= x && 0 <= y && x < width && y < height)) {
+    if (likely (0 <= x && ymin <= y && x < width && y < ymax)) {
 	uint32_t tr, tg, tb, ta;
 
 	/* Premultiply and round */
@@ -481,6 +484,7 @@ draw_pixel (unsigned char *data, int width, int height, int stride,
  * Input: data is the base pointer of the image
  *        width, height are the dimensions of the image
  *        stride is the stride in bytes between adjacent rows
+ *        ymin, ymax delimit the rows that may be modified
  *        ushift is log2(n) if n is the number of desired steps
  *        dxu[i], dyu[i] are the x,y forward differences of the curve
  *        r0,g0,b0,a0 are the color components of the start point
@@ -500,6 +504,7 @@ draw_pixel (unsigned char *data, int width, int height, int stride,
  */
 static inline void
 rasterize_bezier_curve (unsigned char *data, int width, int height, int stride,
+			int ymin, int ymax,
 			int ushift, double dxu[4], double dyu[4],
 			uint16_t r0, uint16_t g0, uint16_t b0, uint16_t a0,
 			uint16_t r3, uint16_t g3, uint16_t b3, uint16_t a3)
@@ -537,7 +542,7 @@ rasterize_bezier_curve (unsigned char *data, int width, int height, int stride,
 	int x = _cairo_fixed_integer_floor (x0 + (xu[0] >> 15) + ((xu[0] >> 14) & 1));
 	int y = _cairo_fixed_integer_floor (y0 + (yu[0] >> 15) + ((yu[0] >> 14) & 1));
 
-	draw_pixel (data, width, height, stride, x, y, r, g, b, a);
+	draw_pixel (data, width, height, stride, ymin, ymax, x, y, r, g, b, a);
 
 	fd_fixed_fwd (xu);
 	fd_fixed_fwd (yu);
@@ -554,6 +559,7 @@ rasterize_bezier_curve (unsigned char *data, int width, int height, int stride,
  * Input: data is the base pointer of the image
  *        width, height are the dimensions of the image
  *        stride is the stride in bytes between adjacent rows
+ *        ymin, ymax delimit the rows that may be modified
  *        p[i] is the i-th node of the Bezier curve
  *        c0[i] is the i-th color component at the start point
  *        c3[i] is the i-th color component at the end point
@@ -574,6 +580,7 @@ rasterize_bezier_curve (unsigned char *data, int width, int height, int stride,
  */
 static void
 draw_bezier_curve (unsigned char *data, int width, int height, int stride,
+		   int ymin, int ymax,
 		   cairo_point_double_t p[4], double c0[4], double c3[4])
 {
     double top, bottom, left, right, steps_sq;
@@ -590,6 +597,10 @@ draw_bezier_curve (unsigned char *data, int width, int height, int stride,
     if (v == OUTSIDE)
 	return;
 
+    /* The rows outside [ymin, ymax) are drawn separately */
+    if (bottom < ymin - 1 || top >= ymax + 1)
+	return;
+
     left = right = p[0].x;
     for (i = 1; i < 4; ++i) {
 	left  = MIN (left,  p[i].x);
@@ -615,8 +626,8 @@ draw_bezier_curve (unsigned char *data, int width, int height, int stride,
 	midc[1] = (c0[1] + c3[1]) * 0.5;
 	midc[2] = (c0[2] + c3[2]) * 0.5;
 	midc[3] = (c0[3] + c3[3]) * 0.5;
-	draw_bezier_curve (data, width, height, stride, first, c0, midc);
-	draw_bezier_curve (data, width, height, stride, second, midc, c3);
+	draw_bezier_curve (data, width, height, stride, ymin, ymax, first, c0, midc);
+	draw_bezier_curve (data, width, height, stride, ymin, ymax, second, midc, c3);
     } else {
 	double xu[4], yu[4];
 	int ushift = sqsteps2shift (steps_sq), k;
@@ -629,7 +640,7 @@ draw_bezier_curve (unsigned char *data, int width, int height, int stride,
 	    fd_down (yu);
 	}
 
-	rasterize_bezier_curve (data, width, height, stride, ushift,
+	rasterize_bezier_curve (data, width, height, stride, ymin, ymax, ushift,
 				xu, yu,
 				_cairo_color_double_to_short (c0[0]),
 				_cairo_color_double_to_short (c0[1]),
@@ -642,7 +653,7 @@ draw_bezier_curve (unsigned char *data, int width, int height, int stride,
 
 	/* Draw the end point, to make sure that we didn't leave it
 	 * out because of rounding */
-	draw_pixel (data, width, height, stride,
+	draw_pixel (data, width, height, stride, ymin, ymax,
 		    _cairo_fixed_integer_floor (_cairo_fixed_from_double (p[3].x)),
 		    _cairo_fixed_integer_floor (_cairo_fixed_from_double (p[3].y)),
 		    _cairo_color_double_to_short (c3[0]),
@@ -658,6 +669,7 @@ draw_bezier_curve (unsigned char *data, int width, int height, int stride,
  * Input: data is the base pointer of the image
  *        width, height are the dimensions of the image
  *        stride is the stride in bytes between adjacent rows
+ *        ymin, ymax delimit the rows that may be modified
  *        vshift is log2(n) if n is the number of desired steps
  *        p[i][j], p[i][j] are the the nodes of the Bezier patch
  *        col[i][j] is the j-th color component of the i-th corner
@@ -693,7 +705,8 @@ draw_bezier_curve (unsigned char *data, int width, int height, int stride,
  * [0,1] (including both extremes).
  */
 static inline void
-rasterize_bezier_patch (unsigned char *data, int width, int height, int stride, int vshift,
+rasterize_bezier_patch (unsigned char *data, int width, int height, int stride,
+			int ymin, int ymax, int vshift,
 			cairo_point_double_t p[4][4], double col[4][4])
 {
     double pv[4][2][4], cstart[4], cend[4], dcstart[4], dcend[4];
@@ -736,7 +749,7 @@ rasterize_bezier_patch (unsigned char *data, int width, int height, int stride,
 	    nodes[i].y = pv[i][1][0];
 	}
 
-	draw_bezier_curve (data, width, height, stride, nodes, cstart, cend);
+	draw_bezier_curve (data, width, height, stride, ymin, ymax, nodes, cstart, cend);
 
 	for (i = 0; i < 4; ++i) {
 	    fd_fwd (pv[i][0]);
@@ -753,6 +766,7 @@ rasterize_bezier_patch (unsigned char *data, int width, int height, int stride,
  * Input: data is the base pointer of the image
  *        width, height are the dimensions of the image
  *        stride is the stride in bytes between adjacent rows
+ *        ymin, ymax delimit the rows that may be modified
  *        p[i][j], p[i][j] are the nodes of the patch
  *        col[i][j] is the j-th color component of the i-th corner
  *
@@ -790,6 +804,7 @@ rasterize_bezier_patch (unsigned char *data, int width, int height, int stride,
  */
 static void
 draw_bezier_patch (unsigned char *data, int width, int height, int stride,
+		   int ymin, int ymax,
 		     cairo_point_double_t p[4][4], double c[4][4])
 {
     double top, bottom, left, right, steps_sq;
@@ -807,6 +822,9 @@ draw_bezier_patch (unsigned char *data, int width, int height, int stride,
     if (v == OUTSIDE)
 	return;
 
+    if (bottom < ymin - 1 || top >= ymax + 1)
+	return;
+
     left = right = p[0][0].x;
     for (i = 0; i < 4; ++i) {
 	for (j= 0; j < 4; ++j) {
@@ -845,7 +863,7 @@ draw_bezier_patch (unsigned char *data, int width, int height, int stride,
 	    subc[3][i] = 0.5 * (c[1][i] + c[3][i]);
 	}
 
-	draw_bezier_patch (data, width, height, stride, first, subc);
+	draw_bezier_patch (data, width, height, stride, ymin, ymax, first, subc);
 
 	for (i = 0; i < 4; ++i) {
 	    subc[0][i] = subc[2][i];
@@ -853,59 +871,32 @@ draw_bezier_patch (unsigned char *data, int width, int height, int stride,
 	    subc[2][i] = c[2][i];
 	    subc[3][i] = c[3][i];
 	}
-	draw_bezier_patch (data, width, height, stride, second, subc);
+	draw_bezier_patch (data, width, height, stride, ymin, ymax, second, subc);
     } else {
-	rasterize_bezier_patch (data, width, height, stride, sqsteps2shift (steps_sq), p, c);
+	rasterize_bezier_patch (data, width, height, stride, ymin, ymax, sqsteps2shift (steps_sq), p, c);
     }
 }
 
-/*
- * Draw a tensor product shading pattern.
- *
- * Input: mesh is the mesh pattern
- *        data is the base pointer of the image
- *        width, height are the dimensions of the image
- *        stride is the stride in bytes between adjacent rows
- *
- * Output: data will be changed to have the pattern drawn on it
- *
- * data is assumed to be clear and its content is assumed to be in
- * CAIRO_FORMAT_ARGB32 (8 bpc, premultiplied).
- *
- * This function can be used to rasterize a PDF type 7 shading (see
- * http://www.adobe.com/devnet/pdf/pdf_reference.html).
- */
-void
-_cairo_mesh_pattern_rasterize (const cairo_mesh_pattern_t *mesh,
-			       void                       *data,
-			       int                         width,
-			       int                         height,
-			       int                         stride,
-			       double                      x_offset,
-			       double                      y_offset)
+static void
+draw_patches (const cairo_mesh_pattern_t *mesh,
+	      const cairo_matrix_t *p2u,
+	      unsigned char *data, int width, int height, int stride,
+	      int ymin, int ymax,
+	      double x_offset, double y_offset)
 {
     cairo_point_double_t nodes[4][4];
     double colors[4][4];
-    cairo_matrix_t p2u;
     unsigned int i, j, k, n;
-    cairo_status_t status;
     const cairo_mesh_patch_t *patch;
     const cairo_color_t *c;
 
-    assert (mesh->base.status == CAIRO_STATUS_SUCCESS);
-    assert (mesh->current_patch == NULL);
-
-    p2u = mesh->base.matrix;
-    status = cairo_matrix_invert (&p2u);
-    assert (status == CAIRO_STATUS_SUCCESS);
-
     n = _cairo_array_num_elements (&mesh->patches);
     patch = _cairo_array_index_const (&mesh->patches, 0);
     for (i = 0; i < n; i++) {
 	for (j = 0; j < 4; j++) {
 	    for (k = 0; k < 4; k++) {
 		nodes[j][k] = patch->points[j][k];
-		cairo_matrix_transform_point (&p2u, &nodes[j][k].x, &nodes[j][k].y);
+		cairo_matrix_transform_point (p2u, &nodes[j][k].x, &nodes[j][k].y);
 		nodes[j][k].x += x_offset;
 		nodes[j][k].y += y_offset;
 	    }
@@ -935,7 +926,117 @@ _cairo_mesh_pattern_rasterize (const cairo_mesh_pattern_t *mesh,
 	colors[3][2] = c->blue;
 	colors[3][3] = c->alpha;
 
-	draw_bezier_patch (data, width, height, stride, nodes, colors);
+	draw_bezier_patch (data, width, height, stride, ymin, ymax, nodes, colors);
 	patch++;
     }
 }
+
+/*
+ * Patches are drawn in order, each overwriting the previous ones, so
+ * the image is split into bands of rows which each draw all the patches.
+ * Every band makes the same splitting decisions (those only depend on
+ * the full image), so the result does not depend on the number of bands.
+ */
+#define BAND_MIN_HEIGHT 32
+
+typedef struct _mesh_band {
+    const cairo_mesh_pattern_t *mesh;
+    const cairo_matrix_t *p2u;
+    unsigned char *data;
+    int width, height, stride;
+    int ymin, ymax;
+    double x_offset, y_offset;
+} mesh_band_t;
+
+static void
+draw_band (void *closure)
+{
+    mesh_band_t *band = closure;
+
+    draw_patches (band->mesh, band->p2u,
+		  band->data, band->width, band->height, band->stride,
+		  band->ymin, band->ymax,
+		  band->x_offset, band->y_offset);
+}
+
+/*
+ * Draw a tensor product shading pattern.
+ *
+ * Input: mesh is the mesh pattern
+ *        data is the base pointer of the image
+ *        width, height are the dimensions of the image
+ *        stride is the stride in bytes between adjacent rows
+ *
+ * Output: data will be changed to have the pattern drawn on it
+ *
+ * data is assumed to be clear and its content is assumed to be in
+ * CAIRO_FORMAT_ARGB32 (8 bpc, premultiplied).
+ *
+ * This function can be used to rasterize a PDF type 7 shading (see
+ * http://www.adobe.com/devnet/pdf/pdf_reference.html).
+ */
+void
+_cairo_mesh_pattern_rasterize (const cairo_mesh_pattern_t *mesh,
+			       void                       *data,
+			       int                         width,
+			       int                         height,
+			       int                         stride,
+			       double                      x_offset,
+			       double                      y_offset)
+{
+    cairo_matrix_t p2u;
+    cairo_status_t status;
+    mesh_band_t bands_stack[16], *bands = bands_stack;
+    int num_threads, num_bands, i, y;
+
+    assert (mesh->base.status == CAIRO_STATUS_SUCCESS);
+    assert (mesh->current_patch == NULL);
+
+    p2u = mesh->base.matrix;
+    status = cairo_matrix_invert (&p2u);
+    assert (status == CAIRO_STATUS_SUCCESS);
+
+    num_bands = 1;
+    num_threads = _cairo_thread_pool_get_num_threads ();
+    if (num_threads > 1 && height >= 2 * BAND_MIN_HEIGHT) {
+	/* oversubscribe a little to even out the load between bands */
+	num_bands = 2 * num_threads;
+	if (num_bands > height / BAND_MIN_HEIGHT)
+	    num_bands = height / BAND_MIN_HEIGHT;
+	if (num_bands > ARRAY_LENGTH (bands_stack)) {
+	    bands = _cairo_malloc_ab (num_bands, sizeof (mesh_band_t));
+	    if (unlikely (bands == NULL)) {
+		bands = bands_stack;
+		num_bands = 1;
+	    }
+	}
+    }
+
+    if (num_bands <= 1) {
+	draw_patches (mesh, &p2u, data, width, height, stride,
+		      0, height, x_offset, y_offset);
+	return;
+    }
+
+    y = 0;
+    for (i = 0; i < num_bands; i++) {
+	mesh_band_t *band = &bands[i];
+
+	band->mesh = mesh;
+	band->p2u = &p2u;
+	band->data = data;
+	band->width = width;
+	band->height = height;
+	band->stride = stride;
+	band->x_offset = x_offset;
+	band->y_offset = y_offset;
+	band->ymin = y;
+	y += (height - y) / (num_bands - i);
+	band->ymax = y;
+    }
+
+    _cairo_thread_pool_run (draw_band, bands, sizeof (mesh_band_t), num_bands);
+
+    if (bands != bands_stack)
+	free (bands);
+}
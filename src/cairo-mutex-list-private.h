@@ -38,7 +38,11 @@
 
 CAIRO_MUTEX_DECLARE (_cairo_pattern_solid_surface_cache_lock)
 
-CAIRO_MUTEX_DECLARE (_cairo_image_solid_cache_mutex)
+CAIRO_MUTEX_DECLARE (_cairo_image_convolution_cache_mutex)
+CAIRO_MUTEX_DECLARE (_cairo_image_gradient_lut_cache_mutex)
+CAIRO_MUTEX_DECLARE (_cairo_image_mesh_cache_mutex)
+CAIRO_MUTEX_DECLARE (_cairo_image_mipmap_mutex)
+CAIRO_MUTEX_DECLARE (_cairo_path_cache_mutex)
 
 CAIRO_MUTEX_DECLARE (_cairo_toy_font_face_mutex)
 CAIRO_MUTEX_DECLARE (_cairo_intern_string_mutex)
@@ -194,8 +194,24 @@ cairo_private cairo_output_stream_t *
 _cairo_base64_stream_create (cairo_output_stream_t *output);
 
 /* cairo-deflate-stream.c */
+
+/* Compression levels follow zlib: 0 stores, 1 is fastest, 9 is smallest. */
+#define CAIRO_DEFLATE_LEVEL_DEFAULT 6
+
 cairo_private cairo_output_stream_t *
 _cairo_deflate_stream_create (cairo_output_stream_t *output);
 
+cairo_private cairo_output_stream_t *
+_cairo_deflate_stream_create_with_level (cairo_output_stream_t *output,
+					 int			level);
+
+/* Compresses all of @data in one pass into a newly allocated buffer. */
+cairo_private cairo_status_t
+_cairo_deflate_compress (const unsigned char	 *data,
+			 unsigned long		  length,
+			 int			  level,
+			 unsigned char		**compressed_out,
+			 unsigned long		 *compressed_length_out);
+
 
 #endif /* CAIRO_OUTPUT_STREAM_PRIVATE_H */
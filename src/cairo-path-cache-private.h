@@ -0,0 +1,63 @@
+/* -*- Mode: c; tab-width: 8; c-basic-offset: 4; indent-tabs-mode: t; -*- */
+/* cairo - a vector graphics library with display and print output
+ *
+ * Copyright © 2026 the cairo authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ *
+ * The Initial Developer of the Original Code is the cairo authors.
+ */
+
+#ifndef CAIRO_PATH_CACHE_PRIVATE_H
+#define CAIRO_PATH_CACHE_PRIVATE_H
+
+#include "cairo-compiler-private.h"
+#include "cairo-path-fixed-private.h"
+#include "cairo-spans-private.h"
+
+CAIRO_BEGIN_DECLS
+
+/* Returns a scan converter generating the coverage of filling @path
+ * within @extents, from the global path cache (see
+ * cairo_path_cache_set_max_size()). The coverage is computed and added
+ * to the cache on first use; it is shared by all fills of the same
+ * path translated by whole pixels.
+ *
+ * Returns %NULL if the cache is disabled or unsuitable for @path, in
+ * which case the caller should tessellate the path itself. */
+cairo_private cairo_scan_converter_t *
+_cairo_path_cache_scan_converter_create (const cairo_path_fixed_t *path,
+					 cairo_fill_rule_t fill_rule,
+					 double tolerance,
+					 cairo_antialias_t antialias,
+					 const cairo_rectangle_int_t *extents);
+
+cairo_private void
+_cairo_path_cache_reset_static_data (void);
+
+CAIRO_END_DECLS
+
+#endif /* CAIRO_PATH_CACHE_PRIVATE_H */
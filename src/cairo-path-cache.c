@@ -0,0 +1,456 @@
+/* -*- Mode: c; tab-width: 8; c-basic-offset: 4; indent-tabs-mode: t; -*- */
+/* cairo - a vector graphics library with display and print output
+ *
+ * Copyright © 2026 the cairo authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ *
+ * The Initial Developer of the Original Code is the cairo authors.
+ */
+
+/* A cache of the coverage masks of filled paths.
+ *
+ * Paths reach the backends in device space, so a symbol drawn at many
+ * positions is a different path each time. The cache key is therefore
+ * the path translated such that the top-left of its extents lies
+ * within the first pixel, together with the fill rule, tolerance and
+ * antialiasing mode; the fractional part of the position is kept, so a
+ * hit generates exactly the coverage that rasterising the path again
+ * would. Any other transformation changes the path and so the key.
+ *
+ * Only small paths are cached, and the cache is disabled until given a
+ * budget with cairo_path_cache_set_max_size().
+ */
+
+#include "cairoint.h"
+
+#include "cairo-cache-private.h"
+#include "cairo-error-private.h"
+#include "cairo-path-cache-private.h"
+#include "cairo-path-fixed-private.h"
+
+/* The largest coverage mask that is cached, in pixels */
+#define CAIRO_PATH_CACHE_MAX_AREA (256 * 256)
+
+typedef struct _cairo_path_cache_entry {
+    cairo_cache_entry_t base;
+    cairo_reference_count_t ref_count;
+
+    cairo_path_fixed_t path; /* translated into the first pixel */
+    cairo_fill_rule_t fill_rule;
+    cairo_antialias_t antialias;
+    double tolerance;
+
+    int width, height;
+    uint8_t *coverage; /* width x height, following the entry */
+} cairo_path_cache_entry_t;
+
+typedef struct _cairo_path_cache_converter {
+    cairo_scan_converter_t base;
+
+    cairo_path_cache_entry_t *entry;
+    int x, y; /* the position of the coverage in device space */
+    cairo_rectangle_int_t extents;
+
+    cairo_half_open_span_t spans[1];
+} cairo_path_cache_converter_t;
+
+typedef struct _coverage_renderer {
+    cairo_span_renderer_t base;
+
+    uint8_t *data;
+    int width;
+} coverage_renderer_t;
+
+static cairo_cache_t path_cache;
+static cairo_bool_t path_cache_initialized;
+static unsigned long path_cache_max_size;
+
+static void
+_cairo_path_cache_entry_destroy (void *closure)
+{
+    cairo_path_cache_entry_t *entry = closure;
+
+    assert (CAIRO_REFERENCE_COUNT_HAS_REFERENCE (&entry->ref_count));
+    if (! _cairo_reference_count_dec_and_test (&entry->ref_count))
+	return;
+
+    _cairo_path_fixed_fini (&entry->path);
+    free (entry);
+}
+
+static cairo_bool_t
+_cairo_path_cache_keys_equal (const void *key_a, const void *key_b)
+{
+    const cairo_path_cache_entry_t *a = key_a;
+    const cairo_path_cache_entry_t *b = key_b;
+
+    return a->fill_rule == b->fill_rule &&
+	   a->antialias == b->antialias &&
+	   a->tolerance == b->tolerance &&
+	   _cairo_path_fixed_equal (&a->path, &b->path);
+}
+
+static cairo_status_t
+_coverage_renderer_render_rows (void *abstract_renderer,
+				int y, int height,
+				const cairo_half_open_span_t *spans,
+				unsigned num_spans)
+{
+    coverage_renderer_t *r = abstract_renderer;
+    uint8_t *row;
+    unsigned i;
+
+    if (num_spans == 0)
+	return CAIRO_STATUS_SUCCESS;
+
+    row = r->data + y * r->width;
+    for (i = 0; i + 1 < num_spans; i++) {
+	if (spans[i].coverage)
+	    memset (row + spans[i].x, spans[i].coverage,
+		    spans[i+1].x - spans[i].x);
+    }
+
+    while (--height) {
+	memcpy (row + r->width, row, r->width);
+	row += r->width;
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* Rasterise the (translated) path of @entry into its coverage mask,
+ * using the same scan converter as the spans compositor would. */
+static cairo_status_t
+_cairo_path_cache_entry_rasterize (cairo_path_cache_entry_t *entry)
+{
+    cairo_scan_converter_t *converter;
+    cairo_scan_converter_add_polygon_func_t add_polygon;
+    coverage_renderer_t renderer;
+    cairo_polygon_t polygon;
+    cairo_status_t status;
+
+    _cairo_polygon_init (&polygon, NULL, 0);
+    status = _cairo_path_fixed_fill_to_polygon (&entry->path,
+						entry->tolerance,
+						&polygon);
+    if (unlikely (status))
+	goto FINI;
+
+    converter = _cairo_scan_converter_create_for_antialias (0, 0,
+							    entry->width,
+							    entry->height,
+							    entry->fill_rule,
+							    entry->antialias,
+							    &add_polygon);
+    status = add_polygon (converter, &polygon);
+    if (likely (status == CAIRO_STATUS_SUCCESS)) {
+	renderer.base.render_rows = _coverage_renderer_render_rows;
+	renderer.data = entry->coverage;
+	renderer.width = entry->width;
+	status = converter->generate (converter, &renderer.base);
+    }
+    converter->destroy (converter);
+
+FINI:
+    _cairo_polygon_fini (&polygon);
+    return status;
+}
+
+static cairo_path_cache_entry_t *
+_cairo_path_cache_entry_create (const cairo_path_cache_entry_t *key)
+{
+    cairo_path_cache_entry_t *entry;
+    cairo_status_t status;
+    size_t area;
+
+    area = (size_t) key->width * key->height;
+    entry = _cairo_malloc (sizeof (cairo_path_cache_entry_t) + area);
+    if (unlikely (entry == NULL))
+	return NULL;
+
+    status = _cairo_path_fixed_init_copy (&entry->path, &key->path);
+    if (unlikely (status)) {
+	free (entry);
+	return NULL;
+    }
+
+    entry->base.hash = key->base.hash;
+    entry->base.size = sizeof (cairo_path_cache_entry_t) + area +
+		       _cairo_path_fixed_size (&entry->path);
+    CAIRO_REFERENCE_COUNT_INIT (&entry->ref_count, 1);
+    entry->fill_rule = key->fill_rule;
+    entry->antialias = key->antialias;
+    entry->tolerance = key->tolerance;
+    entry->width = key->width;
+    entry->height = key->height;
+    entry->coverage = (uint8_t *) (entry + 1);
+    memset (entry->coverage, 0, area);
+
+    status = _cairo_path_cache_entry_rasterize (entry);
+    if (unlikely (status)) {
+	_cairo_path_cache_entry_destroy (entry);
+	return NULL;
+    }
+
+    return entry;
+}
+
+static cairo_status_t
+_cairo_path_cache_converter_generate (void			*abstract_converter,
+				      cairo_span_renderer_t	*renderer)
+{
+    cairo_path_cache_converter_t *self = abstract_converter;
+    const cairo_path_cache_entry_t *entry = self->entry;
+    cairo_half_open_span_t *spans = self->spans;
+    int x0 = self->extents.x - self->x;
+    int x1 = x0 + self->extents.width;
+    int y, y_end;
+
+    y_end = self->extents.y + self->extents.height;
+    for (y = self->extents.y; y < y_end; ) {
+	const uint8_t *row = entry->coverage + (y - self->y) * entry->width;
+	unsigned num_spans;
+	uint8_t last;
+	int x, height;
+	cairo_status_t status;
+
+	/* Coalesce identical rows */
+	height = 1;
+	while (y + height < y_end &&
+	       memcmp (row + x0, row + height * entry->width + x0, x1 - x0) == 0)
+	{
+	    height++;
+	}
+
+	num_spans = 0;
+	last = 0;
+	for (x = x0; x < x1; x++) {
+	    if (row[x] != last) {
+		spans[num_spans].x = x + self->x;
+		spans[num_spans].coverage = row[x];
+		last = row[x];
+		num_spans++;
+	    }
+	}
+	if (last) {
+	    spans[num_spans].x = x1 + self->x;
+	    spans[num_spans].coverage = 0;
+	    num_spans++;
+	}
+
+	if (num_spans) {
+	    status = renderer->render_rows (renderer, y, height,
+					    spans, num_spans);
+	    if (unlikely (status))
+		return status;
+	}
+
+	y += height;
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static void
+_cairo_path_cache_converter_destroy (void *abstract_converter)
+{
+    cairo_path_cache_converter_t *self = abstract_converter;
+
+    _cairo_path_cache_entry_destroy (self->entry);
+    free (self);
+}
+
+cairo_scan_converter_t *
+_cairo_path_cache_scan_converter_create (const cairo_path_fixed_t *path,
+					 cairo_fill_rule_t fill_rule,
+					 double tolerance,
+					 cairo_antialias_t antialias,
+					 const cairo_rectangle_int_t *extents)
+{
+    cairo_path_cache_converter_t *self;
+    cairo_path_cache_entry_t key, *entry;
+    cairo_rectangle_int_t rect;
+    cairo_status_t status;
+    int dx, dy;
+
+    if (path_cache_max_size == 0)
+	return NULL;
+
+    if (path->fill_is_empty)
+	return NULL;
+
+    dx = _cairo_fixed_integer_floor (path->extents.p1.x);
+    dy = _cairo_fixed_integer_floor (path->extents.p1.y);
+    key.width = _cairo_fixed_integer_ceil (path->extents.p2.x) - dx;
+    key.height = _cairo_fixed_integer_ceil (path->extents.p2.y) - dy;
+    if (key.width <= 0 || key.height <= 0 ||
+	key.width > CAIRO_PATH_CACHE_MAX_AREA / key.height)
+    {
+	return NULL;
+    }
+
+    rect.x = dx;
+    rect.y = dy;
+    rect.width = key.width;
+    rect.height = key.height;
+    if (! _cairo_rectangle_intersect (&rect, extents))
+	return NULL;
+
+    status = _cairo_path_fixed_init_copy (&key.path, path);
+    if (unlikely (status))
+	return NULL;
+
+    _cairo_path_fixed_translate (&key.path,
+				 _cairo_fixed_from_int (-dx),
+				 _cairo_fixed_from_int (-dy));
+    key.fill_rule = fill_rule;
+    key.antialias = antialias;
+    key.tolerance = tolerance;
+
+    key.base.hash = _cairo_path_fixed_hash (&key.path);
+    key.base.hash = _cairo_hash_bytes (key.base.hash,
+				       &fill_rule, sizeof (fill_rule));
+    key.base.hash = _cairo_hash_bytes (key.base.hash,
+				       &antialias, sizeof (antialias));
+    key.base.hash = _cairo_hash_bytes (key.base.hash,
+				       &tolerance, sizeof (tolerance));
+
+    CAIRO_MUTEX_LOCK (_cairo_path_cache_mutex);
+    entry = NULL;
+    if (path_cache_initialized) {
+	entry = _cairo_cache_lookup (&path_cache, &key.base);
+	if (entry != NULL)
+	    _cairo_reference_count_inc (&entry->ref_count);
+    }
+    CAIRO_MUTEX_UNLOCK (_cairo_path_cache_mutex);
+
+    if (entry == NULL) {
+	/* Rasterise outside of the lock; should another thread get
+	 * there first, the loser's entry is simply not cached. */
+	entry = _cairo_path_cache_entry_create (&key);
+	if (entry != NULL) {
+	    CAIRO_MUTEX_LOCK (_cairo_path_cache_mutex);
+	    if (! path_cache_initialized && path_cache_max_size) {
+		status = _cairo_cache_init (&path_cache,
+					    _cairo_path_cache_keys_equal,
+					    NULL,
+					    _cairo_path_cache_entry_destroy,
+					    path_cache_max_size);
+		path_cache_initialized = status == CAIRO_STATUS_SUCCESS;
+	    }
+	    if (path_cache_initialized &&
+		entry->base.size <= path_cache.max_size &&
+		_cairo_cache_lookup (&path_cache, &key.base) == NULL)
+	    {
+		_cairo_reference_count_inc (&entry->ref_count);
+		if (_cairo_cache_insert (&path_cache, &entry->base))
+		    _cairo_reference_count_dec (&entry->ref_count);
+	    }
+	    CAIRO_MUTEX_UNLOCK (_cairo_path_cache_mutex);
+	}
+    }
+    _cairo_path_fixed_fini (&key.path);
+
+    if (entry == NULL)
+	return NULL;
+
+    self = _cairo_malloc_ab_plus_c (rect.width + 1,
+				    sizeof (cairo_half_open_span_t),
+				    sizeof (cairo_path_cache_converter_t));
+    if (unlikely (self == NULL)) {
+	_cairo_path_cache_entry_destroy (entry);
+	return NULL;
+    }
+
+    self->base.destroy = _cairo_path_cache_converter_destroy;
+    self->base.generate = _cairo_path_cache_converter_generate;
+    self->base.status = CAIRO_STATUS_SUCCESS;
+
+    self->entry = entry;
+    self->x = dx;
+    self->y = dy;
+    self->extents = rect;
+
+    return &self->base;
+}
+
+void
+_cairo_path_cache_reset_static_data (void)
+{
+    CAIRO_MUTEX_LOCK (_cairo_path_cache_mutex);
+    if (path_cache_initialized) {
+	_cairo_cache_fini (&path_cache);
+	path_cache_initialized = FALSE;
+    }
+    CAIRO_MUTEX_UNLOCK (_cairo_path_cache_mutex);
+}
+
+/**
+ * cairo_path_cache_set_max_size:
+ * @max_size: the new budget in bytes
+ *
+ * Sets the number of bytes that may be used to cache the coverage of
+ * filled paths, shared by all image surfaces. The cache benefits
+ * drawing the same small shape many times over, such as the markers
+ * on a map, as long as the shapes differ only by a translation by
+ * whole pixels: each such fill then need only be composited.
+ *
+ * The cache is disabled, with a budget of 0, by default. Reducing the
+ * budget releases the entries over it.
+ *
+ * Since: 1.16
+ **/
+void
+cairo_path_cache_set_max_size (unsigned long max_size)
+{
+    CAIRO_MUTEX_INITIALIZE ();
+
+    CAIRO_MUTEX_LOCK (_cairo_path_cache_mutex);
+    path_cache_max_size = max_size;
+    if (path_cache_initialized) {
+	path_cache.max_size = max_size;
+	_cairo_cache_freeze (&path_cache);
+	_cairo_cache_thaw (&path_cache);
+    }
+    CAIRO_MUTEX_UNLOCK (_cairo_path_cache_mutex);
+}
+
+/**
+ * cairo_path_cache_get_max_size:
+ *
+ * Returns the budget of the path cache, as set by
+ * cairo_path_cache_set_max_size().
+ *
+ * Return value: the budget in bytes, or 0 if the cache is disabled.
+ *
+ * Since: 1.16
+ **/
+unsigned long
+cairo_path_cache_get_max_size (void)
+{
+    return path_cache_max_size;
+}
@@ -38,6 +38,7 @@
 
 #include "cairo-types-private.h"
 #include "cairo-compiler-private.h"
+#include "cairo-arena-private.h"
 #include "cairo-list-private.h"
 
 #define WATCH_PATH 0
@@ -82,6 +83,8 @@ typedef struct _cairo_path_buf {
 
     cairo_path_op_t *op;
     cairo_point_t *points;
+
+    cairo_bool_t in_arena; /* owned by an arena rather than malloc'd */
 } cairo_path_buf_t;
 
 typedef struct _cairo_path_buf_fixed {
@@ -115,6 +118,11 @@ struct _cairo_path_fixed {
     cairo_path_buf_fixed_t  buf;
 };
 
+cairo_private cairo_status_t
+_cairo_path_fixed_init_copy_in_arena (cairo_path_fixed_t *path,
+				      const cairo_path_fixed_t *other,
+				      cairo_arena_t *arena);
+
 cairo_private void
 _cairo_path_fixed_translate (cairo_path_fixed_t *path,
 			     cairo_fixed_t offx,
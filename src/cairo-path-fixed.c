@@ -55,7 +55,7 @@ _cairo_path_fixed_add_buf (cairo_path_fixed_t *path,
 			   cairo_path_buf_t   *buf);
 
 static cairo_path_buf_t *
-_cairo_path_buf_create (int size_ops, int size_points);
+_cairo_path_buf_create (cairo_arena_t *arena, int size_ops, int size_points);
 
 static void
 _cairo_path_buf_destroy (cairo_path_buf_t *buf);
@@ -100,9 +100,10 @@ _cairo_path_fixed_init (cairo_path_fixed_t *path)
     path->extents.p2.x = path->extents.p2.y = 0;
 }
 
-cairo_status_t
-_cairo_path_fixed_init_copy (cairo_path_fixed_t *path,
-			     const cairo_path_fixed_t *other)
+static cairo_status_t
+_cairo_path_fixed_init_copy_internal (cairo_path_fixed_t *path,
+				      const cairo_path_fixed_t *other,
+				      cairo_arena_t *arena)
 {
     cairo_path_buf_t *buf, *other_buf;
     unsigned int num_points, num_ops;
@@ -147,7 +148,7 @@ _cairo_path_fixed_init_copy (cairo_path_fixed_t *path,
     }
 
     if (num_ops) {
-	buf = _cairo_path_buf_create (num_ops, num_points);
+	buf = _cairo_path_buf_create (arena, num_ops, num_points);
 	if (unlikely (buf == NULL)) {
 	    _cairo_path_fixed_fini (path);
 	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
@@ -172,6 +173,24 @@ _cairo_path_fixed_init_copy (cairo_path_fixed_t *path,
     return CAIRO_STATUS_SUCCESS;
 }
 
+cairo_status_t
+_cairo_path_fixed_init_copy (cairo_path_fixed_t *path,
+			     const cairo_path_fixed_t *other)
+{
+    return _cairo_path_fixed_init_copy_internal (path, other, NULL);
+}
+
+/* As _cairo_path_fixed_init_copy(), but the buffers holding the copy
+ * are allocated from @arena, and so belong to it rather than to @path.
+ * The path must be finished before the arena. */
+cairo_status_t
+_cairo_path_fixed_init_copy_in_arena (cairo_path_fixed_t *path,
+				      const cairo_path_fixed_t *other,
+				      cairo_arena_t *arena)
+{
+    return _cairo_path_fixed_init_copy_internal (path, other, arena);
+}
+
 unsigned long
 _cairo_path_fixed_hash (const cairo_path_fixed_t *path)
 {
@@ -700,7 +719,7 @@ _cairo_path_fixed_add (cairo_path_fixed_t   *path,
     if (buf->num_ops + 1 > buf->size_ops ||
 	buf->num_points + num_points > buf->size_points)
     {
-	buf = _cairo_path_buf_create (buf->num_ops * 2, buf->num_points * 2);
+	buf = _cairo_path_buf_create (NULL, buf->num_ops * 2, buf->num_points * 2);
 	if (unlikely (buf == NULL))
 	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
 
@@ -759,14 +778,24 @@ _cairo_path_fixed_add_buf (cairo_path_fixed_t *path,
 
 COMPILE_TIME_ASSERT (sizeof (cairo_path_op_t) == 1);
 static cairo_path_buf_t *
-_cairo_path_buf_create (int size_ops, int size_points)
+_cairo_path_buf_create (cairo_arena_t *arena, int size_ops, int size_points)
 {
     cairo_path_buf_t *buf;
 
     /* adjust size_ops to ensure that buf->points is naturally aligned */
     size_ops += sizeof (double) - ((sizeof (cairo_path_buf_t) + size_ops) % sizeof (double));
-    buf = _cairo_malloc_ab_plus_c (size_points, sizeof (cairo_point_t), size_ops + sizeof (cairo_path_buf_t));
+    if (arena != NULL) {
+	if (size_points > INT32_MAX / (int) sizeof (cairo_point_t))
+	    return NULL;
+
+	buf = _cairo_arena_alloc (arena,
+				  sizeof (cairo_path_buf_t) + size_ops +
+				  size_points * sizeof (cairo_point_t));
+    } else {
+	buf = _cairo_malloc_ab_plus_c (size_points, sizeof (cairo_point_t), size_ops + sizeof (cairo_path_buf_t));
+    }
     if (buf) {
+	buf->in_arena = arena != NULL;
 	buf->num_ops = 0;
 	buf->num_points = 0;
 	buf->size_ops = size_ops;
@@ -782,7 +811,8 @@ _cairo_path_buf_create (int size_ops, int size_points)
 static void
 _cairo_path_buf_destroy (cairo_path_buf_t *buf)
 {
-    free (buf);
+    if (! buf->in_arena)
+	free (buf);
 }
 
 static void
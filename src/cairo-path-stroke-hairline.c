@@ -0,0 +1,1186 @@
+/* -*- Mode: c; tab-width: 8; c-basic-offset: 4; indent-tabs-mode: t; -*- */
+/* cairo - a vector graphics library with display and print output
+ *
+ * Copyright © 2026 the cairo authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ *
+ * The Initial Developer of the Original Code is the cairo authors.
+ */
+
+/* A stroker for hairlines.
+ *
+ * Strokes no wider than a device pixel, drawn with
+ * CAIRO_ANTIALIAS_FAST, are swept straight into per-pixel coverage, in
+ * the manner of Xiaolin Wu's lines, instead of being outlined with
+ * joins and caps and scan converted.  Along the
+ * major axis of each segment, every pixel column (or row) receives the
+ * exact area of the stroke's cross-section over its pixels.  The butt
+ * ends of consecutive segments thus share the pixel of their vertex
+ * between them.
+ *
+ * Where a segment turns off its predecessor's major axis, the area of
+ * the join outside the two segments is added and their overlap taken
+ * away; segments at least as long as the line width are first squared
+ * off at the vertex.  Caps lengthen the ends by their area.  Shapes
+ * drawn for neighbouring segments sum exactly.  Others only sum to
+ * their union while they are apart, so a path that comes back over
+ * itself, as where it crosses itself, is left to the polygon stroker.
+ *
+ * Dashes, line widths that are not the same in all directions, and
+ * caps that fold back over the stroke they end are left to the
+ * regular strokers.
+ */
+
+#include "cairoint.h"
+
+#include "cairo-array-private.h"
+#include "cairo-error-private.h"
+#include "cairo-path-fixed-private.h"
+#include "cairo-spans-private.h"
+
+/* The largest area swept, in pixels */
+#define CAIRO_HAIRLINE_MAX_AREA (4096 * 4096)
+
+/* The furthest a stroke may reach beyond its path, in pixels, as the
+ * tips of its miters do, before it is left to the polygon stroker */
+#define CAIRO_HAIRLINE_MAX_MARGIN 64
+
+/* Coverage is only stored for the square tiles of pixels the stroke
+ * touches, of this many pixels a side */
+#define HAIRLINE_TILE_BITS 4
+#define HAIRLINE_TILE_SIZE (1 << HAIRLINE_TILE_BITS)
+#define HAIRLINE_TILE_MASK (HAIRLINE_TILE_SIZE - 1)
+
+/* Enough for a join, as a polygon of 16 sides, clipped to a
+ * quadrilateral */
+#define HAIRLINE_MAX_VERTICES 32
+
+/* The cosine of the sharpest turn between segments running on along
+ * their major axis whose join is left to the parallelograms */
+#define HAIRLINE_SHALLOW_TURN .98
+
+typedef struct _cairo_hairline_segment {
+    double x1, y1, x2, y2;
+    double dx, dy; /* the unit direction */
+    double len;
+    int serial;
+} cairo_hairline_segment_t;
+
+/* The coverage of a pixel, and the segment last swept over it */
+typedef struct _cairo_hairline_cell {
+    float cover;
+    int serial;
+} cairo_hairline_cell_t;
+
+typedef struct _cairo_hairline_scan_converter {
+    cairo_scan_converter_t base;
+
+    cairo_rectangle_int_t extents;
+    double line_width;
+    double cap_extension;
+    double miter_limit;
+    cairo_line_join_t line_join;
+    cairo_line_cap_t line_cap;
+
+    /* The current sub path, relative to the extents.  Its segments
+     * are drawn as soon as the next one comes, save for the last,
+     * which is held back until it is known whether it is to be
+     * capped; the start of the first is capped then too. */
+    cairo_point_double_t first_point;
+    cairo_point_double_t current_point;
+    cairo_hairline_segment_t first, second, penultimate, last;
+    int num_segments;
+    cairo_bool_t has_initial_sub_path;
+
+    /* All the segments so far, by serial number less one, the one
+     * being swept and the last it was checked against, and the pair
+     * made neighbours by closing the sub path. */
+    cairo_array_t segments;
+    int serial, checked;
+    int wrap_first, wrap_last;
+    cairo_bool_t overlaps;
+
+    /* The tiles of coverage within the extents, allocated as they are
+     * first touched, and the first and last pixel touched in each
+     * row. */
+    cairo_hairline_cell_t **tiles;
+    int tiles_stride;
+    int *row_extents;
+    cairo_half_open_span_t *spans;
+
+    /* Stands in for the cells of a tile that could not be allocated */
+    cairo_hairline_cell_t scratch;
+} cairo_hairline_scan_converter_t;
+
+/* Returns the cell of the pixel (x, y), allocating its tile on first
+ * use.  Should that fail, the error is recorded in the converter's
+ * status and a scratch cell returned so that the sweep can carry on. */
+static inline cairo_hairline_cell_t *
+hairline_cell (cairo_hairline_scan_converter_t *self, int x, int y)
+{
+    cairo_hairline_cell_t **tile;
+
+    tile = &self->tiles[(y >> HAIRLINE_TILE_BITS) * self->tiles_stride +
+			(x >> HAIRLINE_TILE_BITS)];
+    if (unlikely (*tile == NULL)) {
+	*tile = calloc (HAIRLINE_TILE_SIZE * HAIRLINE_TILE_SIZE,
+			sizeof (cairo_hairline_cell_t));
+	if (unlikely (*tile == NULL)) {
+	    if (self->base.status == CAIRO_STATUS_SUCCESS)
+		self->base.status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	    return &self->scratch;
+	}
+    }
+
+    return *tile + ((y & HAIRLINE_TILE_MASK) << HAIRLINE_TILE_BITS) +
+		   (x & HAIRLINE_TILE_MASK);
+}
+
+/* The square of the distance from (x, y) to @segment */
+static double
+hairline_distance2 (const cairo_hairline_segment_t *segment,
+		    double x, double y)
+{
+    double t, dx, dy;
+
+    t = (x - segment->x1) * segment->dx + (y - segment->y1) * segment->dy;
+    t = MAX (0, MIN (t, segment->len));
+    dx = x - (segment->x1 + t * segment->dx);
+    dy = y - (segment->y1 + t * segment->dy);
+
+    return dx * dx + dy * dy;
+}
+
+/* Whether the strokes of @a and @b may overlap: whether their paths
+ * cross, or come within a line width of each other. */
+static cairo_bool_t
+hairline_segments_overlap (const cairo_hairline_scan_converter_t *self,
+			   const cairo_hairline_segment_t *a,
+			   const cairo_hairline_segment_t *b)
+{
+    double w2 = self->line_width * self->line_width;
+    double o1, o2, o3, o4;
+
+    o1 = a->dx * (b->y1 - a->y1) - a->dy * (b->x1 - a->x1);
+    o2 = a->dx * (b->y2 - a->y1) - a->dy * (b->x2 - a->x1);
+    o3 = b->dx * (a->y1 - b->y1) - b->dy * (a->x1 - b->x1);
+    o4 = b->dx * (a->y2 - b->y1) - b->dy * (a->x2 - b->x1);
+    if ((o1 < 0) != (o2 < 0) && (o3 < 0) != (o4 < 0))
+	return TRUE;
+
+    return hairline_distance2 (a, b->x1, b->y1) < w2 ||
+	   hairline_distance2 (a, b->x2, b->y2) < w2 ||
+	   hairline_distance2 (b, a->x1, a->y1) < w2 ||
+	   hairline_distance2 (b, a->x2, a->y2) < w2;
+}
+
+/* Shapes drawn for neighbouring segments overlap exactly, but those
+ * of any others only sum to their union if they do not overlap. */
+static inline cairo_bool_t
+hairline_is_neighbour (const cairo_hairline_scan_converter_t *self, int serial)
+{
+    int d = serial - self->serial;
+
+    if (d >= -1 && d <= 1 && serial >= self->first.serial)
+	return TRUE;
+
+    return (serial == self->wrap_first && self->serial == self->wrap_last) ||
+	   (serial == self->wrap_last && self->serial == self->wrap_first);
+}
+
+static void
+hairline_check_overlap (cairo_hairline_scan_converter_t *self, int serial)
+{
+    const cairo_hairline_segment_t *a, *b;
+
+    a = _cairo_array_index_const (&self->segments, serial - 1);
+    b = _cairo_array_index_const (&self->segments, self->serial - 1);
+    if (hairline_segments_overlap (self, a, b))
+	self->overlaps = TRUE;
+    self->checked = serial;
+}
+
+/* Adds v to the coverage of a pixel.  While a segment is swept, the
+ * pixels already swept by others are checked against it. */
+static inline void
+hairline_cell_add (cairo_hairline_scan_converter_t *self,
+		   cairo_hairline_cell_t *cell, double v)
+{
+    if (self->serial && cell->serial != self->serial) {
+	if (cell->serial &&
+	    cell->serial != self->checked &&
+	    ! hairline_is_neighbour (self, cell->serial))
+	{
+	    hairline_check_overlap (self, cell->serial);
+	}
+	cell->serial = self->serial;
+    }
+    cell->cover += v;
+}
+
+static inline void
+hairline_touch (cairo_hairline_scan_converter_t *self, int y, int x1, int x2)
+{
+    int *row = self->row_extents + 2 * y;
+
+    if (x1 < row[0])
+	row[0] = x1;
+    if (x2 > row[1])
+	row[1] = x2;
+}
+
+/* The integral of clamp (u, 0, 1) from 0 to u */
+static inline double
+clamped_antiderivative (double u)
+{
+    if (u <= 0)
+	return 0;
+    if (u >= 1)
+	return u - .5;
+    return .5 * u * u;
+}
+
+/* The area between y = 0 and the line from u1 to u2 over a width of f,
+ * clamped to [0, 1]. */
+static inline double
+clamped_area (double u1, double u2, double f)
+{
+    double du = u2 - u1;
+
+    if (fabs (du) < 1e-6) {
+	double u = .5 * (u1 + u2);
+	return f * (u <= 0 ? 0 : u >= 1 ? 1 : u);
+    }
+
+    return f * (clamped_antiderivative (u2) - clamped_antiderivative (u1)) / du;
+}
+
+/* Adds the area between the lines from a1 to a2 and from b1 to b2,
+ * across a width of f, to the pixels of column x. */
+static void
+hairline_add_column (cairo_hairline_scan_converter_t *self,
+		     int x, double a1, double a2, double b1, double b2,
+		     double f)
+{
+    int y, y_end;
+
+    y = MAX (floor (MIN (a1, a2)), 0);
+    y_end = MIN (ceil (MAX (b1, b2)), self->extents.height);
+    for (; y < y_end; y++) {
+	hairline_cell_add (self, hairline_cell (self, x, y),
+			   clamped_area (b1 - y, b2 - y, f) -
+			   clamped_area (a1 - y, a2 - y, f));
+	hairline_touch (self, y, x, x);
+    }
+}
+
+/* Adds the area between the lines from a1 to a2 and from b1 to b2,
+ * across a height of f, to the pixels of row y. */
+static void
+hairline_add_row (cairo_hairline_scan_converter_t *self,
+		  int y, double a1, double a2, double b1, double b2,
+		  double f)
+{
+    int x, x_start, x_end;
+
+    if (y < 0 || y >= self->extents.height)
+	return;
+
+    x_start = x = MAX (floor (MIN (a1, a2)), 0);
+    x_end = MIN (ceil (MAX (b1, b2)), self->extents.width);
+    if (x >= x_end)
+	return;
+
+    for (; x < x_end; x++) {
+	hairline_cell_add (self, hairline_cell (self, x, y),
+			   clamped_area (b1 - x, b2 - x, f) -
+			   clamped_area (a1 - x, a2 - x, f));
+    }
+    hairline_touch (self, y, x_start, x_end - 1);
+}
+
+/* Sweeps the parallelogram about the segment, cut along its minor
+ * axis, a column (or row) at a time. */
+static void
+hairline_add_segment (cairo_hairline_scan_converter_t *self,
+		      double x1, double y1,
+		      double x2, double y2)
+{
+    double dx = x2 - x1, dy = y2 - y1;
+    double m, t;
+    int i, i_end;
+
+    if (fabs (dx) >= fabs (dy)) {
+	if (dx < 0) {
+	    double tx = x1, ty = y1;
+	    x1 = x2; y1 = y2;
+	    x2 = tx; y2 = ty;
+	}
+
+	/* Half the height of the cross-section of the stroke */
+	m = dy / dx;
+	t = .5 * self->line_width * sqrt (1 + m * m);
+
+	i = MAX (floor (x1), 0);
+	i_end = MIN (ceil (x2), self->extents.width);
+	for (; i < i_end; i++) {
+	    double a = MAX (x1, i), b = MIN (x2, i + 1);
+	    double ya = y1 + m * (a - x1), yb = y1 + m * (b - x1);
+
+	    hairline_add_column (self, i, ya - t, yb - t, ya + t, yb + t, b - a);
+	}
+    } else {
+	if (dy < 0) {
+	    double tx = x1, ty = y1;
+	    x1 = x2; y1 = y2;
+	    x2 = tx; y2 = ty;
+	}
+
+	/* Half the width of the cross-section of the stroke */
+	m = dx / dy;
+	t = .5 * self->line_width * sqrt (1 + m * m);
+
+	i = MAX (floor (y1), 0);
+	i_end = MIN (ceil (y2), self->extents.height);
+	for (; i < i_end; i++) {
+	    double a = MAX (y1, i), b = MIN (y2, i + 1);
+	    double xa = x1 + m * (a - y1), xb = x1 + m * (b - y1);
+
+	    hairline_add_row (self, i, xa - t, xb - t, xa + t, xb + t, b - a);
+	}
+    }
+}
+
+/* Adds f times the coverage of the convex polygon @pts.  By Green's
+ * theorem, the area of the polygon within a pixel is the integral of
+ * y dx around its boundary, with x and y clamped to the pixel. */
+static void
+hairline_add_polygon (cairo_hairline_scan_converter_t *self,
+		      const cairo_point_double_t *pts, int n,
+		      double f)
+{
+    int width = self->extents.width;
+    double ymin, ymax, area;
+    int i, j, y_start, y_end;
+
+    if (n < 3)
+	return;
+
+    area = 0;
+    ymin = ymax = pts[0].y;
+    for (i = 0; i < n; i++) {
+	const cairo_point_double_t *p = &pts[i], *q = &pts[(i + 1) % n];
+
+	area += p->x * q->y - q->x * p->y;
+	if (p->y < ymin)
+	    ymin = p->y;
+	if (p->y > ymax)
+	    ymax = p->y;
+    }
+    if (area == 0)
+	return;
+    if (area > 0)
+	f = -f;
+
+    y_start = MAX (floor (ymin), 0);
+    y_end = MIN (ceil (ymax), self->extents.height);
+    if (y_start >= y_end)
+	return;
+
+    for (i = 0; i < n; i++) {
+	const cairo_point_double_t *p = &pts[i], *q = &pts[(i + 1) % n];
+	double x1, y1, x2, y2, m, g;
+	int x, x_end;
+
+	if (p->x == q->x)
+	    continue;
+
+	if (p->x < q->x) {
+	    x1 = p->x; y1 = p->y;
+	    x2 = q->x; y2 = q->y;
+	    g = f;
+	} else {
+	    x1 = q->x; y1 = q->y;
+	    x2 = p->x; y2 = p->y;
+	    g = -f;
+	}
+	m = (y2 - y1) / (x2 - x1);
+
+	x = MAX (floor (x1), 0);
+	x_end = MIN (ceil (x2), width);
+	for (; x < x_end; x++) {
+	    double a = MAX (x1, x), b = MIN (x2, x + 1);
+	    double ya = y1 + m * (a - x1), yb = y1 + m * (b - x1);
+
+	    for (j = y_start; j < y_end; j++) {
+		hairline_cell_add (self, hairline_cell (self, x, j),
+				   g * clamped_area (ya - j, yb - j, b - a));
+		hairline_touch (self, j, x, x);
+	    }
+	}
+    }
+}
+
+/* The parallelogram swept by hairline_add_segment() */
+static void
+hairline_segment_outline (cairo_hairline_scan_converter_t *self,
+			  const cairo_hairline_segment_t *segment,
+			  cairo_point_double_t pts[4])
+{
+    double dx = segment->x2 - segment->x1;
+    double dy = segment->y2 - segment->y1;
+
+    pts[0].x = pts[1].x = segment->x1;
+    pts[0].y = pts[1].y = segment->y1;
+    pts[2].x = pts[3].x = segment->x2;
+    pts[2].y = pts[3].y = segment->y2;
+    if (fabs (dx) >= fabs (dy)) {
+	double t = .5 * self->line_width / fabs (segment->dx);
+
+	pts[0].y -= t;
+	pts[1].y += t;
+	pts[2].y += t;
+	pts[3].y -= t;
+    } else {
+	double t = .5 * self->line_width / fabs (segment->dy);
+
+	pts[0].x -= t;
+	pts[1].x += t;
+	pts[2].x += t;
+	pts[3].x -= t;
+    }
+}
+
+/* Clips the convex polygon @pts to the inside of the edge from p to q,
+ * where the inside has the sign of @orientation. */
+static int
+clip_to_edge (const cairo_point_double_t *pts, int n,
+	      const cairo_point_double_t *p, const cairo_point_double_t *q,
+	      double orientation,
+	      cairo_point_double_t *out)
+{
+    double ex = q->x - p->x, ey = q->y - p->y;
+    int i, m = 0;
+
+    for (i = 0; i < n; i++) {
+	const cairo_point_double_t *a = &pts[i], *b = &pts[(i + 1) % n];
+	double da = orientation * (ex * (a->y - p->y) - ey * (a->x - p->x));
+	double db = orientation * (ex * (b->y - p->y) - ey * (b->x - p->x));
+
+	if (da >= 0)
+	    out[m++] = *a;
+	if ((da >= 0) != (db >= 0)) {
+	    double t = da / (da - db);
+
+	    out[m].x = a->x + t * (b->x - a->x);
+	    out[m].y = a->y + t * (b->y - a->y);
+	    m++;
+	}
+    }
+
+    return m;
+}
+
+/* Clips the convex polygon @pts to the convex quadrilateral @quad,
+ * returning the number of vertices left in @out. */
+static int
+clip_to_quad (const cairo_point_double_t *pts, int n,
+	      const cairo_point_double_t quad[4],
+	      cairo_point_double_t *out)
+{
+    cairo_point_double_t buf[2][HAIRLINE_MAX_VERTICES];
+    double orientation;
+    int i;
+
+    orientation = (quad[1].x - quad[0].x) * (quad[2].y - quad[0].y) -
+		  (quad[1].y - quad[0].y) * (quad[2].x - quad[0].x);
+    for (i = 0; i < 4 && n > 2; i++) {
+	cairo_point_double_t *clipped = i == 3 ? out : buf[i & 1];
+
+	n = clip_to_edge (pts, n, &quad[i], &quad[(i + 1) % 4],
+			  orientation, clipped);
+	pts = clipped;
+    }
+
+    return n > 2 ? n : 0;
+}
+
+/* Fills @pts with the outline of the join from @in to @out, as drawn
+ * by the polygon stroker about the vertex at the start of @out. */
+static int
+hairline_join_outline (cairo_hairline_scan_converter_t *self,
+		       const cairo_hairline_segment_t *in,
+		       const cairo_hairline_segment_t *out,
+		       cairo_point_double_t *pts)
+{
+    double r = .5 * self->line_width;
+    double nx_in, ny_in, nx_out, ny_out;
+    int i, n;
+
+    if (self->line_join == CAIRO_LINE_JOIN_ROUND) {
+	/* A polygon of the same area as the disc */
+	n = HAIRLINE_MAX_VERTICES / 2;
+	r *= sqrt (2 * M_PI / (n * sin (2 * M_PI / n)));
+	for (i = 0; i < n; i++) {
+	    pts[i].x = out->x1 + r * cos (2 * M_PI * i / n);
+	    pts[i].y = out->y1 + r * sin (2 * M_PI * i / n);
+	}
+	return n;
+    }
+
+    /* The normals on the outside of the turn */
+    nx_in = -in->dy;
+    ny_in = in->dx;
+    if (nx_in * out->dx + ny_in * out->dy > 0) {
+	nx_in = -nx_in;
+	ny_in = -ny_in;
+    }
+    nx_out = -out->dy;
+    ny_out = out->dx;
+    if (nx_out * in->dx + ny_out * in->dy < 0) {
+	nx_out = -nx_out;
+	ny_out = -ny_out;
+    }
+
+    n = 0;
+    pts[n].x = out->x1;
+    pts[n].y = out->y1;
+    n++;
+    pts[n].x = out->x1 + r * nx_in;
+    pts[n].y = out->y1 + r * ny_in;
+    n++;
+    if (self->line_join == CAIRO_LINE_JOIN_MITER &&
+	2 <= self->miter_limit * self->miter_limit *
+	     (1 + in->dx * out->dx + in->dy * out->dy))
+    {
+	double k = r / (1 + nx_in * nx_out + ny_in * ny_out);
+
+	pts[n].x = out->x1 + k * (nx_in + nx_out);
+	pts[n].y = out->y1 + k * (ny_in + ny_out);
+	n++;
+    }
+    pts[n].x = out->x1 + r * nx_out;
+    pts[n].y = out->y1 + r * ny_out;
+    n++;
+
+    return n;
+}
+
+/* The parallelogram is cut along the minor axis of the segment, its
+ * stroke across it: at an end of the sub path, swap the triangles
+ * between the two cuts on either side of the end point @p, given
+ * with the direction @dx, @dy leading out of the segment. */
+static void
+hairline_square_end (cairo_hairline_scan_converter_t *self,
+		     double x, double y, double dx, double dy)
+{
+    cairo_point_double_t tri[3];
+    double r = .5 * self->line_width;
+    double t;
+    int side;
+
+    tri[0].x = x;
+    tri[0].y = y;
+    for (side = -1; side <= 1; side += 2) {
+	/* Where the parallelogram's cut meets an edge of the stroke, */
+	if (fabs (dx) >= fabs (dy)) {
+	    t = r / fabs (dx);
+	    tri[1].x = x;
+	    tri[1].y = y + side * t;
+	} else {
+	    t = r / fabs (dy);
+	    tri[1].x = x + side * t;
+	    tri[1].y = y;
+	}
+	/* and where the stroke's square end meets the same edge */
+	if ((tri[1].x - x) * dy - (tri[1].y - y) * dx > 0) {
+	    tri[2].x = x + r * dy;
+	    tri[2].y = y - r * dx;
+	} else {
+	    tri[2].x = x - r * dy;
+	    tri[2].y = y + r * dx;
+	}
+
+	hairline_add_polygon (self, tri, 3,
+			      (tri[2].x - tri[1].x) * dx +
+			      (tri[2].y - tri[1].y) * dy > 0 ? 1 : -1);
+    }
+}
+
+/* The rectangle covered by the stroke of @segment */
+static void
+hairline_segment_rectangle (cairo_hairline_scan_converter_t *self,
+			    const cairo_hairline_segment_t *segment,
+			    cairo_point_double_t pts[4])
+{
+    double nx = -.5 * self->line_width * segment->dy;
+    double ny = .5 * self->line_width * segment->dx;
+
+    pts[0].x = segment->x1 + nx;
+    pts[0].y = segment->y1 + ny;
+    pts[1].x = segment->x2 + nx;
+    pts[1].y = segment->y2 + ny;
+    pts[2].x = segment->x2 - nx;
+    pts[2].y = segment->y2 - ny;
+    pts[3].x = segment->x1 - nx;
+    pts[3].y = segment->y1 - ny;
+}
+
+/* Adds the coverage of the join outside of the shapes @a and @b drawn
+ * for the segments, and removes that of their overlap:
+ *
+ *   - a ∩ b + join - join ∩ a - join ∩ b + join ∩ a ∩ b
+ */
+static void
+hairline_add_join_outside (cairo_hairline_scan_converter_t *self,
+			   const cairo_hairline_segment_t *in,
+			   const cairo_hairline_segment_t *out,
+			   const cairo_point_double_t a[4],
+			   const cairo_point_double_t b[4])
+{
+    cairo_point_double_t join[HAIRLINE_MAX_VERTICES];
+    cairo_point_double_t clipped[HAIRLINE_MAX_VERTICES];
+    int n, m;
+
+    n = clip_to_quad (a, 4, b, clipped);
+    hairline_add_polygon (self, clipped, n, -1);
+
+    n = hairline_join_outline (self, in, out, join);
+    hairline_add_polygon (self, join, n, 1);
+    m = clip_to_quad (join, n, b, clipped);
+    hairline_add_polygon (self, clipped, m, -1);
+    m = clip_to_quad (join, n, a, clipped);
+    hairline_add_polygon (self, clipped, m, -1);
+    m = clip_to_quad (clipped, m, b, clipped);
+    hairline_add_polygon (self, clipped, m, 1);
+}
+
+/* Joins the segments @in and @out at the start of @out.
+ *
+ * Where they run on along the same major axis, their parallelograms
+ * abut at the vertex and differ from the stroke by slivers, which are
+ * left be unless the turn is sharp.  Otherwise, if the segments are
+ * long enough for their ends not to interfere, the ends at the vertex
+ * are squared to give the stroke of each segment and the join is
+ * added outside of them.  Shorter segments that turn back or change
+ * their major axis have the join added outside of their
+ * parallelograms, so a spike is no heavier at its tip than it should
+ * be. */
+static void
+hairline_add_join (cairo_hairline_scan_converter_t *self,
+		   const cairo_hairline_segment_t *in,
+		   const cairo_hairline_segment_t *out)
+{
+    cairo_point_double_t a[4], b[4];
+    cairo_bool_t runs_on;
+
+    if (fabs (in->dx) >= fabs (in->dy))
+	runs_on = fabs (out->dx) >= fabs (out->dy) && in->dx * out->dx > 0;
+    else
+	runs_on = fabs (out->dx) < fabs (out->dy) && in->dy * out->dy > 0;
+
+    if (in->len >= self->line_width && out->len >= self->line_width) {
+	if (runs_on &&
+	    in->dx * out->dx + in->dy * out->dy > HAIRLINE_SHALLOW_TURN)
+	{
+	    return;
+	}
+
+	hairline_square_end (self, out->x1, out->y1, in->dx, in->dy);
+	hairline_square_end (self, out->x1, out->y1, -out->dx, -out->dy);
+	hairline_segment_rectangle (self, in, a);
+	hairline_segment_rectangle (self, out, b);
+    } else {
+	if (runs_on)
+	    return;
+
+	hairline_segment_outline (self, in, a);
+	hairline_segment_outline (self, out, b);
+    }
+
+    hairline_add_join_outside (self, in, out, a, b);
+}
+
+/* Sweeps the part of @segment, or of a cap lengthening it, from
+ * (x1, y1) to (x2, y2). */
+static void
+hairline_sweep (cairo_hairline_scan_converter_t *self,
+		const cairo_hairline_segment_t *segment,
+		double x1, double y1,
+		double x2, double y2)
+{
+    self->serial = segment->serial;
+    self->checked = 0;
+    hairline_add_segment (self, x1, y1, x2, y2);
+    self->serial = 0;
+}
+
+/* Caps the end (x, y) of @segment, leading out of it along (dx, dy),
+ * by lengthening it by the area of the cap.  The parallelograms are
+ * cut along the same axis, so the lengthening adds up exactly with
+ * the segment however long ago that was drawn. */
+static void
+hairline_add_cap (cairo_hairline_scan_converter_t *self,
+		  const cairo_hairline_segment_t *segment,
+		  double x, double y, double dx, double dy)
+{
+    double e = self->cap_extension;
+
+    if (e > 0)
+	hairline_sweep (self, segment, x, y, x + e * dx, y + e * dy);
+    hairline_square_end (self, x + e * dx, y + e * dy, dx, dy);
+}
+
+/* Draws @segment, with caps at the ends asked for. */
+static void
+hairline_add_capped_segment (cairo_hairline_scan_converter_t *self,
+			     const cairo_hairline_segment_t *segment,
+			     cairo_bool_t cap_start,
+			     cairo_bool_t cap_end)
+{
+    hairline_sweep (self, segment,
+		    segment->x1, segment->y1, segment->x2, segment->y2);
+    if (cap_start) {
+	hairline_add_cap (self, segment, segment->x1, segment->y1,
+			  -segment->dx, -segment->dy);
+    }
+    if (cap_end) {
+	hairline_add_cap (self, segment, segment->x2, segment->y2,
+			  segment->dx, segment->dy);
+    }
+}
+
+/* Whether the cap at the end (x, y) of @segment may reach over its
+ * @neighbour, which turns back towards it.  The cap is drawn as if
+ * nothing lay under it, so that would count their overlap twice. */
+static cairo_bool_t
+hairline_cap_overlaps (cairo_hairline_scan_converter_t *self,
+		       double x, double y,
+		       const cairo_hairline_segment_t *segment,
+		       const cairo_hairline_segment_t *neighbour)
+{
+    double reach = (1 + M_SQRT2) / 2 * self->line_width;
+
+    if (segment->dx * neighbour->dx + segment->dy * neighbour->dy >= 0)
+	return FALSE;
+
+    return hairline_distance2 (neighbour, x, y) < reach * reach;
+}
+
+static cairo_status_t
+hairline_end_sub_path (cairo_hairline_scan_converter_t *self,
+		       cairo_bool_t is_closed)
+{
+    /* Leave caps that fold back over the stroke to the polygon
+     * stroker */
+    if (! is_closed &&
+	self->num_segments > 1 &&
+	self->line_cap != CAIRO_LINE_CAP_BUTT &&
+	(hairline_cap_overlaps (self, self->first.x1, self->first.y1,
+				&self->first, &self->second) ||
+	 hairline_cap_overlaps (self, self->last.x2, self->last.y2,
+				&self->last, &self->penultimate)))
+    {
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+    }
+
+    if (self->num_segments == 0) {
+	/* A degenerate sub path is drawn as a dot by round caps; use a
+	 * square of the same area. */
+	if (self->has_initial_sub_path &&
+	    self->line_cap == CAIRO_LINE_CAP_ROUND)
+	{
+	    double s = self->line_width * sqrt (M_PI) / 4;
+	    double x = self->first_point.x, y = self->first_point.y;
+	    int i;
+
+	    for (i = floor (y - s); i < ceil (y + s); i++) {
+		hairline_add_row (self, i, x - s, x - s, x + s, x + s,
+				  MIN (y + s, i + 1) - MAX (y - s, i));
+	    }
+	}
+    } else if (self->num_segments == 1) {
+	hairline_add_capped_segment (self, &self->first,
+				     ! is_closed, ! is_closed);
+    } else {
+	/* the first segment was drawn as soon as the second came */
+	if (! is_closed) {
+	    hairline_add_cap (self, &self->first,
+			      self->first.x1, self->first.y1,
+			      -self->first.dx, -self->first.dy);
+	}
+	hairline_add_capped_segment (self, &self->last, FALSE, ! is_closed);
+    }
+
+    self->wrap_first = self->wrap_last = 0;
+    self->num_segments = 0;
+    self->has_initial_sub_path = FALSE;
+
+    if (self->overlaps)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+hairline_move_to (void *closure, const cairo_point_t *point)
+{
+    cairo_hairline_scan_converter_t *self = closure;
+    cairo_status_t status;
+
+    status = hairline_end_sub_path (self, FALSE);
+    if (unlikely (status))
+	return status;
+
+    self->first_point.x = _cairo_fixed_to_double (point->x) - self->extents.x;
+    self->first_point.y = _cairo_fixed_to_double (point->y) - self->extents.y;
+    self->current_point = self->first_point;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+hairline_line_to_double (cairo_hairline_scan_converter_t *self,
+			 const cairo_point_double_t *point)
+{
+    cairo_hairline_segment_t segment;
+    cairo_status_t status;
+    double len;
+
+    self->has_initial_sub_path = TRUE;
+
+    segment.x1 = self->current_point.x;
+    segment.y1 = self->current_point.y;
+    segment.x2 = point->x;
+    segment.y2 = point->y;
+    len = hypot (segment.x2 - segment.x1, segment.y2 - segment.y1);
+    if (len == 0.)
+	return CAIRO_STATUS_SUCCESS;
+
+    segment.dx = (segment.x2 - segment.x1) / len;
+    segment.dy = (segment.y2 - segment.y1) / len;
+    segment.len = len;
+    segment.serial = _cairo_array_num_elements (&self->segments) + 1;
+    status = _cairo_array_append (&self->segments, &segment);
+    if (unlikely (status))
+	return status;
+
+    if (self->num_segments) {
+	hairline_add_join (self, &self->last, &segment);
+	hairline_add_capped_segment (self, &self->last, FALSE, FALSE);
+	if (self->num_segments == 1)
+	    self->second = segment;
+    } else {
+	self->first = segment;
+    }
+
+    self->penultimate = self->last;
+    self->last = segment;
+    self->num_segments++;
+    self->current_point = *point;
+
+    if (self->overlaps)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+hairline_line_to (void *closure, const cairo_point_t *point)
+{
+    cairo_hairline_scan_converter_t *self = closure;
+    cairo_point_double_t p;
+
+    p.x = _cairo_fixed_to_double (point->x) - self->extents.x;
+    p.y = _cairo_fixed_to_double (point->y) - self->extents.y;
+
+    return hairline_line_to_double (self, &p);
+}
+
+static cairo_status_t
+hairline_close_path (void *closure)
+{
+    cairo_hairline_scan_converter_t *self = closure;
+    cairo_status_t status;
+
+    status = hairline_line_to_double (self, &self->first_point);
+    if (unlikely (status))
+	return status;
+
+    if (self->num_segments > 2) {
+	self->wrap_first = self->first.serial;
+	self->wrap_last = self->last.serial;
+	hairline_add_join (self, &self->last, &self->first);
+    }
+
+    status = hairline_end_sub_path (self, self->num_segments > 1);
+    self->current_point = self->first_point;
+
+    return status;
+}
+
+static inline int
+hairline_coverage_to_alpha (const cairo_hairline_cell_t *cell)
+{
+    float v = cell->cover;
+
+    if (v <= 0)
+	return 0;
+    if (v >= 1)
+	return CAIRO_SPANS_UNIT_COVERAGE;
+    return v * CAIRO_SPANS_UNIT_COVERAGE + .5f;
+}
+
+static cairo_status_t
+_cairo_hairline_scan_converter_generate (void			*abstract_converter,
+					 cairo_span_renderer_t	*renderer)
+{
+    cairo_hairline_scan_converter_t *self = abstract_converter;
+    cairo_half_open_span_t *spans = self->spans;
+    int y;
+
+    for (y = 0; y < self->extents.height; y++) {
+	cairo_hairline_cell_t **tiles = self->tiles +
+	    (y >> HAIRLINE_TILE_BITS) * self->tiles_stride;
+	int offset = (y & HAIRLINE_TILE_MASK) << HAIRLINE_TILE_BITS;
+	int x = self->row_extents[2 * y];
+	int x_end = self->row_extents[2 * y + 1] + 1;
+	unsigned num_spans = 0;
+	int last = 0;
+	cairo_status_t status;
+
+	for (; x < x_end; x++) {
+	    const cairo_hairline_cell_t *tile = tiles[x >> HAIRLINE_TILE_BITS];
+	    int alpha = 0;
+
+	    if (tile != NULL) {
+		alpha = hairline_coverage_to_alpha (tile + offset +
+						    (x & HAIRLINE_TILE_MASK));
+	    }
+
+	    if (alpha != last) {
+		spans[num_spans].x = x + self->extents.x;
+		spans[num_spans].coverage = alpha;
+		last = alpha;
+		num_spans++;
+	    }
+	}
+	if (last) {
+	    spans[num_spans].x = x_end + self->extents.x;
+	    spans[num_spans].coverage = 0;
+	    num_spans++;
+	}
+
+	if (num_spans) {
+	    status = renderer->render_rows (renderer,
+					    y + self->extents.y, 1,
+					    spans, num_spans);
+	    if (unlikely (status))
+		return status;
+	}
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static void
+_cairo_hairline_scan_converter_destroy (void *abstract_converter)
+{
+    cairo_hairline_scan_converter_t *self = abstract_converter;
+    int i, num_tiles;
+
+    if (self->tiles != NULL) {
+	num_tiles = self->tiles_stride *
+		    ((self->extents.height + HAIRLINE_TILE_MASK) >> HAIRLINE_TILE_BITS);
+	for (i = 0; i < num_tiles; i++)
+	    free (self->tiles[i]);
+	free (self->tiles);
+    }
+    free (self->row_extents);
+    _cairo_array_fini (&self->segments);
+    free (self);
+}
+
+/* Returns the width of a stroke in device space, or 0 if it is not
+ * drawn as a hairline. */
+static double
+_cairo_hairline_width (const cairo_path_fixed_t	*path,
+		       const cairo_stroke_style_t	*style,
+		       const cairo_matrix_t		*ctm,
+		       double				 tolerance)
+{
+    double width;
+
+    if (style->num_dashes)
+	return 0;
+
+    /* The ctm must scale all directions alike */
+    if (! (ctm->xx == ctm->yy && ctm->xy == -ctm->yx) &&
+	! (ctm->xx == -ctm->yy && ctm->xy == ctm->yx))
+    {
+	return 0;
+    }
+
+    width = style->line_width *
+	    sqrt (fabs (_cairo_matrix_compute_determinant (ctm)));
+    if (! (width > 0 && width <= 1))
+	return 0;
+
+    /* Leave the strokes that the polygon stroker omits altogether,
+     * as its pen is reduced to a single point, to it. */
+    if ((path->has_curve_to ||
+	 style->line_join == CAIRO_LINE_JOIN_ROUND ||
+	 style->line_cap == CAIRO_LINE_CAP_ROUND) &&
+	_cairo_pen_vertices_needed (tolerance, style->line_width / 2, ctm) <= 1)
+    {
+	return 0;
+    }
+
+    return width;
+}
+
+cairo_int_status_t
+_cairo_hairline_scan_converter_create (const cairo_path_fixed_t	*path,
+				       const cairo_stroke_style_t	*style,
+				       const cairo_matrix_t		*ctm,
+				       double				 tolerance,
+				       const cairo_rectangle_int_t	*extents,
+				       cairo_scan_converter_t	       **converter)
+{
+    cairo_hairline_scan_converter_t *self;
+    cairo_rectangle_int_t rect;
+    cairo_status_t status;
+    double width, reach;
+    int y, margin, num_tiles;
+
+    width = _cairo_hairline_width (path, style, ctm, tolerance);
+    if (width == 0)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    /* How far the stroke reaches beyond the path: the corners of
+     * square caps and bevels lie within sqrt(2) half widths of it,
+     * but the tip of a miter may lie up to miter_limit half widths
+     * away. */
+    reach = M_SQRT2;
+    if (style->line_join == CAIRO_LINE_JOIN_MITER && style->miter_limit > reach)
+	reach = style->miter_limit;
+    reach *= width / 2;
+    if (reach > CAIRO_HAIRLINE_MAX_MARGIN)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+    margin = ceil (reach);
+
+    rect.x = _cairo_fixed_integer_floor (path->extents.p1.x) - margin;
+    rect.y = _cairo_fixed_integer_floor (path->extents.p1.y) - margin;
+    rect.width = _cairo_fixed_integer_ceil (path->extents.p2.x) + margin - rect.x;
+    rect.height = _cairo_fixed_integer_ceil (path->extents.p2.y) + margin - rect.y;
+    if (! _cairo_rectangle_intersect (&rect, extents)) {
+	rect.width = 0;
+	rect.height = 0;
+    }
+    if (rect.width > CAIRO_HAIRLINE_MAX_AREA / MAX (rect.height, 1))
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    self = malloc (sizeof (cairo_hairline_scan_converter_t));
+    if (unlikely (self == NULL))
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+    self->base.destroy = _cairo_hairline_scan_converter_destroy;
+    self->base.generate = _cairo_hairline_scan_converter_generate;
+    self->base.status = CAIRO_STATUS_SUCCESS;
+    _cairo_array_init (&self->segments, sizeof (cairo_hairline_segment_t));
+
+    self->extents = rect;
+    self->line_width = width;
+    self->miter_limit = style->miter_limit;
+    self->line_join = style->line_join;
+    self->line_cap = style->line_cap;
+    switch (style->line_cap) {
+    default:
+    case CAIRO_LINE_CAP_BUTT:
+	self->cap_extension = 0;
+	break;
+    case CAIRO_LINE_CAP_ROUND:
+	/* lengthen the end by the area of the half disc */
+	self->cap_extension = M_PI / 8 * width;
+	break;
+    case CAIRO_LINE_CAP_SQUARE:
+	self->cap_extension = width / 2;
+	break;
+    }
+
+    self->num_segments = 0;
+    self->has_initial_sub_path = FALSE;
+    self->first_point.x = self->first_point.y = 0;
+    self->current_point = self->first_point;
+
+    self->serial = self->checked = 0;
+    self->wrap_first = self->wrap_last = 0;
+    self->overlaps = FALSE;
+    self->tiles = NULL;
+    self->tiles_stride = 0;
+    self->row_extents = NULL;
+    self->spans = NULL;
+    if (rect.width == 0 || rect.height == 0) {
+	self->extents.height = 0;
+	*converter = &self->base;
+	return CAIRO_INT_STATUS_SUCCESS;
+    }
+
+    self->tiles_stride = (rect.width + HAIRLINE_TILE_MASK) >> HAIRLINE_TILE_BITS;
+    num_tiles = self->tiles_stride *
+		((rect.height + HAIRLINE_TILE_MASK) >> HAIRLINE_TILE_BITS);
+    self->tiles = calloc (num_tiles, sizeof (cairo_hairline_cell_t *));
+    self->row_extents = malloc (rect.height * 2 * sizeof (int) +
+				(rect.width + 1) * sizeof (cairo_half_open_span_t));
+    if (unlikely (self->tiles == NULL || self->row_extents == NULL)) {
+	_cairo_hairline_scan_converter_destroy (self);
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    }
+    self->spans = (cairo_half_open_span_t *) (self->row_extents + 2 * rect.height);
+    for (y = 0; y < rect.height; y++) {
+	self->row_extents[2 * y] = rect.width;
+	self->row_extents[2 * y + 1] = -1;
+    }
+
+    status = _cairo_path_fixed_interpret_flat (path,
+					       hairline_move_to,
+					       hairline_line_to,
+					       hairline_close_path,
+					       self,
+					       tolerance);
+    if (likely (status == CAIRO_STATUS_SUCCESS))
+	status = hairline_end_sub_path (self, FALSE);
+    if (likely (status == CAIRO_STATUS_SUCCESS))
+	status = self->base.status;
+    if (unlikely (status)) {
+	_cairo_hairline_scan_converter_destroy (self);
+	return status;
+    }
+
+    *converter = &self->base;
+    return CAIRO_INT_STATUS_SUCCESS;
+}
@@ -262,6 +262,9 @@ _cairo_gradient_pattern_fit_to_range (const cairo_gradient_pattern_t *gradient,
 				      cairo_matrix_t                 *out_matrix,
 				      cairo_circle_double_t	      out_circle[2]);
 
+cairo_private cairo_bool_t
+_cairo_gradient_pattern_is_band_invariant (const cairo_gradient_pattern_t *gradient);
+
 cairo_private cairo_bool_t
 _cairo_radial_pattern_focus_is_inside (const cairo_radial_pattern_t *radial);
 
@@ -305,6 +308,14 @@ _cairo_pattern_get_ink_extents (const cairo_pattern_t	    *pattern,
 cairo_private unsigned long
 _cairo_pattern_hash (const cairo_pattern_t *pattern);
 
+cairo_private unsigned long
+_cairo_gradient_color_stops_hash (unsigned long hash,
+				  const cairo_gradient_pattern_t *gradient);
+
+cairo_private cairo_bool_t
+_cairo_gradient_color_stops_equal (const cairo_gradient_pattern_t *a,
+				   const cairo_gradient_pattern_t *b);
+
 cairo_private unsigned long
 _cairo_linear_pattern_hash (unsigned long hash,
 			    const cairo_linear_pattern_t *linear);
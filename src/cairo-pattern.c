@@ -2762,6 +2762,29 @@ _cairo_gradient_pattern_fit_to_range (const cairo_gradient_pattern_t *gradient,
     }
 }
 
+/**
+ * _cairo_gradient_pattern_is_band_invariant:
+ *
+ * Returns whether pixman samples @gradient identically whatever the
+ * origin of the composite, so that rendering it in bands or tiles
+ * matches rendering it at once.  This holds when its matrix, once
+ * fitted to pixman's range, is a pixman translation.
+ **/
+cairo_bool_t
+_cairo_gradient_pattern_is_band_invariant (const cairo_gradient_pattern_t *gradient)
+{
+    cairo_circle_double_t extremes[2];
+    cairo_matrix_t matrix;
+    int tx = 0, ty = 0;
+
+    _cairo_gradient_pattern_fit_to_range (gradient, PIXMAN_MAX_INT >> 1,
+					  &matrix, extremes);
+
+    return _cairo_matrix_is_pixman_translation (&matrix,
+						gradient->base.filter,
+						&tx, &ty);
+}
+
 static cairo_bool_t
 _gradient_is_clear (const cairo_gradient_pattern_t *gradient,
 		    const cairo_rectangle_int_t *extents)
@@ -3809,7 +3832,7 @@ _cairo_solid_pattern_hash (unsigned long hash,
     return hash;
 }
 
-static unsigned long
+unsigned long
 _cairo_gradient_color_stops_hash (unsigned long hash,
 				  const cairo_gradient_pattern_t *gradient)
 {
@@ -3930,7 +3953,7 @@ _cairo_solid_pattern_equal (const cairo_solid_pattern_t *a,
     return _cairo_color_equal (&a->color, &b->color);
 }
 
-static cairo_bool_t
+cairo_bool_t
 _cairo_gradient_color_stops_equal (const cairo_gradient_pattern_t *a,
 				   const cairo_gradient_pattern_t *b)
 {
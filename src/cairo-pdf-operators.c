@@ -99,6 +99,18 @@ _cairo_pdf_operators_set_stream (cairo_pdf_operators_t	 *pdf_operators,
     pdf_operators->has_line_style = FALSE;
 }
 
+/* Change the font subsets that glyphs are mapped into. This should only
+ * be done between pages, once the previous subsets have been emitted.
+ */
+void
+_cairo_pdf_operators_set_font_subsets (cairo_pdf_operators_t	   *pdf_operators,
+				       cairo_scaled_font_subsets_t *font_subsets)
+{
+    assert (! pdf_operators->in_text_object);
+
+    pdf_operators->font_subsets = font_subsets;
+}
+
 void
 _cairo_pdf_operators_set_cairo_to_pdf_matrix (cairo_pdf_operators_t *pdf_operators,
 					      cairo_matrix_t	    *cairo_to_pdf)
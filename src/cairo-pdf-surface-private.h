@@ -79,6 +79,7 @@ typedef struct _cairo_pdf_source_surface_entry {
     int width;
     int height;
     cairo_rectangle_int_t extents;
+    cairo_surface_t *content; /* a snapshot of the pixels behind a content digest */
 } cairo_pdf_source_surface_entry_t;
 
 typedef struct _cairo_pdf_source_surface {
@@ -138,6 +139,10 @@ typedef struct _cairo_pdf_jbig2_global {
     cairo_bool_t emitted;
 } cairo_pdf_jbig2_global_t;
 
+/* A compressed stream whose deflation has been handed to the thread pool;
+ * it is written to the output, in order, once that completes. */
+typedef struct _cairo_pdf_deferred_stream cairo_pdf_deferred_stream_t;
+
 typedef struct _cairo_pdf_surface cairo_pdf_surface_t;
 
 struct _cairo_pdf_surface {
@@ -170,6 +175,8 @@ struct _cairo_pdf_surface {
 
     cairo_pdf_version_t pdf_version;
     cairo_bool_t compress_content;
+    int compression_level;
+    cairo_bool_t deduplicate_images;
 
     cairo_pdf_resource_t content;
     cairo_pdf_resource_t content_resources;
@@ -184,8 +191,20 @@ struct _cairo_pdf_surface {
 	long start_offset;
 	cairo_bool_t compressed;
 	cairo_output_stream_t *old_output;
+	cairo_pdf_deferred_stream_t *deferred;
     } pdf_stream;
 
+    /* With more than one render thread, compressed streams are deflated
+     * in the background and written out one page later. */
+    cairo_bool_t defer_compression;
+    unsigned int deferred_page;
+    cairo_list_t deferred_streams;
+
+    /* Write out the fonts and forget the shared surfaces every so many
+     * pages, rather than holding on to them until the end. */
+    int resource_flush_interval;
+    int pages_since_resource_flush;
+
     struct {
 	cairo_bool_t active;
 	cairo_output_stream_t *stream;
@@ -54,6 +54,7 @@
 #include "cairo-error-private.h"
 #include "cairo-image-surface-inline.h"
 #include "cairo-image-info-private.h"
+#include "cairo-list-inline.h"
 #include "cairo-recording-surface-private.h"
 #include "cairo-output-stream-private.h"
 #include "cairo-paginated-private.h"
@@ -61,6 +62,7 @@
 #include "cairo-surface-clipper-private.h"
 #include "cairo-surface-snapshot-inline.h"
 #include "cairo-surface-subsurface-private.h"
+#include "cairo-thread-pool-private.h"
 #include "cairo-type3-glyph-surface-private.h"
 
 #include <time.h>
@@ -235,6 +237,13 @@ _cairo_pdf_surface_open_stream (cairo_pdf_surface_t	*surface,
 static cairo_int_status_t
 _cairo_pdf_surface_close_stream (cairo_pdf_surface_t	*surface);
 
+static cairo_int_status_t
+_cairo_pdf_surface_write_deferred_streams (cairo_pdf_surface_t	*surface,
+					   cairo_bool_t		 all);
+
+static void
+_cairo_pdf_surface_discard_deferred_streams (cairo_pdf_surface_t *surface);
+
 static cairo_int_status_t
 _cairo_pdf_surface_write_page (cairo_pdf_surface_t *surface);
 
@@ -256,6 +265,9 @@ _cairo_pdf_surface_write_page (cairo_pdf_surface_t *surface);
 static cairo_int_status_t
 _cairo_pdf_surface_emit_font_subsets (cairo_pdf_surface_t *surface);
 
+static cairo_int_status_t
+_cairo_pdf_surface_flush_resources (cairo_pdf_surface_t *surface);
+
 static cairo_bool_t
 _cairo_pdf_source_surface_equal (const void *key_a, const void *key_b);
 
@@ -410,8 +422,16 @@ _cairo_pdf_surface_create_for_stream_internal (cairo_output_stream_t	*output,
 
     surface->pdf_version = CAIRO_PDF_VERSION_1_5;
     surface->compress_content = TRUE;
+    surface->compression_level = CAIRO_DEFLATE_LEVEL_DEFAULT;
+    surface->deduplicate_images = FALSE;
     surface->pdf_stream.active = FALSE;
     surface->pdf_stream.old_output = NULL;
+    surface->pdf_stream.deferred = NULL;
+    surface->defer_compression = _cairo_thread_pool_get_num_threads () > 1;
+    surface->deferred_page = 0;
+    cairo_list_init (&surface->deferred_streams);
+    surface->resource_flush_interval = 0;
+    surface->pages_since_resource_flush = 0;
     surface->group_stream.active = FALSE;
     surface->group_stream.stream = NULL;
     surface->group_stream.mem_stream = NULL;
@@ -705,6 +725,91 @@ cairo_pdf_surface_set_size (cairo_surface_t	*surface,
 	status = _cairo_surface_set_error (surface, status);
 }
 
+/**
+ * cairo_pdf_surface_set_compression_level:
+ * @surface: a PDF #cairo_surface_t
+ * @level: the deflate compression level, from 0 to 9
+ *
+ * Sets the effort spent compressing the content, image and font
+ * streams subsequently written to the PDF file. Level 1 is the
+ * fastest, level 9 produces the smallest file and level 0 leaves the
+ * streams uncompressed. Values outside of this range are clamped. The
+ * default is 6.
+ *
+ * Since: 1.16
+ **/
+void
+cairo_pdf_surface_set_compression_level (cairo_surface_t	*surface,
+					 int			 level)
+{
+    cairo_pdf_surface_t *pdf_surface = NULL; /* hide compiler warning */
+
+    if (! _extract_pdf_surface (surface, &pdf_surface))
+	return;
+
+    pdf_surface->compression_level = MAX (0, MIN (level, 9));
+}
+
+/**
+ * cairo_pdf_surface_set_resource_flush_interval:
+ * @surface: a PDF #cairo_surface_t
+ * @num_pages: the number of pages between flushes, or 0
+ *
+ * Normally the fonts used by a document are only written once the
+ * surface is finished, so that each font is embedded just once, and
+ * every image and pattern surface stays known in case a later page
+ * uses it again. For long documents the memory this takes grows with
+ * the length of the document.
+ *
+ * After calling this function with a positive @num_pages, the fonts
+ * used so far are written out and released every @num_pages pages, and
+ * the record of shared surfaces is dropped. Memory use is then bounded
+ * by the content of @num_pages pages, at the cost of a font used
+ * throughout the document being embedded once per interval (as a
+ * separate subset) and of surfaces shared across an interval being
+ * embedded again. A @num_pages of 0, the default, disables flushing.
+ *
+ * Since: 1.16
+ **/
+void
+cairo_pdf_surface_set_resource_flush_interval (cairo_surface_t	*surface,
+					       int		 num_pages)
+{
+    cairo_pdf_surface_t *pdf_surface = NULL; /* hide compiler warning */
+
+    if (! _extract_pdf_surface (surface, &pdf_surface))
+	return;
+
+    pdf_surface->resource_flush_interval = MAX (num_pages, 0);
+}
+
+/**
+ * cairo_pdf_surface_set_image_deduplication:
+ * @surface: a PDF #cairo_surface_t
+ * @deduplicate: whether to merge images by content
+ *
+ * Images are normally embedded once per source surface, or once per
+ * %CAIRO_MIME_TYPE_UNIQUE_ID. If @deduplicate is %TRUE, the pixels of
+ * image sources without a unique ID are also hashed, and images with
+ * identical content share a single image object in the document.
+ *
+ * The hash of each source is computed once and kept with the surface
+ * for as long as its contents are unchanged.
+ *
+ * Since: 1.16
+ **/
+void
+cairo_pdf_surface_set_image_deduplication (cairo_surface_t	*surface,
+					   cairo_bool_t		 deduplicate)
+{
+    cairo_pdf_surface_t *pdf_surface = NULL; /* hide compiler warning */
+
+    if (! _extract_pdf_surface (surface, &pdf_surface))
+	return;
+
+    pdf_surface->deduplicate_images = deduplicate;
+}
+
 static void
 _cairo_pdf_surface_clear (cairo_pdf_surface_t *surface)
 {
@@ -1109,6 +1214,69 @@ _cairo_pdf_surface_add_smask_group (cairo_pdf_surface_t     *surface,
     return _cairo_array_append (&surface->smask_groups, &group);
 }
 
+static unsigned long
+_cairo_pdf_content_row_length (const cairo_image_surface_t *image)
+{
+    /* Only the pixels count, not any padding at the end of the rows. */
+    return (image->width * PIXMAN_FORMAT_BPP (image->pixman_format) + 7) / 8;
+}
+
+/* Returns a reference to the surface holding the pixels of @content,
+ * an image or a snapshot of one. */
+static cairo_surface_t *
+_cairo_pdf_content_get_image (cairo_surface_t *content)
+{
+    if (_cairo_surface_is_snapshot (content))
+	return _cairo_surface_snapshot_get_target (content);
+
+    return cairo_surface_reference (content);
+}
+
+static cairo_bool_t
+_cairo_pdf_content_equal (cairo_surface_t *content_a,
+			  cairo_surface_t *content_b)
+{
+    cairo_surface_t *surface_a, *surface_b;
+    cairo_image_surface_t *a, *b;
+    cairo_bool_t equal = FALSE;
+    unsigned long row_length;
+    int y;
+
+    if (content_a == content_b)
+	return TRUE;
+
+    surface_a = _cairo_pdf_content_get_image (content_a);
+    surface_b = _cairo_pdf_content_get_image (content_b);
+
+    /* a snapshot whose copy failed no longer holds an image */
+    if (surface_a->status || ! _cairo_surface_is_image (surface_a) ||
+	surface_b->status || ! _cairo_surface_is_image (surface_b))
+    {
+	goto done;
+    }
+
+    a = (cairo_image_surface_t *) surface_a;
+    b = (cairo_image_surface_t *) surface_b;
+    if (a->pixman_format != b->pixman_format ||
+	a->width != b->width ||
+	a->height != b->height)
+    {
+	goto done;
+    }
+
+    row_length = _cairo_pdf_content_row_length (a);
+    for (y = 0; y < a->height; y++) {
+	if (memcmp (a->data + y * a->stride, b->data + y * b->stride, row_length))
+	    goto done;
+    }
+    equal = TRUE;
+
+done:
+    cairo_surface_destroy (surface_a);
+    cairo_surface_destroy (surface_b);
+    return equal;
+}
+
 static cairo_bool_t
 _cairo_pdf_source_surface_equal (const void *key_a, const void *key_b)
 {
@@ -1118,8 +1286,16 @@ _cairo_pdf_source_surface_equal (const void *key_a, const void *key_b)
     if (a->interpolate != b->interpolate)
 	return FALSE;
 
-    if (a->unique_id && b->unique_id && a->unique_id_length == b->unique_id_length)
-	return (memcmp (a->unique_id, b->unique_id, a->unique_id_length) == 0);
+    if (a->unique_id && b->unique_id && a->unique_id_length == b->unique_id_length) {
+	if (memcmp (a->unique_id, b->unique_id, a->unique_id_length))
+	    return FALSE;
+
+	/* a content digest is only a hash; confirm the match */
+	if (a->content && b->content)
+	    return _cairo_pdf_content_equal (a->content, b->content);
+
+	return TRUE;
+    }
 
     return (a->id == b->id);
 }
@@ -1135,6 +1311,114 @@ _cairo_pdf_source_surface_init_key (cairo_pdf_source_surface_entry_t *key)
     }
 }
 
+/* The content digest of an image, used in place of a unique ID when
+ * deduplicating images. It is cached on the source surface and is only
+ * valid while the surface's serial is unchanged. */
+typedef struct _cairo_pdf_content_digest {
+    unsigned int serial;
+    struct {
+	char tag[4];
+	uint32_t format;
+	uint32_t width;
+	uint32_t height;
+	uint64_t hash[2];
+    } key;
+} cairo_pdf_content_digest_t;
+
+static const cairo_user_data_key_t _cairo_pdf_content_digest_key;
+
+static void
+_cairo_pdf_content_digest_update (uint64_t hash[2], uint64_t word)
+{
+    hash[0] = (hash[0] ^ word) * 0x100000001b3ULL;
+    hash[1] = (hash[1] + word) * 0x9e3779b97f4a7c15ULL;
+    hash[1] ^= hash[1] >> 29;
+}
+
+static void
+_cairo_pdf_content_digest_compute (cairo_image_surface_t	*image,
+				   cairo_pdf_content_digest_t	*digest)
+{
+    unsigned long row_length;
+    int x, y;
+
+    memcpy (digest->key.tag, "\0pdf", 4);
+    digest->key.format = image->format;
+    digest->key.width = image->width;
+    digest->key.height = image->height;
+    digest->key.hash[0] = 0xcbf29ce484222325ULL;
+    digest->key.hash[1] = 0x84222325cbf29ce4ULL;
+
+    row_length = _cairo_pdf_content_row_length (image);
+    for (y = 0; y < image->height; y++) {
+	const unsigned char *row = image->data + y * image->stride;
+	uint64_t word;
+
+	for (x = 0; x + 8 <= (int) row_length; x += 8) {
+	    memcpy (&word, row + x, 8);
+	    _cairo_pdf_content_digest_update (digest->key.hash, word);
+	}
+	if (x < (int) row_length) {
+	    word = 0;
+	    memcpy (&word, row + x, row_length - x);
+	    _cairo_pdf_content_digest_update (digest->key.hash, word);
+	}
+	_cairo_pdf_content_digest_update (digest->key.hash, y);
+    }
+}
+
+/* Returns a reference to the image holding the pixels of @source if it
+ * is (a snapshot of) an image, or %NULL. */
+static cairo_image_surface_t *
+_cairo_pdf_surface_get_content_image (cairo_surface_t *source)
+{
+    cairo_surface_t *target;
+
+    if (_cairo_surface_is_snapshot (source))
+	target = _cairo_surface_snapshot_get_target (source);
+    else
+	target = cairo_surface_reference (source);
+
+    if (! _cairo_surface_is_image (target) ||
+	((cairo_image_surface_t *) target)->pixman_format == 0)
+    {
+	cairo_surface_destroy (target);
+	return NULL;
+    }
+
+    return (cairo_image_surface_t *) target;
+}
+
+/* Returns the content digest of the pixels of @source, held by @image,
+ * computing and caching it on first use. */
+static const cairo_pdf_content_digest_t *
+_cairo_pdf_surface_get_content_digest (cairo_surface_t		*source,
+				       cairo_image_surface_t	*image)
+{
+    cairo_pdf_content_digest_t *digest;
+
+    digest = cairo_surface_get_user_data (source, &_cairo_pdf_content_digest_key);
+    if (digest != NULL && digest->serial == source->serial)
+	return digest;
+
+    digest = malloc (sizeof (cairo_pdf_content_digest_t));
+    if (unlikely (digest == NULL))
+	return NULL;
+
+    memset (digest, 0, sizeof (cairo_pdf_content_digest_t));
+    digest->serial = source->serial;
+    _cairo_pdf_content_digest_compute (image, digest);
+
+    if (cairo_surface_set_user_data (source, &_cairo_pdf_content_digest_key,
+				     digest, free))
+    {
+	free (digest);
+	return NULL;
+    }
+
+    return digest;
+}
+
 static cairo_int_status_t
 _cairo_pdf_surface_acquire_source_image_from_pattern (cairo_pdf_surface_t          *surface,
 						      const cairo_pattern_t        *pattern,
@@ -1409,9 +1693,31 @@ _cairo_pdf_surface_add_source_surface (cairo_pdf_surface_t	    *surface,
 
     surface_key.id  = source_surface->unique_id;
     surface_key.interpolate = interpolate;
+    surface_key.content = NULL;
     cairo_surface_get_mime_data (source_surface, CAIRO_MIME_TYPE_UNIQUE_ID,
 				 (const unsigned char **) &surface_key.unique_id,
 				 &surface_key.unique_id_length);
+    if (surface_key.unique_id == NULL &&
+	surface->deduplicate_images &&
+	! (source_pattern && source_pattern->type == CAIRO_PATTERN_TYPE_RASTER_SOURCE))
+    {
+	const cairo_pdf_content_digest_t *digest = NULL;
+
+	cairo_image_surface_t *content;
+
+	content = _cairo_pdf_surface_get_content_image (source_surface);
+	if (content != NULL) {
+	    digest = _cairo_pdf_surface_get_content_digest (source_surface,
+							    content);
+	    cairo_surface_destroy (&content->base);
+	}
+	if (digest != NULL) {
+	    /* the key only borrows the source; an entry keeps a snapshot */
+	    surface_key.content = source_surface;
+	    surface_key.unique_id = (unsigned char *) &digest->key;
+	    surface_key.unique_id_length = sizeof (digest->key);
+	}
+    }
     _cairo_pdf_source_surface_init_key (&surface_key);
     surface_entry = _cairo_hash_table_lookup (surface->all_surfaces, &surface_key.base);
     if (surface_entry) {
@@ -1456,6 +1762,16 @@ release_source:
 	goto fail1;
     }
 
+    /* The entry keeps the pixels its digest was computed from, as a
+     * snapshot so that later changes to the source are not seen. */
+    surface_entry->content = NULL;
+    if (surface_key.content) {
+	surface_entry->content = _cairo_surface_snapshot (surface_key.content);
+	status = surface_entry->content->status;
+	if (unlikely (status))
+	    goto fail2;
+    }
+
     surface_entry->id = surface_key.id;
     surface_entry->operator = op;
     surface_entry->interpolate = interpolate;
@@ -1512,6 +1828,8 @@ fail3:
 	cairo_surface_destroy (src_surface.surface);
 
 fail2:
+    if (surface_entry->content)
+	cairo_surface_destroy (surface_entry->content);
     free (surface_entry);
 
 fail1:
@@ -1640,6 +1958,183 @@ _cairo_pdf_surface_add_pdf_pattern (cairo_pdf_surface_t		*surface,
 							  gstate_res);
 }
 
+struct _cairo_pdf_deferred_stream {
+    cairo_list_t link;
+    unsigned int page;
+
+    cairo_pdf_resource_t self;
+    cairo_pdf_resource_t length;
+    cairo_output_stream_t *header;	/* the dictionary up to "stream" */
+
+    unsigned char *data;		/* the uncompressed content */
+    unsigned long data_length;
+
+    int level;
+    cairo_thread_pool_job_t *job;
+    unsigned char *compressed;
+    unsigned long compressed_length;
+    cairo_status_t status;
+};
+
+static cairo_pdf_deferred_stream_t *
+_cairo_pdf_deferred_stream_create (void)
+{
+    cairo_pdf_deferred_stream_t *stream;
+
+    stream = malloc (sizeof (cairo_pdf_deferred_stream_t));
+    if (unlikely (stream == NULL))
+	return NULL;
+
+    stream->header = _cairo_memory_stream_create ();
+    if (_cairo_output_stream_get_status (stream->header)) {
+	_cairo_output_stream_destroy (stream->header);
+	free (stream);
+	return NULL;
+    }
+
+    cairo_list_init (&stream->link);
+    stream->data = NULL;
+    stream->data_length = 0;
+    stream->level = CAIRO_DEFLATE_LEVEL_DEFAULT;
+    stream->job = NULL;
+    stream->compressed = NULL;
+    stream->compressed_length = 0;
+    stream->status = CAIRO_STATUS_SUCCESS;
+
+    return stream;
+}
+
+static void
+_cairo_pdf_deferred_stream_destroy (cairo_pdf_deferred_stream_t *stream)
+{
+    _cairo_thread_pool_wait (stream->job);
+
+    cairo_list_del (&stream->link);
+    _cairo_output_stream_destroy (stream->header);
+    free (stream->compressed);
+    free (stream->data);
+    free (stream);
+}
+
+/* Runs on a worker thread, and so must only touch @closure. As the whole
+ * stream is known by now, it is deflated in a single pass. */
+static void
+_cairo_pdf_deferred_stream_compress (void *closure)
+{
+    cairo_pdf_deferred_stream_t *stream = closure;
+
+    stream->status = _cairo_deflate_compress (stream->data,
+					      stream->data_length,
+					      stream->level,
+					      &stream->compressed,
+					      &stream->compressed_length);
+
+    free (stream->data);
+    stream->data = NULL;
+}
+
+static cairo_int_status_t
+_cairo_pdf_surface_close_deferred_stream (cairo_pdf_surface_t	*surface,
+					  cairo_int_status_t	 status)
+{
+    cairo_pdf_deferred_stream_t *stream = surface->pdf_stream.deferred;
+    cairo_int_status_t status2;
+
+    status2 = _cairo_memory_stream_destroy (surface->output,
+					    &stream->data,
+					    &stream->data_length);
+    if (likely (status == CAIRO_INT_STATUS_SUCCESS))
+	status = status2;
+    if (likely (status == CAIRO_INT_STATUS_SUCCESS))
+	status = _cairo_output_stream_get_status (stream->header);
+
+    surface->output = surface->pdf_stream.old_output;
+    _cairo_pdf_operators_set_stream (&surface->pdf_operators, surface->output);
+    surface->pdf_stream.old_output = NULL;
+    surface->pdf_stream.deferred = NULL;
+    surface->pdf_stream.active = FALSE;
+
+    if (unlikely (status)) {
+	_cairo_pdf_deferred_stream_destroy (stream);
+	return status;
+    }
+
+    stream->page = surface->deferred_page;
+    cairo_list_add_tail (&stream->link, &surface->deferred_streams);
+    stream->job = _cairo_thread_pool_submit (_cairo_pdf_deferred_stream_compress,
+					     stream);
+
+    return CAIRO_INT_STATUS_SUCCESS;
+}
+
+static cairo_int_status_t
+_cairo_pdf_surface_write_deferred_stream (cairo_pdf_surface_t		*surface,
+					  cairo_pdf_deferred_stream_t	*stream)
+{
+    _cairo_thread_pool_wait (stream->job);
+    stream->job = NULL;
+    if (unlikely (stream->status))
+	return stream->status;
+
+    _cairo_pdf_surface_update_object (surface, stream->self);
+    _cairo_memory_stream_copy (stream->header, surface->output);
+    _cairo_output_stream_write (surface->output,
+				stream->compressed,
+				stream->compressed_length);
+    _cairo_output_stream_printf (surface->output,
+				 "\n"
+				 "endstream\n"
+				 "endobj\n");
+
+    _cairo_pdf_surface_update_object (surface, stream->length);
+    _cairo_output_stream_printf (surface->output,
+				 "%d 0 obj\n"
+				 "   %lu\n"
+				 "endobj\n",
+				 stream->length.id,
+				 stream->compressed_length);
+
+    return _cairo_output_stream_get_status (surface->output);
+}
+
+/* Writes out, in the order they were closed, the deferred streams of
+ * the pages before the current one, or all of them.  The output, and
+ * the numbering of the objects, is independent of how the compression
+ * was scheduled. */
+static cairo_int_status_t
+_cairo_pdf_surface_write_deferred_streams (cairo_pdf_surface_t	*surface,
+					   cairo_bool_t		 all)
+{
+    cairo_int_status_t status = CAIRO_INT_STATUS_SUCCESS;
+
+    while (! cairo_list_is_empty (&surface->deferred_streams)) {
+	cairo_pdf_deferred_stream_t *stream;
+
+	stream = cairo_list_first_entry (&surface->deferred_streams,
+					 cairo_pdf_deferred_stream_t,
+					 link);
+	if (! all && stream->page >= surface->deferred_page)
+	    break;
+
+	if (likely (status == CAIRO_INT_STATUS_SUCCESS))
+	    status = _cairo_pdf_surface_write_deferred_stream (surface, stream);
+	_cairo_pdf_deferred_stream_destroy (stream);
+    }
+
+    return status;
+}
+
+static void
+_cairo_pdf_surface_discard_deferred_streams (cairo_pdf_surface_t *surface)
+{
+    while (! cairo_list_is_empty (&surface->deferred_streams)) {
+	_cairo_pdf_deferred_stream_destroy (
+	    cairo_list_first_entry (&surface->deferred_streams,
+				    cairo_pdf_deferred_stream_t,
+				    link));
+    }
+}
+
 static cairo_int_status_t
 _cairo_pdf_surface_open_stream (cairo_pdf_surface_t	*surface,
 				cairo_pdf_resource_t    *resource,
@@ -1650,22 +2145,48 @@ _cairo_pdf_surface_open_stream (cairo_pdf_surface_t	*surface,
     va_list ap;
     cairo_pdf_resource_t self, length;
     cairo_output_stream_t *output = NULL;
+    cairo_output_stream_t *header = surface->output;
+    cairo_pdf_deferred_stream_t *deferred = NULL;
+    cairo_status_t status;
+
+    if (compressed && surface->defer_compression) {
+	deferred = _cairo_pdf_deferred_stream_create ();
+	if (unlikely (deferred == NULL))
+	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    }
 
     if (resource) {
 	self = *resource;
-	_cairo_pdf_surface_update_object (surface, self);
+	/* A deferred stream is located when it is finally written. */
+	if (deferred == NULL)
+	    _cairo_pdf_surface_update_object (surface, self);
     } else {
 	self = _cairo_pdf_surface_new_object (surface);
-	if (self.id == 0)
-	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	if (self.id == 0) {
+	    status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	    goto BAIL;
+	}
     }
 
     length = _cairo_pdf_surface_new_object (surface);
-    if (length.id == 0)
-	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    if (length.id == 0) {
+	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	goto BAIL;
+    }
 
-    if (compressed) {
-	output = _cairo_deflate_stream_create (surface->output);
+    if (deferred != NULL) {
+	deferred->self = self;
+	deferred->length = length;
+	deferred->level = surface->compression_level;
+	header = deferred->header;
+	output = _cairo_memory_stream_create ();
+	if (_cairo_output_stream_get_status (output)) {
+	    status = _cairo_output_stream_destroy (output);
+	    goto BAIL;
+	}
+    } else if (compressed) {
+	output = _cairo_deflate_stream_create_with_level (surface->output,
+							  surface->compression_level);
 	if (_cairo_output_stream_get_status (output))
 	    return _cairo_output_stream_destroy (output);
     }
@@ -1674,26 +2195,27 @@ _cairo_pdf_surface_open_stream (cairo_pdf_surface_t	*surface,
     surface->pdf_stream.self = self;
     surface->pdf_stream.length = length;
     surface->pdf_stream.compressed = compressed;
+    surface->pdf_stream.deferred = deferred;
     surface->current_pattern_is_solid_color = FALSE;
     surface->current_operator = CAIRO_OPERATOR_OVER;
     _cairo_pdf_operators_reset (&surface->pdf_operators);
 
-    _cairo_output_stream_printf (surface->output,
+    _cairo_output_stream_printf (header,
 				 "%d 0 obj\n"
 				 "<< /Length %d 0 R\n",
 				 surface->pdf_stream.self.id,
 				 surface->pdf_stream.length.id);
     if (compressed)
-	_cairo_output_stream_printf (surface->output,
+	_cairo_output_stream_printf (header,
 				     "   /Filter /FlateDecode\n");
 
     if (fmt != NULL) {
 	va_start (ap, fmt);
-	_cairo_output_stream_vprintf (surface->output, fmt, ap);
+	_cairo_output_stream_vprintf (header, fmt, ap);
 	va_end (ap);
     }
 
-    _cairo_output_stream_printf (surface->output,
+    _cairo_output_stream_printf (header,
 				 ">>\n"
 				 "stream\n");
 
@@ -1707,6 +2229,11 @@ _cairo_pdf_surface_open_stream (cairo_pdf_surface_t	*surface,
     }
 
     return _cairo_output_stream_get_status (surface->output);
+
+BAIL:
+    if (deferred != NULL)
+	_cairo_pdf_deferred_stream_destroy (deferred);
+    return status;
 }
 
 static cairo_int_status_t
@@ -1720,6 +2247,9 @@ _cairo_pdf_surface_close_stream (cairo_pdf_surface_t *surface)
 
     status = _cairo_pdf_operators_flush (&surface->pdf_operators);
 
+    if (surface->pdf_stream.deferred != NULL)
+	return _cairo_pdf_surface_close_deferred_stream (surface, status);
+
     if (surface->pdf_stream.compressed) {
 	cairo_int_status_t status2;
 
@@ -1824,7 +2354,8 @@ _cairo_pdf_surface_open_group (cairo_pdf_surface_t         *surface,
 
     if (surface->compress_content) {
 	surface->group_stream.stream =
-	    _cairo_deflate_stream_create (surface->group_stream.mem_stream);
+	    _cairo_deflate_stream_create_with_level (surface->group_stream.mem_stream,
+						     surface->compression_level);
     } else {
 	surface->group_stream.stream = surface->group_stream.mem_stream;
     }
@@ -2012,6 +2543,8 @@ _cairo_pdf_source_surface_entry_pluck (void *entry, void *closure)
 
     _cairo_hash_table_remove (patterns, &surface_entry->base);
     free (surface_entry->unique_id);
+    if (surface_entry->content)
+	cairo_surface_destroy (surface_entry->content);
 
     free (surface_entry);
 }
@@ -2030,6 +2563,10 @@ _cairo_pdf_surface_finish (void *abstract_surface)
     if (status == CAIRO_STATUS_SUCCESS)
 	status = _cairo_pdf_surface_emit_font_subsets (surface);
 
+    status2 = _cairo_pdf_surface_write_deferred_streams (surface, TRUE);
+    if (status == CAIRO_STATUS_SUCCESS)
+	status = status2;
+
     _cairo_pdf_surface_write_pages (surface);
 
     info = _cairo_pdf_surface_write_info (surface);
@@ -2069,6 +2606,7 @@ _cairo_pdf_surface_finish (void *abstract_surface)
     status2 = _cairo_pdf_surface_close_stream (surface);
     if (status == CAIRO_STATUS_SUCCESS)
 	status = status2;
+    _cairo_pdf_surface_discard_deferred_streams (surface);
 
     if (surface->group_stream.stream != NULL) {
 	status2 = _cairo_output_stream_destroy (surface->group_stream.stream);
@@ -4605,6 +5143,21 @@ _cairo_pdf_surface_show_page (void *abstract_surface)
 
     _cairo_pdf_surface_clear (surface);
 
+    if (surface->resource_flush_interval > 0 &&
+	++surface->pages_since_resource_flush >= surface->resource_flush_interval)
+    {
+	surface->pages_since_resource_flush = 0;
+	status = _cairo_pdf_surface_flush_resources (surface);
+	if (unlikely (status))
+	    return status;
+    }
+
+    /* Let the streams of this page compress while the next is drawn. */
+    status = _cairo_pdf_surface_write_deferred_streams (surface, FALSE);
+    surface->deferred_page++;
+    if (unlikely (status))
+	return status;
+
     return CAIRO_STATUS_SUCCESS;
 }
 
@@ -5970,6 +6523,42 @@ BAIL:
     return status;
 }
 
+/* Emit the fonts used by the pages so far and start afresh, so that
+ * neither they nor the record of the surfaces already embedded are kept
+ * until the end of the document. Called between pages. */
+static cairo_int_status_t
+_cairo_pdf_surface_flush_resources (cairo_pdf_surface_t *surface)
+{
+    cairo_scaled_font_subsets_t *font_subsets;
+    cairo_int_status_t status;
+
+    assert (! surface->pdf_stream.active);
+    assert (! surface->group_stream.active);
+
+    /* Allocate the replacement first: emitting consumes the current
+     * subsets, and finish must always find a set to emit. */
+    font_subsets = _cairo_scaled_font_subsets_create_composite ();
+    if (unlikely (font_subsets == NULL))
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+    _cairo_scaled_font_subsets_enable_latin_subset (font_subsets, TRUE);
+
+    status = _cairo_pdf_surface_emit_font_subsets (surface);
+    surface->font_subsets = font_subsets;
+    _cairo_pdf_operators_set_font_subsets (&surface->pdf_operators,
+					   surface->font_subsets);
+    if (unlikely (status))
+	return status;
+
+    _cairo_array_truncate (&surface->fonts, 0);
+
+    _cairo_hash_table_foreach (surface->all_surfaces,
+			       _cairo_pdf_source_surface_entry_pluck,
+			       surface->all_surfaces);
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
 static cairo_pdf_resource_t
 _cairo_pdf_surface_write_catalog (cairo_pdf_surface_t *surface)
 {
@@ -85,6 +85,18 @@ cairo_pdf_surface_set_size (cairo_surface_t	*surface,
 			    double		 width_in_points,
 			    double		 height_in_points);
 
+cairo_public void
+cairo_pdf_surface_set_compression_level (cairo_surface_t	*surface,
+					 int			 level);
+
+cairo_public void
+cairo_pdf_surface_set_resource_flush_interval (cairo_surface_t	*surface,
+					       int		 num_pages);
+
+cairo_public void
+cairo_pdf_surface_set_image_deduplication (cairo_surface_t	*surface,
+					   cairo_bool_t		 deduplicate);
+
 CAIRO_END_DECLS
 
 #else  /* CAIRO_HAS_PDF_SURFACE */
@@ -0,0 +1,68 @@
+/* -*- Mode: c; tab-width: 8; c-basic-offset: 4; indent-tabs-mode: t; -*- */
+/* cairo - a vector graphics library with display and print output
+ *
+ * Copyright © 2026 the cairo authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ *
+ * The Initial Developer of the Original Code is the cairo authors.
+ */
+
+#ifndef CAIRO_PNG_SIMD_PRIVATE_H
+#define CAIRO_PNG_SIMD_PRIVATE_H
+
+#include "cairo-compiler-private.h"
+#include "cairo-types-private.h"
+
+CAIRO_BEGIN_DECLS
+
+/* Vectorised row converters for the libpng user transforms in
+ * cairo-png.c.  Each converter rewrites a prefix of the row in place,
+ * whose length in pixels is a multiple of its vector width, and
+ * returns the number of pixels it consumed; the caller converts the
+ * remainder with the scalar loop.  The results are bit-identical to
+ * the scalar code, including for pixels that are not validly
+ * premultiplied.
+ *
+ *   premultiply:     RGBA bytes => premultiplied native ARGB32
+ *   unpremultiply:   premultiplied native ARGB32 => RGBA bytes
+ *   data_to_bytes:   native xRGB32 => RGBx bytes
+ *   bytes_to_data:   RGBx bytes => native xRGB32
+ */
+typedef struct _cairo_png_simd {
+    int (*premultiply) (uint8_t *row, int len);
+    int (*unpremultiply) (uint8_t *row, int len);
+    int (*data_to_bytes) (uint8_t *row, int len);
+    int (*bytes_to_data) (uint8_t *row, int len);
+} cairo_png_simd_t;
+
+/* Returns the best set of converters for the running CPU, or NULL. */
+cairo_private const cairo_png_simd_t *
+_cairo_png_simd_get (void);
+
+CAIRO_END_DECLS
+
+#endif /* CAIRO_PNG_SIMD_PRIVATE_H */
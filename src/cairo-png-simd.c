@@ -0,0 +1,346 @@
+/* -*- Mode: c; tab-width: 8; c-basic-offset: 4; indent-tabs-mode: t; -*- */
+/* cairo - a vector graphics library with display and print output
+ *
+ * Copyright © 2026 the cairo authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ *
+ * The Initial Developer of the Original Code is the cairo authors.
+ */
+
+#include "cairoint.h"
+
+#include "cairo-png-simd-private.h"
+
+#if defined(__SSE2__)
+#define HAVE_PNG_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if HAVE_PNG_SSE2 && defined(__GNUC__) && \
+    (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define HAVE_PNG_AVX2 1
+#include <immintrin.h>
+#define AVX2 __attribute__((target("avx2")))
+#endif
+
+#if HAVE_PNG_SSE2
+/* Unpremultiplying computes (c * 255 + a / 2) / a per channel.  We
+ * multiply by a single precision reciprocal of the alpha instead of
+ * dividing; as every operand is an integer below 2^17 the estimate is
+ * within one of the true quotient, and one exact correction step in
+ * either direction recovers the result of the integer division.
+ * Entry 0 is a dummy, transparent pixels are cleared separately.
+ */
+#define RCP1(a) (1.f / ((a) | !(a)))
+#define RCP4(a) RCP1(a), RCP1(a + 1), RCP1(a + 2), RCP1(a + 3)
+#define RCP16(a) RCP4(a), RCP4(a + 4), RCP4(a + 8), RCP4(a + 12)
+#define RCP64(a) RCP16(a), RCP16(a + 16), RCP16(a + 32), RCP16(a + 48)
+static const float rcp_table[256] = {
+    RCP64(0), RCP64(64), RCP64(128), RCP64(192)
+};
+#undef RCP64
+#undef RCP16
+#undef RCP4
+#undef RCP1
+
+/* a * c / 255 on unpacked 16-bit channels, rounded as multiply_alpha() */
+static inline __m128i
+mul_alpha_sse2 (__m128i c, __m128i a)
+{
+    __m128i t = _mm_add_epi16 (_mm_mullo_epi16 (c, a), _mm_set1_epi16 (0x80));
+    return _mm_srli_epi16 (_mm_add_epi16 (t, _mm_srli_epi16 (t, 8)), 8);
+}
+
+/* RGBA => BGRA with the colour premultiplied, two pixels per register */
+static inline __m128i
+premultiply2_sse2 (__m128i v)
+{
+    __m128i a;
+
+    a = _mm_shufflelo_epi16 (v, _MM_SHUFFLE (3, 3, 3, 3));
+    a = _mm_shufflehi_epi16 (a, _MM_SHUFFLE (3, 3, 3, 3));
+    a = _mm_or_si128 (a, _mm_set_epi16 (0xff, 0, 0, 0, 0xff, 0, 0, 0));
+
+    v = mul_alpha_sse2 (v, a);
+    v = _mm_shufflelo_epi16 (v, _MM_SHUFFLE (3, 0, 1, 2));
+    return _mm_shufflehi_epi16 (v, _MM_SHUFFLE (3, 0, 1, 2));
+}
+
+static int
+premultiply_sse2 (uint8_t *row, int len)
+{
+    const __m128i zero = _mm_setzero_si128 ();
+    int n;
+
+    for (n = 0; n + 4 <= len; n += 4) {
+	__m128i v = _mm_loadu_si128 ((__m128i *) (row + 4 * n));
+
+	v = _mm_packus_epi16 (premultiply2_sse2 (_mm_unpacklo_epi8 (v, zero)),
+			      premultiply2_sse2 (_mm_unpackhi_epi8 (v, zero)));
+	_mm_storeu_si128 ((__m128i *) (row + 4 * n), v);
+    }
+
+    return n;
+}
+
+/* (c * 255 + a / 2) / a, truncated to 8 bits */
+static inline __m128i
+unpremultiply_channel_sse2 (__m128i c, __m128i h, __m128 fa, __m128 rcp)
+{
+    __m128i n, q;
+    __m128 fn;
+
+    n = _mm_add_epi32 (_mm_sub_epi32 (_mm_slli_epi32 (c, 8), c), h);
+    fn = _mm_cvtepi32_ps (n);
+    q = _mm_cvttps_epi32 (_mm_mul_ps (fn, rcp));
+
+    /* the comparisons yield -1 where the estimate needs adjusting */
+    q = _mm_sub_epi32 (q, _mm_castps_si128 (_mm_cmple_ps (_mm_mul_ps (_mm_cvtepi32_ps (_mm_add_epi32 (q, _mm_set1_epi32 (1))), fa), fn)));
+    q = _mm_add_epi32 (q, _mm_castps_si128 (_mm_cmpgt_ps (_mm_mul_ps (_mm_cvtepi32_ps (q), fa), fn)));
+
+    return _mm_and_si128 (q, _mm_set1_epi32 (0xff));
+}
+
+static int
+unpremultiply_sse2 (uint8_t *row, int len)
+{
+    const __m128i mask = _mm_set1_epi32 (0xff);
+    int n;
+
+    for (n = 0; n + 4 <= len; n += 4) {
+	uint8_t *b = row + 4 * n;
+	__m128i p = _mm_loadu_si128 ((__m128i *) b);
+	__m128i a, h, r, g, v;
+	__m128 fa, rcp;
+
+	a = _mm_srli_epi32 (p, 24);
+	h = _mm_srli_epi32 (a, 1);
+	fa = _mm_cvtepi32_ps (a);
+	rcp = _mm_set_ps (rcp_table[b[15]], rcp_table[b[11]],
+			  rcp_table[b[7]], rcp_table[b[3]]);
+
+	r = unpremultiply_channel_sse2 (_mm_and_si128 (_mm_srli_epi32 (p, 16), mask), h, fa, rcp);
+	g = unpremultiply_channel_sse2 (_mm_and_si128 (_mm_srli_epi32 (p, 8), mask), h, fa, rcp);
+	v = unpremultiply_channel_sse2 (_mm_and_si128 (p, mask), h, fa, rcp);
+
+	v = _mm_or_si128 (_mm_or_si128 (r, _mm_slli_epi32 (g, 8)),
+			  _mm_or_si128 (_mm_slli_epi32 (v, 16), _mm_slli_epi32 (a, 24)));
+	v = _mm_andnot_si128 (_mm_cmpeq_epi32 (a, _mm_setzero_si128 ()), v);
+	_mm_storeu_si128 ((__m128i *) b, v);
+    }
+
+    return n;
+}
+
+/* Swaps the first and third bytes of each pixel and replaces the fourth */
+static inline __m128i
+swap_rb_sse2 (__m128i p, __m128i x)
+{
+    const __m128i mask = _mm_set1_epi32 (0xff);
+
+    return _mm_or_si128 (_mm_or_si128 (_mm_and_si128 (_mm_srli_epi32 (p, 16), mask),
+				       _mm_and_si128 (p, _mm_set1_epi32 (0xff00))),
+			 _mm_or_si128 (_mm_slli_epi32 (_mm_and_si128 (p, mask), 16), x));
+}
+
+static int
+data_to_bytes_sse2 (uint8_t *row, int len)
+{
+    int n;
+
+    for (n = 0; n + 4 <= len; n += 4) {
+	__m128i v = _mm_loadu_si128 ((__m128i *) (row + 4 * n));
+	_mm_storeu_si128 ((__m128i *) (row + 4 * n),
+			  swap_rb_sse2 (v, _mm_setzero_si128 ()));
+    }
+
+    return n;
+}
+
+static int
+bytes_to_data_sse2 (uint8_t *row, int len)
+{
+    int n;
+
+    for (n = 0; n + 4 <= len; n += 4) {
+	__m128i v = _mm_loadu_si128 ((__m128i *) (row + 4 * n));
+	_mm_storeu_si128 ((__m128i *) (row + 4 * n),
+			  swap_rb_sse2 (v, _mm_set1_epi32 (0xff000000)));
+    }
+
+    return n;
+}
+
+static const cairo_png_simd_t png_sse2 = {
+    premultiply_sse2,
+    unpremultiply_sse2,
+    data_to_bytes_sse2,
+    bytes_to_data_sse2,
+};
+#endif
+
+#if HAVE_PNG_AVX2
+static inline AVX2 __m256i
+premultiply2_avx2 (__m256i v)
+{
+    __m256i a, t;
+
+    a = _mm256_shufflelo_epi16 (v, _MM_SHUFFLE (3, 3, 3, 3));
+    a = _mm256_shufflehi_epi16 (a, _MM_SHUFFLE (3, 3, 3, 3));
+    a = _mm256_or_si256 (a, _mm256_set1_epi64x (0x00ff000000000000));
+
+    t = _mm256_add_epi16 (_mm256_mullo_epi16 (v, a), _mm256_set1_epi16 (0x80));
+    v = _mm256_srli_epi16 (_mm256_add_epi16 (t, _mm256_srli_epi16 (t, 8)), 8);
+    v = _mm256_shufflelo_epi16 (v, _MM_SHUFFLE (3, 0, 1, 2));
+    return _mm256_shufflehi_epi16 (v, _MM_SHUFFLE (3, 0, 1, 2));
+}
+
+static AVX2 int
+premultiply_avx2 (uint8_t *row, int len)
+{
+    const __m256i zero = _mm256_setzero_si256 ();
+    int n;
+
+    for (n = 0; n + 8 <= len; n += 8) {
+	__m256i v = _mm256_loadu_si256 ((__m256i *) (row + 4 * n));
+
+	v = _mm256_packus_epi16 (premultiply2_avx2 (_mm256_unpacklo_epi8 (v, zero)),
+				 premultiply2_avx2 (_mm256_unpackhi_epi8 (v, zero)));
+	_mm256_storeu_si256 ((__m256i *) (row + 4 * n), v);
+    }
+
+    return n;
+}
+
+static inline AVX2 __m256i
+unpremultiply_channel_avx2 (__m256i c, __m256i h, __m256 fa, __m256 rcp)
+{
+    __m256i n, q;
+    __m256 fn;
+
+    n = _mm256_add_epi32 (_mm256_sub_epi32 (_mm256_slli_epi32 (c, 8), c), h);
+    fn = _mm256_cvtepi32_ps (n);
+    q = _mm256_cvttps_epi32 (_mm256_mul_ps (fn, rcp));
+
+    q = _mm256_sub_epi32 (q, _mm256_castps_si256 (_mm256_cmp_ps (_mm256_mul_ps (_mm256_cvtepi32_ps (_mm256_add_epi32 (q, _mm256_set1_epi32 (1))), fa), fn, _CMP_LE_OQ)));
+    q = _mm256_add_epi32 (q, _mm256_castps_si256 (_mm256_cmp_ps (_mm256_mul_ps (_mm256_cvtepi32_ps (q), fa), fn, _CMP_GT_OQ)));
+
+    return _mm256_and_si256 (q, _mm256_set1_epi32 (0xff));
+}
+
+static AVX2 int
+unpremultiply_avx2 (uint8_t *row, int len)
+{
+    const __m256i mask = _mm256_set1_epi32 (0xff);
+    int n;
+
+    for (n = 0; n + 8 <= len; n += 8) {
+	__m256i p = _mm256_loadu_si256 ((__m256i *) (row + 4 * n));
+	__m256i a, h, r, g, v;
+	__m256 fa, rcp;
+
+	a = _mm256_srli_epi32 (p, 24);
+	h = _mm256_srli_epi32 (a, 1);
+	fa = _mm256_cvtepi32_ps (a);
+	rcp = _mm256_i32gather_ps (rcp_table, a, 4);
+
+	r = unpremultiply_channel_avx2 (_mm256_and_si256 (_mm256_srli_epi32 (p, 16), mask), h, fa, rcp);
+	g = unpremultiply_channel_avx2 (_mm256_and_si256 (_mm256_srli_epi32 (p, 8), mask), h, fa, rcp);
+	v = unpremultiply_channel_avx2 (_mm256_and_si256 (p, mask), h, fa, rcp);
+
+	v = _mm256_or_si256 (_mm256_or_si256 (r, _mm256_slli_epi32 (g, 8)),
+			     _mm256_or_si256 (_mm256_slli_epi32 (v, 16), _mm256_slli_epi32 (a, 24)));
+	v = _mm256_andnot_si256 (_mm256_cmpeq_epi32 (a, _mm256_setzero_si256 ()), v);
+	_mm256_storeu_si256 ((__m256i *) (row + 4 * n), v);
+    }
+
+    return n;
+}
+
+/* RGBx <=> xRGB is the same byte shuffle in both directions */
+static inline AVX2 __m256i
+swap_rb_avx2 (__m256i p, __m256i x)
+{
+    const __m256i shuffle = _mm256_setr_epi8 (2, 1, 0, -1, 6, 5, 4, -1,
+					      10, 9, 8, -1, 14, 13, 12, -1,
+					      2, 1, 0, -1, 6, 5, 4, -1,
+					      10, 9, 8, -1, 14, 13, 12, -1);
+
+    return _mm256_or_si256 (_mm256_shuffle_epi8 (p, shuffle), x);
+}
+
+static AVX2 int
+data_to_bytes_avx2 (uint8_t *row, int len)
+{
+    int n;
+
+    for (n = 0; n + 8 <= len; n += 8) {
+	__m256i v = _mm256_loadu_si256 ((__m256i *) (row + 4 * n));
+	_mm256_storeu_si256 ((__m256i *) (row + 4 * n),
+			     swap_rb_avx2 (v, _mm256_setzero_si256 ()));
+    }
+
+    return n;
+}
+
+static AVX2 int
+bytes_to_data_avx2 (uint8_t *row, int len)
+{
+    int n;
+
+    for (n = 0; n + 8 <= len; n += 8) {
+	__m256i v = _mm256_loadu_si256 ((__m256i *) (row + 4 * n));
+	_mm256_storeu_si256 ((__m256i *) (row + 4 * n),
+			     swap_rb_avx2 (v, _mm256_set1_epi32 (0xff000000)));
+    }
+
+    return n;
+}
+
+static const cairo_png_simd_t png_avx2 = {
+    premultiply_avx2,
+    unpremultiply_avx2,
+    data_to_bytes_avx2,
+    bytes_to_data_avx2,
+};
+#endif
+
+const cairo_png_simd_t *
+_cairo_png_simd_get (void)
+{
+#if HAVE_PNG_AVX2
+    __builtin_cpu_init ();
+    if (__builtin_cpu_supports ("avx2"))
+	return &png_avx2;
+#endif
+
+#if HAVE_PNG_SSE2
+    return &png_sse2;
+#else
+    return NULL;
+#endif
+}
@@ -41,6 +41,7 @@
 #include "cairo-error-private.h"
 #include "cairo-image-surface-private.h"
 #include "cairo-output-stream-private.h"
+#include "cairo-png-simd-private.h"
 
 #include <stdio.h>
 #include <errno.h>
@@ -85,9 +86,13 @@ struct png_read_closure_t {
 static void
 unpremultiply_data (png_structp png, png_row_infop row_info, png_bytep data)
 {
-    unsigned int i;
+    const cairo_png_simd_t *simd = png_get_user_transform_ptr (png);
+    unsigned int i = 0;
+
+    if (simd != NULL)
+	i = 4 * simd->unpremultiply (data, row_info->rowbytes / 4);
 
-    for (i = 0; i < row_info->rowbytes; i += 4) {
+    for (; i < row_info->rowbytes; i += 4) {
         uint8_t *b = &data[i];
         uint32_t pixel;
         uint8_t  alpha;
@@ -109,9 +114,13 @@ unpremultiply_data (png_structp png, png_row_infop row_info, png_bytep data)
 static void
 convert_data_to_bytes (png_structp png, png_row_infop row_info, png_bytep data)
 {
-    unsigned int i;
+    const cairo_png_simd_t *simd = png_get_user_transform_ptr (png);
+    unsigned int i = 0;
 
-    for (i = 0; i < row_info->rowbytes; i += 4) {
+    if (simd != NULL)
+	i = 4 * simd->data_to_bytes (data, row_info->rowbytes / 4);
+
+    for (; i < row_info->rowbytes; i += 4) {
         uint8_t *b = &data[i];
         uint32_t pixel;
 
@@ -295,6 +304,9 @@ write_png (cairo_surface_t	*surface,
      */
     png_write_info (png, info);
 
+    /* The row converters pick up the vectorised kernels from here */
+    png_set_user_transform_info (png, (void *) _cairo_png_simd_get (), 0, 0);
+
     if (png_color_type == PNG_COLOR_TYPE_RGB_ALPHA) {
 	png_set_write_user_transform_fn (png, unpremultiply_data);
     } else if (png_color_type == PNG_COLOR_TYPE_RGB) {
@@ -454,9 +466,13 @@ premultiply_data (png_structp   png,
                   png_row_infop row_info,
                   png_bytep     data)
 {
-    unsigned int i;
+    const cairo_png_simd_t *simd = png_get_user_transform_ptr (png);
+    unsigned int i = 0;
+
+    if (simd != NULL)
+	i = 4 * simd->premultiply (data, row_info->rowbytes / 4);
 
-    for (i = 0; i < row_info->rowbytes; i += 4) {
+    for (; i < row_info->rowbytes; i += 4) {
 	uint8_t *base  = &data[i];
 	uint8_t  alpha = base[3];
 	uint32_t p;
@@ -483,9 +499,13 @@ premultiply_data (png_structp   png,
 static void
 convert_bytes_to_data (png_structp png, png_row_infop row_info, png_bytep data)
 {
-    unsigned int i;
+    const cairo_png_simd_t *simd = png_get_user_transform_ptr (png);
+    unsigned int i = 0;
 
-    for (i = 0; i < row_info->rowbytes; i += 4) {
+    if (simd != NULL)
+	i = 4 * simd->bytes_to_data (data, row_info->rowbytes / 4);
+
+    for (; i < row_info->rowbytes; i += 4) {
 	uint8_t *base  = &data[i];
 	uint8_t  red   = base[0];
 	uint8_t  green = base[1];
@@ -623,6 +643,9 @@ read_png (struct png_read_closure_t *png_closure)
 
     png_set_filler (png, 0xff, PNG_FILLER_AFTER);
 
+    /* libpng refuses to change this once the row transforms are set up */
+    png_set_user_transform_info (png, (void *) _cairo_png_simd_get (), 0, 0);
+
     /* recheck header after setting EXPAND options */
     png_read_update_info (png, info);
     png_get_IHDR (png, info,
@@ -71,6 +71,7 @@ typedef struct cairo_ps_surface {
     cairo_matrix_t cairo_to_ps;
 
     cairo_bool_t use_string_datasource;
+    int compression_level;
 
     cairo_bool_t current_pattern_is_solid_color;
     cairo_color_t current_color;
@@ -1048,6 +1048,7 @@ _cairo_ps_surface_create_for_stream_internal (cairo_output_stream_t *stream,
     _cairo_scaled_font_subsets_enable_latin_subset (surface->font_subsets, TRUE);
     surface->has_creation_date = FALSE;
     surface->eps = FALSE;
+    surface->compression_level = CAIRO_DEFLATE_LEVEL_DEFAULT;
     surface->ps_level = CAIRO_PS_LEVEL_3;
     surface->ps_level_used = CAIRO_PS_LEVEL_2;
     surface->width  = width;
@@ -1410,6 +1411,31 @@ cairo_ps_surface_set_size (cairo_surface_t	*surface,
 	status = _cairo_surface_set_error (surface, status);
 }
 
+/**
+ * cairo_ps_surface_set_compression_level:
+ * @surface: a PostScript #cairo_surface_t
+ * @level: the deflate compression level, from 0 to 9
+ *
+ * Sets the effort spent compressing the images subsequently written to
+ * the PostScript output at language level 3. Level 1 is the fastest,
+ * level 9 produces the smallest output and level 0 stores the data
+ * uncompressed. Values outside of this range are clamped. The default
+ * is 6.
+ *
+ * Since: 1.16
+ **/
+void
+cairo_ps_surface_set_compression_level (cairo_surface_t	*surface,
+					int		 level)
+{
+    cairo_ps_surface_t *ps_surface = NULL;
+
+    if (! _extract_ps_surface (surface, TRUE, &ps_surface))
+	return;
+
+    ps_surface->compression_level = MAX (0, MIN (level, 9));
+}
+
 /**
  * cairo_ps_surface_dsc_comment:
  * @surface: a PostScript #cairo_surface_t
@@ -2402,7 +2428,8 @@ _cairo_ps_surface_emit_base85_string (cairo_ps_surface_t    *surface,
 	    break;
 
 	case CAIRO_PS_COMPRESS_DEFLATE:
-	    deflate_stream = _cairo_deflate_stream_create (base85_stream);
+	    deflate_stream = _cairo_deflate_stream_create_with_level (base85_stream,
+								      surface->compression_level);
 	    if (_cairo_output_stream_get_status (deflate_stream)) {
 		return _cairo_output_stream_destroy (deflate_stream);
 	    }
@@ -97,6 +97,10 @@ cairo_ps_surface_set_size (cairo_surface_t	*surface,
 			   double		 width_in_points,
 			   double		 height_in_points);
 
+cairo_public void
+cairo_ps_surface_set_compression_level (cairo_surface_t	*surface,
+					int		 level);
+
 cairo_public void
 cairo_ps_surface_dsc_comment (cairo_surface_t	*surface,
 			      const char	*comment);
@@ -38,6 +38,7 @@
 #define CAIRO_RECORDING_SURFACE_H
 
 #include "cairoint.h"
+#include "cairo-arena-private.h"
 #include "cairo-path-fixed-private.h"
 #include "cairo-pattern-private.h"
 #include "cairo-surface-backend-private.h"
@@ -65,7 +66,6 @@ typedef struct _cairo_command_header {
     cairo_clip_t		*clip;
 
     int index;
-    struct _cairo_command_header *chain;
 } cairo_command_header_t;
 
 typedef struct _cairo_command_paint {
@@ -122,6 +122,19 @@ typedef union _cairo_command {
     cairo_command_show_text_glyphs_t		show_text_glyphs;
 } cairo_command_t;
 
+typedef struct _cairo_recording_data cairo_recording_data_t;
+
+/* The header of each command in a serialized recording, see
+ * cairo-recording-surface-serialize.c. Records are laid out back to
+ * back, each padded to a multiple of 8 bytes. */
+typedef struct _cairo_recording_record {
+    uint32_t size;
+    uint32_t type;
+    uint32_t op;
+    uint32_t reserved;
+    int32_t x, y, width, height;
+} cairo_recording_record_t;
+
 typedef struct _cairo_recording_surface {
     cairo_surface_t base;
 
@@ -132,6 +145,9 @@ typedef struct _cairo_recording_surface {
     cairo_rectangle_int_t extents;
     cairo_bool_t unbounded;
 
+    /* The commands, and their paths and glyphs, are allocated from the
+     * arena and released together with the surface. */
+    cairo_arena_t arena;
     cairo_array_t commands;
     unsigned int *indices;
     unsigned int num_indices;
@@ -139,11 +155,23 @@ typedef struct _cairo_recording_surface {
     cairo_bool_t has_bilevel_alpha;
     cairo_bool_t has_only_op_over;
 
+    /* Packed R-tree over the extents of the first num_items commands;
+     * any commands recorded since are searched linearly. */
     struct bbtree {
-	cairo_box_t extents;
-	struct bbtree *left, *right;
-	cairo_command_header_t *chain;
+	struct bbtree_node *nodes;
+	unsigned int *items;
+	unsigned int num_nodes;
+	unsigned int num_items;
     } bbtree;
+
+    /* The commands of a surface loaded from a serialized recording are
+     * decoded on the fly during replay, and only copied into @commands
+     * should the surface need them. @depth counts the recordings that
+     * the document is nested within. */
+    cairo_recording_data_t *data;
+    const unsigned char *records;
+    const unsigned char *records_end;
+    unsigned int depth;
 } cairo_recording_surface_t;
 
 slim_hidden_proto (cairo_recording_surface_create);
@@ -192,4 +220,20 @@ _cairo_recording_surface_has_only_bilevel_alpha (cairo_recording_surface_t *surf
 cairo_private cairo_bool_t
 _cairo_recording_surface_has_only_op_over (cairo_recording_surface_t *surface);
 
+cairo_private cairo_status_t
+_cairo_recording_surface_load (cairo_recording_surface_t *surface);
+
+cairo_private void
+_cairo_recording_command_fini (cairo_command_t *command);
+
+cairo_private void
+_cairo_recording_data_destroy (cairo_recording_data_t *data);
+
+cairo_private cairo_status_t
+_cairo_recording_data_decode_command (cairo_recording_data_t *data,
+				      const cairo_recording_record_t *record,
+				      cairo_command_t *command,
+				      cairo_bool_t copy,
+				      unsigned int depth);
+
 #endif /* CAIRO_RECORDING_SURFACE_H */
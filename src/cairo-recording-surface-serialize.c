@@ -0,0 +1,1795 @@
+/* -*- Mode: c; tab-width: 8; c-basic-offset: 4; indent-tabs-mode: t; -*- */
+/* cairo - a vector graphics library with display and print output
+ *
+ * Copyright © 2026 the cairo authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ *
+ * The Initial Developer of the Original Code is the cairo authors.
+ */
+
+/* The serialized form of a recording surface is a header followed by
+ * one record per command. Everything is stored in native byte order and
+ * is addressed relative to the start of the data, with every field
+ * aligned to and every item padded to 8 bytes, so that it can be read
+ * in place.
+ *
+ * A loaded surface does not decode its commands up front. Plain replays
+ * skip over the records outside of the area being drawn and decode each
+ * of the others into a temporary command just before it is replayed.
+ * Images are drawn directly from the pixels in the data, and a nested
+ * recording surface becomes another loaded surface sharing the same
+ * data. Only those operations that need the commands to persist, such
+ * as recording further drawing or replaying into a paginated backend,
+ * decode them all with _cairo_recording_surface_load().
+ *
+ * Text is written as the outlines of the glyphs, and raster-source
+ * patterns cannot be written at all.
+ */
+
+#include "cairoint.h"
+
+#include "cairo-array-private.h"
+#include "cairo-clip-inline.h"
+#include "cairo-clip-private.h"
+#include "cairo-error-private.h"
+#include "cairo-image-surface-private.h"
+#include "cairo-list-inline.h"
+#include "cairo-path-fixed-private.h"
+#include "cairo-recording-surface-inline.h"
+#include "cairo-recording-surface-private.h"
+
+#include <errno.h>
+#include <float.h>
+
+#define CAIRO_RECORDING_MAGIC 0x53524343 /* "CCRS" in little-endian */
+#define CAIRO_RECORDING_VERSION 1
+
+/* Nested recordings are replayed recursively, so bound how deeply a
+ * document may nest them. */
+#define CAIRO_RECORDING_MAX_DEPTH 64
+
+#define ALIGN_8(size) (((size) + 7) & ~(uint64_t) 7)
+
+enum {
+    SERIALIZED_SURFACE_IMAGE,
+    SERIALIZED_SURFACE_RECORDING
+};
+
+enum {
+    SERIALIZED_PATH_HAS_CURRENT_POINT = 0x1,
+    SERIALIZED_PATH_NEEDS_MOVE_TO = 0x2,
+    SERIALIZED_PATH_HAS_EXTENTS = 0x4,
+    SERIALIZED_PATH_HAS_CURVE_TO = 0x8,
+    SERIALIZED_PATH_STROKE_IS_RECTILINEAR = 0x10,
+    SERIALIZED_PATH_FILL_IS_RECTILINEAR = 0x20,
+    SERIALIZED_PATH_FILL_MAYBE_REGION = 0x40,
+    SERIALIZED_PATH_FILL_IS_EMPTY = 0x80
+};
+
+typedef struct _serialized_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t fixed_frac_bits;
+    uint32_t content;
+    double x, y, width, height;
+    uint64_t length; /* of the records following the header */
+    uint32_t unbounded;
+    uint32_t num_records;
+} serialized_header_t;
+
+typedef struct _serialized_clip {
+    uint32_t is_clip;
+    uint32_t is_region;
+    uint32_t num_boxes;
+    uint32_t num_paths;
+    int32_t x, y, width, height;
+    /* followed by the boxes, then each clip path and its path */
+} serialized_clip_t;
+
+typedef struct _serialized_clip_path {
+    double tolerance;
+    uint32_t fill_rule;
+    uint32_t antialias;
+} serialized_clip_path_t;
+
+/* The state and flags of the path are written for reference only, as
+ * the reader rebuilds the path from its ops and points. */
+typedef struct _serialized_path {
+    cairo_point_t last_move_point;
+    cairo_point_t current_point;
+    cairo_box_t extents;
+    uint32_t flags;
+    uint32_t num_ops;
+    uint32_t num_points;
+    uint32_t reserved;
+    /* followed by the ops, then the points */
+} serialized_path_t;
+
+typedef struct _serialized_color {
+    double red, green, blue, alpha;
+} serialized_color_t;
+
+typedef struct _serialized_pattern {
+    uint32_t type;
+    uint32_t filter;
+    uint32_t extend;
+    uint32_t has_component_alpha;
+    cairo_matrix_t matrix;
+    double opacity;
+} serialized_pattern_t;
+
+typedef struct _serialized_gradient {
+    double points[6]; /* x0, y0, x1, y1 or cx0, cy0, r0, cx1, cy1, r1 */
+    uint32_t num_stops;
+    uint32_t reserved;
+} serialized_gradient_t;
+
+typedef struct _serialized_stop {
+    double offset;
+    serialized_color_t color;
+} serialized_stop_t;
+
+typedef struct _serialized_mesh {
+    uint32_t num_patches;
+    uint32_t reserved;
+} serialized_mesh_t;
+
+typedef struct _serialized_patch {
+    cairo_point_double_t points[4][4];
+    serialized_color_t colors[4];
+} serialized_patch_t;
+
+typedef struct _serialized_surface {
+    uint32_t kind;
+    uint32_t reserved;
+    cairo_matrix_t device_transform;
+    /* followed by a serialized_image_t and its pixels, or a document */
+} serialized_surface_t;
+
+typedef struct _serialized_image {
+    uint32_t format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;
+} serialized_image_t;
+
+typedef struct _serialized_stroke {
+    cairo_matrix_t ctm;
+    cairo_matrix_t ctm_inverse;
+    double tolerance;
+    double line_width;
+    double miter_limit;
+    double dash_offset;
+    uint32_t antialias;
+    uint32_t line_cap;
+    uint32_t line_join;
+    uint32_t num_dashes;
+} serialized_stroke_t;
+
+typedef struct _serialized_fill {
+    double tolerance;
+    uint32_t fill_rule;
+    uint32_t antialias;
+} serialized_fill_t;
+
+struct _cairo_recording_data {
+    cairo_reference_count_t ref_count;
+
+    void *allocated;
+};
+
+static cairo_recording_data_t *
+_cairo_recording_data_create (void)
+{
+    cairo_recording_data_t *data;
+
+    data = malloc (sizeof (cairo_recording_data_t));
+    if (unlikely (data == NULL))
+	return NULL;
+
+    CAIRO_REFERENCE_COUNT_INIT (&data->ref_count, 1);
+    data->allocated = NULL;
+
+    return data;
+}
+
+static cairo_recording_data_t *
+_cairo_recording_data_reference (cairo_recording_data_t *data)
+{
+    assert (CAIRO_REFERENCE_COUNT_HAS_REFERENCE (&data->ref_count));
+
+    _cairo_reference_count_inc (&data->ref_count);
+    return data;
+}
+
+void
+_cairo_recording_data_destroy (cairo_recording_data_t *data)
+{
+    assert (CAIRO_REFERENCE_COUNT_HAS_REFERENCE (&data->ref_count));
+
+    if (! _cairo_reference_count_dec_and_test (&data->ref_count))
+	return;
+
+    free (data->allocated);
+    free (data);
+}
+
+/* Writing */
+
+static cairo_status_t
+_write_document (cairo_array_t *buf, cairo_recording_surface_t *surface);
+
+static cairo_status_t
+_write_data (cairo_array_t *buf, const void *data, uint64_t size)
+{
+    cairo_status_t status;
+    uint64_t aligned = ALIGN_8 (size);
+    void *ptr;
+
+    if (aligned > INT_MAX - buf->num_elements)
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+    status = _cairo_array_allocate (buf, aligned, &ptr);
+    if (unlikely (status))
+	return status;
+
+    if (data != NULL)
+	memcpy (ptr, data, size);
+    else
+	memset (ptr, 0, size);
+    memset ((char *) ptr + size, 0, aligned - size);
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static void
+_write_color (serialized_color_t *dst,
+	      double red, double green, double blue, double alpha)
+{
+    dst->red = red;
+    dst->green = green;
+    dst->blue = blue;
+    dst->alpha = alpha;
+}
+
+static cairo_status_t
+_write_path (cairo_array_t *buf, const cairo_path_fixed_t *path)
+{
+    serialized_path_t sp;
+    const cairo_path_buf_t *pbuf;
+    cairo_status_t status;
+    unsigned int offset;
+
+    memset (&sp, 0, sizeof (sp));
+    sp.last_move_point = path->last_move_point;
+    sp.current_point = path->current_point;
+    sp.extents = path->extents;
+    if (path->has_current_point)
+	sp.flags |= SERIALIZED_PATH_HAS_CURRENT_POINT;
+    if (path->needs_move_to)
+	sp.flags |= SERIALIZED_PATH_NEEDS_MOVE_TO;
+    if (path->has_extents)
+	sp.flags |= SERIALIZED_PATH_HAS_EXTENTS;
+    if (path->has_curve_to)
+	sp.flags |= SERIALIZED_PATH_HAS_CURVE_TO;
+    if (path->stroke_is_rectilinear)
+	sp.flags |= SERIALIZED_PATH_STROKE_IS_RECTILINEAR;
+    if (path->fill_is_rectilinear)
+	sp.flags |= SERIALIZED_PATH_FILL_IS_RECTILINEAR;
+    if (path->fill_maybe_region)
+	sp.flags |= SERIALIZED_PATH_FILL_MAYBE_REGION;
+    if (path->fill_is_empty)
+	sp.flags |= SERIALIZED_PATH_FILL_IS_EMPTY;
+
+    cairo_path_foreach_buf_start (pbuf, path) {
+	sp.num_ops += pbuf->num_ops;
+	sp.num_points += pbuf->num_points;
+    } cairo_path_foreach_buf_end (pbuf, path);
+
+    status = _write_data (buf, &sp, sizeof (sp));
+    if (unlikely (status))
+	return status;
+
+    /* Reserve the space, then gather the ops and points of each buffer */
+    offset = buf->num_elements;
+    status = _write_data (buf, NULL, sp.num_ops);
+    if (unlikely (status))
+	return status;
+
+    cairo_path_foreach_buf_start (pbuf, path) {
+	memcpy (_cairo_array_index (buf, offset), pbuf->op, pbuf->num_ops);
+	offset += pbuf->num_ops;
+    } cairo_path_foreach_buf_end (pbuf, path);
+
+    offset = buf->num_elements;
+    status = _write_data (buf, NULL,
+			  (uint64_t) sp.num_points * sizeof (cairo_point_t));
+    if (unlikely (status))
+	return status;
+
+    cairo_path_foreach_buf_start (pbuf, path) {
+	memcpy (_cairo_array_index (buf, offset), pbuf->points,
+		pbuf->num_points * sizeof (cairo_point_t));
+	offset += pbuf->num_points * sizeof (cairo_point_t);
+    } cairo_path_foreach_buf_end (pbuf, path);
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* Write the clip paths oldest first, so that they can be reapplied in
+ * the same order. */
+static cairo_status_t
+_write_clip_path (cairo_array_t *buf, const cairo_clip_path_t *clip_path)
+{
+    serialized_clip_path_t scp;
+    cairo_status_t status;
+
+    if (clip_path->prev) {
+	status = _write_clip_path (buf, clip_path->prev);
+	if (unlikely (status))
+	    return status;
+    }
+
+    memset (&scp, 0, sizeof (scp));
+    scp.tolerance = clip_path->tolerance;
+    scp.fill_rule = clip_path->fill_rule;
+    scp.antialias = clip_path->antialias;
+    status = _write_data (buf, &scp, sizeof (scp));
+    if (unlikely (status))
+	return status;
+
+    return _write_path (buf, &clip_path->path);
+}
+
+static cairo_status_t
+_write_clip (cairo_array_t *buf, const cairo_clip_t *clip)
+{
+    serialized_clip_t sc;
+    const cairo_clip_path_t *clip_path;
+    cairo_status_t status;
+
+    memset (&sc, 0, sizeof (sc));
+    if (clip == NULL)
+	return _write_data (buf, &sc, sizeof (sc));
+
+    /* An empty clip would have dropped the command from the recording */
+    assert (! _cairo_clip_is_all_clipped (clip));
+
+    sc.is_clip = TRUE;
+    sc.is_region = clip->is_region;
+    sc.num_boxes = clip->num_boxes;
+    for (clip_path = clip->path; clip_path; clip_path = clip_path->prev)
+	sc.num_paths++;
+    sc.x = clip->extents.x;
+    sc.y = clip->extents.y;
+    sc.width = clip->extents.width;
+    sc.height = clip->extents.height;
+
+    status = _write_data (buf, &sc, sizeof (sc));
+    if (unlikely (status))
+	return status;
+
+    status = _write_data (buf, clip->boxes,
+			  (uint64_t) clip->num_boxes * sizeof (cairo_box_t));
+    if (unlikely (status))
+	return status;
+
+    if (clip->path)
+	return _write_clip_path (buf, clip->path);
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_write_image (cairo_array_t *buf, cairo_surface_t *surface)
+{
+    cairo_image_surface_t *image, *clone;
+    serialized_image_t si;
+    cairo_status_t status;
+    void *image_extra;
+    unsigned int offset;
+    int y;
+
+    status = _cairo_surface_acquire_source_image (surface, &image, &image_extra);
+    if (unlikely (status))
+	return status;
+
+    /* Reduce the more unusual formats to one matching the content */
+    clone = _cairo_image_surface_coerce (image);
+    status = clone->base.status;
+    if (unlikely (status))
+	goto BAIL;
+
+    si.format = clone->format;
+    si.width = clone->width;
+    si.height = clone->height;
+    si.stride = cairo_format_stride_for_width (clone->format, clone->width);
+    status = _write_data (buf, &si, sizeof (si));
+    if (unlikely (status))
+	goto BAIL;
+
+    offset = buf->num_elements;
+    status = _write_data (buf, NULL, (uint64_t) si.height * si.stride);
+    if (unlikely (status))
+	goto BAIL;
+
+    for (y = 0; y < clone->height; y++) {
+	memcpy (_cairo_array_index (buf, offset + y * si.stride),
+		clone->data + y * clone->stride,
+		si.stride);
+    }
+
+BAIL:
+    cairo_surface_destroy (&clone->base);
+    _cairo_surface_release_source_image (surface, image, image_extra);
+    return status;
+}
+
+static cairo_status_t
+_write_surface (cairo_array_t *buf, cairo_surface_t *surface)
+{
+    serialized_surface_t ss;
+    cairo_status_t status;
+
+    memset (&ss, 0, sizeof (ss));
+    ss.kind = _cairo_surface_is_recording (surface) ?
+	SERIALIZED_SURFACE_RECORDING : SERIALIZED_SURFACE_IMAGE;
+    ss.device_transform = surface->device_transform;
+    status = _write_data (buf, &ss, sizeof (ss));
+    if (unlikely (status))
+	return status;
+
+    if (ss.kind == SERIALIZED_SURFACE_RECORDING)
+	return _write_document (buf, (cairo_recording_surface_t *) surface);
+
+    return _write_image (buf, surface);
+}
+
+static cairo_status_t
+_write_pattern (cairo_array_t *buf, const cairo_pattern_t *pattern)
+{
+    serialized_pattern_t sp;
+    cairo_status_t status;
+    unsigned int i;
+
+    if (pattern->type == CAIRO_PATTERN_TYPE_RASTER_SOURCE)
+	return _cairo_error (CAIRO_STATUS_PATTERN_TYPE_MISMATCH);
+
+    memset (&sp, 0, sizeof (sp));
+    sp.type = pattern->type;
+    sp.filter = pattern->filter;
+    sp.extend = pattern->extend;
+    sp.has_component_alpha = pattern->has_component_alpha;
+    sp.matrix = pattern->matrix;
+    sp.opacity = pattern->opacity;
+    status = _write_data (buf, &sp, sizeof (sp));
+    if (unlikely (status))
+	return status;
+
+    switch (pattern->type) {
+    case CAIRO_PATTERN_TYPE_SOLID: {
+	const cairo_color_t *color = &((cairo_solid_pattern_t *) pattern)->color;
+	serialized_color_t sc;
+
+	_write_color (&sc, color->red, color->green, color->blue, color->alpha);
+	return _write_data (buf, &sc, sizeof (sc));
+    }
+
+    case CAIRO_PATTERN_TYPE_LINEAR:
+    case CAIRO_PATTERN_TYPE_RADIAL: {
+	const cairo_gradient_pattern_t *gradient = (cairo_gradient_pattern_t *) pattern;
+	serialized_gradient_t sg;
+
+	memset (&sg, 0, sizeof (sg));
+	if (pattern->type == CAIRO_PATTERN_TYPE_LINEAR) {
+	    const cairo_linear_pattern_t *linear = (cairo_linear_pattern_t *) pattern;
+
+	    sg.points[0] = linear->pd1.x;
+	    sg.points[1] = linear->pd1.y;
+	    sg.points[2] = linear->pd2.x;
+	    sg.points[3] = linear->pd2.y;
+	} else {
+	    const cairo_radial_pattern_t *radial = (cairo_radial_pattern_t *) pattern;
+
+	    sg.points[0] = radial->cd1.center.x;
+	    sg.points[1] = radial->cd1.center.y;
+	    sg.points[2] = radial->cd1.radius;
+	    sg.points[3] = radial->cd2.center.x;
+	    sg.points[4] = radial->cd2.center.y;
+	    sg.points[5] = radial->cd2.radius;
+	}
+	sg.num_stops = gradient->n_stops;
+	status = _write_data (buf, &sg, sizeof (sg));
+	if (unlikely (status))
+	    return status;
+
+	for (i = 0; i < gradient->n_stops; i++) {
+	    const cairo_gradient_stop_t *stop = &gradient->stops[i];
+	    serialized_stop_t ss;
+
+	    ss.offset = stop->offset;
+	    _write_color (&ss.color,
+			  stop->color.red, stop->color.green,
+			  stop->color.blue, stop->color.alpha);
+	    status = _write_data (buf, &ss, sizeof (ss));
+	    if (unlikely (status))
+		return status;
+	}
+	return CAIRO_STATUS_SUCCESS;
+    }
+
+    case CAIRO_PATTERN_TYPE_MESH: {
+	const cairo_mesh_pattern_t *mesh = (cairo_mesh_pattern_t *) pattern;
+	const cairo_mesh_patch_t *patches;
+	serialized_mesh_t sm;
+
+	memset (&sm, 0, sizeof (sm));
+	sm.num_patches = _cairo_array_num_elements (&mesh->patches);
+	status = _write_data (buf, &sm, sizeof (sm));
+	if (unlikely (status))
+	    return status;
+
+	patches = _cairo_array_index_const (&mesh->patches, 0);
+	for (i = 0; i < sm.num_patches; i++) {
+	    serialized_patch_t patch;
+	    int j;
+
+	    memcpy (patch.points, patches[i].points, sizeof (patch.points));
+	    for (j = 0; j < 4; j++) {
+		const cairo_color_t *color = &patches[i].colors[j];
+		_write_color (&patch.colors[j],
+			      color->red, color->green, color->blue, color->alpha);
+	    }
+	    status = _write_data (buf, &patch, sizeof (patch));
+	    if (unlikely (status))
+		return status;
+	}
+	return CAIRO_STATUS_SUCCESS;
+    }
+
+    case CAIRO_PATTERN_TYPE_SURFACE:
+	return _write_surface (buf, ((cairo_surface_pattern_t *) pattern)->surface);
+
+    default:
+	ASSERT_NOT_REACHED;
+	return _cairo_error (CAIRO_STATUS_PATTERN_TYPE_MISMATCH);
+    }
+}
+
+static cairo_status_t
+_write_stroke (cairo_array_t *buf, const cairo_command_stroke_t *command)
+{
+    serialized_stroke_t ss;
+    cairo_status_t status;
+
+    memset (&ss, 0, sizeof (ss));
+    ss.ctm = command->ctm;
+    ss.ctm_inverse = command->ctm_inverse;
+    ss.tolerance = command->tolerance;
+    ss.line_width = command->style.line_width;
+    /* The strokers only use the square of the miter limit, and one below
+     * 1 never allows a miter, whereas only positive limits are read. */
+    ss.miter_limit = MAX (fabs (command->style.miter_limit), 1.);
+    ss.dash_offset = command->style.dash_offset;
+    ss.antialias = command->antialias;
+    ss.line_cap = command->style.line_cap;
+    ss.line_join = command->style.line_join;
+    ss.num_dashes = command->style.num_dashes;
+    status = _write_data (buf, &ss, sizeof (ss));
+    if (unlikely (status))
+	return status;
+
+    return _write_data (buf, command->style.dash,
+			(uint64_t) ss.num_dashes * sizeof (double));
+}
+
+static cairo_status_t
+_write_fill (cairo_array_t *buf,
+	     cairo_fill_rule_t fill_rule,
+	     double tolerance,
+	     cairo_antialias_t antialias)
+{
+    serialized_fill_t sf;
+
+    memset (&sf, 0, sizeof (sf));
+    sf.tolerance = tolerance;
+    sf.fill_rule = fill_rule;
+    sf.antialias = antialias;
+    return _write_data (buf, &sf, sizeof (sf));
+}
+
+static cairo_status_t
+_write_command (cairo_array_t *buf, const cairo_command_t *command)
+{
+    cairo_recording_record_t record;
+    cairo_status_t status;
+    unsigned int offset;
+
+    memset (&record, 0, sizeof (record));
+    record.type = command->header.type;
+    record.op = command->header.op;
+    record.x = command->header.extents.x;
+    record.y = command->header.extents.y;
+    record.width = command->header.extents.width;
+    record.height = command->header.extents.height;
+
+    /* Glyphs are replaced by their outlines */
+    if (record.type == CAIRO_COMMAND_SHOW_TEXT_GLYPHS)
+	record.type = CAIRO_COMMAND_FILL;
+
+    offset = buf->num_elements;
+    status = _write_data (buf, &record, sizeof (record));
+    if (unlikely (status))
+	return status;
+
+    status = _write_clip (buf, command->header.clip);
+    if (unlikely (status))
+	return status;
+
+    switch (command->header.type) {
+    case CAIRO_COMMAND_PAINT:
+	status = _write_pattern (buf, &command->paint.source.base);
+	break;
+
+    case CAIRO_COMMAND_MASK:
+	status = _write_pattern (buf, &command->mask.source.base);
+	if (likely (status == CAIRO_STATUS_SUCCESS))
+	    status = _write_pattern (buf, &command->mask.mask.base);
+	break;
+
+    case CAIRO_COMMAND_STROKE:
+	status = _write_pattern (buf, &command->stroke.source.base);
+	if (likely (status == CAIRO_STATUS_SUCCESS))
+	    status = _write_path (buf, &command->stroke.path);
+	if (likely (status == CAIRO_STATUS_SUCCESS))
+	    status = _write_stroke (buf, &command->stroke);
+	break;
+
+    case CAIRO_COMMAND_FILL:
+	status = _write_pattern (buf, &command->fill.source.base);
+	if (likely (status == CAIRO_STATUS_SUCCESS))
+	    status = _write_path (buf, &command->fill.path);
+	if (likely (status == CAIRO_STATUS_SUCCESS))
+	    status = _write_fill (buf,
+				  command->fill.fill_rule,
+				  command->fill.tolerance,
+				  command->fill.antialias);
+	break;
+
+    case CAIRO_COMMAND_SHOW_TEXT_GLYPHS: {
+	const cairo_command_show_text_glyphs_t *glyphs = &command->show_text_glyphs;
+	cairo_path_fixed_t path;
+
+	status = _write_pattern (buf, &glyphs->source.base);
+	if (unlikely (status))
+	    break;
+
+	_cairo_path_fixed_init (&path);
+	status = _cairo_scaled_font_glyph_path (glyphs->scaled_font,
+						glyphs->glyphs,
+						glyphs->num_glyphs,
+						&path);
+	if (likely (status == CAIRO_STATUS_SUCCESS))
+	    status = _write_path (buf, &path);
+	_cairo_path_fixed_fini (&path);
+	if (likely (status == CAIRO_STATUS_SUCCESS))
+	    status = _write_fill (buf,
+				  CAIRO_FILL_RULE_WINDING,
+				  CAIRO_GSTATE_TOLERANCE_DEFAULT,
+				  glyphs->scaled_font->options.antialias);
+	break;
+    }
+
+    default:
+	ASSERT_NOT_REACHED;
+    }
+    if (unlikely (status))
+	return status;
+
+    ((cairo_recording_record_t *) _cairo_array_index (buf, offset))->size =
+	buf->num_elements - offset;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_write_document (cairo_array_t *buf, cairo_recording_surface_t *surface)
+{
+    serialized_header_t header;
+    cairo_status_t status;
+    unsigned int offset;
+
+    memset (&header, 0, sizeof (header));
+    header.magic = CAIRO_RECORDING_MAGIC;
+    header.version = CAIRO_RECORDING_VERSION;
+    header.fixed_frac_bits = CAIRO_FIXED_FRAC_BITS;
+    header.content = surface->base.content;
+    header.x = surface->extents_pixels.x;
+    header.y = surface->extents_pixels.y;
+    header.width = surface->extents_pixels.width;
+    header.height = surface->extents_pixels.height;
+    header.unbounded = surface->unbounded;
+
+    offset = buf->num_elements;
+    status = _write_data (buf, &header, sizeof (header));
+    if (unlikely (status))
+	return status;
+
+    if (surface->data) {
+	const unsigned char *p;
+
+	/* The records are position independent, so copy them as is */
+	for (p = surface->records; p < surface->records_end;
+	     p += ((const cairo_recording_record_t *) p)->size)
+	{
+	    header.num_records++;
+	}
+
+	status = _write_data (buf, surface->records,
+			      surface->records_end - surface->records);
+	if (unlikely (status))
+	    return status;
+    } else {
+	cairo_command_t **elements;
+	unsigned int i;
+
+	elements = _cairo_array_index (&surface->commands, 0);
+	for (i = 0; i < surface->commands.num_elements; i++) {
+	    status = _write_command (buf, elements[i]);
+	    if (unlikely (status))
+		return status;
+	}
+	header.num_records = surface->commands.num_elements;
+    }
+
+    header.length = buf->num_elements - offset - sizeof (header);
+    memcpy (_cairo_array_index (buf, offset), &header, sizeof (header));
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* Reading */
+
+typedef struct _reader {
+    cairo_recording_data_t *data;
+    const unsigned char *p;
+    const unsigned char *end;
+    cairo_bool_t copy;
+    unsigned int depth;
+} reader_t;
+
+static const void *
+_read (reader_t *r, uint64_t size)
+{
+    const unsigned char *p = r->p;
+
+    size = ALIGN_8 (size);
+    if ((uint64_t) (r->end - p) < size)
+	return NULL;
+
+    r->p += size;
+    return p;
+}
+
+static cairo_bool_t
+_read_color (const serialized_color_t *sc, cairo_color_t *color)
+{
+    if (! (sc->red >= 0. && sc->red <= 1.) ||
+	! (sc->green >= 0. && sc->green <= 1.) ||
+	! (sc->blue >= 0. && sc->blue <= 1.) ||
+	! (sc->alpha >= 0. && sc->alpha <= 1.))
+    {
+	return FALSE;
+    }
+
+    _cairo_color_init_rgba (color, sc->red, sc->green, sc->blue, sc->alpha);
+    return TRUE;
+}
+
+static cairo_bool_t
+_read_finite (double x)
+{
+    return x >= -DBL_MAX && x <= DBL_MAX; /* and not a NaN */
+}
+
+static cairo_bool_t
+_read_positive (double x)
+{
+    return x > 0. && x <= DBL_MAX;
+}
+
+static cairo_bool_t
+_read_matrix (const cairo_matrix_t *matrix)
+{
+    cairo_matrix_t inverse = *matrix;
+
+    return _read_finite (matrix->x0) && _read_finite (matrix->y0) &&
+	   cairo_matrix_invert (&inverse) == CAIRO_STATUS_SUCCESS;
+}
+
+/* Checks that @inverse undoes @matrix, to within rounding */
+static cairo_bool_t
+_read_matrix_inverse (const cairo_matrix_t *matrix,
+		      const cairo_matrix_t *inverse)
+{
+    cairo_matrix_t m;
+    double epsilon;
+
+    if (! _read_matrix (matrix) || ! _read_matrix (inverse))
+	return FALSE;
+
+    cairo_matrix_multiply (&m, matrix, inverse);
+    epsilon = 1e-6 * (1 + fabs (inverse->x0) + fabs (inverse->y0));
+    return fabs (m.xx - 1) < 1e-6 && fabs (m.yx) < 1e-6 &&
+	   fabs (m.xy) < 1e-6 && fabs (m.yy - 1) < 1e-6 &&
+	   fabs (m.x0) < epsilon && fabs (m.y0) < epsilon;
+}
+
+/* The path is rebuilt from its operations rather than copied, so that
+ * its flags and extents, which the rasterisers rely upon, are derived
+ * from the points and not taken on trust. The flags and extents stored
+ * alongside are ignored. */
+static cairo_status_t
+_read_path (reader_t *r, cairo_path_fixed_t *path)
+{
+    const serialized_path_t *sp;
+    const cairo_path_op_t *ops;
+    const cairo_point_t *points;
+    cairo_status_t status;
+    uint64_t num_points;
+    unsigned int i;
+
+    sp = _read (r, sizeof (*sp));
+    if (unlikely (sp == NULL))
+	return _cairo_error (CAIRO_STATUS_READ_ERROR);
+
+    ops = _read (r, sp->num_ops);
+    points = _read (r, (uint64_t) sp->num_points * sizeof (cairo_point_t));
+    if (unlikely (ops == NULL || points == NULL))
+	return _cairo_error (CAIRO_STATUS_READ_ERROR);
+
+    /* Check that the points correspond to the ops */
+    num_points = 0;
+    for (i = 0; i < sp->num_ops; i++) {
+	switch (ops[i]) {
+	case CAIRO_PATH_OP_MOVE_TO:
+	case CAIRO_PATH_OP_LINE_TO:
+	    num_points += 1;
+	    break;
+	case CAIRO_PATH_OP_CURVE_TO:
+	    num_points += 3;
+	    break;
+	case CAIRO_PATH_OP_CLOSE_PATH:
+	    break;
+	default:
+	    return _cairo_error (CAIRO_STATUS_READ_ERROR);
+	}
+    }
+    if (unlikely (num_points != sp->num_points))
+	return _cairo_error (CAIRO_STATUS_READ_ERROR);
+
+    _cairo_path_fixed_init (path);
+    status = CAIRO_STATUS_SUCCESS;
+    for (i = 0; i < sp->num_ops && status == CAIRO_STATUS_SUCCESS; i++) {
+	switch (ops[i]) {
+	case CAIRO_PATH_OP_MOVE_TO:
+	    status = _cairo_path_fixed_move_to (path, points[0].x, points[0].y);
+	    points += 1;
+	    break;
+	case CAIRO_PATH_OP_LINE_TO:
+	    status = _cairo_path_fixed_line_to (path, points[0].x, points[0].y);
+	    points += 1;
+	    break;
+	case CAIRO_PATH_OP_CURVE_TO:
+	    status = _cairo_path_fixed_curve_to (path,
+						 points[0].x, points[0].y,
+						 points[1].x, points[1].y,
+						 points[2].x, points[2].y);
+	    points += 3;
+	    break;
+	case CAIRO_PATH_OP_CLOSE_PATH:
+	    status = _cairo_path_fixed_close_path (path);
+	    break;
+	}
+    }
+    if (unlikely (status))
+	_cairo_path_fixed_fini (path);
+
+    return status;
+}
+
+/* The clip is rebuilt by intersecting its boxes and paths afresh, so
+ * that its extents and whether it is a region are recomputed rather
+ * than taken from the data. */
+static cairo_status_t
+_read_clip (reader_t *r, cairo_clip_t **out)
+{
+    const serialized_clip_t *sc;
+    const cairo_box_t *boxes;
+    cairo_clip_t *clip;
+    unsigned int i;
+
+    *out = NULL;
+
+    sc = _read (r, sizeof (*sc));
+    if (unlikely (sc == NULL))
+	return _cairo_error (CAIRO_STATUS_READ_ERROR);
+
+    if (! sc->is_clip)
+	return CAIRO_STATUS_SUCCESS;
+
+    boxes = _read (r, (uint64_t) sc->num_boxes * sizeof (cairo_box_t));
+    if (unlikely (boxes == NULL || sc->num_boxes + (uint64_t) sc->num_paths == 0))
+	return _cairo_error (CAIRO_STATUS_READ_ERROR);
+
+    for (i = 0; i < sc->num_boxes; i++) {
+	if (unlikely (boxes[i].p1.x > boxes[i].p2.x ||
+		      boxes[i].p1.y > boxes[i].p2.y))
+	{
+	    return _cairo_error (CAIRO_STATUS_READ_ERROR);
+	}
+    }
+
+    clip = NULL;
+    if (sc->num_boxes) {
+	cairo_boxes_t clip_boxes;
+
+	/* The boxes are only read, and copied into the clip */
+	_cairo_boxes_init_for_array (&clip_boxes,
+				     (cairo_box_t *) boxes, sc->num_boxes);
+	clip = _cairo_clip_intersect_boxes (NULL, &clip_boxes);
+    }
+
+    for (i = 0; i < sc->num_paths; i++) {
+	const serialized_clip_path_t *scp;
+	cairo_path_fixed_t path;
+	cairo_status_t status;
+
+	scp = _read (r, sizeof (*scp));
+	if (unlikely (scp == NULL ||
+		      ! _read_positive (scp->tolerance) ||
+		      scp->fill_rule > CAIRO_FILL_RULE_EVEN_ODD ||
+		      scp->antialias > CAIRO_ANTIALIAS_BEST))
+	{
+	    _cairo_clip_destroy (clip);
+	    return _cairo_error (CAIRO_STATUS_READ_ERROR);
+	}
+
+	status = _read_path (r, &path);
+	if (unlikely (status)) {
+	    _cairo_clip_destroy (clip);
+	    return status;
+	}
+
+	clip = _cairo_clip_intersect_path (clip, &path,
+					   scp->fill_rule,
+					   scp->tolerance,
+					   scp->antialias);
+	_cairo_path_fixed_fini (&path);
+    }
+
+    /* An empty clip would have dropped the command from the recording */
+    if (unlikely (_cairo_clip_is_all_clipped (clip))) {
+	_cairo_clip_destroy (clip);
+	return _cairo_error (CAIRO_STATUS_READ_ERROR);
+    }
+
+    *out = clip;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_surface_t *
+_cairo_recording_surface_create_for_document (cairo_recording_data_t *data,
+					      const unsigned char *bytes,
+					      uint64_t length,
+					      unsigned int depth,
+					      uint64_t *consumed);
+
+static cairo_status_t
+_read_surface (reader_t *r, cairo_surface_t **out)
+{
+    const serialized_surface_t *ss;
+    cairo_surface_t *surface;
+    cairo_status_t status;
+
+    ss = _read (r, sizeof (*ss));
+    if (unlikely (ss == NULL || ! _read_matrix (&ss->device_transform)))
+	return _cairo_error (CAIRO_STATUS_READ_ERROR);
+
+    switch (ss->kind) {
+    case SERIALIZED_SURFACE_IMAGE: {
+	const serialized_image_t *si;
+	const unsigned char *pixels;
+
+	si = _read (r, sizeof (*si));
+	if (unlikely (si == NULL ||
+		      ! CAIRO_FORMAT_VALID ((int) si->format) ||
+		      si->stride != (uint32_t) cairo_format_stride_for_width (si->format, si->width)))
+	{
+	    return _cairo_error (CAIRO_STATUS_READ_ERROR);
+	}
+
+	pixels = _read (r, (uint64_t) si->height * si->stride);
+	if (unlikely (pixels == NULL))
+	    return _cairo_error (CAIRO_STATUS_READ_ERROR);
+
+	if (r->copy) {
+	    cairo_image_surface_t *image;
+	    unsigned int y;
+
+	    surface = cairo_image_surface_create (si->format,
+						  si->width, si->height);
+	    if (unlikely (surface->status))
+		return surface->status;
+
+	    image = (cairo_image_surface_t *) surface;
+	    for (y = 0; y < si->height; y++) {
+		memcpy (image->data + y * image->stride,
+			pixels + y * si->stride,
+			si->stride);
+	    }
+	} else {
+	    /* The image is only used for the duration of this command */
+	    surface = cairo_image_surface_create_for_data ((unsigned char *) pixels,
+							   si->format,
+							   si->width,
+							   si->height,
+							   si->stride);
+	    if (unlikely (surface->status))
+		return surface->status;
+	}
+	break;
+    }
+
+    case SERIALIZED_SURFACE_RECORDING: {
+	uint64_t consumed;
+
+	surface = _cairo_recording_surface_create_for_document (r->data,
+								r->p,
+								r->end - r->p,
+								r->depth + 1,
+								&consumed);
+	if (unlikely (surface->status))
+	    return surface->status;
+
+	r->p += consumed;
+
+	if (r->copy) {
+	    status = _cairo_recording_surface_load ((cairo_recording_surface_t *) surface);
+	    if (unlikely (status)) {
+		cairo_surface_destroy (surface);
+		return status;
+	    }
+	}
+	break;
+    }
+
+    default:
+	return _cairo_error (CAIRO_STATUS_READ_ERROR);
+    }
+
+    surface->device_transform = ss->device_transform;
+    surface->device_transform_inverse = ss->device_transform;
+    status = cairo_matrix_invert (&surface->device_transform_inverse);
+    assert (status == CAIRO_STATUS_SUCCESS);
+
+    *out = surface;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_read_gradient (reader_t *r, cairo_gradient_pattern_t *gradient)
+{
+    const serialized_gradient_t *sg;
+    const serialized_stop_t *stops;
+    unsigned int i;
+
+    sg = _read (r, sizeof (*sg));
+    if (unlikely (sg == NULL))
+	return _cairo_error (CAIRO_STATUS_READ_ERROR);
+
+    stops = _read (r, (uint64_t) sg->num_stops * sizeof (serialized_stop_t));
+    if (unlikely (stops == NULL))
+	return _cairo_error (CAIRO_STATUS_READ_ERROR);
+
+    if (gradient->base.type == CAIRO_PATTERN_TYPE_LINEAR) {
+	cairo_linear_pattern_t *linear = (cairo_linear_pattern_t *) gradient;
+
+	linear->pd1.x = sg->points[0];
+	linear->pd1.y = sg->points[1];
+	linear->pd2.x = sg->points[2];
+	linear->pd2.y = sg->points[3];
+    } else {
+	cairo_radial_pattern_t *radial = (cairo_radial_pattern_t *) gradient;
+
+	if (unlikely (! (sg->points[2] >= 0.) || ! (sg->points[5] >= 0.)))
+	    return _cairo_error (CAIRO_STATUS_READ_ERROR);
+
+	radial->cd1.center.x = sg->points[0];
+	radial->cd1.center.y = sg->points[1];
+	radial->cd1.radius = sg->points[2];
+	radial->cd2.center.x = sg->points[3];
+	radial->cd2.center.y = sg->points[4];
+	radial->cd2.radius = sg->points[5];
+    }
+
+    if (sg->num_stops <= ARRAY_LENGTH (gradient->stops_embedded)) {
+	gradient->stops = gradient->stops_embedded;
+	gradient->stops_size = ARRAY_LENGTH (gradient->stops_embedded);
+    } else {
+	gradient->stops = _cairo_malloc_ab (sg->num_stops,
+					    sizeof (cairo_gradient_stop_t));
+	if (unlikely (gradient->stops == NULL))
+	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	gradient->stops_size = sg->num_stops;
+    }
+
+    for (i = 0; i < sg->num_stops; i++) {
+	cairo_gradient_stop_t *stop = &gradient->stops[i];
+	cairo_color_t color;
+
+	if (unlikely (! _read_color (&stops[i].color, &color) ||
+		      ! (stops[i].offset >= 0. && stops[i].offset <= 1.)))
+	{
+	    return _cairo_error (CAIRO_STATUS_READ_ERROR);
+	}
+
+	stop->offset = stops[i].offset;
+	stop->color.red = color.red;
+	stop->color.green = color.green;
+	stop->color.blue = color.blue;
+	stop->color.alpha = color.alpha;
+	stop->color.red_short = color.red_short;
+	stop->color.green_short = color.green_short;
+	stop->color.blue_short = color.blue_short;
+	stop->color.alpha_short = color.alpha_short;
+    }
+    gradient->n_stops = sg->num_stops;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_read_mesh (reader_t *r, cairo_mesh_pattern_t *mesh)
+{
+    const serialized_mesh_t *sm;
+    const serialized_patch_t *patches;
+    cairo_status_t status;
+    unsigned int i;
+    int j;
+
+    sm = _read (r, sizeof (*sm));
+    if (unlikely (sm == NULL))
+	return _cairo_error (CAIRO_STATUS_READ_ERROR);
+
+    patches = _read (r, (uint64_t) sm->num_patches * sizeof (serialized_patch_t));
+    if (unlikely (patches == NULL))
+	return _cairo_error (CAIRO_STATUS_READ_ERROR);
+
+    for (i = 0; i < sm->num_patches; i++) {
+	cairo_mesh_patch_t patch;
+
+	memcpy (patch.points, patches[i].points, sizeof (patch.points));
+	for (j = 0; j < 4; j++) {
+	    if (unlikely (! _read_color (&patches[i].colors[j], &patch.colors[j])))
+		return _cairo_error (CAIRO_STATUS_READ_ERROR);
+	}
+
+	status = _cairo_array_append (&mesh->patches, &patch);
+	if (unlikely (status))
+	    return status;
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_read_pattern (reader_t *r, cairo_pattern_union_t *pattern)
+{
+    const serialized_pattern_t *sp;
+    cairo_status_t status;
+
+    sp = _read (r, sizeof (*sp));
+    if (unlikely (sp == NULL ||
+		  sp->type > CAIRO_PATTERN_TYPE_MESH ||
+		  sp->filter > CAIRO_FILTER_GAUSSIAN ||
+		  sp->extend > CAIRO_EXTEND_PAD ||
+		  ! (sp->opacity >= 0. && sp->opacity <= 1.) ||
+		  ! _read_matrix (&sp->matrix)))
+    {
+	return _cairo_error (CAIRO_STATUS_READ_ERROR);
+    }
+
+    switch (sp->type) {
+    case CAIRO_PATTERN_TYPE_SOLID: {
+	const serialized_color_t *sc;
+	cairo_color_t color;
+
+	sc = _read (r, sizeof (*sc));
+	if (unlikely (sc == NULL || ! _read_color (sc, &color)))
+	    return _cairo_error (CAIRO_STATUS_READ_ERROR);
+
+	_cairo_pattern_init_solid (&pattern->solid, &color);
+	status = CAIRO_STATUS_SUCCESS;
+	break;
+    }
+
+    case CAIRO_PATTERN_TYPE_LINEAR:
+    case CAIRO_PATTERN_TYPE_RADIAL:
+	_cairo_pattern_init (&pattern->base, sp->type);
+	pattern->gradient.base.n_stops = 0;
+	pattern->gradient.base.stops_size = 0;
+	pattern->gradient.base.stops = NULL;
+	status = _read_gradient (r, &pattern->gradient.base);
+	break;
+
+    case CAIRO_PATTERN_TYPE_MESH:
+	_cairo_pattern_init (&pattern->base, CAIRO_PATTERN_TYPE_MESH);
+	_cairo_array_init (&pattern->mesh.patches, sizeof (cairo_mesh_patch_t));
+	pattern->mesh.current_patch = NULL;
+	status = _read_mesh (r, &pattern->mesh);
+	break;
+
+    case CAIRO_PATTERN_TYPE_SURFACE: {
+	cairo_surface_t *surface;
+
+	status = _read_surface (r, &surface);
+	if (unlikely (status))
+	    return status;
+
+	_cairo_pattern_init_for_surface (&pattern->surface, surface);
+	cairo_surface_destroy (surface);
+	break;
+    }
+
+    default:
+	return _cairo_error (CAIRO_STATUS_READ_ERROR);
+    }
+
+    if (unlikely (status)) {
+	_cairo_pattern_fini (&pattern->base);
+	return status;
+    }
+
+    pattern->base.filter = sp->filter;
+    pattern->base.extend = sp->extend;
+    pattern->base.has_component_alpha = sp->has_component_alpha;
+    pattern->base.matrix = sp->matrix;
+    pattern->base.opacity = sp->opacity;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_read_stroke (reader_t *r, cairo_command_stroke_t *command)
+{
+    const serialized_stroke_t *ss;
+    const double *dash;
+    double dash_total;
+    unsigned int i;
+
+    ss = _read (r, sizeof (*ss));
+    if (unlikely (ss == NULL ||
+		  ! _read_positive (ss->tolerance) ||
+		  ! _read_positive (ss->line_width) ||
+		  ! _read_positive (ss->miter_limit) ||
+		  ! _read_finite (ss->dash_offset) ||
+		  ! _read_matrix_inverse (&ss->ctm, &ss->ctm_inverse) ||
+		  ss->antialias > CAIRO_ANTIALIAS_BEST ||
+		  ss->line_cap > CAIRO_LINE_CAP_SQUARE ||
+		  ss->line_join > CAIRO_LINE_JOIN_BEVEL))
+    {
+	return _cairo_error (CAIRO_STATUS_READ_ERROR);
+    }
+
+    dash = _read (r, (uint64_t) ss->num_dashes * sizeof (double));
+    if (unlikely (dash == NULL))
+	return _cairo_error (CAIRO_STATUS_READ_ERROR);
+
+    /* As cairo_set_dash(), with the dashes and their sum finite */
+    dash_total = 0.;
+    for (i = 0; i < ss->num_dashes; i++) {
+	if (unlikely (! (dash[i] >= 0.)))
+	    return _cairo_error (CAIRO_STATUS_READ_ERROR);
+	dash_total += dash[i];
+    }
+    if (unlikely (ss->num_dashes && ! _read_positive (dash_total)))
+	return _cairo_error (CAIRO_STATUS_READ_ERROR);
+
+    _cairo_stroke_style_init (&command->style);
+    command->style.line_width = ss->line_width;
+    command->style.line_cap = ss->line_cap;
+    command->style.line_join = ss->line_join;
+    command->style.miter_limit = ss->miter_limit;
+    command->style.dash_offset = ss->dash_offset;
+    if (ss->num_dashes) {
+	command->style.dash = _cairo_malloc_ab (ss->num_dashes, sizeof (double));
+	if (unlikely (command->style.dash == NULL))
+	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+	memcpy (command->style.dash, dash, ss->num_dashes * sizeof (double));
+	command->style.num_dashes = ss->num_dashes;
+    }
+
+    command->ctm = ss->ctm;
+    command->ctm_inverse = ss->ctm_inverse;
+    command->tolerance = ss->tolerance;
+    command->antialias = ss->antialias;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_read_fill (reader_t *r, cairo_command_fill_t *command)
+{
+    const serialized_fill_t *sf;
+
+    sf = _read (r, sizeof (*sf));
+    if (unlikely (sf == NULL ||
+		  ! _read_positive (sf->tolerance) ||
+		  sf->fill_rule > CAIRO_FILL_RULE_EVEN_ODD ||
+		  sf->antialias > CAIRO_ANTIALIAS_BEST))
+    {
+	return _cairo_error (CAIRO_STATUS_READ_ERROR);
+    }
+
+    command->fill_rule = sf->fill_rule;
+    command->tolerance = sf->tolerance;
+    command->antialias = sf->antialias;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/**
+ * _cairo_recording_data_decode_command:
+ * @data: the serialized data holding @record
+ * @record: the record to decode
+ * @command: the command to initialise
+ * @copy: whether the command may outlive @data
+ * @depth: how deeply the document holding @record is nested
+ *
+ * Decodes @record into @command, which is to be released with
+ * _cairo_recording_command_fini(). Unless @copy is set, the command may
+ * still refer to the contents of @data, such as the pixels of an image.
+ *
+ * Return value: %CAIRO_STATUS_SUCCESS, or %CAIRO_STATUS_READ_ERROR if
+ * the record is invalid.
+ **/
+cairo_status_t
+_cairo_recording_data_decode_command (cairo_recording_data_t *data,
+				      const cairo_recording_record_t *record,
+				      cairo_command_t *command,
+				      cairo_bool_t copy,
+				      unsigned int depth)
+{
+    cairo_status_t status;
+    reader_t r;
+
+    if (unlikely (record->op > CAIRO_OPERATOR_HSL_LUMINOSITY))
+	return _cairo_error (CAIRO_STATUS_READ_ERROR);
+
+    r.data = data;
+    r.p = (const unsigned char *) (record + 1);
+    r.end = (const unsigned char *) record + record->size;
+    r.copy = copy;
+    r.depth = depth;
+
+    command->header.type = record->type;
+    command->header.region = CAIRO_RECORDING_REGION_ALL;
+    command->header.op = record->op;
+    command->header.extents.x = record->x;
+    command->header.extents.y = record->y;
+    command->header.extents.width = record->width;
+    command->header.extents.height = record->height;
+    command->header.index = 0;
+
+    status = _read_clip (&r, &command->header.clip);
+    if (unlikely (status))
+	return status;
+
+    switch (record->type) {
+    case CAIRO_COMMAND_PAINT:
+	status = _read_pattern (&r, &command->paint.source);
+	break;
+
+    case CAIRO_COMMAND_MASK:
+	status = _read_pattern (&r, &command->mask.source);
+	if (unlikely (status))
+	    break;
+
+	status = _read_pattern (&r, &command->mask.mask);
+	if (unlikely (status))
+	    _cairo_pattern_fini (&command->mask.source.base);
+	break;
+
+    case CAIRO_COMMAND_STROKE:
+	status = _read_pattern (&r, &command->stroke.source);
+	if (unlikely (status))
+	    break;
+
+	status = _read_path (&r, &command->stroke.path);
+	if (unlikely (status)) {
+	    _cairo_pattern_fini (&command->stroke.source.base);
+	    break;
+	}
+
+	status = _read_stroke (&r, &command->stroke);
+	if (unlikely (status)) {
+	    _cairo_path_fixed_fini (&command->stroke.path);
+	    _cairo_pattern_fini (&command->stroke.source.base);
+	}
+	break;
+
+    case CAIRO_COMMAND_FILL:
+	status = _read_pattern (&r, &command->fill.source);
+	if (unlikely (status))
+	    break;
+
+	status = _read_path (&r, &command->fill.path);
+	if (unlikely (status)) {
+	    _cairo_pattern_fini (&command->fill.source.base);
+	    break;
+	}
+
+	status = _read_fill (&r, &command->fill);
+	if (unlikely (status)) {
+	    _cairo_path_fixed_fini (&command->fill.path);
+	    _cairo_pattern_fini (&command->fill.source.base);
+	}
+	break;
+
+    default:
+	status = _cairo_error (CAIRO_STATUS_READ_ERROR);
+	break;
+    }
+
+    if (unlikely (status))
+	_cairo_clip_destroy (command->header.clip);
+
+    return status;
+}
+
+/* Validate the header and the framing of the records of the document at
+ * @bytes, nested @depth recordings deep, and wrap them in a new
+ * recording surface. */
+static cairo_surface_t *
+_cairo_recording_surface_create_for_document (cairo_recording_data_t *data,
+					      const unsigned char *bytes,
+					      uint64_t length,
+					      unsigned int depth,
+					      uint64_t *consumed)
+{
+    const serialized_header_t *header = (const serialized_header_t *) bytes;
+    cairo_recording_surface_t *surface;
+    const unsigned char *p, *end;
+    cairo_rectangle_t extents;
+    unsigned int num_records;
+
+    if (depth > CAIRO_RECORDING_MAX_DEPTH ||
+	length < sizeof (serialized_header_t) ||
+	header->magic != CAIRO_RECORDING_MAGIC ||
+	header->version != CAIRO_RECORDING_VERSION ||
+	header->fixed_frac_bits != CAIRO_FIXED_FRAC_BITS ||
+	! CAIRO_CONTENT_VALID (header->content) ||
+	header->length > length - sizeof (serialized_header_t))
+    {
+	return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_READ_ERROR));
+    }
+
+    p = bytes + sizeof (serialized_header_t);
+    end = p + header->length;
+    num_records = 0;
+    while (p < end) {
+	const cairo_recording_record_t *record = (const cairo_recording_record_t *) p;
+
+	if ((size_t) (end - p) < sizeof (cairo_recording_record_t) ||
+	    record->size < sizeof (cairo_recording_record_t) ||
+	    record->size > (size_t) (end - p) ||
+	    (record->size & 7) ||
+	    record->type > CAIRO_COMMAND_FILL)
+	{
+	    return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_READ_ERROR));
+	}
+
+	p += record->size;
+	num_records++;
+    }
+    if (num_records != header->num_records)
+	return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_READ_ERROR));
+
+    extents.x = header->x;
+    extents.y = header->y;
+    extents.width = header->width;
+    extents.height = header->height;
+    surface = (cairo_recording_surface_t *)
+	cairo_recording_surface_create (header->content,
+					header->unbounded ? NULL : &extents);
+    if (unlikely (surface->base.status))
+	return &surface->base;
+
+    surface->data = _cairo_recording_data_reference (data);
+    surface->records = bytes + sizeof (serialized_header_t);
+    surface->records_end = end;
+    surface->depth = depth;
+    surface->base.is_clear = num_records == 0;
+
+    *consumed = sizeof (serialized_header_t) + header->length;
+    return &surface->base;
+}
+
+static cairo_status_t
+stdio_write_func (void *closure, const unsigned char *data, unsigned int size)
+{
+    FILE *file = closure;
+
+    if (fwrite (data, 1, size, file) != size)
+	return _cairo_error (CAIRO_STATUS_WRITE_ERROR);
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/**
+ * cairo_recording_surface_write_to_stream:
+ * @surface: a #cairo_recording_surface_t
+ * @write_func: a #cairo_write_func_t
+ * @closure: closure data for the write function
+ *
+ * Writes the operations recorded by @surface to @write_func in a
+ * compact binary form, that can be loaded again with
+ * cairo_recording_surface_create_for_data() or
+ * cairo_recording_surface_create_from_file() by another instance of
+ * cairo built for a machine of the same byte order.
+ *
+ * The text recorded on the surface is written as the outlines of the
+ * glyphs, and surfaces other than recording surfaces used as sources
+ * are written as images.
+ *
+ * Return value: %CAIRO_STATUS_SUCCESS if the surface was written
+ * successfully. Otherwise, %CAIRO_STATUS_SURFACE_TYPE_MISMATCH if
+ * @surface is not a recording surface,
+ * %CAIRO_STATUS_PATTERN_TYPE_MISMATCH if a raster-source pattern was
+ * recorded, %CAIRO_STATUS_NO_MEMORY if memory could not be allocated
+ * for the operation, or the error returned by @write_func.
+ *
+ * Since: 1.16
+ **/
+cairo_status_t
+cairo_recording_surface_write_to_stream (cairo_surface_t	*surface,
+					 cairo_write_func_t	 write_func,
+					 void			*closure)
+{
+    cairo_status_t status;
+    cairo_array_t buf;
+
+    if (unlikely (surface->status))
+	return surface->status;
+
+    if (unlikely (surface->finished))
+	return _cairo_error (CAIRO_STATUS_SURFACE_FINISHED);
+
+    if (! _cairo_surface_is_recording (surface))
+	return _cairo_error (CAIRO_STATUS_SURFACE_TYPE_MISMATCH);
+
+    _cairo_array_init (&buf, 1);
+    status = _write_document (&buf, (cairo_recording_surface_t *) surface);
+    if (status == CAIRO_STATUS_SUCCESS)
+	status = write_func (closure, _cairo_array_index (&buf, 0), buf.num_elements);
+    _cairo_array_fini (&buf);
+
+    return status;
+}
+
+/**
+ * cairo_recording_surface_write_to_file:
+ * @surface: a #cairo_recording_surface_t
+ * @filename: the name of a file to write to
+ *
+ * Writes the operations recorded by @surface to a new file @filename,
+ * as described for cairo_recording_surface_write_to_stream().
+ *
+ * Return value: %CAIRO_STATUS_SUCCESS if the file was written
+ * successfully. Otherwise, one of the errors of
+ * cairo_recording_surface_write_to_stream(), or
+ * %CAIRO_STATUS_WRITE_ERROR if an I/O error occurs while attempting to
+ * write the file.
+ *
+ * Since: 1.16
+ **/
+cairo_status_t
+cairo_recording_surface_write_to_file (cairo_surface_t	*surface,
+				       const char	*filename)
+{
+    cairo_status_t status;
+    FILE *fp;
+
+    if (unlikely (surface->status))
+	return surface->status;
+
+    if (unlikely (surface->finished))
+	return _cairo_error (CAIRO_STATUS_SURFACE_FINISHED);
+
+    if (! _cairo_surface_is_recording (surface))
+	return _cairo_error (CAIRO_STATUS_SURFACE_TYPE_MISMATCH);
+
+    fp = fopen (filename, "wb");
+    if (fp == NULL) {
+	switch (errno) {
+	case ENOMEM:
+	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	default:
+	    return _cairo_error (CAIRO_STATUS_WRITE_ERROR);
+	}
+    }
+
+    status = cairo_recording_surface_write_to_stream (surface,
+						      stdio_write_func, fp);
+
+    if (fclose (fp) && status == CAIRO_STATUS_SUCCESS)
+	status = _cairo_error (CAIRO_STATUS_WRITE_ERROR);
+
+    return status;
+}
+
+/**
+ * cairo_recording_surface_create_for_data:
+ * @data: the serialized recording, as written by
+ * cairo_recording_surface_write_to_stream()
+ * @length: the length of @data in bytes
+ *
+ * Creates a recording surface that replays the operations serialized
+ * in @data. The operations are decoded on demand as the surface is
+ * replayed, rather than up front, and images are drawn directly from
+ * their pixels within @data where possible.
+ *
+ * The surface refers to @data rather than copying it (unless it is not
+ * suitably aligned to 8 bytes), so the data must remain valid and
+ * unmodified for the lifetime of the surface. Drawing onto the surface
+ * first copies the serialized operations into the surface.
+ *
+ * Return value: a pointer to the newly created surface. The caller
+ * owns the surface and should call cairo_surface_destroy() when done
+ * with it.
+ *
+ * This function always returns a valid pointer, but it will return a
+ * pointer to a "nil" surface if an error such as out of memory
+ * occurs. In particular, %CAIRO_STATUS_READ_ERROR is reported if
+ * @data does not hold a valid serialized recording. You can use
+ * cairo_surface_status() to check for this.
+ *
+ * Since: 1.16
+ **/
+cairo_surface_t *
+cairo_recording_surface_create_for_data (const unsigned char	*data,
+					 unsigned long		 length)
+{
+    cairo_recording_data_t *rd;
+    cairo_surface_t *surface;
+    uint64_t consumed;
+
+    rd = _cairo_recording_data_create ();
+    if (unlikely (rd == NULL))
+	return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_NO_MEMORY));
+
+    if ((uintptr_t) data & 7) {
+	rd->allocated = _cairo_malloc (length);
+	if (unlikely (rd->allocated == NULL)) {
+	    _cairo_recording_data_destroy (rd);
+	    return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_NO_MEMORY));
+	}
+
+	memcpy (rd->allocated, data, length);
+	data = rd->allocated;
+    }
+
+    surface = _cairo_recording_surface_create_for_document (rd, data, length, 0,
+							    &consumed);
+    _cairo_recording_data_destroy (rd);
+
+    return surface;
+}
+
+/**
+ * cairo_recording_surface_create_from_file:
+ * @filename: the name of a file written by
+ * cairo_recording_surface_write_to_file()
+ *
+ * Creates a recording surface that replays the operations serialized
+ * in the file @filename. The file is read into memory once, so that
+ * later changes to it do not affect the surface, and as with
+ * cairo_recording_surface_create_for_data() the operations are decoded
+ * on demand.
+ *
+ * Return value: a pointer to the newly created surface. The caller
+ * owns the surface and should call cairo_surface_destroy() when done
+ * with it.
+ *
+ * This function always returns a valid pointer, but it will return a
+ * pointer to a "nil" surface if an error occurs: %CAIRO_STATUS_NO_MEMORY,
+ * %CAIRO_STATUS_FILE_NOT_FOUND if the file could not be opened, or
+ * %CAIRO_STATUS_READ_ERROR if it could not be read or does not hold a
+ * valid serialized recording.
+ *
+ * Since: 1.16
+ **/
+cairo_surface_t *
+cairo_recording_surface_create_from_file (const char *filename)
+{
+    cairo_recording_data_t *rd;
+    cairo_surface_t *surface;
+    const unsigned char *bytes;
+    uint64_t consumed;
+    long length;
+    FILE *fp;
+
+    fp = fopen (filename, "rb");
+    if (fp == NULL) {
+	switch (errno) {
+	case ENOMEM:
+	    return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_NO_MEMORY));
+	case ENOENT:
+	    return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_FILE_NOT_FOUND));
+	default:
+	    return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_READ_ERROR));
+	}
+    }
+
+    if (fseek (fp, 0, SEEK_END) || (length = ftell (fp)) < 0 ||
+	fseek (fp, 0, SEEK_SET))
+    {
+	fclose (fp);
+	return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_READ_ERROR));
+    }
+
+    rd = _cairo_recording_data_create ();
+    if (unlikely (rd == NULL)) {
+	fclose (fp);
+	return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_NO_MEMORY));
+    }
+
+    /* The records are validated once and then trusted while they are
+     * replayed, so they must not be shared with a file that may change
+     * (or be truncated) underneath a mapping. */
+    rd->allocated = _cairo_malloc (length);
+    if (unlikely (rd->allocated == NULL && length > 0)) {
+	fclose (fp);
+	_cairo_recording_data_destroy (rd);
+	return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_NO_MEMORY));
+    }
+
+    if (fread (rd->allocated, 1, length, fp) != (size_t) length) {
+	fclose (fp);
+	_cairo_recording_data_destroy (rd);
+	return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_READ_ERROR));
+    }
+    bytes = rd->allocated;
+    fclose (fp);
+
+    surface = _cairo_recording_surface_create_for_document (rd, bytes, length, 0,
+							    &consumed);
+    _cairo_recording_data_destroy (rd);
+
+    return surface;
+}
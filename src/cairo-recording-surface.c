@@ -85,10 +85,11 @@
 #include "cairo-composite-rectangles-private.h"
 #include "cairo-default-context-private.h"
 #include "cairo-error-private.h"
-#include "cairo-image-surface-private.h"
+#include "cairo-image-surface-inline.h"
 #include "cairo-recording-surface-inline.h"
 #include "cairo-surface-snapshot-inline.h"
 #include "cairo-surface-wrapper-private.h"
+#include "cairo-thread-pool-private.h"
 #include "cairo-traps-private.h"
 
 typedef enum {
@@ -117,159 +118,88 @@ static const cairo_surface_backend_t cairo_recording_surface_backend;
  * according to the intended replay target).
  */
 
-static int bbtree_left_or_right (struct bbtree *bbt,
-				 const cairo_box_t *box)
-{
-    int left, right;
-
-    if (bbt->left) {
-	cairo_box_t *e = &bbt->left->extents;
-	cairo_box_t b;
-
-	b.p1.x = MIN (e->p1.x, box->p1.x);
-	b.p1.y = MIN (e->p1.y, box->p1.y);
-	b.p2.x = MAX (e->p2.x, box->p2.x);
-	b.p2.y = MAX (e->p2.y, box->p2.y);
-
-	left = _cairo_fixed_integer_part (b.p2.x - b.p1.x) * _cairo_fixed_integer_part (b.p2.y - b.p1.y);
-	left -= _cairo_fixed_integer_part (e->p2.x - e->p1.x) * _cairo_fixed_integer_part (e->p2.y - e->p1.y);
-    } else
-	left = 0;
-
-    if (bbt->right) {
-	cairo_box_t *e = &bbt->right->extents;
-	cairo_box_t b;
-
-	b.p1.x = MIN (e->p1.x, box->p1.x);
-	b.p1.y = MIN (e->p1.y, box->p1.y);
-	b.p2.x = MAX (e->p2.x, box->p2.x);
-	b.p2.y = MAX (e->p2.y, box->p2.y);
-
-	right = _cairo_fixed_integer_part (b.p2.x - b.p1.x) * _cairo_fixed_integer_part (b.p2.y - b.p1.y);
-	right -= _cairo_fixed_integer_part (e->p2.x - e->p1.x) * _cairo_fixed_integer_part (e->p2.y - e->p1.y);
-    } else
-	right = 0;
+/* The commands are indexed by a packed R-tree built in bulk using
+ * Sort-Tile-Recursive: the commands are sorted into vertical slices by
+ * the centre of their extents, each slice is sorted vertically and then
+ * cut into leaves of BBTREE_FANOUT commands. The leaves are packed into
+ * their parents in the same manner until only the root remains.
+ *
+ * Recording only ever appends, so rather than throwing the tree away
+ * for every new command, the commands recorded since the last build are
+ * left as an unindexed tail that is tested linearly by each query. The
+ * tree is only rebuilt once the tail grows to a fraction of the indexed
+ * commands, so the cost of maintaining the index is amortised across
+ * many appends and many queries.
+ */
 
-    return left <= right;
-}
+#define BBTREE_FANOUT 16
+#define BBTREE_MIN_TAIL 64
 
-#define INVALID_CHAIN ((cairo_command_header_t *)-1)
+struct bbtree_node {
+    cairo_box_t extents;
+    unsigned int first; /* first child node, or first item of a leaf */
+    unsigned int count;
+    cairo_bool_t is_leaf;
+};
 
-static struct bbtree *
-bbtree_new (const cairo_box_t *box, cairo_command_header_t *chain)
+static cairo_bool_t box_outside (const cairo_box_t *a, const cairo_box_t *b)
 {
-    struct bbtree *bbt = malloc (sizeof (*bbt));
-    if (bbt == NULL)
-	return NULL;
-    bbt->extents = *box;
-    bbt->left = bbt->right = NULL;
-    bbt->chain = chain;
-    return bbt;
+    return
+	a->p1.x >= b->p2.x || a->p1.y >= b->p2.y ||
+	a->p2.x <= b->p1.x || a->p2.y <= b->p1.y;
 }
 
 static void
-bbtree_init (struct bbtree *bbt, cairo_command_header_t *header)
+box_add_box (cairo_box_t *box, const cairo_box_t *other)
 {
-    _cairo_box_from_rectangle (&bbt->extents, &header->extents);
-    bbt->chain = header;
+    box->p1.x = MIN (box->p1.x, other->p1.x);
+    box->p1.y = MIN (box->p1.y, other->p1.y);
+    box->p2.x = MAX (box->p2.x, other->p2.x);
+    box->p2.y = MAX (box->p2.y, other->p2.y);
 }
 
-static cairo_status_t
-bbtree_add (struct bbtree *bbt,
-	    cairo_command_header_t *header,
-	    const cairo_box_t *box)
+static inline int int64cmp (int64_t a, int64_t b)
 {
-    if (box->p1.x < bbt->extents.p1.x || box->p1.y < bbt->extents.p1.y ||
-	box->p2.x > bbt->extents.p2.x || box->p2.y > bbt->extents.p2.y)
-    {
-	if (bbt->chain) {
-	    if (bbtree_left_or_right (bbt, &bbt->extents)) {
-		if (bbt->left == NULL) {
-		    bbt->left = bbtree_new (&bbt->extents, bbt->chain);
-		    if (unlikely (bbt->left == NULL))
-			return _cairo_error (CAIRO_STATUS_NO_MEMORY);
-		} else
-		    bbtree_add (bbt->left, bbt->chain, &bbt->extents);
-	    } else {
-		if (bbt->right == NULL) {
-		    bbt->right = bbtree_new (&bbt->extents, bbt->chain);
-		    if (unlikely (bbt->right == NULL))
-			return _cairo_error (CAIRO_STATUS_NO_MEMORY);
-		} else
-		    bbtree_add (bbt->right, bbt->chain, &bbt->extents);
-	    }
-
-	    bbt->chain = NULL;
-	}
-
-	bbt->extents.p1.x = MIN (bbt->extents.p1.x, box->p1.x);
-	bbt->extents.p1.y = MIN (bbt->extents.p1.y, box->p1.y);
-	bbt->extents.p2.x = MAX (bbt->extents.p2.x, box->p2.x);
-	bbt->extents.p2.y = MAX (bbt->extents.p2.y, box->p2.y);
-    }
-
-    if (box->p1.x == bbt->extents.p1.x && box->p1.y == bbt->extents.p1.y &&
-	box->p2.x == bbt->extents.p2.x && box->p2.y == bbt->extents.p2.y)
-    {
-	cairo_command_header_t *last = header;
-	while (last->chain) /* expected to be infrequent */
-	    last = last->chain;
-	last->chain = bbt->chain;
-	bbt->chain = header;
-	return CAIRO_STATUS_SUCCESS;
-    }
+    return a < b ? -1 : a > b;
+}
 
-    if (bbtree_left_or_right (bbt, box)) {
-	if (bbt->left == NULL) {
-	    bbt->left = bbtree_new (box, header);
-	    if (unlikely (bbt->left == NULL))
-		return _cairo_error (CAIRO_STATUS_NO_MEMORY);
-	} else
-	    return bbtree_add (bbt->left, header, box);
-    } else {
-	if (bbt->right == NULL) {
-	    bbt->right = bbtree_new (box, header);
-	    if (unlikely (bbt->right == NULL))
-		return _cairo_error (CAIRO_STATUS_NO_MEMORY);
-	} else
-	    return bbtree_add (bbt->right, header, box);
-    }
+static inline int
+item_xcmp (unsigned int a, unsigned int b, cairo_command_t **elements)
+{
+    const cairo_rectangle_int_t *ra = &elements[a]->header.extents;
+    const cairo_rectangle_int_t *rb = &elements[b]->header.extents;
 
-    return CAIRO_STATUS_SUCCESS;
+    return int64cmp (2 * (int64_t) ra->x + ra->width,
+		     2 * (int64_t) rb->x + rb->width);
 }
+CAIRO_COMBSORT_DECLARE_WITH_DATA (sort_items_x, unsigned int, item_xcmp)
 
-static void bbtree_del (struct bbtree *bbt)
+static inline int
+item_ycmp (unsigned int a, unsigned int b, cairo_command_t **elements)
 {
-    if (bbt->left)
-	bbtree_del (bbt->left);
-    if (bbt->right)
-	bbtree_del (bbt->right);
+    const cairo_rectangle_int_t *ra = &elements[a]->header.extents;
+    const cairo_rectangle_int_t *rb = &elements[b]->header.extents;
 
-    free (bbt);
+    return int64cmp (2 * (int64_t) ra->y + ra->height,
+		     2 * (int64_t) rb->y + rb->height);
 }
+CAIRO_COMBSORT_DECLARE_WITH_DATA (sort_items_y, unsigned int, item_ycmp)
 
-static cairo_bool_t box_outside (const cairo_box_t *a, const cairo_box_t *b)
+static inline int
+node_xcmp (const struct bbtree_node a, const struct bbtree_node b)
 {
-    return
-	a->p1.x >= b->p2.x || a->p1.y >= b->p2.y ||
-	a->p2.x <= b->p1.x || a->p2.y <= b->p1.y;
+    return int64cmp ((int64_t) a.extents.p1.x + a.extents.p2.x,
+		     (int64_t) b.extents.p1.x + b.extents.p2.x);
 }
+CAIRO_COMBSORT_DECLARE (sort_nodes_x, struct bbtree_node, node_xcmp)
 
-static void
-bbtree_foreach_mark_visible (struct bbtree *bbt,
-			     const cairo_box_t *box,
-			     unsigned int **indices)
+static inline int
+node_ycmp (const struct bbtree_node a, const struct bbtree_node b)
 {
-    cairo_command_header_t *chain;
-
-    for (chain = bbt->chain; chain; chain = chain->chain)
-	*(*indices)++ = chain->index;
-
-    if (bbt->left && ! box_outside (box, &bbt->left->extents))
-	bbtree_foreach_mark_visible (bbt->left, box, indices);
-    if (bbt->right && ! box_outside (box, &bbt->right->extents))
-	bbtree_foreach_mark_visible (bbt->right, box, indices);
+    return int64cmp ((int64_t) a.extents.p1.y + a.extents.p2.y,
+		     (int64_t) b.extents.p1.y + b.extents.p2.y);
 }
+CAIRO_COMBSORT_DECLARE (sort_nodes_y, struct bbtree_node, node_ycmp)
 
 static inline int intcmp (const unsigned int a, const unsigned int b)
 {
@@ -277,88 +207,208 @@ static inline int intcmp (const unsigned int a, const unsigned int b)
 }
 CAIRO_COMBSORT_DECLARE (sort_indices, unsigned int, intcmp)
 
-static inline int sizecmp (unsigned int a, unsigned int b, cairo_command_header_t **elements)
+/* The number of entries in each vertical slice when packing @count
+ * entries into nodes of BBTREE_FANOUT. */
+static unsigned int
+bbtree_slice_size (unsigned int count)
 {
-    const cairo_rectangle_int_t *r;
+    unsigned int num_nodes, num_slices;
 
-    r = &elements[a]->extents;
-    a = r->width * r->height;
+    num_nodes = (count + BBTREE_FANOUT - 1) / BBTREE_FANOUT;
+    num_slices = ceil (sqrt (num_nodes));
+    return num_slices * BBTREE_FANOUT;
+}
 
-    r = &elements[b]->extents;
-    b = r->width * r->height;
+static void
+bbtree_pack_items (unsigned int *items,
+		   unsigned int count,
+		   cairo_command_t **elements)
+{
+    unsigned int i, slice;
 
-    return b - a;
+    if (count <= BBTREE_FANOUT)
+	return;
+
+    sort_items_x (items, count, elements);
+
+    slice = bbtree_slice_size (count);
+    for (i = 0; i < count; i += slice) {
+	unsigned int n = MIN (slice, count - i);
+	if (n > 1)
+	    sort_items_y (items + i, n, elements);
+    }
 }
-CAIRO_COMBSORT_DECLARE_WITH_DATA (sort_commands, unsigned int, sizecmp)
 
 static void
-_cairo_recording_surface_destroy_bbtree (cairo_recording_surface_t *surface)
+bbtree_pack_nodes (struct bbtree_node *nodes,
+		   unsigned int count)
 {
-    cairo_command_t **elements;
-    int i, num_elements;
+    unsigned int i, slice;
 
-    if (surface->bbtree.chain == INVALID_CHAIN)
+    if (count <= BBTREE_FANOUT)
 	return;
 
-    if (surface->bbtree.left) {
-	bbtree_del (surface->bbtree.left);
-	surface->bbtree.left = NULL;
+    sort_nodes_x (nodes, count);
+
+    slice = bbtree_slice_size (count);
+    for (i = 0; i < count; i += slice) {
+	unsigned int n = MIN (slice, count - i);
+	if (n > 1)
+	    sort_nodes_y (nodes + i, n);
     }
-    if (surface->bbtree.right) {
-	bbtree_del (surface->bbtree.right);
-	surface->bbtree.right = NULL;
+}
+
+static void
+bbtree_foreach_mark_visible (const struct bbtree *bbt,
+			     const struct bbtree_node *node,
+			     cairo_command_t **elements,
+			     const cairo_box_t *box,
+			     unsigned int **indices)
+{
+    unsigned int i;
+
+    if (node->is_leaf) {
+	for (i = 0; i < node->count; i++) {
+	    unsigned int index = bbt->items[node->first + i];
+	    cairo_box_t b;
+
+	    _cairo_box_from_rectangle (&b, &elements[index]->header.extents);
+	    if (! box_outside (box, &b))
+		*(*indices)++ = index;
+	}
+    } else {
+	for (i = 0; i < node->count; i++) {
+	    const struct bbtree_node *child = &bbt->nodes[node->first + i];
+	    if (! box_outside (box, &child->extents))
+		bbtree_foreach_mark_visible (bbt, child, elements, box, indices);
+	}
     }
+}
 
-    elements = _cairo_array_index (&surface->commands, 0);
-    num_elements = surface->commands.num_elements;
-    for (i = 0; i < num_elements; i++)
-	elements[i]->header.chain = NULL;
+static void
+_cairo_recording_surface_destroy_bbtree (cairo_recording_surface_t *surface)
+{
+    free (surface->bbtree.nodes);
+    surface->bbtree.nodes = NULL;
+    surface->bbtree.num_nodes = 0;
 
-    surface->bbtree.chain = INVALID_CHAIN;
+    free (surface->bbtree.items);
+    surface->bbtree.items = NULL;
+    surface->bbtree.num_items = 0;
 }
 
 static cairo_status_t
 _cairo_recording_surface_create_bbtree (cairo_recording_surface_t *surface)
 {
     cairo_command_t **elements = _cairo_array_index (&surface->commands, 0);
-    unsigned int *indices;
-    cairo_status_t status;
-    unsigned int i, count;
+    struct bbtree_node *nodes;
+    unsigned int *items;
+    unsigned int count, num_nodes, level, level_end, n, i, j;
+
+    _cairo_recording_surface_destroy_bbtree (surface);
 
     count = surface->commands.num_elements;
-    if (count > surface->num_indices) {
-	free (surface->indices);
-	surface->indices = _cairo_malloc_ab (count, sizeof (int));
-	if (unlikely (surface->indices == NULL))
-	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    if (count == 0)
+	return CAIRO_STATUS_SUCCESS;
 
-	surface->num_indices = count;
+    n = count;
+    num_nodes = 0;
+    do {
+	n = (n + BBTREE_FANOUT - 1) / BBTREE_FANOUT;
+	num_nodes += n;
+    } while (n > 1);
+
+    items = _cairo_malloc_ab (count, sizeof (unsigned int));
+    if (unlikely (items == NULL))
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+    nodes = _cairo_malloc_ab (num_nodes, sizeof (struct bbtree_node));
+    if (unlikely (nodes == NULL)) {
+	free (items);
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
     }
 
-    indices = surface->indices;
     for (i = 0; i < count; i++)
-	indices[i] = i;
+	items[i] = i;
+    bbtree_pack_items (items, count, elements);
 
-    sort_commands (indices, count, elements);
+    n = 0;
+    for (i = 0; i < count; i += BBTREE_FANOUT) {
+	struct bbtree_node *node = &nodes[n++];
 
-    bbtree_init (&surface->bbtree, &elements[indices[0]]->header);
-    for (i = 1; i < count; i++) {
-	cairo_command_header_t *header = &elements[indices[i]]->header;
-	cairo_box_t box;
+	node->first = i;
+	node->count = MIN (BBTREE_FANOUT, count - i);
+	node->is_leaf = TRUE;
 
-	_cairo_box_from_rectangle (&box, &header->extents);
-	status = bbtree_add (&surface->bbtree, header, &box);
-	if (unlikely (status))
-	    goto cleanup;
+	_cairo_box_from_rectangle (&node->extents,
+				   &elements[items[i]]->header.extents);
+	for (j = 1; j < node->count; j++) {
+	    cairo_box_t b;
+
+	    _cairo_box_from_rectangle (&b,
+				       &elements[items[i + j]]->header.extents);
+	    box_add_box (&node->extents, &b);
+	}
     }
 
-    return CAIRO_STATUS_SUCCESS;
+    level = 0;
+    level_end = n;
+    while (level_end - level > 1) {
+	bbtree_pack_nodes (nodes + level, level_end - level);
 
-cleanup:
-    bbtree_del (&surface->bbtree);
-    return status;
+	for (i = level; i < level_end; i += BBTREE_FANOUT) {
+	    struct bbtree_node *node = &nodes[n++];
+
+	    node->first = i;
+	    node->count = MIN (BBTREE_FANOUT, level_end - i);
+	    node->is_leaf = FALSE;
+
+	    node->extents = nodes[i].extents;
+	    for (j = 1; j < node->count; j++)
+		box_add_box (&node->extents, &nodes[i + j].extents);
+	}
+
+	level = level_end;
+	level_end = n;
+    }
+    assert (n == num_nodes);
+
+    surface->bbtree.nodes = nodes;
+    surface->bbtree.num_nodes = num_nodes;
+    surface->bbtree.items = items;
+    surface->bbtree.num_items = count;
+
+    return CAIRO_STATUS_SUCCESS;
 }
 
+/* Prepare the index and the shared scratch space for a query against
+ * every command recorded so far. The tree is only rebuilt once the
+ * unindexed tail has grown too long to scan. */
+static cairo_status_t
+_cairo_recording_surface_update_bbtree (cairo_recording_surface_t *surface)
+{
+    unsigned int count, tail;
+
+    count = surface->commands.num_elements;
+    if (count > surface->num_indices) {
+	unsigned int size = MAX (count, 2 * surface->num_indices);
+
+	free (surface->indices);
+	surface->indices = _cairo_malloc_ab (size, sizeof (unsigned int));
+	if (unlikely (surface->indices == NULL)) {
+	    surface->num_indices = 0;
+	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	}
+
+	surface->num_indices = size;
+    }
+
+    tail = count - surface->bbtree.num_items;
+    if (tail > MAX (BBTREE_MIN_TAIL, surface->bbtree.num_items / 4))
+	return _cairo_recording_surface_create_bbtree (surface);
+
+    return CAIRO_STATUS_SUCCESS;
+}
 /**
  * cairo_recording_surface_create:
  * @content: the content of the recording surface
@@ -412,14 +462,22 @@ cairo_recording_surface_create (cairo_content_t		 content,
     }
 
     _cairo_array_init (&surface->commands, sizeof (cairo_command_t *));
+    _cairo_arena_init (&surface->arena);
 
     surface->base.is_clear = TRUE;
 
-    surface->bbtree.left = surface->bbtree.right = NULL;
-    surface->bbtree.chain = INVALID_CHAIN;
+    surface->bbtree.nodes = NULL;
+    surface->bbtree.items = NULL;
+    surface->bbtree.num_nodes = 0;
+    surface->bbtree.num_items = 0;
 
     surface->indices = NULL;
     surface->num_indices = 0;
+
+    surface->data = NULL;
+    surface->records = surface->records_end = NULL;
+    surface->depth = 0;
+
     surface->optimize_clears = TRUE;
     surface->has_bilevel_alpha = FALSE;
     surface->has_only_op_over = FALSE;
@@ -441,64 +499,65 @@ _cairo_recording_surface_create_similar (void		       *abstract_surface,
     return cairo_recording_surface_create (content, &extents);
 }
 
-static cairo_status_t
-_cairo_recording_surface_finish (void *abstract_surface)
+void
+_cairo_recording_command_fini (cairo_command_t *command)
 {
-    cairo_recording_surface_t *surface = abstract_surface;
-    cairo_command_t **elements;
-    int i, num_elements;
+    switch (command->header.type) {
+    case CAIRO_COMMAND_PAINT:
+	_cairo_pattern_fini (&command->paint.source.base);
+	break;
 
-    num_elements = surface->commands.num_elements;
-    elements = _cairo_array_index (&surface->commands, 0);
-    for (i = 0; i < num_elements; i++) {
-	cairo_command_t *command = elements[i];
+    case CAIRO_COMMAND_MASK:
+	_cairo_pattern_fini (&command->mask.source.base);
+	_cairo_pattern_fini (&command->mask.mask.base);
+	break;
 
-	switch (command->header.type) {
-	case CAIRO_COMMAND_PAINT:
-	    _cairo_pattern_fini (&command->paint.source.base);
-	    break;
+    case CAIRO_COMMAND_STROKE:
+	_cairo_pattern_fini (&command->stroke.source.base);
+	_cairo_path_fixed_fini (&command->stroke.path);
+	_cairo_stroke_style_fini (&command->stroke.style);
+	break;
 
-	case CAIRO_COMMAND_MASK:
-	    _cairo_pattern_fini (&command->mask.source.base);
-	    _cairo_pattern_fini (&command->mask.mask.base);
-	    break;
+    case CAIRO_COMMAND_FILL:
+	_cairo_pattern_fini (&command->fill.source.base);
+	_cairo_path_fixed_fini (&command->fill.path);
+	break;
 
-	case CAIRO_COMMAND_STROKE:
-	    _cairo_pattern_fini (&command->stroke.source.base);
-	    _cairo_path_fixed_fini (&command->stroke.path);
-	    _cairo_stroke_style_fini (&command->stroke.style);
-	    break;
+    case CAIRO_COMMAND_SHOW_TEXT_GLYPHS:
+	_cairo_pattern_fini (&command->show_text_glyphs.source.base);
+	cairo_scaled_font_destroy (command->show_text_glyphs.scaled_font);
+	break;
 
-	case CAIRO_COMMAND_FILL:
-	    _cairo_pattern_fini (&command->fill.source.base);
-	    _cairo_path_fixed_fini (&command->fill.path);
-	    break;
+    default:
+	ASSERT_NOT_REACHED;
+    }
 
-	case CAIRO_COMMAND_SHOW_TEXT_GLYPHS:
-	    _cairo_pattern_fini (&command->show_text_glyphs.source.base);
-	    free (command->show_text_glyphs.utf8);
-	    free (command->show_text_glyphs.glyphs);
-	    free (command->show_text_glyphs.clusters);
-	    cairo_scaled_font_destroy (command->show_text_glyphs.scaled_font);
-	    break;
+    _cairo_clip_destroy (command->header.clip);
+}
 
-	default:
-	    ASSERT_NOT_REACHED;
-	}
+static cairo_status_t
+_cairo_recording_surface_finish (void *abstract_surface)
+{
+    cairo_recording_surface_t *surface = abstract_surface;
+    cairo_command_t **elements;
+    int i, num_elements;
 
-	_cairo_clip_destroy (command->header.clip);
-	free (command);
-    }
+    num_elements = surface->commands.num_elements;
+    elements = _cairo_array_index (&surface->commands, 0);
+    for (i = 0; i < num_elements; i++)
+	_cairo_recording_command_fini (elements[i]);
 
     _cairo_array_fini (&surface->commands);
+    _cairo_arena_fini (&surface->arena);
 
-    if (surface->bbtree.left)
-	bbtree_del (surface->bbtree.left);
-    if (surface->bbtree.right)
-	bbtree_del (surface->bbtree.right);
+    free (surface->bbtree.nodes);
+    free (surface->bbtree.items);
 
     free (surface->indices);
 
+    if (surface->data)
+	_cairo_recording_data_destroy (surface->data);
+
     return CAIRO_STATUS_SUCCESS;
 }
 
@@ -639,7 +698,6 @@ _command_init (cairo_recording_surface_t *surface,
     command->region = CAIRO_RECORDING_REGION_ALL;
 
     command->extents = composite->unbounded;
-    command->chain = NULL;
     command->index = surface->commands.num_elements;
 
     /* steal the clip */
@@ -674,13 +732,103 @@ _cairo_recording_surface_reset (cairo_recording_surface_t *surface)
     /* Reset the commands and temporaries */
     _cairo_recording_surface_finish (surface);
 
-    surface->bbtree.left = surface->bbtree.right = NULL;
-    surface->bbtree.chain = INVALID_CHAIN;
+    surface->bbtree.nodes = NULL;
+    surface->bbtree.items = NULL;
+    surface->bbtree.num_nodes = 0;
+    surface->bbtree.num_items = 0;
 
     surface->indices = NULL;
     surface->num_indices = 0;
 
+    surface->data = NULL;
+    surface->records = surface->records_end = NULL;
+
     _cairo_array_init (&surface->commands, sizeof (cairo_command_t *));
+    _cairo_arena_init (&surface->arena);
+}
+
+/* Decode the serialized commands between @p and @end into the list of
+ * commands of @surface. */
+static cairo_status_t
+_cairo_recording_surface_read_records (cairo_recording_surface_t *surface,
+				       cairo_recording_data_t *data,
+				       const unsigned char *p,
+				       const unsigned char *end)
+{
+    while (p < end) {
+	const cairo_recording_record_t *record = (const cairo_recording_record_t *) p;
+	cairo_command_t *command;
+	cairo_status_t status;
+	size_t size;
+
+	switch (record->type) {
+	case CAIRO_COMMAND_PAINT:
+	    size = sizeof (cairo_command_paint_t);
+	    break;
+	case CAIRO_COMMAND_MASK:
+	    size = sizeof (cairo_command_mask_t);
+	    break;
+	case CAIRO_COMMAND_STROKE:
+	    size = sizeof (cairo_command_stroke_t);
+	    break;
+	case CAIRO_COMMAND_FILL:
+	    size = sizeof (cairo_command_fill_t);
+	    break;
+	default:
+	    return _cairo_error (CAIRO_STATUS_READ_ERROR);
+	}
+
+	command = _cairo_arena_alloc (&surface->arena, size);
+	if (unlikely (command == NULL))
+	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+	status = _cairo_recording_data_decode_command (data, record,
+						       command, TRUE,
+						       surface->depth);
+	if (unlikely (status))
+	    return status;
+
+	command->header.index = surface->commands.num_elements;
+	status = _cairo_recording_surface_commit (surface, &command->header);
+	if (unlikely (status)) {
+	    _cairo_recording_command_fini (command);
+	    return status;
+	}
+
+	p += record->size;
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/**
+ * _cairo_recording_surface_load:
+ * @surface: a #cairo_recording_surface_t
+ *
+ * Copies any commands still held in the serialized data of @surface
+ * into its list of commands, for those operations that need to inspect
+ * or extend them rather than merely replay them.
+ *
+ * Return value: %CAIRO_STATUS_SUCCESS, or an error if the commands
+ * could not be decoded.
+ **/
+cairo_status_t
+_cairo_recording_surface_load (cairo_recording_surface_t *surface)
+{
+    cairo_recording_data_t *data = surface->data;
+    cairo_status_t status;
+
+    if (data == NULL)
+	return CAIRO_STATUS_SUCCESS;
+
+    surface->data = NULL;
+    status = _cairo_recording_surface_read_records (surface, data,
+						    surface->records,
+						    surface->records_end);
+    surface->records = surface->records_end = NULL;
+    _cairo_recording_data_destroy (data);
+
+    return status;
 }
 
 static cairo_bool_t
@@ -730,6 +878,10 @@ _cairo_recording_surface_paint (void			  *abstract_surface,
 	}
     }
 
+    status = _cairo_recording_surface_load (surface);
+    if (unlikely (status))
+	return status;
+
     status = _cairo_composite_rectangles_init_for_paint (&composite,
 							 &surface->base,
 							 op, source,
@@ -737,7 +889,7 @@ _cairo_recording_surface_paint (void			  *abstract_surface,
     if (unlikely (status))
 	return status;
 
-    command = malloc (sizeof (cairo_command_paint_t));
+    command = _cairo_arena_alloc (&surface->arena, sizeof (cairo_command_paint_t));
     if (unlikely (command == NULL)) {
 	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
 	goto CLEANUP_COMPOSITE;
@@ -757,8 +909,6 @@ _cairo_recording_surface_paint (void			  *abstract_surface,
     if (unlikely (status))
 	goto CLEANUP_SOURCE;
 
-    _cairo_recording_surface_destroy_bbtree (surface);
-
     _cairo_composite_rectangles_fini (&composite);
     return CAIRO_STATUS_SUCCESS;
 
@@ -766,7 +916,6 @@ _cairo_recording_surface_paint (void			  *abstract_surface,
     _cairo_pattern_fini (&command->source.base);
   CLEANUP_COMMAND:
     _cairo_clip_destroy (command->header.clip);
-    free (command);
 CLEANUP_COMPOSITE:
     _cairo_composite_rectangles_fini (&composite);
     return status;
@@ -786,6 +935,10 @@ _cairo_recording_surface_mask (void			*abstract_surface,
 
     TRACE ((stderr, "%s: surface=%d\n", __FUNCTION__, surface->base.unique_id));
 
+    status = _cairo_recording_surface_load (surface);
+    if (unlikely (status))
+	return status;
+
     status = _cairo_composite_rectangles_init_for_mask (&composite,
 							&surface->base,
 							op, source, mask,
@@ -793,7 +946,7 @@ _cairo_recording_surface_mask (void			*abstract_surface,
     if (unlikely (status))
 	return status;
 
-    command = malloc (sizeof (cairo_command_mask_t));
+    command = _cairo_arena_alloc (&surface->arena, sizeof (cairo_command_mask_t));
     if (unlikely (command == NULL)) {
 	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
 	goto CLEANUP_COMPOSITE;
@@ -817,8 +970,6 @@ _cairo_recording_surface_mask (void			*abstract_surface,
     if (unlikely (status))
 	goto CLEANUP_MASK;
 
-    _cairo_recording_surface_destroy_bbtree (surface);
-
     _cairo_composite_rectangles_fini (&composite);
     return CAIRO_STATUS_SUCCESS;
 
@@ -828,7 +979,6 @@ _cairo_recording_surface_mask (void			*abstract_surface,
     _cairo_pattern_fini (&command->source.base);
   CLEANUP_COMMAND:
     _cairo_clip_destroy (command->header.clip);
-    free (command);
 CLEANUP_COMPOSITE:
     _cairo_composite_rectangles_fini (&composite);
     return status;
@@ -853,6 +1003,10 @@ _cairo_recording_surface_stroke (void			*abstract_surface,
 
     TRACE ((stderr, "%s: surface=%d\n", __FUNCTION__, surface->base.unique_id));
 
+    status = _cairo_recording_surface_load (surface);
+    if (unlikely (status))
+	return status;
+
     status = _cairo_composite_rectangles_init_for_stroke (&composite,
 							  &surface->base,
 							  op, source,
@@ -861,7 +1015,7 @@ _cairo_recording_surface_stroke (void			*abstract_surface,
     if (unlikely (status))
 	return status;
 
-    command = malloc (sizeof (cairo_command_stroke_t));
+    command = _cairo_arena_alloc (&surface->arena, sizeof (cairo_command_stroke_t));
     if (unlikely (command == NULL)) {
 	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
 	goto CLEANUP_COMPOSITE;
@@ -877,7 +1031,8 @@ _cairo_recording_surface_stroke (void			*abstract_surface,
     if (unlikely (status))
 	goto CLEANUP_COMMAND;
 
-    status = _cairo_path_fixed_init_copy (&command->path, path);
+    status = _cairo_path_fixed_init_copy_in_arena (&command->path, path,
+						   &surface->arena);
     if (unlikely (status))
 	goto CLEANUP_SOURCE;
 
@@ -894,8 +1049,6 @@ _cairo_recording_surface_stroke (void			*abstract_surface,
     if (unlikely (status))
 	goto CLEANUP_STYLE;
 
-    _cairo_recording_surface_destroy_bbtree (surface);
-
     _cairo_composite_rectangles_fini (&composite);
     return CAIRO_STATUS_SUCCESS;
 
@@ -907,7 +1060,6 @@ _cairo_recording_surface_stroke (void			*abstract_surface,
     _cairo_pattern_fini (&command->source.base);
   CLEANUP_COMMAND:
     _cairo_clip_destroy (command->header.clip);
-    free (command);
 CLEANUP_COMPOSITE:
     _cairo_composite_rectangles_fini (&composite);
     return status;
@@ -930,6 +1082,10 @@ _cairo_recording_surface_fill (void			*abstract_surface,
 
     TRACE ((stderr, "%s: surface=%d\n", __FUNCTION__, surface->base.unique_id));
 
+    status = _cairo_recording_surface_load (surface);
+    if (unlikely (status))
+	return status;
+
     status = _cairo_composite_rectangles_init_for_fill (&composite,
 							&surface->base,
 							op, source, path,
@@ -937,7 +1093,7 @@ _cairo_recording_surface_fill (void			*abstract_surface,
     if (unlikely (status))
 	return status;
 
-    command = malloc (sizeof (cairo_command_fill_t));
+    command = _cairo_arena_alloc (&surface->arena, sizeof (cairo_command_fill_t));
     if (unlikely (command == NULL)) {
 	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
 	goto CLEANUP_COMPOSITE;
@@ -953,7 +1109,8 @@ _cairo_recording_surface_fill (void			*abstract_surface,
     if (unlikely (status))
 	goto CLEANUP_COMMAND;
 
-    status = _cairo_path_fixed_init_copy (&command->path, path);
+    status = _cairo_path_fixed_init_copy_in_arena (&command->path, path,
+						   &surface->arena);
     if (unlikely (status))
 	goto CLEANUP_SOURCE;
 
@@ -965,8 +1122,6 @@ _cairo_recording_surface_fill (void			*abstract_surface,
     if (unlikely (status))
 	goto CLEANUP_PATH;
 
-    _cairo_recording_surface_destroy_bbtree (surface);
-
     _cairo_composite_rectangles_fini (&composite);
     return CAIRO_STATUS_SUCCESS;
 
@@ -976,7 +1131,6 @@ _cairo_recording_surface_fill (void			*abstract_surface,
     _cairo_pattern_fini (&command->source.base);
   CLEANUP_COMMAND:
     _cairo_clip_destroy (command->header.clip);
-    free (command);
 CLEANUP_COMPOSITE:
     _cairo_composite_rectangles_fini (&composite);
     return status;
@@ -1009,6 +1163,10 @@ _cairo_recording_surface_show_text_glyphs (void				*abstract_surface,
 
     TRACE ((stderr, "%s: surface=%d\n", __FUNCTION__, surface->base.unique_id));
 
+    status = _cairo_recording_surface_load (surface);
+    if (unlikely (status))
+	return status;
+
     status = _cairo_composite_rectangles_init_for_glyphs (&composite,
 							  &surface->base,
 							  op, source,
@@ -1019,7 +1177,7 @@ _cairo_recording_surface_show_text_glyphs (void				*abstract_surface,
     if (unlikely (status))
 	return status;
 
-    command = malloc (sizeof (cairo_command_show_text_glyphs_t));
+    command = _cairo_arena_alloc (&surface->arena, sizeof (cairo_command_show_text_glyphs_t));
     if (unlikely (command == NULL)) {
 	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
 	goto CLEANUP_COMPOSITE;
@@ -1043,7 +1201,7 @@ _cairo_recording_surface_show_text_glyphs (void				*abstract_surface,
     command->num_clusters = num_clusters;
 
     if (utf8_len) {
-	command->utf8 = malloc (utf8_len);
+	command->utf8 = _cairo_arena_alloc (&surface->arena, utf8_len);
 	if (unlikely (command->utf8 == NULL)) {
 	    status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
 	    goto CLEANUP_ARRAYS;
@@ -1051,7 +1209,8 @@ _cairo_recording_surface_show_text_glyphs (void				*abstract_surface,
 	memcpy (command->utf8, utf8, utf8_len);
     }
     if (num_glyphs) {
-	command->glyphs = _cairo_malloc_ab (num_glyphs, sizeof (glyphs[0]));
+	command->glyphs = _cairo_arena_alloc_ab (&surface->arena,
+						 num_glyphs, sizeof (glyphs[0]));
 	if (unlikely (command->glyphs == NULL)) {
 	    status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
 	    goto CLEANUP_ARRAYS;
@@ -1059,7 +1218,8 @@ _cairo_recording_surface_show_text_glyphs (void				*abstract_surface,
 	memcpy (command->glyphs, glyphs, sizeof (glyphs[0]) * num_glyphs);
     }
     if (num_clusters) {
-	command->clusters = _cairo_malloc_ab (num_clusters, sizeof (clusters[0]));
+	command->clusters = _cairo_arena_alloc_ab (&surface->arena,
+						   num_clusters, sizeof (clusters[0]));
 	if (unlikely (command->clusters == NULL)) {
 	    status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
 	    goto CLEANUP_ARRAYS;
@@ -1081,14 +1241,9 @@ _cairo_recording_surface_show_text_glyphs (void				*abstract_surface,
   CLEANUP_SCALED_FONT:
     cairo_scaled_font_destroy (command->scaled_font);
   CLEANUP_ARRAYS:
-    free (command->utf8);
-    free (command->glyphs);
-    free (command->clusters);
-
     _cairo_pattern_fini (&command->source.base);
   CLEANUP_COMMAND:
     _cairo_clip_destroy (command->header.clip);
-    free (command);
 CLEANUP_COMPOSITE:
     _cairo_composite_rectangles_fini (&composite);
     return status;
@@ -1104,7 +1259,6 @@ _command_init_copy (cairo_recording_surface_t *surface,
     dst->region = CAIRO_RECORDING_REGION_ALL;
 
     dst->extents = src->extents;
-    dst->chain = NULL;
     dst->index = surface->commands.num_elements;
 
     dst->clip = _cairo_clip_copy (src->clip);
@@ -1117,7 +1271,7 @@ _cairo_recording_surface_copy__paint (cairo_recording_surface_t *surface,
     cairo_command_paint_t *command;
     cairo_status_t status;
 
-    command = malloc (sizeof (*command));
+    command = _cairo_arena_alloc (&surface->arena, sizeof (*command));
     if (unlikely (command == NULL)) {
 	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
 	goto err;
@@ -1128,7 +1282,7 @@ _cairo_recording_surface_copy__paint (cairo_recording_surface_t *surface,
     status = _cairo_pattern_init_copy (&command->source.base,
 				       &src->paint.source.base);
     if (unlikely (status))
-	goto err_command;
+	goto err;
 
     status = _cairo_recording_surface_commit (surface, &command->header);
     if (unlikely (status))
@@ -1138,8 +1292,6 @@ _cairo_recording_surface_copy__paint (cairo_recording_surface_t *surface,
 
 err_source:
     _cairo_pattern_fini (&command->source.base);
-err_command:
-    free(command);
 err:
     return status;
 }
@@ -1151,7 +1303,7 @@ _cairo_recording_surface_copy__mask (cairo_recording_surface_t *surface,
     cairo_command_mask_t *command;
     cairo_status_t status;
 
-    command = malloc (sizeof (*command));
+    command = _cairo_arena_alloc (&surface->arena, sizeof (*command));
     if (unlikely (command == NULL)) {
 	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
 	goto err;
@@ -1162,7 +1314,7 @@ _cairo_recording_surface_copy__mask (cairo_recording_surface_t *surface,
     status = _cairo_pattern_init_copy (&command->source.base,
 				       &src->mask.source.base);
     if (unlikely (status))
-	goto err_command;
+	goto err;
 
     status = _cairo_pattern_init_copy (&command->mask.base,
 				       &src->mask.mask.base);
@@ -1179,8 +1331,6 @@ err_mask:
     _cairo_pattern_fini (&command->mask.base);
 err_source:
     _cairo_pattern_fini (&command->source.base);
-err_command:
-    free(command);
 err:
     return status;
 }
@@ -1192,7 +1342,7 @@ _cairo_recording_surface_copy__stroke (cairo_recording_surface_t *surface,
     cairo_command_stroke_t *command;
     cairo_status_t status;
 
-    command = malloc (sizeof (*command));
+    command = _cairo_arena_alloc (&surface->arena, sizeof (*command));
     if (unlikely (command == NULL)) {
 	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
 	goto err;
@@ -1203,9 +1353,11 @@ _cairo_recording_surface_copy__stroke (cairo_recording_surface_t *surface,
     status = _cairo_pattern_init_copy (&command->source.base,
 				       &src->stroke.source.base);
     if (unlikely (status))
-	goto err_command;
+	goto err;
 
-    status = _cairo_path_fixed_init_copy (&command->path, &src->stroke.path);
+    status = _cairo_path_fixed_init_copy_in_arena (&command->path,
+						   &src->stroke.path,
+						   &surface->arena);
     if (unlikely (status))
 	goto err_source;
 
@@ -1231,8 +1383,6 @@ err_path:
     _cairo_path_fixed_fini (&command->path);
 err_source:
     _cairo_pattern_fini (&command->source.base);
-err_command:
-    free(command);
 err:
     return status;
 }
@@ -1244,7 +1394,7 @@ _cairo_recording_surface_copy__fill (cairo_recording_surface_t *surface,
     cairo_command_fill_t *command;
     cairo_status_t status;
 
-    command = malloc (sizeof (*command));
+    command = _cairo_arena_alloc (&surface->arena, sizeof (*command));
     if (unlikely (command == NULL)) {
 	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
 	goto err;
@@ -1255,9 +1405,11 @@ _cairo_recording_surface_copy__fill (cairo_recording_surface_t *surface,
     status = _cairo_pattern_init_copy (&command->source.base,
 				       &src->fill.source.base);
     if (unlikely (status))
-	goto err_command;
+	goto err;
 
-    status = _cairo_path_fixed_init_copy (&command->path, &src->fill.path);
+    status = _cairo_path_fixed_init_copy_in_arena (&command->path,
+						   &src->fill.path,
+						   &surface->arena);
     if (unlikely (status))
 	goto err_source;
 
@@ -1275,8 +1427,6 @@ err_path:
     _cairo_path_fixed_fini (&command->path);
 err_source:
     _cairo_pattern_fini (&command->source.base);
-err_command:
-    free(command);
 err:
     return status;
 }
@@ -1288,7 +1438,7 @@ _cairo_recording_surface_copy__glyphs (cairo_recording_surface_t *surface,
     cairo_command_show_text_glyphs_t *command;
     cairo_status_t status;
 
-    command = malloc (sizeof (*command));
+    command = _cairo_arena_alloc (&surface->arena, sizeof (*command));
     if (unlikely (command == NULL)) {
 	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
 	goto err;
@@ -1299,7 +1449,7 @@ _cairo_recording_surface_copy__glyphs (cairo_recording_surface_t *surface,
     status = _cairo_pattern_init_copy (&command->source.base,
 				       &src->show_text_glyphs.source.base);
     if (unlikely (status))
-	goto err_command;
+	goto err;
 
     command->utf8 = NULL;
     command->utf8_len = src->show_text_glyphs.utf8_len;
@@ -1309,7 +1459,7 @@ _cairo_recording_surface_copy__glyphs (cairo_recording_surface_t *surface,
     command->num_clusters = src->show_text_glyphs.num_clusters;
 
     if (command->utf8_len) {
-	command->utf8 = malloc (command->utf8_len);
+	command->utf8 = _cairo_arena_alloc (&surface->arena, command->utf8_len);
 	if (unlikely (command->utf8 == NULL)) {
 	    status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
 	    goto err_arrays;
@@ -1317,8 +1467,9 @@ _cairo_recording_surface_copy__glyphs (cairo_recording_surface_t *surface,
 	memcpy (command->utf8, src->show_text_glyphs.utf8, command->utf8_len);
     }
     if (command->num_glyphs) {
-	command->glyphs = _cairo_malloc_ab (command->num_glyphs,
-					    sizeof (command->glyphs[0]));
+	command->glyphs = _cairo_arena_alloc_ab (&surface->arena,
+						 command->num_glyphs,
+						 sizeof (command->glyphs[0]));
 	if (unlikely (command->glyphs == NULL)) {
 	    status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
 	    goto err_arrays;
@@ -1327,8 +1478,9 @@ _cairo_recording_surface_copy__glyphs (cairo_recording_surface_t *surface,
 		sizeof (command->glyphs[0]) * command->num_glyphs);
     }
     if (command->num_clusters) {
-	command->clusters = _cairo_malloc_ab (command->num_clusters,
-					      sizeof (command->clusters[0]));
+	command->clusters = _cairo_arena_alloc_ab (&surface->arena,
+						   command->num_clusters,
+						   sizeof (command->clusters[0]));
 	if (unlikely (command->clusters == NULL)) {
 	    status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
 	    goto err_arrays;
@@ -1349,12 +1501,7 @@ _cairo_recording_surface_copy__glyphs (cairo_recording_surface_t *surface,
     return CAIRO_STATUS_SUCCESS;
 
 err_arrays:
-    free (command->utf8);
-    free (command->glyphs);
-    free (command->clusters);
     _cairo_pattern_fini (&command->source.base);
-err_command:
-    free(command);
 err:
     return status;
 }
@@ -1439,15 +1586,28 @@ _cairo_recording_surface_snapshot (void *abstract_other)
 
     surface->base.is_clear = other->base.is_clear;
 
-    surface->bbtree.left = surface->bbtree.right = NULL;
-    surface->bbtree.chain = INVALID_CHAIN;
+    surface->bbtree.nodes = NULL;
+    surface->bbtree.items = NULL;
+    surface->bbtree.num_nodes = 0;
+    surface->bbtree.num_items = 0;
 
     surface->indices = NULL;
     surface->num_indices = 0;
+
+    surface->data = NULL;
+    surface->records = surface->records_end = NULL;
+    surface->depth = other->depth;
+
     surface->optimize_clears = TRUE;
 
     _cairo_array_init (&surface->commands, sizeof (cairo_command_t *));
-    status = _cairo_recording_surface_copy (surface, other);
+    _cairo_arena_init (&surface->arena);
+    if (other->data) {
+	status = _cairo_recording_surface_read_records (surface, other->data,
+							other->records,
+							other->records_end);
+    } else
+	status = _cairo_recording_surface_copy (surface, other);
     if (unlikely (status)) {
 	cairo_surface_destroy (&surface->base);
 	return _cairo_surface_create_in_error (status);
@@ -1522,7 +1682,9 @@ _cairo_recording_surface_get_path (cairo_surface_t    *abstract_surface,
 	return abstract_surface->status;
 
     surface = (cairo_recording_surface_t *) abstract_surface;
-    status = CAIRO_STATUS_SUCCESS;
+    status = _cairo_recording_surface_load (surface);
+    if (unlikely (status))
+	return status;
 
     num_elements = surface->commands.num_elements;
     elements = _cairo_array_index (&surface->commands, 0);
@@ -1582,28 +1744,57 @@ _cairo_recording_surface_get_path (cairo_surface_t    *abstract_surface,
     return status;
 }
 
+/* Collect the indices of the commands that intersect @extents, in
+ * recording order, into @indices. If @indices is %NULL the surface's own
+ * scratch space is used and the index is brought up to date first;
+ * callers supplying their own array must have done so in advance.
+ */
 static int
 _cairo_recording_surface_get_visible_commands (cairo_recording_surface_t *surface,
-					       const cairo_rectangle_int_t *extents)
+					       const cairo_rectangle_int_t *extents,
+					       unsigned int *indices)
 {
-    unsigned int num_visible, *indices;
+    cairo_command_t **elements;
+    unsigned int num_visible, i, *end;
     cairo_box_t box;
 
     if (surface->commands.num_elements == 0)
 	    return 0;
 
+    if (indices == NULL) {
+	/* Without an index fall back to replaying every command */
+	if (unlikely (_cairo_recording_surface_update_bbtree (surface)))
+	    return surface->commands.num_elements;
+
+	indices = surface->indices;
+    }
+
     _cairo_box_from_rectangle (&box, extents);
+    elements = _cairo_array_index (&surface->commands, 0);
 
-    if (surface->bbtree.chain == INVALID_CHAIN)
-	_cairo_recording_surface_create_bbtree (surface);
+    end = indices;
+    if (surface->bbtree.num_nodes) {
+	const struct bbtree_node *root;
 
-    indices = surface->indices;
-    bbtree_foreach_mark_visible (&surface->bbtree, &box, &indices);
-    num_visible = indices - surface->indices;
+	root = &surface->bbtree.nodes[surface->bbtree.num_nodes - 1];
+	if (! box_outside (&box, &root->extents))
+	    bbtree_foreach_mark_visible (&surface->bbtree, root,
+					 elements, &box, &end);
+    }
+    num_visible = end - indices;
     if (num_visible > 1)
-	sort_indices (surface->indices, num_visible);
+	sort_indices (indices, num_visible);
+
+    /* The tail recorded since the tree was built is already in order */
+    for (i = surface->bbtree.num_items; i < surface->commands.num_elements; i++) {
+	cairo_box_t b;
+
+	_cairo_box_from_rectangle (&b, &elements[i]->header.extents);
+	if (! box_outside (&box, &b))
+	    *end++ = i;
+    }
 
-    return num_visible;
+    return end - indices;
 }
 
 static void
@@ -1668,12 +1859,102 @@ _cairo_recording_surface_merge_source_attributes (cairo_recording_surface_t  *su
 	surface->has_bilevel_alpha = FALSE;
 }
 
-static cairo_status_t
-_cairo_recording_surface_replay_internal (cairo_recording_surface_t	*surface,
+/* Streams the serialized commands of @surface through @wrapper, decoding
+ * each one that intersects @extents in turn.
+ */
+static cairo_int_status_t
+_cairo_recording_surface_replay_records (cairo_recording_surface_t *surface,
+					 cairo_surface_wrapper_t *wrapper,
+					 const cairo_rectangle_int_t *extents)
+{
+    cairo_int_status_t status = CAIRO_STATUS_SUCCESS;
+    const unsigned char *p = surface->records;
+
+    while (p < surface->records_end) {
+	const cairo_recording_record_t *record = (const cairo_recording_record_t *) p;
+	cairo_rectangle_int_t r;
+	cairo_command_t command;
+
+	p += record->size;
+
+	r.x = record->x;
+	r.y = record->y;
+	r.width = record->width;
+	r.height = record->height;
+	if (! _cairo_rectangle_intersects (extents, &r))
+	    continue;
+
+	status = _cairo_recording_data_decode_command (surface->data, record,
+						       &command, FALSE,
+						       surface->depth);
+	if (unlikely (status))
+	    break;
+
+	switch (command.header.type) {
+	case CAIRO_COMMAND_PAINT:
+	    status = _cairo_surface_wrapper_paint (wrapper,
+						   command.header.op,
+						   &command.paint.source.base,
+						   command.header.clip);
+	    break;
+
+	case CAIRO_COMMAND_MASK:
+	    status = _cairo_surface_wrapper_mask (wrapper,
+						  command.header.op,
+						  &command.mask.source.base,
+						  &command.mask.mask.base,
+						  command.header.clip);
+	    break;
+
+	case CAIRO_COMMAND_STROKE:
+	    status = _cairo_surface_wrapper_stroke (wrapper,
+						    command.header.op,
+						    &command.stroke.source.base,
+						    &command.stroke.path,
+						    &command.stroke.style,
+						    &command.stroke.ctm,
+						    &command.stroke.ctm_inverse,
+						    command.stroke.tolerance,
+						    command.stroke.antialias,
+						    command.header.clip);
+	    break;
+
+	case CAIRO_COMMAND_FILL:
+	    status = _cairo_surface_wrapper_fill (wrapper,
+						  command.header.op,
+						  &command.fill.source.base,
+						  &command.fill.path,
+						  command.fill.fill_rule,
+						  command.fill.tolerance,
+						  command.fill.antialias,
+						  command.header.clip);
+	    break;
+
+	default:
+	    ASSERT_NOT_REACHED;
+	}
+
+	_cairo_recording_command_fini (&command);
+	if (unlikely (status))
+	    break;
+    }
+
+    return status;
+}
+
+/* Replays the (visible) commands of @surface onto @target, culling them
+ * against the extents of @target. @indices provides the scratch space
+ * for the culling and may be %NULL to use the surface's own array; a
+ * caller replaying from several threads at once must provide separate
+ * arrays and have brought the bbtree up to date.
+ */
+static cairo_int_status_t
+_cairo_recording_surface_replay_commands (cairo_recording_surface_t	*surface,
 					  const cairo_rectangle_int_t *surface_extents,
 					  const cairo_matrix_t *surface_transform,
 					  cairo_surface_t	     *target,
 					  const cairo_clip_t *target_clip,
+					  unsigned int *indices,
 					  cairo_recording_replay_type_t type,
 					  cairo_recording_region_type_t region)
 {
@@ -1688,20 +1969,6 @@ _cairo_recording_surface_replay_internal (cairo_recording_surface_t	*surface,
     const cairo_rectangle_int_t *r;
     unsigned int i, num_elements;
 
-    if (unlikely (surface->base.status))
-	return surface->base.status;
-
-    if (unlikely (target->status))
-	return target->status;
-
-    if (unlikely (surface->base.finished))
-	return _cairo_error (CAIRO_STATUS_SURFACE_FINISHED);
-
-    if (surface->base.is_clear)
-	return CAIRO_STATUS_SUCCESS;
-
-    assert (_cairo_surface_is_recording (&surface->base));
-
     _cairo_surface_wrapper_init (&wrapper, target);
     if (surface_extents)
 	_cairo_surface_wrapper_intersect_extents (&wrapper, surface_extents);
@@ -1717,19 +1984,25 @@ _cairo_recording_surface_replay_internal (cairo_recording_surface_t	*surface,
     if (! _cairo_surface_wrapper_get_target_extents (&wrapper, &extents))
 	goto done;
 
-    surface->has_bilevel_alpha = TRUE;
-    surface->has_only_op_over = TRUE;
+    if (surface->data) {
+	status = _cairo_recording_surface_replay_records (surface, &wrapper,
+							  &extents);
+	goto done;
+    }
 
     num_elements = surface->commands.num_elements;
     elements = _cairo_array_index (&surface->commands, 0);
     if (extents.width < r->width || extents.height < r->height) {
 	num_elements =
-	    _cairo_recording_surface_get_visible_commands (surface, &extents);
+	    _cairo_recording_surface_get_visible_commands (surface, &extents,
+							   indices);
 	use_indices = num_elements != surface->commands.num_elements;
+	if (indices == NULL)
+	    indices = surface->indices;
     }
 
     for (i = 0; i < num_elements; i++) {
-	cairo_command_t *command = elements[use_indices ? surface->indices[i] : i];
+	cairo_command_t *command = elements[use_indices ? indices[i] : i];
 
 	if (! replay_all && command->header.region != region)
 	    continue;
@@ -1889,6 +2162,311 @@ _cairo_recording_surface_replay_internal (cairo_recording_surface_t	*surface,
 
 done:
     _cairo_surface_wrapper_fini (&wrapper);
+    return status;
+}
+
+/* Replaying onto an image can be split into horizontal tiles that are
+ * rendered concurrently, each through its own view of the target pixels
+ * and with its own culling of the commands. As every operation is clipped
+ * to the tile it is rendered into and the edges keep their original
+ * geometry, the result is identical to that of a single serial replay.
+ */
+#define TILE_MIN_HEIGHT 64
+#define TILE_MIN_COMMANDS 16
+
+typedef struct _cairo_recording_tile {
+    cairo_recording_surface_t *surface;
+    const cairo_rectangle_int_t *surface_extents;
+    const cairo_matrix_t *surface_transform;
+    cairo_surface_t *target;
+    unsigned int *indices;
+    cairo_int_status_t status;
+} cairo_recording_tile_t;
+
+static cairo_bool_t
+_pattern_is_thread_safe (const cairo_pattern_t *pattern,
+			 cairo_bool_t is_translation)
+{
+    /* Surface patterns are excluded as acquiring them shares (and
+     * refcounts) their pixman images or recursively replays into
+     * caches, and raster sources call back into the application.
+     *
+     * Each tile composites from its own origin, so gradients must also
+     * be sampled independently of it, as for the bands of the spans
+     * compositor; meshes are rasterised over the extents of each
+     * operation and so never are.
+     */
+    switch (pattern->type) {
+    case CAIRO_PATTERN_TYPE_SOLID:
+	return TRUE;
+    case CAIRO_PATTERN_TYPE_LINEAR:
+    case CAIRO_PATTERN_TYPE_RADIAL:
+	return is_translation &&
+	    _cairo_gradient_pattern_is_band_invariant ((const cairo_gradient_pattern_t *) pattern);
+    case CAIRO_PATTERN_TYPE_MESH:
+    case CAIRO_PATTERN_TYPE_SURFACE:
+    case CAIRO_PATTERN_TYPE_RASTER_SOURCE:
+    default:
+	return FALSE;
+    }
+}
+
+static cairo_bool_t
+_cairo_recording_surface_can_replay_tiled (cairo_recording_surface_t *surface,
+					   cairo_bool_t is_translation)
+{
+    cairo_command_t **elements;
+    unsigned int i, num_elements;
+
+    num_elements = surface->commands.num_elements;
+    elements = _cairo_array_index (&surface->commands, 0);
+    for (i = 0; i < num_elements; i++) {
+	cairo_command_t *command = elements[i];
+
+	switch (command->header.type) {
+	case CAIRO_COMMAND_PAINT:
+	    if (! _pattern_is_thread_safe (&command->paint.source.base,
+					   is_translation))
+		return FALSE;
+	    break;
+
+	case CAIRO_COMMAND_MASK:
+	    if (! _pattern_is_thread_safe (&command->mask.source.base,
+					   is_translation) ||
+		! _pattern_is_thread_safe (&command->mask.mask.base,
+					   is_translation))
+		return FALSE;
+	    break;
+
+	case CAIRO_COMMAND_STROKE:
+	    if (! _pattern_is_thread_safe (&command->stroke.source.base,
+					   is_translation))
+		return FALSE;
+	    break;
+
+	case CAIRO_COMMAND_FILL:
+	    if (! _pattern_is_thread_safe (&command->fill.source.base,
+					   is_translation))
+		return FALSE;
+	    break;
+
+	case CAIRO_COMMAND_SHOW_TEXT_GLYPHS:
+	    if (! _pattern_is_thread_safe (&command->show_text_glyphs.source.base,
+					   is_translation))
+		return FALSE;
+	    /* user fonts render their glyphs by replaying recordings */
+	    if (cairo_scaled_font_get_type (command->show_text_glyphs.scaled_font) == CAIRO_FONT_TYPE_USER)
+		return FALSE;
+	    break;
+
+	default:
+	    return FALSE;
+	}
+    }
+
+    return TRUE;
+}
+
+static int
+_cairo_recording_surface_num_tiles (cairo_recording_surface_t *surface,
+				    const cairo_matrix_t *surface_transform,
+				    cairo_surface_t *target,
+				    const cairo_clip_t *target_clip,
+				    cairo_recording_replay_type_t type,
+				    cairo_recording_region_type_t region)
+{
+    cairo_image_surface_t *image = (cairo_image_surface_t *) target;
+    const cairo_matrix_t *device = &target->device_transform;
+    cairo_bool_t is_translation;
+    int num_threads, num_tiles, tx, ty;
+
+    if (type != CAIRO_RECORDING_REPLAY || region != CAIRO_RECORDING_REGION_ALL)
+	return 1;
+
+    if (target_clip != NULL || ! _cairo_surface_is_image (target))
+	return 1;
+
+    if (device->xy != 0. || device->yx != 0.)
+	return 1;
+
+    if (image->height < 2 * TILE_MIN_HEIGHT ||
+	surface->commands.num_elements < TILE_MIN_COMMANDS)
+	return 1;
+
+    num_threads = _cairo_thread_pool_get_num_threads ();
+    if (num_threads <= 1)
+	return 1;
+
+    /* the gradients are checked as recorded, so the replay must not
+     * transform them other than by whole pixels */
+    is_translation = _cairo_matrix_is_integer_translation (device, &tx, &ty) &&
+	(surface_transform == NULL ||
+	 _cairo_matrix_is_integer_translation (surface_transform, &tx, &ty));
+
+    if (! _cairo_recording_surface_can_replay_tiled (surface, is_translation))
+	return 1;
+
+    /* oversubscribe a little to even out the load between tiles */
+    num_tiles = 2 * num_threads;
+    if (num_tiles > image->height / TILE_MIN_HEIGHT)
+	num_tiles = image->height / TILE_MIN_HEIGHT;
+
+    return num_tiles;
+}
+
+static void
+_cairo_recording_surface_replay_tile (void *closure)
+{
+    cairo_recording_tile_t *tile = closure;
+
+    tile->status =
+	_cairo_recording_surface_replay_commands (tile->surface,
+						  tile->surface_extents,
+						  tile->surface_transform,
+						  tile->target, NULL,
+						  tile->indices,
+						  CAIRO_RECORDING_REPLAY,
+						  CAIRO_RECORDING_REGION_ALL);
+}
+
+static cairo_int_status_t
+_cairo_recording_surface_replay_tiled (cairo_recording_surface_t *surface,
+				       const cairo_rectangle_int_t *surface_extents,
+				       const cairo_matrix_t *surface_transform,
+				       cairo_surface_t *target,
+				       int num_tiles)
+{
+    cairo_image_surface_t *image = (cairo_image_surface_t *) target;
+    const cairo_matrix_t *device = &target->device_transform;
+    cairo_recording_tile_t *tiles;
+    unsigned int *indices, num_elements;
+    cairo_int_status_t status;
+    cairo_bool_t is_clear;
+    int y, height, i;
+
+    num_elements = surface->commands.num_elements;
+    tiles = _cairo_malloc_ab_plus_c (num_tiles,
+				     sizeof (cairo_recording_tile_t) +
+				     num_elements * sizeof (unsigned int),
+				     0);
+    if (unlikely (tiles == NULL))
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    indices = (unsigned int *) (tiles + num_tiles);
+
+    /* The tiles only read the bbtree, so bring it up to date first */
+    status = _cairo_recording_surface_update_bbtree (surface);
+    if (unlikely (status))
+	goto cleanup;
+
+    status = _cairo_surface_begin_modification (target);
+    if (unlikely (status))
+	goto cleanup;
+
+    y = 0;
+    for (i = 0; i < num_tiles; i++) {
+	cairo_recording_tile_t *tile = &tiles[i];
+	cairo_surface_t *view;
+
+	height = (image->height - y) / (num_tiles - i);
+
+	view = _cairo_image_surface_create_with_pixman_format (image->data + y * image->stride,
+								image->pixman_format,
+								image->width,
+								height,
+								image->stride);
+	if (unlikely (view->status)) {
+	    status = view->status;
+	    num_tiles = i;
+	    goto cleanup_tiles;
+	}
+
+	view->content = target->content;
+	view->is_clear = target->is_clear;
+	cairo_surface_set_device_scale (view, device->xx, device->yy);
+	cairo_surface_set_device_offset (view, device->x0, device->y0 - y);
+
+	tile->surface = surface;
+	tile->surface_extents = surface_extents;
+	tile->surface_transform = surface_transform;
+	tile->target = view;
+	tile->indices = indices + i * num_elements;
+	tile->status = CAIRO_INT_STATUS_SUCCESS;
+
+	y += height;
+    }
+
+    _cairo_thread_pool_run (_cairo_recording_surface_replay_tile, tiles,
+			    sizeof (cairo_recording_tile_t), num_tiles);
+
+cleanup_tiles:
+    is_clear = target->is_clear;
+    for (i = 0; i < num_tiles; i++) {
+	if (status == CAIRO_INT_STATUS_SUCCESS)
+	    status = tiles[i].status;
+	is_clear &= tiles[i].target->is_clear;
+	cairo_surface_destroy (tiles[i].target);
+    }
+    target->is_clear = is_clear;
+
+cleanup:
+    free (tiles);
+    return status;
+}
+
+static cairo_status_t
+_cairo_recording_surface_replay_internal (cairo_recording_surface_t	*surface,
+					  const cairo_rectangle_int_t *surface_extents,
+					  const cairo_matrix_t *surface_transform,
+					  cairo_surface_t	     *target,
+					  const cairo_clip_t *target_clip,
+					  cairo_recording_replay_type_t type,
+					  cairo_recording_region_type_t region)
+{
+    cairo_int_status_t status;
+    int num_tiles;
+
+    if (unlikely (surface->base.status))
+	return surface->base.status;
+
+    if (unlikely (target->status))
+	return target->status;
+
+    if (unlikely (surface->base.finished))
+	return _cairo_error (CAIRO_STATUS_SURFACE_FINISHED);
+
+    if (surface->base.is_clear)
+	return CAIRO_STATUS_SUCCESS;
+
+    assert (_cairo_surface_is_recording (&surface->base));
+
+    /* Serialized commands can be streamed straight to the target, but
+     * they need to be decoded to be marked up with their regions. */
+    if (type == CAIRO_RECORDING_CREATE_REGIONS) {
+	status = _cairo_recording_surface_load (surface);
+	if (unlikely (status))
+	    return _cairo_surface_set_error (&surface->base, status);
+    }
+
+    surface->has_bilevel_alpha = TRUE;
+    surface->has_only_op_over = TRUE;
+
+    num_tiles = _cairo_recording_surface_num_tiles (surface, surface_transform,
+						    target, target_clip,
+						    type, region);
+    if (num_tiles > 1) {
+	status = _cairo_recording_surface_replay_tiled (surface,
+							surface_extents,
+							surface_transform,
+							target,
+							num_tiles);
+    } else {
+	status = _cairo_recording_surface_replay_commands (surface,
+							   surface_extents,
+							   surface_transform,
+							   target, target_clip,
+							   NULL, type, region);
+    }
+
     return _cairo_surface_set_error (&surface->base, status);
 }
 
@@ -1912,6 +2490,10 @@ _cairo_recording_surface_replay_one (cairo_recording_surface_t	*surface,
 
     assert (_cairo_surface_is_recording (&surface->base));
 
+    status = _cairo_recording_surface_load (surface);
+    if (unlikely (status))
+	return status;
+
     /* XXX
      * Use a surface wrapper because we may want to do transformed
      * replay in the future.
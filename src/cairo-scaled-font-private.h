@@ -70,7 +70,10 @@ struct _cairo_scaled_font {
      *    Modifications to the reference count are protected by the
      *    _cairo_scaled_font_map_mutex. This is because the reference
      *    count of a scaled font is intimately related with the font
-     *    map itself, (and the magic holdovers array).
+     *    map itself, (and the magic holdovers list). The one exception
+     *    is cairo_scaled_font_create() taking an additional reference
+     *    on a font that is already referenced, which it does under the
+     *    shared read lock of the font map.
      *
      * 2. The cache of glyphs (scaled_font->glyphs)
      * 3. The backend private data (scaled_font->surface_backend,
@@ -98,6 +101,7 @@ struct _cairo_scaled_font {
     unsigned int placeholder : 1; /*  protected by fontmap mutex */
     unsigned int holdover : 1;
     unsigned int finished : 1;
+    cairo_list_t holdover_link;   /*  protected by fontmap mutex */
 
     /* "live" scaled_font members */
     cairo_matrix_t scale;	     /* font space => device space */
@@ -113,6 +117,7 @@ struct _cairo_scaled_font {
     cairo_list_t glyph_pages;
     cairo_bool_t cache_frozen;
     cairo_bool_t global_cache_frozen;
+    unsigned int glyph_cache_hits; /* not yet added to the global count */
 
     cairo_list_t dev_privates;
 
@@ -141,6 +146,8 @@ struct _cairo_scaled_glyph {
     cairo_image_surface_t   *surface;		/* device-space image */
     cairo_path_fixed_t	    *path;		/* device-space outline */
     cairo_surface_t         *recording_surface;	/* device-space recording-surface */
+    cairo_scaled_glyph_page_t *page;		/* owning page in the glyph cache */
+    cairo_atomic_int_t	    image_shards;	/* image glyph caches holding it */
 
     const void		   *dev_private_key;
     void		   *dev_private;
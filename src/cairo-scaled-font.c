@@ -76,15 +76,48 @@ _cairo_scaled_font_compute_hash (cairo_scaled_font_t *scaled_font);
  * The glyphs are allocated in pages, which are capped in the global pool.
  * Using pages means we can reduce the frequency at which we have to probe the
  * global pool and ameliorates the memory allocation pressure.
+ *
+ * The pool is capped by the number of bytes held by the pages and their
+ * glyphs (see cairo_glyph_cache_set_max_size()). Pages are expired in
+ * approximately least-recently-used order: a lookup hit only marks the
+ * page as referenced (so that it does not need the global lock), and
+ * eviction gives referenced pages a second chance by moving them to the
+ * back of the queue.
  */
 
-/* XXX: This number is arbitrary---we've never done any measurement of this. */
-#define MAX_GLYPH_PAGES_CACHED 512
-static cairo_cache_t cairo_scaled_glyph_page_cache;
+#define CAIRO_GLYPH_CACHE_DEFAULT_MAX_SIZE (16 * 1024 * 1024)
+
+/* Lookup hits are counted per font and folded into the global
+ * statistics once this many have accumulated. */
+#define CAIRO_GLYPH_CACHE_HITS_FLUSH 256
+
+typedef struct _cairo_scaled_glyph_page_cache {
+    cairo_list_t pages; /* least-recently-used first */
+    int num_pages;
+    int freeze_count;
+
+    unsigned long size;
+    unsigned long max_size;
+
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long evictions;
+} cairo_scaled_glyph_page_cache_t;
+
+static cairo_scaled_glyph_page_cache_t cairo_scaled_glyph_page_cache = {
+    { &cairo_scaled_glyph_page_cache.pages, &cairo_scaled_glyph_page_cache.pages },
+    0, 0,
+    0, CAIRO_GLYPH_CACHE_DEFAULT_MAX_SIZE,
+    0, 0, 0
+};
 
 #define CAIRO_SCALED_GLYPH_PAGE_SIZE 32
 struct _cairo_scaled_glyph_page {
-    cairo_cache_entry_t cache_entry;
+    cairo_scaled_font_t *scaled_font;
+
+    cairo_list_t lru;	/* protected by the page cache mutex */
+    unsigned long size;	/* protected by the page cache mutex */
+    cairo_atomic_int_t referenced; /* set without the page cache mutex */
 
     cairo_list_t link;
 
@@ -243,6 +276,7 @@ static const cairo_scaled_font_t _cairo_scaled_font_nil = {
     FALSE,			/* placeholder */
     FALSE,			/* holdover */
     TRUE,			/* finished */
+    { NULL, NULL },		/* holdover_link */
     { 1., 0., 0., 1., 0, 0},	/* scale */
     { 1., 0., 0., 1., 0, 0},	/* scale_inverse */
     1.,				/* max_scale */
@@ -253,6 +287,7 @@ static const cairo_scaled_font_t _cairo_scaled_font_nil = {
     { NULL, NULL },		/* pages */
     FALSE,			/* cache_frozen */
     FALSE,			/* global_cache_frozen */
+    0,				/* glyph_cache_hits */
     { NULL, NULL },		/* privates */
     NULL			/* backend */
 };
@@ -339,36 +374,85 @@ slim_hidden_def (cairo_scaled_font_status);
  *  b) Some number of not otherwise referenced #cairo_scaled_font_t's
  *
  * The implementation uses a hash table which covers (a)
- * completely. Then, for (b) we have an array of otherwise
+ * completely. Then, for (b) we have a list of otherwise
  * unreferenced fonts (holdovers) which are expired in
  * least-recently-used order.
  *
  * The cairo_scaled_font_create() code gets to treat this like a regular
  * hash table. All of the magic for the little holdover cache is in
  * cairo_scaled_font_reference() and cairo_scaled_font_destroy().
+ *
+ * Looking up a font that is still referenced elsewhere does not modify
+ * the map, so on platforms with pthreads such lookups only take a
+ * shared read lock and may proceed in parallel.  Everything that does
+ * modify the map (or resurrects a font with no references) takes the
+ * write lock, which also holds _cairo_scaled_font_map_mutex.
  */
 
-/* This defines the size of the holdover array ... that is, the number
- * of scaled fonts we keep around even when not otherwise referenced
+/* This defines the default size of the holdover list ... that is, the
+ * number of scaled fonts we keep around even when not otherwise
+ * referenced.  It can be overridden with CAIRO_SCALED_FONT_HOLDOVERS.
  */
 #define CAIRO_SCALED_FONT_MAX_HOLDOVERS 256
 
 typedef struct _cairo_scaled_font_map {
     cairo_scaled_font_t *mru_scaled_font;
     cairo_hash_table_t *hash_table;
-    cairo_scaled_font_t *holdovers[CAIRO_SCALED_FONT_MAX_HOLDOVERS];
+    cairo_list_t holdovers; /* least-recently-used first */
     int num_holdovers;
+    int max_holdovers;
 } cairo_scaled_font_map_t;
 
+#if CAIRO_MUTEX_IMPL_PTHREAD
+#include <pthread.h>
+
+static pthread_rwlock_t _cairo_scaled_font_map_rwlock = PTHREAD_RWLOCK_INITIALIZER;
+
+#define FONT_MAP_READ_LOCK() \
+    pthread_rwlock_rdlock (&_cairo_scaled_font_map_rwlock)
+#define FONT_MAP_READ_UNLOCK() \
+    pthread_rwlock_unlock (&_cairo_scaled_font_map_rwlock)
+#define FONT_MAP_WRITE_LOCK() do { \
+    CAIRO_MUTEX_LOCK (_cairo_scaled_font_map_mutex); \
+    pthread_rwlock_wrlock (&_cairo_scaled_font_map_rwlock); \
+} while (0)
+#define FONT_MAP_WRITE_UNLOCK() do { \
+    pthread_rwlock_unlock (&_cairo_scaled_font_map_rwlock); \
+    CAIRO_MUTEX_UNLOCK (_cairo_scaled_font_map_mutex); \
+} while (0)
+#else
+#define FONT_MAP_READ_LOCK() CAIRO_MUTEX_LOCK (_cairo_scaled_font_map_mutex)
+#define FONT_MAP_READ_UNLOCK() CAIRO_MUTEX_UNLOCK (_cairo_scaled_font_map_mutex)
+#define FONT_MAP_WRITE_LOCK() CAIRO_MUTEX_LOCK (_cairo_scaled_font_map_mutex)
+#define FONT_MAP_WRITE_UNLOCK() CAIRO_MUTEX_UNLOCK (_cairo_scaled_font_map_mutex)
+#endif
+
 static cairo_scaled_font_map_t *cairo_scaled_font_map;
 
 static int
 _cairo_scaled_font_keys_equal (const void *abstract_key_a, const void *abstract_key_b);
 
+static int
+_cairo_scaled_font_map_max_holdovers (void)
+{
+    const char *env;
+    long n;
+
+    env = getenv ("CAIRO_SCALED_FONT_HOLDOVERS");
+    if (env == NULL || *env == '\0')
+	return CAIRO_SCALED_FONT_MAX_HOLDOVERS;
+
+    n = strtol (env, NULL, 10);
+    if (n < 0)
+	return CAIRO_SCALED_FONT_MAX_HOLDOVERS;
+
+    return MIN (n, 1 << 20);
+}
+
 static cairo_scaled_font_map_t *
 _cairo_scaled_font_map_lock (void)
 {
-    CAIRO_MUTEX_LOCK (_cairo_scaled_font_map_mutex);
+    FONT_MAP_WRITE_LOCK ();
 
     if (cairo_scaled_font_map == NULL) {
 	cairo_scaled_font_map = malloc (sizeof (cairo_scaled_font_map_t));
@@ -382,7 +466,10 @@ _cairo_scaled_font_map_lock (void)
 	if (unlikely (cairo_scaled_font_map->hash_table == NULL))
 	    goto CLEANUP_SCALED_FONT_MAP;
 
+	cairo_list_init (&cairo_scaled_font_map->holdovers);
 	cairo_scaled_font_map->num_holdovers = 0;
+	cairo_scaled_font_map->max_holdovers =
+	    _cairo_scaled_font_map_max_holdovers ();
     }
 
     return cairo_scaled_font_map;
@@ -391,7 +478,7 @@ _cairo_scaled_font_map_lock (void)
     free (cairo_scaled_font_map);
     cairo_scaled_font_map = NULL;
  CLEANUP_MUTEX_LOCK:
-    CAIRO_MUTEX_UNLOCK (_cairo_scaled_font_map_mutex);
+    FONT_MAP_WRITE_UNLOCK ();
     _cairo_error_throw (CAIRO_STATUS_NO_MEMORY);
     return NULL;
 }
@@ -399,7 +486,7 @@ _cairo_scaled_font_map_lock (void)
 static void
 _cairo_scaled_font_map_unlock (void)
 {
-   CAIRO_MUTEX_UNLOCK (_cairo_scaled_font_map_mutex);
+   FONT_MAP_WRITE_UNLOCK ();
 }
 
 void
@@ -408,7 +495,7 @@ _cairo_scaled_font_map_destroy (void)
     cairo_scaled_font_map_t *font_map;
     cairo_scaled_font_t *scaled_font;
 
-    CAIRO_MUTEX_LOCK (_cairo_scaled_font_map_mutex);
+    FONT_MAP_WRITE_LOCK ();
 
     font_map = cairo_scaled_font_map;
     if (unlikely (font_map == NULL)) {
@@ -417,19 +504,23 @@ _cairo_scaled_font_map_destroy (void)
 
     scaled_font = font_map->mru_scaled_font;
     if (scaled_font != NULL) {
-	CAIRO_MUTEX_UNLOCK (_cairo_scaled_font_map_mutex);
+	FONT_MAP_WRITE_UNLOCK ();
 	cairo_scaled_font_destroy (scaled_font);
-	CAIRO_MUTEX_LOCK (_cairo_scaled_font_map_mutex);
+	FONT_MAP_WRITE_LOCK ();
     }
 
-    /* remove scaled_fonts starting from the end so that font_map->holdovers
-     * is always in a consistent state when we release the mutex. */
-    while (font_map->num_holdovers) {
-	scaled_font = font_map->holdovers[font_map->num_holdovers-1];
+    /* unlink each scaled_font before finishing it so that
+     * font_map->holdovers is always in a consistent state when we
+     * release the mutex. */
+    while (! cairo_list_is_empty (&font_map->holdovers)) {
+	scaled_font = cairo_list_last_entry (&font_map->holdovers,
+					     cairo_scaled_font_t,
+					     holdover_link);
 	assert (! CAIRO_REFERENCE_COUNT_HAS_REFERENCE (&scaled_font->ref_count));
 	_cairo_hash_table_remove (font_map->hash_table,
 				  &scaled_font->hash_entry);
 
+	cairo_list_del (&scaled_font->holdover_link);
 	font_map->num_holdovers--;
 
 	/* This releases the font_map lock to avoid the possibility of a
@@ -447,7 +538,7 @@ _cairo_scaled_font_map_destroy (void)
     cairo_scaled_font_map = NULL;
 
  CLEANUP_MUTEX_LOCK:
-    CAIRO_MUTEX_UNLOCK (_cairo_scaled_font_map_mutex);
+    FONT_MAP_WRITE_UNLOCK ();
 }
 
 static void
@@ -462,6 +553,9 @@ _cairo_scaled_glyph_page_destroy (cairo_scaled_font_t *scaled_font,
     for (n = 0; n < page->num_glyphs; n++) {
 	_cairo_hash_table_remove (scaled_font->glyphs,
 				  &page->glyphs[n].hash_entry);
+	/* The page is no longer accounted, and the page cache mutex may
+	 * be held, so stop the glyph reporting size changes. */
+	page->glyphs[n].page = NULL;
 	_cairo_scaled_glyph_fini (scaled_font, &page->glyphs[n]);
     }
 
@@ -469,6 +563,68 @@ _cairo_scaled_glyph_page_destroy (cairo_scaled_font_t *scaled_font,
     free (page);
 }
 
+static void
+_cairo_scaled_glyph_page_cache_thaw (void);
+
+/* The number of bytes held by the glyph in addition to its slot in the
+ * page.  Recording surfaces are charged by the area of the glyph. */
+static unsigned long
+_cairo_scaled_glyph_size (const cairo_scaled_glyph_t *scaled_glyph)
+{
+    unsigned long size = 0;
+
+    if (scaled_glyph->surface != NULL) {
+	size += sizeof (cairo_image_surface_t);
+	size += (unsigned long) scaled_glyph->surface->stride *
+		scaled_glyph->surface->height;
+    }
+
+    if (scaled_glyph->path != NULL) {
+	size += sizeof (cairo_path_fixed_t);
+	size += _cairo_path_fixed_size (scaled_glyph->path);
+    }
+
+    if (scaled_glyph->recording_surface != NULL) {
+	const cairo_box_t *b = &scaled_glyph->bbox;
+
+	size += 4 * (unsigned long)
+	    (_cairo_fixed_integer_ceil (b->p2.x) - _cairo_fixed_integer_floor (b->p1.x)) *
+	    (_cairo_fixed_integer_ceil (b->p2.y) - _cairo_fixed_integer_floor (b->p1.y));
+    }
+
+    return size;
+}
+
+/* Charge the change in a glyph's size, from @old_size, to its page. */
+static void
+_cairo_scaled_glyph_page_resize (cairo_scaled_glyph_t *scaled_glyph,
+				 unsigned long old_size)
+{
+    unsigned long new_size = _cairo_scaled_glyph_size (scaled_glyph);
+
+    if (new_size == old_size || scaled_glyph->page == NULL)
+	return;
+
+    CAIRO_MUTEX_LOCK (_cairo_scaled_glyph_page_cache_mutex);
+    scaled_glyph->page->size += new_size - old_size;
+    if (! cairo_list_is_empty (&scaled_glyph->page->lru))
+	cairo_scaled_glyph_page_cache.size += new_size - old_size;
+    CAIRO_MUTEX_UNLOCK (_cairo_scaled_glyph_page_cache_mutex);
+}
+
+/* Remove the page from the global cache; the caller holds the page cache
+ * mutex and remains responsible for destroying the page. */
+static void
+_cairo_scaled_glyph_page_cache_unlink (cairo_scaled_glyph_page_t *page)
+{
+    if (cairo_list_is_empty (&page->lru))
+	return;
+
+    cairo_scaled_glyph_page_cache.size -= page->size;
+    cairo_scaled_glyph_page_cache.num_pages--;
+    cairo_list_del (&page->lru);
+}
+
 static void
 _cairo_scaled_glyph_page_pluck (void *closure)
 {
@@ -477,7 +633,7 @@ _cairo_scaled_glyph_page_pluck (void *closure)
 
     assert (! cairo_list_is_empty (&page->link));
 
-    scaled_font = (cairo_scaled_font_t *) page->cache_entry.hash;
+    scaled_font = page->scaled_font;
 
     CAIRO_MUTEX_LOCK (scaled_font->mutex);
     _cairo_scaled_glyph_page_destroy (scaled_font, page);
@@ -535,7 +691,7 @@ _cairo_scaled_font_register_placeholder_and_unlock_font_map (cairo_scaled_font_t
     if (unlikely (status))
 	goto FINI_PLACEHOLDER;
 
-    CAIRO_MUTEX_UNLOCK (_cairo_scaled_font_map_mutex);
+    FONT_MAP_WRITE_UNLOCK ();
     CAIRO_MUTEX_LOCK (placeholder_scaled_font->mutex);
 
     return CAIRO_STATUS_SUCCESS;
@@ -553,7 +709,7 @@ _cairo_scaled_font_unregister_placeholder_and_lock_font_map (cairo_scaled_font_t
 {
     cairo_scaled_font_t *placeholder_scaled_font;
 
-    CAIRO_MUTEX_LOCK (_cairo_scaled_font_map_mutex);
+    FONT_MAP_WRITE_LOCK ();
 
     /* temporary hash value to match the placeholder */
     scaled_font->hash_entry.hash
@@ -568,12 +724,12 @@ _cairo_scaled_font_unregister_placeholder_and_lock_font_map (cairo_scaled_font_t
     _cairo_hash_table_remove (cairo_scaled_font_map->hash_table,
 			      &placeholder_scaled_font->hash_entry);
 
-    CAIRO_MUTEX_UNLOCK (_cairo_scaled_font_map_mutex);
+    FONT_MAP_WRITE_UNLOCK ();
 
     CAIRO_MUTEX_UNLOCK (placeholder_scaled_font->mutex);
     cairo_scaled_font_destroy (placeholder_scaled_font);
 
-    CAIRO_MUTEX_LOCK (_cairo_scaled_font_map_mutex);
+    FONT_MAP_WRITE_LOCK ();
 }
 
 static void
@@ -583,7 +739,7 @@ _cairo_scaled_font_placeholder_wait_for_creation_to_finish (cairo_scaled_font_t
     cairo_scaled_font_reference (placeholder_scaled_font);
 
     /* now unlock the fontmap mutex so creation has a chance to finish */
-    CAIRO_MUTEX_UNLOCK (_cairo_scaled_font_map_mutex);
+    FONT_MAP_WRITE_UNLOCK ();
 
     /* wait on placeholder mutex until we are awaken */
     CAIRO_MUTEX_LOCK (placeholder_scaled_font->mutex);
@@ -592,7 +748,7 @@ _cairo_scaled_font_placeholder_wait_for_creation_to_finish (cairo_scaled_font_t
     CAIRO_MUTEX_UNLOCK (placeholder_scaled_font->mutex);
     cairo_scaled_font_destroy (placeholder_scaled_font);
 
-    CAIRO_MUTEX_LOCK (_cairo_scaled_font_map_mutex);
+    FONT_MAP_WRITE_LOCK ();
 }
 
 /* Fowler / Noll / Vo (FNV) Hash (http://www.isthe.com/chongo/tech/comp/fnv/)
@@ -768,8 +924,10 @@ _cairo_scaled_font_init (cairo_scaled_font_t               *scaled_font,
     cairo_list_init (&scaled_font->glyph_pages);
     scaled_font->cache_frozen = FALSE;
     scaled_font->global_cache_frozen = FALSE;
+    scaled_font->glyph_cache_hits = 0;
 
     scaled_font->holdover = FALSE;
+    cairo_list_init (&scaled_font->holdover_link);
     scaled_font->finished = FALSE;
 
     CAIRO_REFERENCE_COUNT_INIT (&scaled_font->ref_count, 1);
@@ -804,9 +962,14 @@ _cairo_scaled_font_thaw_cache (cairo_scaled_font_t *scaled_font)
 {
     assert (scaled_font->cache_frozen);
 
-    if (scaled_font->global_cache_frozen) {
+    if (scaled_font->global_cache_frozen ||
+	scaled_font->glyph_cache_hits >= CAIRO_GLYPH_CACHE_HITS_FLUSH)
+    {
 	CAIRO_MUTEX_LOCK (_cairo_scaled_glyph_page_cache_mutex);
-	_cairo_cache_thaw (&cairo_scaled_glyph_page_cache);
+	cairo_scaled_glyph_page_cache.hits += scaled_font->glyph_cache_hits;
+	scaled_font->glyph_cache_hits = 0;
+	if (scaled_font->global_cache_frozen)
+	    _cairo_scaled_glyph_page_cache_thaw ();
 	CAIRO_MUTEX_UNLOCK (_cairo_scaled_glyph_page_cache_mutex);
 	scaled_font->global_cache_frozen = FALSE;
     }
@@ -829,11 +992,12 @@ _cairo_scaled_font_reset_cache (cairo_scaled_font_t *scaled_font)
 			      cairo_scaled_glyph_page_t,
 			      &scaled_font->glyph_pages,
 			      link) {
-	cairo_scaled_glyph_page_cache.size -= page->cache_entry.size;
-	_cairo_hash_table_remove (cairo_scaled_glyph_page_cache.hash_table,
-				  (cairo_hash_entry_t *) &page->cache_entry);
+	_cairo_scaled_glyph_page_cache_unlink (page);
     }
 
+    cairo_scaled_glyph_page_cache.hits += scaled_font->glyph_cache_hits;
+    scaled_font->glyph_cache_hits = 0;
+
     CAIRO_MUTEX_UNLOCK (_cairo_scaled_glyph_page_cache_mutex);
 
     /* Destroy scaled_font's pages while holding its lock only, and not the
@@ -913,9 +1077,9 @@ _cairo_scaled_font_fini (cairo_scaled_font_t *scaled_font)
 {
     /* Release the lock to avoid the possibility of a recursive
      * deadlock when the scaled font destroy closure gets called. */
-    CAIRO_MUTEX_UNLOCK (_cairo_scaled_font_map_mutex);
+    FONT_MAP_WRITE_UNLOCK ();
     _cairo_scaled_font_fini_internal (scaled_font);
-    CAIRO_MUTEX_LOCK (_cairo_scaled_font_map_mutex);
+    FONT_MAP_WRITE_LOCK ();
 }
 
 void
@@ -981,6 +1145,70 @@ _cairo_scaled_glyph_find_private (cairo_scaled_glyph_t *scaled_glyph,
     return NULL;
 }
 
+/* Take a reference on @scaled_font, but only if it already has one:
+ * resurrecting an unreferenced font (which may be sitting in the
+ * holdovers list) must be done under the write lock.
+ */
+static cairo_bool_t
+_cairo_scaled_font_reference_if_live (cairo_scaled_font_t *scaled_font)
+{
+    cairo_atomic_int_t old;
+
+    do {
+	old = CAIRO_REFERENCE_COUNT_GET_VALUE (&scaled_font->ref_count);
+	if (old <= 0)
+	    return FALSE;
+    } while (! _cairo_atomic_int_cmpxchg (&scaled_font->ref_count.ref_count,
+					  old, old + 1));
+
+    return TRUE;
+}
+
+/* The fast path of cairo_scaled_font_create(): find a font that is
+ * currently referenced elsewhere while holding only the read lock.
+ * Anything else (a miss, a holdover, a placeholder or a font in an
+ * error state) is left to the full path under the write lock.
+ */
+static cairo_scaled_font_t *
+_cairo_scaled_font_map_lookup_shared (cairo_font_face_t          *font_face,
+				      const cairo_matrix_t       *font_matrix,
+				      const cairo_matrix_t       *ctm,
+				      const cairo_font_options_t *options)
+{
+    cairo_scaled_font_map_t *font_map;
+    cairo_scaled_font_t key, *scaled_font;
+
+    FONT_MAP_READ_LOCK ();
+
+    font_map = cairo_scaled_font_map;
+    if (unlikely (font_map == NULL)) {
+	FONT_MAP_READ_UNLOCK ();
+	return NULL;
+    }
+
+    scaled_font = font_map->mru_scaled_font;
+    if (scaled_font == NULL ||
+	! _cairo_scaled_font_matches (scaled_font,
+				      font_face, font_matrix, ctm, options))
+    {
+	_cairo_scaled_font_init_key (&key, font_face, font_matrix, ctm, options);
+	scaled_font = _cairo_hash_table_lookup_shared (font_map->hash_table,
+						       &key.hash_entry);
+    }
+
+    if (scaled_font != NULL &&
+	(scaled_font->placeholder ||
+	 scaled_font->status != CAIRO_STATUS_SUCCESS ||
+	 ! _cairo_scaled_font_reference_if_live (scaled_font)))
+    {
+	scaled_font = NULL;
+    }
+
+    FONT_MAP_READ_UNLOCK ();
+
+    return scaled_font;
+}
+
 /**
  * cairo_scaled_font_create:
  * @font_face: a #cairo_font_face_t
@@ -1034,6 +1262,13 @@ cairo_scaled_font_create (cairo_font_face_t          *font_face,
     /* Note that degenerate ctm or font_matrix *are* allowed.
      * We want to support a font size of 0. */
 
+    scaled_font = _cairo_scaled_font_map_lookup_shared (font_face,
+							font_matrix,
+							ctm,
+							options);
+    if (scaled_font != NULL)
+	return scaled_font;
+
     font_map = _cairo_scaled_font_map_lock ();
     if (unlikely (font_map == NULL))
 	return _cairo_scaled_font_create_in_error (_cairo_error (CAIRO_STATUS_NO_MEMORY));
@@ -1085,18 +1320,8 @@ cairo_scaled_font_create (cairo_font_face_t          *font_face,
 	 */
 	if (! CAIRO_REFERENCE_COUNT_HAS_REFERENCE (&scaled_font->ref_count)) {
 	    if (scaled_font->holdover) {
-		int i;
-
-		for (i = 0; i < font_map->num_holdovers; i++) {
-		    if (font_map->holdovers[i] == scaled_font) {
-			font_map->num_holdovers--;
-			memmove (&font_map->holdovers[i],
-				 &font_map->holdovers[i+1],
-				 (font_map->num_holdovers - i) * sizeof (cairo_scaled_font_t*));
-			break;
-		    }
-		}
-
+		cairo_list_del (&scaled_font->holdover_link);
+		font_map->num_holdovers--;
 		scaled_font->holdover = FALSE;
 	    }
 
@@ -1261,10 +1486,19 @@ _cairo_scaled_font_reset_static_data (void)
     CAIRO_MUTEX_UNLOCK (_cairo_scaled_font_error_mutex);
 
     CAIRO_MUTEX_LOCK (_cairo_scaled_glyph_page_cache_mutex);
-    if (cairo_scaled_glyph_page_cache.hash_table != NULL) {
-	_cairo_cache_fini (&cairo_scaled_glyph_page_cache);
-	cairo_scaled_glyph_page_cache.hash_table = NULL;
-    }
+    while (! cairo_list_is_empty (&cairo_scaled_glyph_page_cache.pages)) {
+	cairo_scaled_glyph_page_t *page;
+
+	page = cairo_list_first_entry (&cairo_scaled_glyph_page_cache.pages,
+				       cairo_scaled_glyph_page_t,
+				       lru);
+	_cairo_scaled_glyph_page_cache_unlink (page);
+	_cairo_scaled_glyph_page_pluck (page);
+    }
+    assert (cairo_scaled_glyph_page_cache.size == 0);
+    cairo_scaled_glyph_page_cache.hits = 0;
+    cairo_scaled_glyph_page_cache.misses = 0;
+    cairo_scaled_glyph_page_cache.evictions = 0;
     CAIRO_MUTEX_UNLOCK (_cairo_scaled_glyph_page_cache_mutex);
 }
 
@@ -1342,26 +1576,35 @@ cairo_scaled_font_destroy (cairo_scaled_font_t *scaled_font)
 		goto unlock;
 
 	    /* Rather than immediately destroying this object, we put it into
-	     * the font_map->holdovers array in case it will get used again
+	     * the font_map->holdovers list in case it will get used again
 	     * soon (and is why we must hold the lock over the atomic op on
 	     * the reference count). To make room for it, we do actually
 	     * destroy the least-recently-used holdover.
 	     */
 
-	    if (font_map->num_holdovers == CAIRO_SCALED_FONT_MAX_HOLDOVERS) {
-		lru = font_map->holdovers[0];
+	    if (font_map->max_holdovers == 0) {
+		_cairo_hash_table_remove (font_map->hash_table,
+					  &scaled_font->hash_entry);
+		lru = scaled_font;
+		goto unlock;
+	    }
+
+	    if (font_map->num_holdovers == font_map->max_holdovers) {
+		lru = cairo_list_first_entry (&font_map->holdovers,
+					      cairo_scaled_font_t,
+					      holdover_link);
 		assert (! CAIRO_REFERENCE_COUNT_HAS_REFERENCE (&lru->ref_count));
 
 		_cairo_hash_table_remove (font_map->hash_table,
 					  &lru->hash_entry);
 
+		cairo_list_del (&lru->holdover_link);
 		font_map->num_holdovers--;
-		memmove (&font_map->holdovers[0],
-			 &font_map->holdovers[1],
-			 font_map->num_holdovers * sizeof (cairo_scaled_font_t*));
 	    }
 
-	    font_map->holdovers[font_map->num_holdovers++] = scaled_font;
+	    cairo_list_add_tail (&scaled_font->holdover_link,
+				 &font_map->holdovers);
+	    font_map->num_holdovers++;
 	    scaled_font->holdover = TRUE;
 	} else
 	    lru = scaled_font;
@@ -1370,7 +1613,7 @@ cairo_scaled_font_destroy (cairo_scaled_font_t *scaled_font)
   unlock:
     _cairo_scaled_font_map_unlock ();
 
-    /* If we pulled an item from the holdovers array, (while the font
+    /* If we pulled an item from the holdovers list, (while the font
      * map lock was held, of course), then there is no way that anyone
      * else could have acquired a reference to it. So we can now
      * safely call fini on it without any lock held. This is desirable
@@ -2783,12 +3026,15 @@ _cairo_scaled_glyph_set_surface (cairo_scaled_glyph_t *scaled_glyph,
 				 cairo_scaled_font_t *scaled_font,
 				 cairo_image_surface_t *surface)
 {
+    unsigned long size = _cairo_scaled_glyph_size (scaled_glyph);
+
     if (scaled_glyph->surface != NULL)
 	cairo_surface_destroy (&scaled_glyph->surface->base);
 
     /* sanity check the backend glyph contents */
     _cairo_debug_check_image_surface_is_defined (&surface->base);
     scaled_glyph->surface = surface;
+    _cairo_scaled_glyph_page_resize (scaled_glyph, size);
 
     if (surface != NULL)
 	scaled_glyph->has_info |= CAIRO_SCALED_GLYPH_INFO_SURFACE;
@@ -2801,10 +3047,13 @@ _cairo_scaled_glyph_set_path (cairo_scaled_glyph_t *scaled_glyph,
 			      cairo_scaled_font_t *scaled_font,
 			      cairo_path_fixed_t *path)
 {
+    unsigned long size = _cairo_scaled_glyph_size (scaled_glyph);
+
     if (scaled_glyph->path != NULL)
 	_cairo_path_fixed_destroy (scaled_glyph->path);
 
     scaled_glyph->path = path;
+    _cairo_scaled_glyph_page_resize (scaled_glyph, size);
 
     if (path != NULL)
 	scaled_glyph->has_info |= CAIRO_SCALED_GLYPH_INFO_PATH;
@@ -2817,12 +3066,15 @@ _cairo_scaled_glyph_set_recording_surface (cairo_scaled_glyph_t *scaled_glyph,
 					   cairo_scaled_font_t *scaled_font,
 					   cairo_surface_t *recording_surface)
 {
+    unsigned long size = _cairo_scaled_glyph_size (scaled_glyph);
+
     if (scaled_glyph->recording_surface != NULL) {
 	cairo_surface_finish (scaled_glyph->recording_surface);
 	cairo_surface_destroy (scaled_glyph->recording_surface);
     }
 
     scaled_glyph->recording_surface = recording_surface;
+    _cairo_scaled_glyph_page_resize (scaled_glyph, size);
 
     if (recording_surface != NULL)
 	scaled_glyph->has_info |= CAIRO_SCALED_GLYPH_INFO_RECORDING_SURFACE;
@@ -2836,16 +3088,56 @@ _cairo_scaled_glyph_page_can_remove (const void *closure)
     const cairo_scaled_glyph_page_t *page = closure;
     const cairo_scaled_font_t *scaled_font;
 
-    scaled_font = (cairo_scaled_font_t *) page->cache_entry.hash;
+    scaled_font = page->scaled_font;
     return scaled_font->cache_frozen == 0;
 }
 
+static void
+_cairo_scaled_glyph_page_cache_shrink (unsigned long additional)
+{
+    cairo_scaled_glyph_page_cache_t *cache = &cairo_scaled_glyph_page_cache;
+    int budget;
+
+    /* Each page is visited at most twice: once to clear its referenced
+     * bit and once more to evict it (unless its font is in use). */
+    budget = 2 * cache->num_pages;
+    while (cache->size + additional > cache->max_size && budget--) {
+	cairo_scaled_glyph_page_t *page;
+
+	if (cairo_list_is_empty (&cache->pages))
+	    break;
+
+	page = cairo_list_first_entry (&cache->pages,
+				       cairo_scaled_glyph_page_t,
+				       lru);
+	if (_cairo_atomic_int_get (&page->referenced) ||
+	    ! _cairo_scaled_glyph_page_can_remove (page))
+	{
+	    _cairo_atomic_int_cmpxchg (&page->referenced, TRUE, FALSE);
+	    cairo_list_move_tail (&page->lru, &cache->pages);
+	    continue;
+	}
+
+	_cairo_scaled_glyph_page_cache_unlink (page);
+	cache->evictions++;
+	_cairo_scaled_glyph_page_pluck (page);
+    }
+}
+
+static void
+_cairo_scaled_glyph_page_cache_thaw (void)
+{
+    assert (cairo_scaled_glyph_page_cache.freeze_count > 0);
+
+    if (--cairo_scaled_glyph_page_cache.freeze_count == 0)
+	_cairo_scaled_glyph_page_cache_shrink (0);
+}
+
 static cairo_status_t
 _cairo_scaled_font_allocate_glyph (cairo_scaled_font_t *scaled_font,
 				   cairo_scaled_glyph_t **scaled_glyph)
 {
     cairo_scaled_glyph_page_t *page;
-    cairo_status_t status;
 
     assert (scaled_font->cache_frozen);
 
@@ -2864,36 +3156,26 @@ _cairo_scaled_font_allocate_glyph (cairo_scaled_font_t *scaled_font,
     if (unlikely (page == NULL))
 	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
 
-    page->cache_entry.hash = (unsigned long) scaled_font;
-    page->cache_entry.size = 1; /* XXX occupancy weighting? */
+    page->scaled_font = scaled_font;
+    page->size = sizeof (cairo_scaled_glyph_page_t);
+    page->referenced = FALSE;
     page->num_glyphs = 0;
 
     CAIRO_MUTEX_LOCK (_cairo_scaled_glyph_page_cache_mutex);
     if (scaled_font->global_cache_frozen == FALSE) {
-	if (unlikely (cairo_scaled_glyph_page_cache.hash_table == NULL)) {
-	    status = _cairo_cache_init (&cairo_scaled_glyph_page_cache,
-					NULL,
-					_cairo_scaled_glyph_page_can_remove,
-					_cairo_scaled_glyph_page_pluck,
-					MAX_GLYPH_PAGES_CACHED);
-	    if (unlikely (status)) {
-		CAIRO_MUTEX_UNLOCK (_cairo_scaled_glyph_page_cache_mutex);
-		free (page);
-		return status;
-	    }
-	}
+	/* Make room before we freeze the cache; pages of fonts frozen by
+	 * other threads are skipped by the eviction. */
+	if (cairo_scaled_glyph_page_cache.freeze_count == 0)
+	    _cairo_scaled_glyph_page_cache_shrink (page->size);
 
-	_cairo_cache_freeze (&cairo_scaled_glyph_page_cache);
+	cairo_scaled_glyph_page_cache.freeze_count++;
 	scaled_font->global_cache_frozen = TRUE;
     }
 
-    status = _cairo_cache_insert (&cairo_scaled_glyph_page_cache,
-				  &page->cache_entry);
+    cairo_list_add_tail (&page->lru, &cairo_scaled_glyph_page_cache.pages);
+    cairo_scaled_glyph_page_cache.num_pages++;
+    cairo_scaled_glyph_page_cache.size += page->size;
     CAIRO_MUTEX_UNLOCK (_cairo_scaled_glyph_page_cache_mutex);
-    if (unlikely (status)) {
-	free (page);
-	return status;
-    }
 
     cairo_list_add_tail (&page->link, &scaled_font->glyph_pages);
 
@@ -2913,16 +3195,18 @@ _cairo_scaled_font_free_last_glyph (cairo_scaled_font_t *scaled_font,
                                   link);
     assert (scaled_glyph == &page->glyphs[page->num_glyphs-1]);
 
+    CAIRO_MUTEX_LOCK (_cairo_scaled_glyph_page_cache_mutex);
+    page->size -= _cairo_scaled_glyph_size (scaled_glyph);
+    cairo_scaled_glyph_page_cache.size -= _cairo_scaled_glyph_size (scaled_glyph);
+    CAIRO_MUTEX_UNLOCK (_cairo_scaled_glyph_page_cache_mutex);
+
+    scaled_glyph->page = NULL;
     _cairo_scaled_glyph_fini (scaled_font, scaled_glyph);
 
     if (--page->num_glyphs == 0) {
 	CAIRO_MUTEX_LOCK (_cairo_scaled_glyph_page_cache_mutex);
-	/* Temporarily disconnect callback to avoid recursive locking */
-	cairo_scaled_glyph_page_cache.entry_destroy = NULL;
-	_cairo_cache_remove (&cairo_scaled_glyph_page_cache,
-		             &page->cache_entry);
+	_cairo_scaled_glyph_page_cache_unlink (page);
 	_cairo_scaled_glyph_page_destroy (scaled_font, page);
-	cairo_scaled_glyph_page_cache.entry_destroy = _cairo_scaled_glyph_page_pluck;
 	CAIRO_MUTEX_UNLOCK (_cairo_scaled_glyph_page_cache_mutex);
     }
 }
@@ -2980,14 +3264,29 @@ _cairo_scaled_glyph_lookup (cairo_scaled_font_t *scaled_font,
      */
     scaled_glyph = _cairo_hash_table_lookup (scaled_font->glyphs,
 					     (cairo_hash_entry_t *) &index);
-    if (scaled_glyph == NULL) {
+    if (scaled_glyph != NULL) {
+	if (! _cairo_atomic_int_get (&scaled_glyph->page->referenced))
+	    _cairo_atomic_int_cmpxchg (&scaled_glyph->page->referenced,
+				       FALSE, TRUE);
+	scaled_font->glyph_cache_hits++;
+    } else {
+	cairo_scaled_glyph_page_t *page;
+
 	status = _cairo_scaled_font_allocate_glyph (scaled_font, &scaled_glyph);
 	if (unlikely (status))
 	    goto err;
 
+	page = cairo_list_last_entry (&scaled_font->glyph_pages,
+				      cairo_scaled_glyph_page_t,
+				      link);
 	memset (scaled_glyph, 0, sizeof (cairo_scaled_glyph_t));
 	_cairo_scaled_glyph_set_index (scaled_glyph, index);
 	cairo_list_init (&scaled_glyph->dev_privates);
+	scaled_glyph->page = page;
+
+	CAIRO_MUTEX_LOCK (_cairo_scaled_glyph_page_cache_mutex);
+	cairo_scaled_glyph_page_cache.misses++;
+	CAIRO_MUTEX_UNLOCK (_cairo_scaled_glyph_page_cache_mutex);
 
 	/* ask backend to initialize metrics and shape fields */
 	status =
@@ -3168,3 +3467,75 @@ cairo_scaled_font_get_font_options (cairo_scaled_font_t		*scaled_font,
     _cairo_font_options_init_copy (options, &scaled_font->options);
 }
 slim_hidden_def (cairo_scaled_font_get_font_options);
+
+/**
+ * cairo_glyph_cache_set_max_size:
+ * @max_size: the new budget in bytes
+ *
+ * Sets the number of bytes that the glyphs of all scaled fonts may
+ * occupy in the global glyph cache, including their rendered images
+ * and outlines. If the cache is over the new budget, the least
+ * recently used glyphs not currently in use are released.
+ *
+ * Since: 1.16
+ **/
+void
+cairo_glyph_cache_set_max_size (unsigned long max_size)
+{
+    CAIRO_MUTEX_INITIALIZE ();
+
+    CAIRO_MUTEX_LOCK (_cairo_scaled_glyph_page_cache_mutex);
+    cairo_scaled_glyph_page_cache.max_size = max_size;
+    if (cairo_scaled_glyph_page_cache.freeze_count == 0)
+	_cairo_scaled_glyph_page_cache_shrink (0);
+    CAIRO_MUTEX_UNLOCK (_cairo_scaled_glyph_page_cache_mutex);
+}
+
+/**
+ * cairo_glyph_cache_get_max_size:
+ *
+ * Returns the budget of the global glyph cache, as set by
+ * cairo_glyph_cache_set_max_size().
+ *
+ * Return value: the budget in bytes.
+ *
+ * Since: 1.16
+ **/
+unsigned long
+cairo_glyph_cache_get_max_size (void)
+{
+    unsigned long max_size;
+
+    CAIRO_MUTEX_INITIALIZE ();
+
+    CAIRO_MUTEX_LOCK (_cairo_scaled_glyph_page_cache_mutex);
+    max_size = cairo_scaled_glyph_page_cache.max_size;
+    CAIRO_MUTEX_UNLOCK (_cairo_scaled_glyph_page_cache_mutex);
+
+    return max_size;
+}
+
+/**
+ * cairo_glyph_cache_get_statistics:
+ * @stats: return value for the statistics
+ *
+ * Stores the current occupancy of the global glyph cache together
+ * with the number of hits, misses and evictions since the cache
+ * was last reset into @stats. Lookup hits are accumulated per font
+ * and so may lag behind slightly.
+ *
+ * Since: 1.16
+ **/
+void
+cairo_glyph_cache_get_statistics (cairo_glyph_cache_statistics_t *stats)
+{
+    CAIRO_MUTEX_INITIALIZE ();
+
+    CAIRO_MUTEX_LOCK (_cairo_scaled_glyph_page_cache_mutex);
+    stats->size = cairo_scaled_glyph_page_cache.size;
+    stats->max_size = cairo_scaled_glyph_page_cache.max_size;
+    stats->hits = cairo_scaled_glyph_page_cache.hits;
+    stats->misses = cairo_scaled_glyph_page_cache.misses;
+    stats->evictions = cairo_scaled_glyph_page_cache.evictions;
+    CAIRO_MUTEX_UNLOCK (_cairo_scaled_glyph_page_cache_mutex);
+}
@@ -129,6 +129,7 @@ struct _cairo_script_context {
     cairo_bool_t owns_stream;
     cairo_output_stream_t *stream;
     cairo_script_mode_t mode;
+    int compression_level;
 
     struct _bitmap {
 	unsigned long min;
@@ -1434,7 +1435,8 @@ _emit_image_surface (cairo_script_surface_t *surface,
 	    len = to_be32 (len);
 	    _cairo_output_stream_write (base85_stream, &len, sizeof (len));
 
-	    zlib_stream = _cairo_deflate_stream_create (base85_stream);
+	    zlib_stream = _cairo_deflate_stream_create_with_level (base85_stream,
+								   ctx->compression_level);
 	    status = _write_image_surface (zlib_stream, clone);
 
 	    status2 = _cairo_output_stream_destroy (zlib_stream);
@@ -2882,7 +2884,8 @@ _emit_type42_font (cairo_script_surface_t *surface,
     len = to_be32 (size);
     _cairo_output_stream_write (base85_stream, &len, sizeof (len));
 
-    zlib_stream = _cairo_deflate_stream_create (base85_stream);
+    zlib_stream = _cairo_deflate_stream_create_with_level (base85_stream,
+							   ctx->compression_level);
 
     _cairo_output_stream_write (zlib_stream, buf, size);
     free (buf);
@@ -3701,6 +3704,7 @@ _cairo_script_context_create_internal (cairo_output_stream_t *stream)
     cairo_list_init (&ctx->deferred);
     ctx->stream = stream;
     ctx->mode = CAIRO_SCRIPT_MODE_ASCII;
+    ctx->compression_level = CAIRO_DEFLATE_LEVEL_DEFAULT;
 
     cairo_list_init (&ctx->fonts);
     cairo_list_init (&ctx->defines);
@@ -3858,6 +3862,27 @@ cairo_script_get_mode (cairo_device_t *script)
     return context->mode;
 }
 
+/**
+ * cairo_script_set_compression_level:
+ * @script: The script (output device)
+ * @level: the deflate compression level, from 0 to 9
+ *
+ * Sets the effort spent compressing the images and fonts subsequently
+ * embedded into the script. Level 1 is the fastest, level 9 produces
+ * the smallest output and level 0 stores the data uncompressed. Values
+ * outside of this range are clamped. The default is 6.
+ *
+ * Since: 1.16
+ **/
+void
+cairo_script_set_compression_level (cairo_device_t *script,
+				    int level)
+{
+    cairo_script_context_t *context = (cairo_script_context_t *) script;
+
+    context->compression_level = MAX (0, MIN (level, 9));
+}
+
 /**
  * cairo_script_surface_create:
  * @script: the script (output device)
@@ -75,6 +75,10 @@ cairo_script_set_mode (cairo_device_t *script,
 cairo_public cairo_script_mode_t
 cairo_script_get_mode (cairo_device_t *script);
 
+cairo_public void
+cairo_script_set_compression_level (cairo_device_t *script,
+				    int level);
+
 cairo_public cairo_surface_t *
 cairo_script_surface_create (cairo_device_t *script,
 			     cairo_content_t content,
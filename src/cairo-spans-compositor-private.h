@@ -100,6 +100,10 @@ struct cairo_spans_compositor {
 
     void (*renderer_fini) (cairo_abstract_span_renderer_t *renderer,
 			   cairo_int_status_t status);
+
+    /* optional: a private alias of the surface that may be rendered to
+     * concurrently with other aliases, used for banded rasterisation */
+    cairo_surface_t * (*create_band_surface) (cairo_surface_t *surface);
 };
 
 cairo_private void
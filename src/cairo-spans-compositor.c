@@ -46,6 +46,7 @@
 #include "cairo-clip-private.h"
 #include "cairo-image-surface-private.h"
 #include "cairo-paginated-private.h"
+#include "cairo-path-cache-private.h"
 #include "cairo-pattern-inline.h"
 #include "cairo-region-private.h"
 #include "cairo-recording-surface-inline.h"
@@ -53,6 +54,7 @@
 #include "cairo-surface-subsurface-private.h"
 #include "cairo-surface-snapshot-private.h"
 #include "cairo-surface-observer-private.h"
+#include "cairo-thread-pool-private.h"
 
 typedef struct {
     cairo_polygon_t	*polygon;
@@ -79,10 +81,10 @@ clip_and_composite_polygon (const cairo_spans_compositor_t	*compositor,
 			    cairo_fill_rule_t			 fill_rule,
 			    cairo_antialias_t			 antialias);
 static cairo_surface_t *
-get_clip_surface (const cairo_spans_compositor_t *compositor,
-		  cairo_surface_t *dst,
-		  const cairo_clip_t *clip,
-		  const cairo_rectangle_int_t *extents)
+create_clip_surface (const cairo_spans_compositor_t *compositor,
+		     cairo_surface_t *dst,
+		     const cairo_clip_t *clip,
+		     const cairo_rectangle_int_t *extents)
 {
     cairo_composite_rectangles_t composite;
     cairo_surface_t *surface;
@@ -238,6 +240,25 @@ error:
     return _cairo_int_surface_create_in_error (status);
 }
 
+/* As create_clip_surface(), but shared with other draws to @dst under
+ * the same clip; the mask must not be modified. */
+static cairo_surface_t *
+get_clip_surface (const cairo_spans_compositor_t *compositor,
+		  cairo_surface_t *dst,
+		  const cairo_clip_t *clip,
+		  const cairo_rectangle_int_t *extents)
+{
+    cairo_surface_t *surface;
+
+    surface = _cairo_clip_mask_cache_lookup (dst, compositor, clip, extents);
+    if (surface != NULL)
+	return surface;
+
+    surface = create_clip_surface (compositor, dst, clip, extents);
+    _cairo_clip_mask_cache_insert (dst, compositor, clip, extents, surface);
+    return surface;
+}
+
 static cairo_int_status_t
 fixup_unbounded_mask (const cairo_spans_compositor_t *compositor,
 		      const cairo_composite_rectangles_t *extents,
@@ -637,8 +658,13 @@ composite_aligned_boxes (const cairo_spans_compositor_t		*compositor,
 
 	/* All typical cases will have been resolved before now... */
 	if (need_clip_mask) {
-	    mask = get_clip_surface (compositor, dst, extents->clip,
-				     &extents->bounded);
+	    /* a shared mask cannot take the mask pattern in place */
+	    if (no_mask)
+		mask = get_clip_surface (compositor, dst, extents->clip,
+					 &extents->bounded);
+	    else
+		mask = create_clip_surface (compositor, dst, extents->clip,
+					    &extents->bounded);
 	    if (unlikely (mask->status))
 		return mask->status;
 
@@ -746,6 +772,205 @@ cleanup_converter:
     return status;
 }
 
+/* Large polygons may be split into horizontal bands that are scan
+ * converted and rendered concurrently on the thread pool.  Each band
+ * gets its own converter, renderer and alias of the destination, so
+ * the only shared state is the read-only polygon.  In order for the
+ * result to be identical to the serial path, the source and mask must
+ * be sampled identically whatever the extents of the band are.
+ */
+#define BAND_MIN_HEIGHT 64
+#define BAND_MIN_AREA (512 * 512)
+
+typedef struct {
+    const cairo_spans_compositor_t *compositor;
+    cairo_composite_rectangles_t extents;
+    const cairo_polygon_t *polygon;
+    cairo_fill_rule_t fill_rule;
+    cairo_antialias_t antialias;
+    cairo_int_status_t status;
+} composite_band_t;
+
+static cairo_bool_t
+pattern_is_band_invariant (const cairo_pattern_t *pattern,
+			   const cairo_rectangle_int_t *sample,
+			   const cairo_surface_t *dst)
+{
+    const cairo_surface_t *surface;
+    cairo_rectangle_int_t limit;
+    int tx, ty;
+
+    switch (pattern->type) {
+    case CAIRO_PATTERN_TYPE_SOLID:
+	return TRUE;
+
+    case CAIRO_PATTERN_TYPE_SURFACE:
+	surface = ((const cairo_surface_pattern_t *) pattern)->surface;
+	if (surface == dst || surface->backend->type != CAIRO_SURFACE_TYPE_IMAGE)
+	    return FALSE;
+
+	limit.x = limit.y = 0;
+	limit.width  = ((const cairo_image_surface_t *) surface)->width;
+	limit.height = ((const cairo_image_surface_t *) surface)->height;
+	if (! _cairo_rectangle_contains_rectangle (&limit, sample))
+	    return FALSE;
+
+	return _cairo_matrix_is_pixman_translation (&pattern->matrix,
+						    pattern->filter,
+						    &tx, &ty);
+
+    case CAIRO_PATTERN_TYPE_LINEAR:
+    case CAIRO_PATTERN_TYPE_RADIAL:
+	return _cairo_gradient_pattern_is_band_invariant ((const cairo_gradient_pattern_t *) pattern);
+
+    case CAIRO_PATTERN_TYPE_MESH:
+    case CAIRO_PATTERN_TYPE_RASTER_SOURCE:
+    default:
+	return FALSE;
+    }
+}
+
+static int
+composite_polygon_num_bands (const cairo_spans_compositor_t *compositor,
+			     const cairo_composite_rectangles_t *extents,
+			     cairo_antialias_t antialias)
+{
+    const cairo_rectangle_int_t *r = &extents->unbounded;
+    int num_threads, num_bands;
+
+    if (compositor->create_band_surface == NULL)
+	return 1;
+
+    if (antialias == CAIRO_ANTIALIAS_FAST || antialias == CAIRO_ANTIALIAS_NONE)
+	return 1;
+
+    if (! extents->is_bounded)
+	return 1;
+
+    if (r->height < 2 * BAND_MIN_HEIGHT ||
+	(int64_t) r->width * r->height < BAND_MIN_AREA)
+	return 1;
+
+    num_threads = _cairo_thread_pool_get_num_threads ();
+    if (num_threads <= 1)
+	return 1;
+
+    if (! pattern_is_band_invariant (&extents->source_pattern.base,
+				     &extents->source_sample_area,
+				     extents->surface) ||
+	! pattern_is_band_invariant (&extents->mask_pattern.base,
+				     &extents->mask_sample_area,
+				     extents->surface))
+	return 1;
+
+    /* oversubscribe a little to even out the load between bands */
+    num_bands = 2 * num_threads;
+    if (num_bands > r->height / BAND_MIN_HEIGHT)
+	num_bands = r->height / BAND_MIN_HEIGHT;
+
+    return num_bands;
+}
+
+static void
+composite_band (void *closure)
+{
+    composite_band_t *band = closure;
+    const cairo_spans_compositor_t *compositor = band->compositor;
+    const cairo_rectangle_int_t *r = &band->extents.unbounded;
+    cairo_abstract_span_renderer_t renderer;
+    cairo_scan_converter_t *converter;
+    cairo_scan_converter_add_polygon_func_t add_polygon;
+    cairo_surface_t *surface;
+    cairo_int_status_t status;
+
+    if (band->extents.bounded.width == 0 || band->extents.bounded.height == 0)
+	return;
+
+    surface = compositor->create_band_surface (band->extents.surface);
+    if (unlikely (surface->status)) {
+	band->status = surface->status;
+	return;
+    }
+    band->extents.surface = surface;
+
+    converter = _cairo_scan_converter_create_for_antialias (r->x, r->y,
+							    r->x + r->width,
+							    r->y + r->height,
+							    band->fill_rule,
+							    band->antialias,
+							    &add_polygon);
+    status = add_polygon (converter, band->polygon);
+    if (unlikely (status))
+	goto cleanup_converter;
+
+    status = compositor->renderer_init (&renderer, &band->extents,
+					band->antialias, FALSE);
+    if (likely (status == CAIRO_INT_STATUS_SUCCESS))
+	status = converter->generate (converter, &renderer.base);
+    compositor->renderer_fini (&renderer, status);
+
+cleanup_converter:
+    converter->destroy (converter);
+    cairo_surface_destroy (surface);
+    band->status = status;
+}
+
+static cairo_int_status_t
+composite_polygon_bands (const cairo_spans_compositor_t	*compositor,
+			 cairo_composite_rectangles_t	*extents,
+			 cairo_polygon_t		*polygon,
+			 cairo_fill_rule_t		 fill_rule,
+			 cairo_antialias_t		 antialias,
+			 int				 num_bands)
+{
+    composite_band_t *bands;
+    cairo_int_status_t status;
+    int y, height, i;
+
+    TRACE ((stderr, "%s: num_bands=%d\n", __FUNCTION__, num_bands));
+
+    bands = _cairo_malloc_ab (num_bands, sizeof (composite_band_t));
+    if (unlikely (bands == NULL))
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+    y = extents->unbounded.y;
+    for (i = 0; i < num_bands; i++) {
+	composite_band_t *band = &bands[i];
+	cairo_rectangle_int_t *r;
+
+	height = (extents->unbounded.y + extents->unbounded.height - y) / (num_bands - i);
+
+	band->compositor = compositor;
+	band->extents = *extents;
+	band->polygon = polygon;
+	band->fill_rule = fill_rule;
+	band->antialias = antialias;
+	band->status = CAIRO_INT_STATUS_SUCCESS;
+
+	r = &band->extents.unbounded;
+	r->y = y;
+	r->height = height;
+	band->extents.bounded = *r;
+	_cairo_rectangle_intersect (&band->extents.bounded, &extents->bounded);
+
+	y += height;
+    }
+
+    _cairo_thread_pool_run (composite_band, bands,
+			    sizeof (composite_band_t), num_bands);
+
+    status = CAIRO_INT_STATUS_SUCCESS;
+    for (i = 0; i < num_bands; i++) {
+	if (bands[i].status) {
+	    status = bands[i].status;
+	    break;
+	}
+    }
+
+    free (bands);
+    return status;
+}
+
 static cairo_int_status_t
 composite_polygon (const cairo_spans_compositor_t	*compositor,
 		   cairo_composite_rectangles_t		 *extents,
@@ -753,10 +978,13 @@ composite_polygon (const cairo_spans_compositor_t	*compositor,
 		   cairo_fill_rule_t			 fill_rule,
 		   cairo_antialias_t			 antialias)
 {
+    const cairo_rectangle_int_t *r = &extents->unbounded;
     cairo_abstract_span_renderer_t renderer;
     cairo_scan_converter_t *converter;
+    cairo_scan_converter_add_polygon_func_t add_polygon;
     cairo_bool_t needs_clip;
     cairo_int_status_t status;
+    int num_bands;
 
     if (extents->is_bounded)
 	needs_clip = extents->clip->path != NULL;
@@ -764,33 +992,38 @@ composite_polygon (const cairo_spans_compositor_t	*compositor,
 	needs_clip = !_clip_is_region (extents->clip) || extents->clip->num_boxes > 1;
     TRACE ((stderr, "%s - needs_clip=%d\n", __FUNCTION__, needs_clip));
     if (needs_clip) {
-	TRACE ((stderr, "%s: unsupported clip\n", __FUNCTION__));
-	return CAIRO_INT_STATUS_UNSUPPORTED;
-	converter = _cairo_clip_tor_scan_converter_create (extents->clip,
-							   polygon,
-							   fill_rule, antialias);
-    } else {
-	const cairo_rectangle_int_t *r = &extents->unbounded;
+	/* Outside of the clip an unbounded operator must leave the
+	 * destination untouched, which a single coverage cannot say. */
+	if (! extents->is_bounded) {
+	    TRACE ((stderr, "%s: unsupported clip\n", __FUNCTION__));
+	    return CAIRO_INT_STATUS_UNSUPPORTED;
+	}
 
-	if (antialias == CAIRO_ANTIALIAS_FAST) {
-	    converter = _cairo_tor22_scan_converter_create (r->x, r->y,
-							    r->x + r->width,
-							    r->y + r->height,
-							    fill_rule, antialias);
-	    status = _cairo_tor22_scan_converter_add_polygon (converter, polygon);
-	} else if (antialias == CAIRO_ANTIALIAS_NONE) {
-	    converter = _cairo_mono_scan_converter_create (r->x, r->y,
+	converter = _cairo_clip_tor_scan_converter_create (r->x, r->y,
 							   r->x + r->width,
 							   r->y + r->height,
-							   fill_rule);
-	    status = _cairo_mono_scan_converter_add_polygon (converter, polygon);
-	} else {
-	    converter = _cairo_tor_scan_converter_create (r->x, r->y,
-							  r->x + r->width,
-							  r->y + r->height,
-							  fill_rule, antialias);
-	    status = _cairo_tor_scan_converter_add_polygon (converter, polygon);
-	}
+							   fill_rule, antialias);
+	status = _cairo_clip_tor_scan_converter_add_clip (converter,
+							  extents->clip);
+	if (likely (status == CAIRO_INT_STATUS_SUCCESS))
+	    status = _cairo_clip_tor_scan_converter_add_polygon (converter,
+								 polygon);
+
+	/* The clip is now part of the coverage */
+	needs_clip = FALSE;
+    } else {
+	num_bands = composite_polygon_num_bands (compositor, extents, antialias);
+	if (num_bands > 1)
+	    return composite_polygon_bands (compositor, extents, polygon,
+					    fill_rule, antialias, num_bands);
+
+	converter = _cairo_scan_converter_create_for_antialias (r->x, r->y,
+								r->x + r->width,
+								r->y + r->height,
+								fill_rule,
+								antialias,
+								&add_polygon);
+	status = add_polygon (converter, polygon);
     }
     if (unlikely (status))
 	goto cleanup_converter;
@@ -1002,6 +1235,48 @@ _cairo_spans_compositor_mask (const cairo_compositor_t		*_compositor,
     return status;
 }
 
+/* Composite the coverage of a stroke thin enough to be swept directly
+ * into spans, skipping the outline of its joins and caps.  Its output
+ * differs slightly from that of the polygon stroker, so it is only
+ * used when asked for speed over quality with CAIRO_ANTIALIAS_FAST. */
+static cairo_int_status_t
+composite_hairline (const cairo_spans_compositor_t	*compositor,
+		    cairo_composite_rectangles_t	*extents,
+		    const cairo_path_fixed_t		*path,
+		    const cairo_stroke_style_t		*style,
+		    const cairo_matrix_t		*ctm,
+		    double				 tolerance,
+		    cairo_antialias_t			 antialias)
+{
+    cairo_abstract_span_renderer_t renderer;
+    cairo_scan_converter_t *converter;
+    cairo_int_status_t status;
+
+    if (antialias != CAIRO_ANTIALIAS_FAST)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    /* The coverage is only limited to pixel-aligned extents */
+    if (! _clip_is_region (extents->clip) || extents->clip->num_boxes > 1)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    status = _cairo_hairline_scan_converter_create (path, style, ctm,
+						    tolerance,
+						    &extents->unbounded,
+						    &converter);
+    if (status != CAIRO_INT_STATUS_SUCCESS)
+	return status;
+
+    TRACE ((stderr, "%s - hairline\n", __FUNCTION__));
+
+    status = compositor->renderer_init (&renderer, extents, antialias, FALSE);
+    if (likely (status == CAIRO_INT_STATUS_SUCCESS))
+	status = converter->generate (converter, &renderer.base);
+    compositor->renderer_fini (&renderer, status);
+
+    converter->destroy (converter);
+    return status;
+}
+
 static cairo_int_status_t
 _cairo_spans_compositor_stroke (const cairo_compositor_t	*_compositor,
 				cairo_composite_rectangles_t	 *extents,
@@ -1039,6 +1314,11 @@ _cairo_spans_compositor_stroke (const cairo_compositor_t	*_compositor,
 	_cairo_boxes_fini (&boxes);
     }
 
+    if (status == CAIRO_INT_STATUS_UNSUPPORTED) {
+	status = composite_hairline (compositor, extents, path, style, ctm,
+				     tolerance, antialias);
+    }
+
     if (status == CAIRO_INT_STATUS_UNSUPPORTED) {
 	cairo_polygon_t polygon;
 	cairo_fill_rule_t fill_rule = CAIRO_FILL_RULE_WINDING;
@@ -1094,6 +1374,48 @@ _cairo_spans_compositor_stroke (const cairo_compositor_t	*_compositor,
     return status;
 }
 
+/* Composite the coverage of @path from the path cache, if enabled,
+ * saving the tessellation and scan conversion of repeated shapes. */
+static cairo_int_status_t
+composite_cached_path (const cairo_spans_compositor_t	*compositor,
+		       cairo_composite_rectangles_t	*extents,
+		       const cairo_path_fixed_t		*path,
+		       cairo_fill_rule_t		 fill_rule,
+		       double				 tolerance,
+		       cairo_antialias_t		 antialias)
+{
+    cairo_abstract_span_renderer_t renderer;
+    cairo_scan_converter_t *converter;
+    cairo_int_status_t status;
+
+    /* The cached coverage can only be limited to pixel-aligned extents */
+    if (! _clip_is_region (extents->clip) || extents->clip->num_boxes > 1)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    converter = _cairo_path_cache_scan_converter_create (path,
+							 fill_rule,
+							 tolerance,
+							 antialias,
+							 &extents->unbounded);
+    if (converter == NULL)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    TRACE ((stderr, "%s - cached\n", __FUNCTION__));
+
+    status = _cairo_composite_rectangles_intersect_mask_extents (extents,
+								 &path->extents);
+    if (likely (status == CAIRO_INT_STATUS_SUCCESS)) {
+	status = compositor->renderer_init (&renderer, extents,
+					    antialias, FALSE);
+	if (likely (status == CAIRO_INT_STATUS_SUCCESS))
+	    status = converter->generate (converter, &renderer.base);
+	compositor->renderer_fini (&renderer, status);
+    }
+
+    converter->destroy (converter);
+    return status;
+}
+
 static cairo_int_status_t
 _cairo_spans_compositor_fill (const cairo_compositor_t		*_compositor,
 			      cairo_composite_rectangles_t	 *extents,
@@ -1126,6 +1448,10 @@ _cairo_spans_compositor_fill (const cairo_compositor_t		*_compositor,
 	    status = clip_and_composite_boxes (compositor, extents, &boxes);
 	_cairo_boxes_fini (&boxes);
     }
+    if (status == CAIRO_INT_STATUS_UNSUPPORTED) {
+	status = composite_cached_path (compositor, extents, path,
+					fill_rule, tolerance, antialias);
+    }
     if (status == CAIRO_INT_STATUS_UNSUPPORTED) {
 	cairo_polygon_t polygon;
 
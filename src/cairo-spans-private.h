@@ -83,6 +83,10 @@ struct _cairo_scan_converter {
 
 /* Scan converter constructors. */
 
+typedef cairo_status_t
+(*cairo_scan_converter_add_polygon_func_t) (void		*converter,
+					    const cairo_polygon_t *polygon);
+
 cairo_private cairo_scan_converter_t *
 _cairo_tor_scan_converter_create (int			xmin,
 				  int			ymin,
@@ -105,6 +109,16 @@ cairo_private cairo_status_t
 _cairo_tor22_scan_converter_add_polygon (void		*converter,
 					 const cairo_polygon_t *polygon);
 
+cairo_private cairo_scan_converter_t *
+_cairo_analytic_scan_converter_create (int			xmin,
+				       int			ymin,
+				       int			xmax,
+				       int			ymax,
+				       cairo_fill_rule_t	fill_rule);
+cairo_private cairo_status_t
+_cairo_analytic_scan_converter_add_polygon (void		*converter,
+					    const cairo_polygon_t *polygon);
+
 cairo_private cairo_scan_converter_t *
 _cairo_mono_scan_converter_create (int			xmin,
 				   int			ymin,
@@ -116,10 +130,29 @@ _cairo_mono_scan_converter_add_polygon (void		*converter,
 					const cairo_polygon_t *polygon);
 
 cairo_private cairo_scan_converter_t *
-_cairo_clip_tor_scan_converter_create (cairo_clip_t *clip,
-				       cairo_polygon_t *polygon,
-				       cairo_fill_rule_t fill_rule,
-				       cairo_antialias_t antialias);
+_cairo_clip_tor_scan_converter_create (int			xmin,
+				       int			ymin,
+				       int			xmax,
+				       int			ymax,
+				       cairo_fill_rule_t	fill_rule,
+				       cairo_antialias_t	antialias);
+cairo_private cairo_status_t
+_cairo_clip_tor_scan_converter_add_polygon (void		*converter,
+					    const cairo_polygon_t *polygon);
+cairo_private cairo_int_status_t
+_cairo_clip_tor_scan_converter_add_clip (void			*converter,
+					 const cairo_clip_t	*clip);
+
+/* Sweeps a stroke of @path no wider than a device pixel into coverage
+ * within @extents.  Returns %CAIRO_INT_STATUS_UNSUPPORTED if the stroke
+ * has to be outlined instead, see cairo-path-stroke-hairline.c. */
+cairo_private cairo_int_status_t
+_cairo_hairline_scan_converter_create (const cairo_path_fixed_t	*path,
+				       const cairo_stroke_style_t	*style,
+				       const cairo_matrix_t		*ctm,
+				       double				 tolerance,
+				       const cairo_rectangle_int_t	*extents,
+				       cairo_scan_converter_t	       **converter);
 
 typedef struct _cairo_rectangular_scan_converter {
     cairo_scan_converter_t base;
@@ -180,6 +213,15 @@ cairo_private cairo_status_t
 _cairo_scan_converter_set_error (void *abstract_converter,
 				 cairo_status_t error);
 
+cairo_private cairo_scan_converter_t *
+_cairo_scan_converter_create_for_antialias (int				 xmin,
+					    int				 ymin,
+					    int				 xmax,
+					    int				 ymax,
+					    cairo_fill_rule_t		 fill_rule,
+					    cairo_antialias_t		 antialias,
+					    cairo_scan_converter_add_polygon_func_t *add_polygon);
+
 cairo_private cairo_span_renderer_t *
 _cairo_span_renderer_create_in_error (cairo_status_t error);
 
@@ -248,3 +248,41 @@ _cairo_span_renderer_create_in_error (cairo_status_t status)
     RETURN_NIL;
 #undef RETURN_NIL
 }
+
+/* Creates the scan converter that rasterises fills with @antialias, and
+ * returns in @add_polygon the function that adds a polygon to it. */
+cairo_scan_converter_t *
+_cairo_scan_converter_create_for_antialias (int				 xmin,
+					    int				 ymin,
+					    int				 xmax,
+					    int				 ymax,
+					    cairo_fill_rule_t		 fill_rule,
+					    cairo_antialias_t		 antialias,
+					    cairo_scan_converter_add_polygon_func_t *add_polygon)
+{
+    switch (antialias) {
+    case CAIRO_ANTIALIAS_NONE:
+	*add_polygon = _cairo_mono_scan_converter_add_polygon;
+	return _cairo_mono_scan_converter_create (xmin, ymin, xmax, ymax,
+						  fill_rule);
+
+    case CAIRO_ANTIALIAS_FAST:
+	*add_polygon = _cairo_tor22_scan_converter_add_polygon;
+	return _cairo_tor22_scan_converter_create (xmin, ymin, xmax, ymax,
+						   fill_rule, antialias);
+
+    case CAIRO_ANTIALIAS_GOOD:
+    case CAIRO_ANTIALIAS_BEST:
+	*add_polygon = _cairo_analytic_scan_converter_add_polygon;
+	return _cairo_analytic_scan_converter_create (xmin, ymin, xmax, ymax,
+						      fill_rule);
+
+    case CAIRO_ANTIALIAS_DEFAULT:
+    case CAIRO_ANTIALIAS_GRAY:
+    case CAIRO_ANTIALIAS_SUBPIXEL:
+    default:
+	*add_polygon = _cairo_tor_scan_converter_add_polygon;
+	return _cairo_tor_scan_converter_create (xmin, ymin, xmax, ymax,
+						 fill_rule, antialias);
+    }
+}
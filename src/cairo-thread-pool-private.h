@@ -0,0 +1,85 @@
+/* -*- Mode: c; tab-width: 8; c-basic-offset: 4; indent-tabs-mode: t; -*- */
+/* cairo - a vector graphics library with display and print output
+ *
+ * Copyright © 2026 the cairo authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ *
+ * The Initial Developer of the Original Code is the cairo authors.
+ */
+
+#ifndef CAIRO_THREAD_POOL_PRIVATE_H
+#define CAIRO_THREAD_POOL_PRIVATE_H
+
+#include "cairo-compiler-private.h"
+
+CAIRO_BEGIN_DECLS
+
+/* A small pool of worker threads shared by the rasterisers that can
+ * split their work into independent pieces (image bands, tiles, ...).
+ *
+ * The pool is opt-in: it is sized by the CAIRO_RENDER_THREADS
+ * environment variable, read once on first use, and is disabled
+ * (i.e. everything runs on the calling thread) if that is unset, 1 or
+ * if cairo was built without full pthread support.
+ */
+
+typedef void (*cairo_thread_pool_func_t) (void *task);
+
+cairo_private int
+_cairo_thread_pool_get_num_threads (void);
+
+/* Calls @func on each of the @num_tasks elements of @tasks (each
+ * @task_size bytes large) and returns once all have completed. The
+ * calling thread participates, so it is safe to call this from within
+ * a task. */
+cairo_private void
+_cairo_thread_pool_run (cairo_thread_pool_func_t func,
+			void *tasks,
+			size_t task_size,
+			int num_tasks);
+
+/* Queues a single call of @func on @task and returns immediately. The
+ * returned job must be passed to _cairo_thread_pool_wait() exactly once;
+ * %NULL is returned if @func has already been run on the calling thread
+ * (e.g. because the pool is disabled). */
+typedef struct _cairo_thread_pool_batch cairo_thread_pool_job_t;
+
+cairo_private cairo_thread_pool_job_t *
+_cairo_thread_pool_submit (cairo_thread_pool_func_t func,
+			   void *task);
+
+/* Waits for @job to complete, running it on the calling thread if no
+ * worker has picked it up yet, and releases it. */
+cairo_private void
+_cairo_thread_pool_wait (cairo_thread_pool_job_t *job);
+
+cairo_private void
+_cairo_thread_pool_reset_static_data (void);
+
+CAIRO_END_DECLS
+
+#endif /* CAIRO_THREAD_POOL_PRIVATE_H */
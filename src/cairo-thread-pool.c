@@ -0,0 +1,342 @@
+/* -*- Mode: c; tab-width: 8; c-basic-offset: 4; indent-tabs-mode: t; -*- */
+/* cairo - a vector graphics library with display and print output
+ *
+ * Copyright © 2026 the cairo authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ *
+ * The Initial Developer of the Original Code is the cairo authors.
+ */
+
+#include "cairoint.h"
+
+#include "cairo-list-inline.h"
+#include "cairo-thread-pool-private.h"
+
+#if CAIRO_HAS_REAL_PTHREAD
+
+#include <pthread.h>
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#define MAX_THREADS 64
+
+typedef struct _cairo_thread_pool_batch {
+    cairo_list_t link;
+
+    cairo_thread_pool_func_t func;
+    char *tasks;
+    size_t task_size;
+    int num_tasks;
+
+    int next;
+    int pending;
+    pthread_cond_t done;
+} cairo_thread_pool_batch_t;
+
+static struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t wakeup;
+    cairo_list_t batches;
+
+    cairo_bool_t initialized;
+    cairo_bool_t shutdown;
+    int num_threads;
+    int num_workers;
+    pthread_t workers[MAX_THREADS];
+} pool = {
+    PTHREAD_MUTEX_INITIALIZER,
+    PTHREAD_COND_INITIALIZER,
+};
+
+/* Claims the next task from @batch; called with the pool mutex held. */
+static void *
+batch_claim (cairo_thread_pool_batch_t *batch)
+{
+    void *task;
+
+    task = batch->tasks + batch->next * batch->task_size;
+    if (++batch->next == batch->num_tasks)
+	cairo_list_del (&batch->link);
+
+    return task;
+}
+
+/* Runs @task with the pool mutex dropped, then retires it. */
+static void
+batch_execute (cairo_thread_pool_batch_t *batch, void *task)
+{
+    pthread_mutex_unlock (&pool.mutex);
+    batch->func (task);
+    pthread_mutex_lock (&pool.mutex);
+
+    if (--batch->pending == 0)
+	pthread_cond_signal (&batch->done);
+}
+
+static void *
+worker_main (void *arg)
+{
+    pthread_mutex_lock (&pool.mutex);
+    for (;;) {
+	cairo_thread_pool_batch_t *batch;
+
+	while (cairo_list_is_empty (&pool.batches) && ! pool.shutdown)
+	    pthread_cond_wait (&pool.wakeup, &pool.mutex);
+	if (pool.shutdown)
+	    break;
+
+	batch = cairo_list_first_entry (&pool.batches,
+					cairo_thread_pool_batch_t,
+					link);
+	batch_execute (batch, batch_claim (batch));
+    }
+    pthread_mutex_unlock (&pool.mutex);
+
+    return NULL;
+}
+
+static int
+_cairo_thread_pool_num_threads_from_env (void)
+{
+    const char *env;
+    int n;
+
+    env = getenv ("CAIRO_RENDER_THREADS");
+    if (env == NULL)
+	return 1;
+
+    n = atoi (env);
+#if HAVE_UNISTD_H && defined (_SC_NPROCESSORS_ONLN)
+    if (n == 0)
+	n = sysconf (_SC_NPROCESSORS_ONLN);
+#endif
+    if (n < 1)
+	n = 1;
+    if (n > MAX_THREADS)
+	n = MAX_THREADS;
+
+    return n;
+}
+
+/* Called with the pool mutex held. */
+static void
+_cairo_thread_pool_init (void)
+{
+    int n;
+
+    pool.initialized = TRUE;
+    pool.shutdown = FALSE;
+    cairo_list_init (&pool.batches);
+
+    n = _cairo_thread_pool_num_threads_from_env ();
+    for (pool.num_workers = 0; pool.num_workers < n - 1; pool.num_workers++) {
+	if (pthread_create (&pool.workers[pool.num_workers], NULL,
+			    worker_main, NULL))
+	    break;
+    }
+
+    pool.num_threads = pool.num_workers + 1;
+}
+
+int
+_cairo_thread_pool_get_num_threads (void)
+{
+    int n;
+
+    pthread_mutex_lock (&pool.mutex);
+    if (! pool.initialized)
+	_cairo_thread_pool_init ();
+    n = pool.num_threads;
+    pthread_mutex_unlock (&pool.mutex);
+
+    return n;
+}
+
+void
+_cairo_thread_pool_run (cairo_thread_pool_func_t func,
+			void *tasks,
+			size_t task_size,
+			int num_tasks)
+{
+    cairo_thread_pool_batch_t batch;
+    int i;
+
+    if (num_tasks <= 0)
+	return;
+
+    pthread_mutex_lock (&pool.mutex);
+    if (! pool.initialized)
+	_cairo_thread_pool_init ();
+
+    if (pool.num_workers == 0 || num_tasks == 1) {
+	pthread_mutex_unlock (&pool.mutex);
+
+	for (i = 0; i < num_tasks; i++)
+	    func ((char *) tasks + i * task_size);
+	return;
+    }
+
+    batch.func = func;
+    batch.tasks = tasks;
+    batch.task_size = task_size;
+    batch.num_tasks = num_tasks;
+    batch.next = 0;
+    batch.pending = num_tasks;
+    pthread_cond_init (&batch.done, NULL);
+
+    cairo_list_add_tail (&batch.link, &pool.batches);
+    pthread_cond_broadcast (&pool.wakeup);
+
+    /* Help out with our own batch rather than sleep; this also
+     * guarantees progress when we are ourselves running as a task. */
+    while (batch.next < batch.num_tasks)
+	batch_execute (&batch, batch_claim (&batch));
+
+    while (batch.pending)
+	pthread_cond_wait (&batch.done, &pool.mutex);
+    pthread_mutex_unlock (&pool.mutex);
+
+    pthread_cond_destroy (&batch.done);
+}
+
+cairo_thread_pool_job_t *
+_cairo_thread_pool_submit (cairo_thread_pool_func_t func,
+			   void *task)
+{
+    cairo_thread_pool_batch_t *batch;
+
+    pthread_mutex_lock (&pool.mutex);
+    if (! pool.initialized)
+	_cairo_thread_pool_init ();
+
+    if (pool.num_workers == 0)
+	goto run_inline;
+
+    batch = malloc (sizeof (cairo_thread_pool_batch_t));
+    if (unlikely (batch == NULL))
+	goto run_inline;
+
+    batch->func = func;
+    batch->tasks = task;
+    batch->task_size = 0;
+    batch->num_tasks = 1;
+    batch->next = 0;
+    batch->pending = 1;
+    pthread_cond_init (&batch->done, NULL);
+
+    cairo_list_add_tail (&batch->link, &pool.batches);
+    pthread_cond_signal (&pool.wakeup);
+    pthread_mutex_unlock (&pool.mutex);
+
+    return batch;
+
+run_inline:
+    pthread_mutex_unlock (&pool.mutex);
+    func (task);
+    return NULL;
+}
+
+void
+_cairo_thread_pool_wait (cairo_thread_pool_job_t *job)
+{
+    if (job == NULL)
+	return;
+
+    pthread_mutex_lock (&pool.mutex);
+    if (job->next < job->num_tasks)
+	batch_execute (job, batch_claim (job));
+    while (job->pending)
+	pthread_cond_wait (&job->done, &pool.mutex);
+    pthread_mutex_unlock (&pool.mutex);
+
+    pthread_cond_destroy (&job->done);
+    free (job);
+}
+
+void
+_cairo_thread_pool_reset_static_data (void)
+{
+    int i;
+
+    pthread_mutex_lock (&pool.mutex);
+    if (! pool.initialized) {
+	pthread_mutex_unlock (&pool.mutex);
+	return;
+    }
+
+    pool.shutdown = TRUE;
+    pthread_cond_broadcast (&pool.wakeup);
+    pthread_mutex_unlock (&pool.mutex);
+
+    for (i = 0; i < pool.num_workers; i++)
+	pthread_join (pool.workers[i], NULL);
+
+    pool.num_workers = 0;
+    pool.num_threads = 0;
+    pool.initialized = FALSE;
+}
+
+#else /* ! CAIRO_HAS_REAL_PTHREAD */
+
+int
+_cairo_thread_pool_get_num_threads (void)
+{
+    return 1;
+}
+
+void
+_cairo_thread_pool_run (cairo_thread_pool_func_t func,
+			void *tasks,
+			size_t task_size,
+			int num_tasks)
+{
+    int i;
+
+    for (i = 0; i < num_tasks; i++)
+	func ((char *) tasks + i * task_size);
+}
+
+cairo_thread_pool_job_t *
+_cairo_thread_pool_submit (cairo_thread_pool_func_t func,
+			   void *task)
+{
+    func (task);
+    return NULL;
+}
+
+void
+_cairo_thread_pool_wait (cairo_thread_pool_job_t *job)
+{
+}
+
+void
+_cairo_thread_pool_reset_static_data (void)
+{
+}
+
+#endif
@@ -102,6 +102,11 @@
 #include <limits.h>
 #include <setjmp.h>
 
+#if defined(__SSE2__)
+#define HAVE_TOR_SSE2 1
+#include <emmintrin.h>
+#endif
+
 /*-------------------------------------------------------------------------
  * cairo specific config
  */
@@ -118,6 +123,12 @@ typedef cairo_status_t glitter_status_t;
 #define GRID_X_BITS CAIRO_FIXED_FRAC_BITS
 #define GRID_Y 15
 
+/* Accumulate coverage into dense rows instead of the cell list when
+ * the clip is at most this many pixels wide per active edge. */
+#ifndef GLITTER_DENSE_WIDTH_PER_EDGE
+#define GLITTER_DENSE_WIDTH_PER_EDGE 64
+#endif
+
 /* Set glitter up to use a cairo span renderer to do the coverage
  * blitting. */
 struct pool;
@@ -362,6 +373,10 @@ struct polygon {
     struct edge **y_buckets;
     struct edge *y_buckets_embedded[64];
 
+    /* Sum of the clipped heights of all edges, from which the
+     * average number of active edges per row is estimated. */
+    int64_t edge_height;
+
     struct {
 	struct pool base[1];
 	struct edge embedded[32];
@@ -439,6 +454,22 @@ struct cell_pair {
     struct cell *cell2;
 };
 
+/* A dense row holds the same accumulators as the cell list in flat
+ * arrays indexed by pixel.  Finding a cell is then free, at the cost
+ * of scanning the touched part of the row when blitting.  Slot 0
+ * collects the covered height of all cells left of the clip and
+ * cells right of the clip are dropped. */
+struct dense_row {
+    int16_t *uncovered_area;
+    int16_t *covered_height;
+
+    int xmin, width;
+
+    /* The touched slots, empty if lo > hi. */
+    int lo, hi;
+    int dirty;
+};
+
 /* The active list contains edges in the current scan line ordered by
  * the x-coordinate of the intercept of the edge and the scan line. */
 struct active_list {
@@ -457,6 +488,7 @@ struct glitter_scan_converter {
     struct polygon	polygon[1];
     struct active_list	active[1];
     struct cell_list	coverages[1];
+    struct dense_row	dense[1];
 
     cairo_half_open_span_t *spans;
     cairo_half_open_span_t spans_embedded[64];
@@ -774,6 +806,41 @@ inline static void full_step (struct edge *e)
 }
 
 
+/* Advances the edge by a full pixel row and returns its x positions
+ * at the top and bottom of the row it has crossed. */
+inline static void
+edge_step_row (struct edge *edge,
+	       struct quorem *x1,
+	       struct quorem *x2)
+{
+    *x1 = edge->x;
+    full_step (edge);
+    *x2 = edge->x;
+
+    /* Step back from the sample location (half-subrow) to the pixel origin */
+    if (edge->dy) {
+	x1->quo -= edge->dxdy.quo / 2;
+	x1->rem -= edge->dxdy.rem / 2;
+	if (x1->rem < 0) {
+	    --x1->quo;
+	    x1->rem += edge->dy;
+	} else if (x1->rem >= edge->dy) {
+	    ++x1->quo;
+	    x1->rem -= edge->dy;
+	}
+
+	x2->quo -= edge->dxdy.quo / 2;
+	x2->rem -= edge->dxdy.rem / 2;
+	if (x2->rem < 0) {
+	    --x2->quo;
+	    x2->rem += edge->dy;
+	} else if (x2->rem >= edge->dy) {
+	    ++x2->quo;
+	    x2->rem -= edge->dy;
+	}
+    }
+}
+
 /* Adds the analytical coverage of an edge crossing the current pixel
  * row to the coverage cells and advances the edge's x position to the
  * following row.
@@ -800,32 +867,7 @@ cell_list_render_edge(struct cell_list *cells,
     grid_scaled_x_t fx1, fx2;
     int ix1, ix2;
 
-    x1 = edge->x;
-    full_step (edge);
-    x2 = edge->x;
-
-    /* Step back from the sample location (half-subrow) to the pixel origin */
-    if (edge->dy) {
-	x1.quo -= edge->dxdy.quo / 2;
-	x1.rem -= edge->dxdy.rem / 2;
-	if (x1.rem < 0) {
-	    --x1.quo;
-	    x1.rem += edge->dy;
-	} else if (x1.rem >= edge->dy) {
-	    ++x1.quo;
-	    x1.rem -= edge->dy;
-	}
-
-	x2.quo -= edge->dxdy.quo / 2;
-	x2.rem -= edge->dxdy.rem / 2;
-	if (x2.rem < 0) {
-	    --x2.quo;
-	    x2.rem += edge->dy;
-	} else if (x2.rem >= edge->dy) {
-	    ++x2.quo;
-	    x2.rem -= edge->dy;
-	}
-    }
+    edge_step_row (edge, &x1, &x2);
 
     GRID_X_TO_INT_FRAC(x1.quo, ix1, fx1);
     GRID_X_TO_INT_FRAC(x2.quo, ix2, fx2);
@@ -929,11 +971,197 @@ cell_list_render_edge(struct cell_list *cells,
     }
 }
 
+static void
+dense_row_init (struct dense_row *row)
+{
+    row->uncovered_area = NULL;
+    row->covered_height = NULL;
+    row->xmin = row->width = 0;
+    row->lo = INT_MAX;
+    row->hi = -1;
+    row->dirty = 0;
+}
+
+static void
+dense_row_fini (struct dense_row *row)
+{
+    free (row->uncovered_area);
+    dense_row_init (row);
+}
+
+/* Allocates a dense row spanning the pixels [xmin, xmax).  Returns
+ * FALSE if we ran out of memory, in which case the cell list should
+ * be used instead. */
+static int
+dense_row_alloc (struct dense_row *row, int xmin, int xmax)
+{
+    int width = xmax - xmin;
+
+    if (row->uncovered_area != NULL)
+	return row->xmin == xmin && row->width == width;
+
+    row->uncovered_area = calloc (2 * (width + 1), sizeof (int16_t));
+    if (unlikely (row->uncovered_area == NULL))
+	return 0;
+
+    row->covered_height = row->uncovered_area + width + 1;
+    row->xmin = xmin;
+    row->width = width;
+    return 1;
+}
+
+/* Empty the touched slots of the row.  This is called at the start
+ * of every pixel row. */
+inline static void
+dense_row_reset (struct dense_row *row)
+{
+    if (row->lo <= row->hi) {
+	int len = row->hi - row->lo + 1;
+
+	memset (row->uncovered_area + row->lo, 0, len * sizeof (int16_t));
+	memset (row->covered_height + row->lo, 0, len * sizeof (int16_t));
+    }
+
+    row->lo = INT_MAX;
+    row->hi = -1;
+    row->dirty = 0;
+}
+
+inline static void
+dense_row_add (struct dense_row *row, int x, int area, int height)
+{
+    int i = x - row->xmin + 1;
+
+    row->dirty = 1;
+    if (i > row->width)
+	return;
+    if (i < 0)
+	i = 0;
+
+    row->uncovered_area[i] += area;
+    row->covered_height[i] += height;
+
+    if (i < row->lo)
+	row->lo = i;
+    if (i > row->hi)
+	row->hi = i;
+}
+
+/* Add a subpixel span covering [x1, x2) to the dense row. */
+inline static void
+dense_row_add_subspan (struct dense_row *row,
+		       grid_scaled_x_t x1,
+		       grid_scaled_x_t x2)
+{
+    int ix1, fx1;
+    int ix2, fx2;
+
+    if (x1 == x2)
+	return;
+
+    GRID_X_TO_INT_FRAC(x1, ix1, fx1);
+    GRID_X_TO_INT_FRAC(x2, ix2, fx2);
+
+    if (ix1 != ix2) {
+	dense_row_add (row, ix1, 2*fx1, 1);
+	dense_row_add (row, ix2, -2*fx2, -1);
+    } else
+	dense_row_add (row, ix1, 2*(fx1-fx2), 0);
+}
+
+/* The dense row counterpart of cell_list_render_edge(), with the
+ * same preconditions but no restriction on the order of the edges. */
+static void
+dense_row_render_edge (struct dense_row *row,
+		       struct edge *edge,
+		       int sign)
+{
+    struct quorem x1, x2;
+    grid_scaled_x_t fx1, fx2;
+    int ix1, ix2;
+
+    edge_step_row (edge, &x1, &x2);
+
+    GRID_X_TO_INT_FRAC(x1.quo, ix1, fx1);
+    GRID_X_TO_INT_FRAC(x2.quo, ix2, fx2);
+
+    /* Edge is entirely within a column? */
+    if (ix1 == ix2) {
+	dense_row_add (row, ix1, sign*(fx1 + fx2)*GRID_Y, sign*GRID_Y);
+	return;
+    }
+
+    /* Orient the edge left-to-right. */
+    if (ix2 < ix1) {
+	struct quorem tx;
+	int t;
+
+	t = ix1;
+	ix1 = ix2;
+	ix2 = t;
+
+	t = fx1;
+	fx1 = fx2;
+	fx2 = t;
+
+	tx = x1;
+	x1 = x2;
+	x2 = tx;
+    }
+
+    /* Add coverage for all pixels [ix1,ix2] on this row crossed
+     * by the edge. */
+    {
+	struct quorem y;
+	int64_t tmp, dx;
+	int y_last;
+
+	dx = (x2.quo - x1.quo) * edge->dy + (x2.rem - x1.rem);
+
+	tmp = (ix1 + 1) * GRID_X * edge->dy;
+	tmp -= x1.quo * edge->dy + x1.rem;
+	tmp *= GRID_Y;
+
+	y.quo = tmp / dx;
+	y.rem = tmp % dx;
+
+	dense_row_add (row, ix1, sign*y.quo*(GRID_X + fx1), sign*y.quo);
+	y_last = y.quo;
+
+	if (ix1+1 < ix2) {
+	    struct quorem dydx_full;
+
+	    dydx_full.quo = GRID_Y * GRID_X * edge->dy / dx;
+	    dydx_full.rem = GRID_Y * GRID_X * edge->dy % dx;
+
+	    ++ix1;
+	    do {
+		y.quo += dydx_full.quo;
+		y.rem += dydx_full.rem;
+		if (y.rem >= dx) {
+		    y.quo++;
+		    y.rem -= dx;
+		}
+
+		dense_row_add (row, ix1,
+			       sign*(y.quo - y_last)*GRID_X,
+			       sign*(y.quo - y_last));
+		y_last = y.quo;
+	    } while (++ix1 != ix2);
+	}
+
+	dense_row_add (row, ix2,
+		       sign*(GRID_Y - y_last)*fx2,
+		       sign*(GRID_Y - y_last));
+    }
+}
+
 static void
 polygon_init (struct polygon *polygon, jmp_buf *jmp)
 {
     polygon->ymin = polygon->ymax = 0;
     polygon->y_buckets = polygon->y_buckets_embedded;
+    polygon->edge_height = 0;
     pool_init (polygon->edge_pool.base, jmp,
 	       8192 - sizeof (struct _pool_chunk),
 	       sizeof (polygon->edge_pool.embedded));
@@ -978,6 +1206,7 @@ polygon_reset (struct polygon *polygon,
 
     polygon->ymin = ymin;
     polygon->ymax = ymax;
+    polygon->edge_height = 0;
     return GLITTER_STATUS_SUCCESS;
 
 bail_no_mem:
@@ -1259,6 +1488,7 @@ static void step (struct edge *edge)
 inline static void
 sub_row (struct active_list *active,
 	 struct cell_list *coverages,
+	 struct dense_row *dense,
 	 unsigned int mask)
 {
     struct edge *edge = active->head.next;
@@ -1296,7 +1526,10 @@ sub_row (struct active_list *active,
 	winding += edge->dir;
 	if ((winding & mask) == 0) {
 	    if (next->cell != xend) {
-		cell_list_add_subspan (coverages, xstart, xend);
+		if (dense)
+		    dense_row_add_subspan (dense, xstart, xend);
+		else
+		    cell_list_add_subspan (coverages, xstart, xend);
 		xstart = INT_MIN;
 	    }
 	} else if (xstart == INT_MIN)
@@ -1319,6 +1552,7 @@ inline static void dec (struct active_list *a, struct edge *e, int h)
 static void
 full_row (struct active_list *active,
 	  struct cell_list *coverages,
+	  struct dense_row *dense,
 	  unsigned int mask)
 {
     struct edge *left = active->head.next;
@@ -1343,9 +1577,14 @@ full_row (struct active_list *active,
 	    right = right->next;
 	} while (1);
 
-	cell_list_set_rewind (coverages);
-	cell_list_render_edge (coverages, left, +1);
-	cell_list_render_edge (coverages, right, -1);
+	if (dense) {
+	    dense_row_render_edge (dense, left, +1);
+	    dense_row_render_edge (dense, right, -1);
+	} else {
+	    cell_list_set_rewind (coverages);
+	    cell_list_render_edge (coverages, left, +1);
+	    cell_list_render_edge (coverages, right, -1);
+	}
 
 	left = right->next;
     }
@@ -1357,6 +1596,7 @@ _glitter_scan_converter_init(glitter_scan_converter_t *converter, jmp_buf *jmp)
     polygon_init(converter->polygon, jmp);
     active_list_init(converter->active);
     cell_list_init(converter->coverages, jmp);
+    dense_row_init(converter->dense);
     converter->xmin=0;
     converter->ymin=0;
     converter->xmax=0;
@@ -1371,6 +1611,7 @@ _glitter_scan_converter_fini(glitter_scan_converter_t *self)
 
     polygon_fini(self->polygon);
     cell_list_fini(self->coverages);
+    dense_row_fini(self->dense);
 
     self->xmin=0;
     self->ymin=0;
@@ -1425,6 +1666,7 @@ glitter_scan_converter_reset(
 
     active_list_reset(converter->active);
     cell_list_reset(converter->coverages);
+    dense_row_fini(converter->dense);
     status = polygon_reset(converter->polygon, ymin, ymax);
     if (status)
 	return status;
@@ -1485,6 +1727,7 @@ polygon_add_edge (struct polygon *polygon,
 
     e->ytop = ytop;
     e->height_left = ybot - ytop;
+    polygon->edge_height += e->height_left;
     if (edge->line.p2.y > edge->line.p1.y) {
 	    e->dir = edge->dir;
 	    p1 = &edge->line.p1;
@@ -1713,6 +1956,187 @@ blit_a1 (struct cell_list *cells,
 }
 
 
+/* Replaces the covered heights of the touched slots with the coverage
+ * carried to the right of each pixel, and the uncovered areas with
+ * the coverage of the pixel itself.  The prefix sum wraps in 16 bits
+ * exactly as the cell list blitters do. */
+static void
+dense_row_resolve (struct dense_row *row)
+{
+    int16_t *cover = row->covered_height;
+    int16_t *area = row->uncovered_area;
+    int16_t sum = 0;
+    int i = row->lo, end = row->hi + 1;
+
+#if HAVE_TOR_SSE2
+    if (i + 8 <= end) {
+	const __m128i scale = _mm_set1_epi16 (GRID_X*2);
+	__m128i carry = _mm_setzero_si128 ();
+
+	do {
+	    __m128i h, c;
+
+	    h = _mm_loadu_si128 ((const __m128i *) (cover + i));
+	    h = _mm_add_epi16 (h, _mm_slli_si128 (h, 2));
+	    h = _mm_add_epi16 (h, _mm_slli_si128 (h, 4));
+	    h = _mm_add_epi16 (h, _mm_slli_si128 (h, 8));
+	    h = _mm_add_epi16 (h, carry);
+
+	    carry = _mm_shufflehi_epi16 (h, _MM_SHUFFLE (3, 3, 3, 3));
+	    carry = _mm_unpackhi_epi64 (carry, carry);
+
+	    c = _mm_mullo_epi16 (h, scale);
+	    _mm_storeu_si128 ((__m128i *) (cover + i), c);
+	    _mm_storeu_si128 ((__m128i *) (area + i),
+			      _mm_sub_epi16 (c, _mm_loadu_si128 ((const __m128i *) (area + i))));
+	    i += 8;
+	} while (i + 8 <= end);
+
+	sum = _mm_extract_epi16 (carry, 0);
+    }
+#endif
+
+    for (; i < end; i++) {
+	sum += cover[i];
+	cover[i] = sum * (GRID_X*2);
+	area[i] = cover[i] - area[i];
+    }
+}
+
+/* Returns the first slot in [i, end) whose coverage differs from v. */
+inline static int
+dense_row_skip (const int16_t *area, int i, int end, int16_t v)
+{
+#if HAVE_TOR_SSE2
+    const __m128i vv = _mm_set1_epi16 (v);
+
+    for (; i + 8 <= end; i += 8) {
+	__m128i eq;
+
+	eq = _mm_cmpeq_epi16 (_mm_loadu_si128 ((const __m128i *) (area + i)), vv);
+	if (_mm_movemask_epi8 (eq) != 0xffff)
+	    break;
+    }
+#endif
+
+    while (i < end && area[i] == v)
+	i++;
+
+    return i;
+}
+
+static glitter_status_t
+blit_dense_a8 (struct dense_row *row,
+	       cairo_span_renderer_t *renderer,
+	       cairo_half_open_span_t *spans,
+	       int y, int height)
+{
+    int16_t last_cover = 0;
+    unsigned num_spans = 0;
+
+    if (! row->dirty)
+	return CAIRO_STATUS_SUCCESS;
+
+    if (row->hi >= 0) {
+	const int16_t *area = row->uncovered_area;
+	int i, end = row->hi + 1;
+
+	dense_row_resolve (row);
+
+	/* Slot i holds pixel xmin + i - 1. */
+	for (i = MAX (row->lo, 1);
+	     (i = dense_row_skip (area, i, end, last_cover)) < end;
+	     i++)
+	{
+	    last_cover = area[i];
+	    spans[num_spans].x = row->xmin + i - 1;
+	    spans[num_spans].coverage = GRID_AREA_TO_ALPHA (last_cover);
+	    ++num_spans;
+	}
+
+	/* Past the last touched slot the coverage is constant. */
+	if (end <= row->width && row->covered_height[row->hi] != last_cover) {
+	    last_cover = row->covered_height[row->hi];
+	    spans[num_spans].x = row->xmin + end - 1;
+	    spans[num_spans].coverage = GRID_AREA_TO_ALPHA (last_cover);
+	    ++num_spans;
+	}
+
+	if (last_cover) {
+	    spans[num_spans].x = row->xmin + row->width;
+	    spans[num_spans].coverage = 0;
+	    ++num_spans;
+	}
+    }
+
+    /* Dump them into the renderer. */
+    return renderer->render_rows (renderer, y, height, spans, num_spans);
+}
+
+static glitter_status_t
+blit_dense_a1 (struct dense_row *row,
+	       cairo_span_renderer_t *renderer,
+	       cairo_half_open_span_t *spans,
+	       int y, int height)
+{
+    uint8_t coverage, last_cover = 0;
+    unsigned num_spans = 0;
+
+    if (! row->dirty)
+	return CAIRO_STATUS_SUCCESS;
+
+    if (row->hi >= 0) {
+	const int16_t *area = row->uncovered_area;
+	int16_t last_area = 0;
+	int i, end = row->hi + 1;
+
+	dense_row_resolve (row);
+
+	for (i = MAX (row->lo, 1);
+	     (i = dense_row_skip (area, i, end, last_area)) < end;
+	     i++)
+	{
+	    last_area = area[i];
+	    coverage = GRID_AREA_TO_A1 (last_area);
+	    if (coverage != last_cover) {
+		spans[num_spans].x = row->xmin + i - 1;
+		last_cover = spans[num_spans].coverage = coverage;
+		++num_spans;
+	    }
+	}
+
+	coverage = GRID_AREA_TO_A1 (row->covered_height[row->hi]);
+	if (end <= row->width && coverage != last_cover) {
+	    spans[num_spans].x = row->xmin + end - 1;
+	    last_cover = spans[num_spans].coverage = coverage;
+	    ++num_spans;
+	}
+
+	if (last_cover) {
+	    spans[num_spans].x = row->xmin + row->width;
+	    spans[num_spans].coverage = 0;
+	    ++num_spans;
+	}
+    }
+    if (num_spans == 1)
+	return CAIRO_STATUS_SUCCESS;
+
+    /* Dump them into the renderer. */
+    return renderer->render_rows (renderer, y, height, spans, num_spans);
+}
+
+/* The cell list pays for every cell it searches for and allocates,
+ * a dense row for every pixel of its width.  Prefer the latter when
+ * the polygon has enough active edges on average per pixel row. */
+static int
+dense_row_is_cheaper (glitter_scan_converter_t *converter, int width)
+{
+    int64_t area = (int64_t) width * (converter->ymax - converter->ymin);
+
+    return area <= GLITTER_DENSE_WIDTH_PER_EDGE * converter->polygon->edge_height;
+}
+
+
 I void
 glitter_scan_converter_render(glitter_scan_converter_t *converter,
 			      unsigned int winding_mask,
@@ -1726,6 +2150,7 @@ glitter_scan_converter_render(glitter_scan_converter_t *converter,
     int h = ymax_i - ymin_i;
     struct polygon *polygon = converter->polygon;
     struct cell_list *coverages = converter->coverages;
+    struct dense_row *dense = NULL;
     struct active_list *active = converter->active;
     struct edge *buckets[GRID_Y] = { 0 };
 
@@ -1734,6 +2159,10 @@ glitter_scan_converter_render(glitter_scan_converter_t *converter,
     if (xmin_i >= xmax_i)
 	return;
 
+    if (dense_row_is_cheaper (converter, xmax_i - xmin_i) &&
+	dense_row_alloc (converter->dense, xmin_i, xmax_i))
+	dense = converter->dense;
+
     /* Render each pixel row. */
     for (i = 0; i < h; i = j) {
 	int do_full_row = 0;
@@ -1764,7 +2193,7 @@ glitter_scan_converter_render(glitter_scan_converter_t *converter,
 
 	if (do_full_row) {
 	    /* Step by a full pixel row's worth. */
-	    full_row (active, coverages, winding_mask);
+	    full_row (active, coverages, dense, winding_mask);
 
 	    if (active->is_vertical) {
 		while (j < h &&
@@ -1786,17 +2215,27 @@ glitter_scan_converter_render(glitter_scan_converter_t *converter,
 		    active_list_merge_edges_from_bucket (active, buckets[sub]);
 		    buckets[sub] = NULL;
 		}
-		sub_row (active, coverages, winding_mask);
+		sub_row (active, coverages, dense, winding_mask);
 	    }
 	}
 
-	if (antialias)
-	    blit_a8 (coverages, renderer, converter->spans,
-		     i+ymin_i, j-i, xmin_i, xmax_i);
-	else
-	    blit_a1 (coverages, renderer, converter->spans,
-		     i+ymin_i, j-i, xmin_i, xmax_i);
-	cell_list_reset (coverages);
+	if (dense) {
+	    if (antialias)
+		blit_dense_a8 (dense, renderer, converter->spans,
+			       i+ymin_i, j-i);
+	    else
+		blit_dense_a1 (dense, renderer, converter->spans,
+			       i+ymin_i, j-i);
+	    dense_row_reset (dense);
+	} else {
+	    if (antialias)
+		blit_a8 (coverages, renderer, converter->spans,
+			 i+ymin_i, j-i, xmin_i, xmax_i);
+	    else
+		blit_a1 (coverages, renderer, converter->spans,
+			 i+ymin_i, j-i, xmin_i, xmax_i);
+	    cell_list_reset (coverages);
+	}
 
 	active->min_height -= GRID_Y;
     }
@@ -370,6 +370,11 @@ traps_get_clip_surface (const cairo_traps_compositor_t *compositor,
 
     TRACE ((stderr, "%s\n", __FUNCTION__));
 
+    surface = _cairo_clip_mask_cache_lookup (composite->surface, compositor,
+					     composite->clip, extents);
+    if (surface != NULL)
+	return surface;
+
     status = __clip_to_surface (compositor, composite, extents, &surface);
     if (status == CAIRO_INT_STATUS_UNSUPPORTED) {
 	surface = _cairo_surface_create_scratch (composite->surface,
@@ -385,9 +390,11 @@ traps_get_clip_surface (const cairo_traps_compositor_t *compositor,
     }
     if (unlikely (status)) {
 	cairo_surface_destroy (surface);
-	surface = _cairo_surface_create_in_error (status);
+	return _cairo_surface_create_in_error (status);
     }
 
+    _cairo_clip_mask_cache_insert (composite->surface, compositor,
+				   composite->clip, extents, surface);
     return surface;
 }
 
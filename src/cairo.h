@@ -1643,6 +1643,36 @@ cairo_public void
 cairo_scaled_font_get_font_options (cairo_scaled_font_t		*scaled_font,
 				    cairo_font_options_t	*options);
 
+/**
+ * cairo_glyph_cache_statistics_t:
+ * @size: number of bytes currently held by the glyph cache
+ * @max_size: the byte budget of the glyph cache
+ * @hits: number of glyph lookups satisfied by the cache
+ * @misses: number of glyph lookups that had to load the glyph
+ * @evictions: number of glyph pages expired to honour the budget
+ *
+ * A snapshot of the global glyph cache shared by all scaled fonts, as
+ * returned by cairo_glyph_cache_get_statistics().
+ *
+ * Since: 1.16
+ **/
+typedef struct _cairo_glyph_cache_statistics {
+    unsigned long size;
+    unsigned long max_size;
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long evictions;
+} cairo_glyph_cache_statistics_t;
+
+cairo_public void
+cairo_glyph_cache_set_max_size (unsigned long max_size);
+
+cairo_public unsigned long
+cairo_glyph_cache_get_max_size (void);
+
+cairo_public void
+cairo_glyph_cache_get_statistics (cairo_glyph_cache_statistics_t *stats);
+
 
 /* Toy fonts */
 
@@ -2090,6 +2120,12 @@ cairo_append_path (cairo_t		*cr,
 cairo_public void
 cairo_path_destroy (cairo_path_t *path);
 
+cairo_public void
+cairo_path_cache_set_max_size (unsigned long max_size);
+
+cairo_public unsigned long
+cairo_path_cache_get_max_size (void);
+
 /* Error status queries */
 
 cairo_public cairo_status_t
@@ -2570,6 +2606,22 @@ cairo_public cairo_bool_t
 cairo_recording_surface_get_extents (cairo_surface_t *surface,
 				     cairo_rectangle_t *extents);
 
+cairo_public cairo_status_t
+cairo_recording_surface_write_to_stream (cairo_surface_t	*surface,
+					 cairo_write_func_t	 write_func,
+					 void			*closure);
+
+cairo_public cairo_status_t
+cairo_recording_surface_write_to_file (cairo_surface_t	*surface,
+				       const char	*filename);
+
+cairo_public cairo_surface_t *
+cairo_recording_surface_create_for_data (const unsigned char	*data,
+					 unsigned long		 length);
+
+cairo_public cairo_surface_t *
+cairo_recording_surface_create_from_file (const char *filename);
+
 /* raster-source pattern (callback) functions */
 
 /**
@@ -0,0 +1,182 @@
+/*
+ * Copyright © 2026 the cairo authors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "cairo-test.h"
+
+/* When the antialiasing of a fill differs from that of the clip the
+ * two are scan converted separately and their coverages multiplied.
+ * Check that this matches painting the fill through a mask of the
+ * clip, for every pairing of the antialias modes.
+ */
+
+#define SIZE 64
+
+static void
+clip_shape (cairo_t *cr)
+{
+    cairo_arc (cr, SIZE / 2. + .3, SIZE / 2. - .2, SIZE / 2. - 6, 0, 2 * M_PI);
+    cairo_new_sub_path (cr);
+    cairo_arc (cr, SIZE / 2. + .3, SIZE / 2. - .2, SIZE / 5., 0, 2 * M_PI);
+}
+
+static void
+fill_shape (cairo_t *cr)
+{
+    cairo_move_to (cr, 3.5, 10.25);
+    cairo_line_to (cr, SIZE - 8.75, 4.5);
+    cairo_line_to (cr, SIZE / 2. + .5, SIZE - 2.25);
+    cairo_close_path (cr);
+    cairo_rectangle (cr, 20.25, 20.75, 30, 9.5);
+}
+
+static cairo_surface_t *
+draw_clipped (cairo_antialias_t clip, cairo_antialias_t fill)
+{
+    cairo_surface_t *image;
+    cairo_t *cr;
+
+    image = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, SIZE, SIZE);
+    cr = cairo_create (image);
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+
+    cairo_set_fill_rule (cr, CAIRO_FILL_RULE_EVEN_ODD);
+    cairo_set_antialias (cr, clip);
+    clip_shape (cr);
+    cairo_clip (cr);
+
+    cairo_set_fill_rule (cr, CAIRO_FILL_RULE_WINDING);
+    cairo_set_antialias (cr, fill);
+    cairo_set_source_rgba (cr, 0, 0, 1, .8);
+    fill_shape (cr);
+    cairo_fill (cr);
+
+    cairo_destroy (cr);
+    return image;
+}
+
+static cairo_surface_t *
+draw_masked (cairo_antialias_t clip, cairo_antialias_t fill)
+{
+    cairo_surface_t *image, *mask;
+    cairo_t *cr;
+
+    mask = cairo_image_surface_create (CAIRO_FORMAT_A8, SIZE, SIZE);
+    cr = cairo_create (mask);
+    cairo_set_fill_rule (cr, CAIRO_FILL_RULE_EVEN_ODD);
+    cairo_set_antialias (cr, clip);
+    clip_shape (cr);
+    cairo_fill (cr);
+    cairo_destroy (cr);
+
+    image = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, SIZE, SIZE);
+    cr = cairo_create (image);
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+
+    cairo_push_group (cr);
+    cairo_set_antialias (cr, fill);
+    cairo_set_source_rgba (cr, 0, 0, 1, .8);
+    fill_shape (cr);
+    cairo_fill (cr);
+    cairo_pop_group_to_source (cr);
+    cairo_mask_surface (cr, mask, 0, 0);
+
+    cairo_destroy (cr);
+    cairo_surface_destroy (mask);
+    return image;
+}
+
+static cairo_bool_t
+compare (cairo_test_context_t *ctx,
+	 cairo_surface_t *a,
+	 cairo_surface_t *b,
+	 cairo_antialias_t clip,
+	 cairo_antialias_t fill)
+{
+    const uint32_t *pa, *pb;
+    int stride, x, y, c;
+
+    cairo_surface_flush (a);
+    cairo_surface_flush (b);
+    pa = (const uint32_t *) cairo_image_surface_get_data (a);
+    pb = (const uint32_t *) cairo_image_surface_get_data (b);
+    stride = cairo_image_surface_get_stride (a) / sizeof (uint32_t);
+    for (y = 0; y < SIZE; y++) {
+	for (x = 0; x < SIZE; x++) {
+	    uint32_t va = pa[y * stride + x], vb = pb[y * stride + x];
+
+	    /* the group rounds once more than the clipped fill */
+	    for (c = 0; c < 32; c += 8) {
+		if (abs ((int) ((va >> c) & 0xff) - (int) ((vb >> c) & 0xff)) > 2) {
+		    cairo_test_log (ctx,
+				    "Error: pixel (%d, %d) is 0x%08x, expected 0x%08x (clip antialias %d, fill antialias %d)\n",
+				    x, y, vb, va, clip, fill);
+		    return FALSE;
+		}
+	    }
+	}
+    }
+
+    return TRUE;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    static const cairo_antialias_t modes[] = {
+	CAIRO_ANTIALIAS_DEFAULT,
+	CAIRO_ANTIALIAS_NONE,
+	CAIRO_ANTIALIAS_FAST,
+    };
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    unsigned int i, j;
+
+    for (i = 0; i < ARRAY_LENGTH (modes); i++) {
+	for (j = 0; j < ARRAY_LENGTH (modes); j++) {
+	    cairo_surface_t *expected, *clipped;
+
+	    /* matching modes intersect the polygons instead */
+	    if (i == j)
+		continue;
+
+	    expected = draw_masked (modes[i], modes[j]);
+	    clipped = draw_clipped (modes[i], modes[j]);
+
+	    if (! compare (ctx, expected, clipped, modes[i], modes[j]))
+		ret = CAIRO_TEST_FAILURE;
+
+	    cairo_surface_destroy (expected);
+	    cairo_surface_destroy (clipped);
+	}
+    }
+
+    return ret;
+}
+
+CAIRO_TEST (clip_fill_fused,
+	    "Check fills under a clip of differing antialias against masking",
+	    "clip, fill", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
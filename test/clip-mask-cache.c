@@ -0,0 +1,154 @@
+/*
+ * Copyright © 2026 the cairo authors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "cairo-test.h"
+
+/* Draws through a path clip may reuse the clip mask rendered for an
+ * earlier draw to the same target.  Replay a sequence of draws under
+ * repeated, changed and restored clips, and across a change of device
+ * offset, and check that the result matches performing each draw on a
+ * fresh copy of the target, where nothing can have been cached.
+ */
+
+#define SIZE 64
+#define NUM_STEPS 6
+
+static void
+background (cairo_t *cr)
+{
+    int i;
+
+    for (i = 0; i < SIZE; i += 8) {
+	cairo_rectangle (cr, i, 0, 4, SIZE);
+	cairo_rectangle (cr, 0, i, SIZE, 4);
+    }
+    cairo_set_source_rgb (cr, 0, .5, 0);
+    cairo_paint (cr);
+    cairo_set_source_rgb (cr, 1, 1, 0);
+    cairo_set_fill_rule (cr, CAIRO_FILL_RULE_EVEN_ODD);
+    cairo_fill (cr);
+}
+
+static void
+step (cairo_t *cr, int n)
+{
+    double cx = n == 3 ? SIZE / 2. + 5.5 : SIZE / 2. + .25;
+
+    cairo_save (cr);
+    cairo_arc (cr, cx, SIZE / 2. - .5, SIZE / 3., 0, 2 * M_PI);
+    cairo_clip (cr);
+
+    /* an unbounded operator needs the clip as a mask */
+    cairo_set_operator (cr, CAIRO_OPERATOR_IN);
+    cairo_set_source_rgba (cr, 1, 0, n / (double) NUM_STEPS, .75);
+    cairo_rectangle (cr, 4 + 3 * n, 6 + 2 * n, SIZE / 2., SIZE / 3.);
+    cairo_fill (cr);
+    cairo_restore (cr);
+}
+
+static void
+set_offset (cairo_surface_t *surface, int n)
+{
+    /* the last two steps are drawn with the target offset */
+    if (n >= NUM_STEPS - 2)
+	cairo_surface_set_device_offset (surface, 3, -2);
+}
+
+static cairo_surface_t *
+copy (cairo_surface_t *src)
+{
+    cairo_surface_t *dst;
+    cairo_t *cr;
+
+    dst = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, SIZE, SIZE);
+    cr = cairo_create (dst);
+    cairo_set_source_surface (cr, src, 0, 0);
+    cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+    cairo_paint (cr);
+    cairo_destroy (cr);
+
+    return dst;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_surface_t *cached, *expected;
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    const uint32_t *pa, *pb;
+    int n, x, y, stride;
+    cairo_t *cr;
+
+    cached = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, SIZE, SIZE);
+    cr = cairo_create (cached);
+    background (cr);
+    cairo_destroy (cr);
+
+    expected = copy (cached);
+
+    for (n = 0; n < NUM_STEPS; n++) {
+	cairo_surface_t *fresh;
+
+	set_offset (cached, n);
+	cr = cairo_create (cached);
+	step (cr, n);
+	cairo_destroy (cr);
+
+	/* copy before offsetting so that the pixels line up */
+	fresh = copy (expected);
+	cairo_surface_destroy (expected);
+	set_offset (fresh, n);
+	cr = cairo_create (fresh);
+	step (cr, n);
+	cairo_destroy (cr);
+	expected = fresh;
+    }
+
+    cairo_surface_flush (cached);
+    cairo_surface_flush (expected);
+    pa = (const uint32_t *) cairo_image_surface_get_data (expected);
+    pb = (const uint32_t *) cairo_image_surface_get_data (cached);
+    stride = cairo_image_surface_get_stride (cached) / sizeof (uint32_t);
+    for (y = 0; y < SIZE && ret == CAIRO_TEST_SUCCESS; y++) {
+	for (x = 0; x < SIZE; x++) {
+	    if (pa[y * stride + x] != pb[y * stride + x]) {
+		cairo_test_log (ctx,
+				"Error: pixel (%d, %d) is 0x%08x, expected 0x%08x\n",
+				x, y, pb[y * stride + x], pa[y * stride + x]);
+		ret = CAIRO_TEST_FAILURE;
+		break;
+	    }
+	}
+    }
+
+    cairo_surface_destroy (cached);
+    cairo_surface_destroy (expected);
+    return ret;
+}
+
+CAIRO_TEST (clip_mask_cache,
+	    "Check draws sharing a cached clip mask against uncached draws",
+	    "clip", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
@@ -0,0 +1,97 @@
+/*
+ * Copyright © 2026 the cairo authors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Helpers shared by the tests that check antialiased coverage
+ * against a fine supersampling of the exact shape.
+ */
+
+#ifndef COVERAGE_CHECK_H
+#define COVERAGE_CHECK_H
+
+/* Returns whether the point (x, y) lies inside the shape. */
+typedef cairo_bool_t
+(*coverage_inside_func_t) (const void *closure, double x, double y);
+
+static int
+coverage_expected_alpha (coverage_inside_func_t inside,
+			 const void *closure,
+			 int samples,
+			 int px, int py)
+{
+    int i, j, n = 0;
+
+    for (j = 0; j < samples; j++) {
+	for (i = 0; i < samples; i++) {
+	    if (inside (closure,
+			px + (i + .5) / samples,
+			py + (j + .5) / samples))
+	    {
+		n++;
+	    }
+	}
+    }
+
+    return (n * 255 + samples * samples / 2) / (samples * samples);
+}
+
+/* Compares each pixel of the A8 @surface with the fraction of
+ * samples x samples points inside the shape, and logs the first
+ * pixel of each row that is further than @tolerance from it. */
+static cairo_test_status_t
+coverage_check (cairo_test_context_t *ctx,
+		const char *name,
+		cairo_surface_t *surface,
+		coverage_inside_func_t inside,
+		const void *closure,
+		int samples,
+		int tolerance)
+{
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    const uint8_t *data;
+    int x, y, width, height, stride;
+
+    cairo_surface_flush (surface);
+    data = cairo_image_surface_get_data (surface);
+    width = cairo_image_surface_get_width (surface);
+    height = cairo_image_surface_get_height (surface);
+    stride = cairo_image_surface_get_stride (surface);
+    for (y = 0; y < height; y++) {
+	for (x = 0; x < width; x++) {
+	    int expected = coverage_expected_alpha (inside, closure,
+						    samples, x, y);
+	    int alpha = data[y * stride + x];
+
+	    if (abs (alpha - expected) > tolerance) {
+		cairo_test_log (ctx,
+				"Error: %s: pixel (%d, %d) is %d, expected %d\n",
+				name, x, y, alpha, expected);
+		ret = CAIRO_TEST_FAILURE;
+		break;
+	    }
+	}
+    }
+
+    return ret;
+}
+
+#endif /* COVERAGE_CHECK_H */
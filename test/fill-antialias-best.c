@@ -0,0 +1,170 @@
+/*
+ * Copyright © 2026 the cairo authors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "cairo-test.h"
+#include "coverage-check.h"
+
+/* CAIRO_ANTIALIAS_GOOD and BEST compute the exact area of each pixel
+ * covered by the fill, rather than counting samples on a grid.
+ * Check the coverage of a few awkward shapes, including edges that
+ * cross inside a pixel and overlapping windings, against a fine
+ * supersampling of the same polygons.
+ *
+ * The {255/127} stars cross more than 1024 times within the rows
+ * around their centre, beyond which the converter only orders the
+ * edges within slices of a 64th of a pixel; they are held to the
+ * same tolerance.
+ */
+
+#define SIZE 16
+#define SAMPLES 128
+#define TOLERANCE 3
+
+#define MAX_POINTS 255
+
+struct shape {
+    const char *name;
+    cairo_fill_rule_t fill_rule;
+    int num_points;
+    double points[MAX_POINTS][2];
+};
+
+static const struct shape shapes[] = {
+    { "triangle", CAIRO_FILL_RULE_WINDING, 3,
+      { { 1.3, .7 }, { 14.6, 3.2 }, { 4.1, 15.4 } } },
+    { "bowtie", CAIRO_FILL_RULE_WINDING, 4,
+      { { .5, .5 }, { 15.5, 12.7 }, { 15.5, .5 }, { .5, 12.7 } } },
+    { "sliver", CAIRO_FILL_RULE_WINDING, 4,
+      { { .2, 1.1 }, { 15.8, 14.3 }, { 15.8, 14.6 }, { .2, 1.3 } } },
+    { "star", CAIRO_FILL_RULE_WINDING, 5,
+      { { 8, .5 }, { 12.4, 14.6 }, { .9, 5.6 }, { 15.1, 5.6 }, { 3.6, 14.6 } } },
+    { "star", CAIRO_FILL_RULE_EVEN_ODD, 5,
+      { { 8, .5 }, { 12.4, 14.6 }, { .9, 5.6 }, { 15.1, 5.6 }, { 3.6, 14.6 } } },
+};
+
+/* The star polygon {n/k} inscribed in the surface. */
+static void
+star (struct shape *s, const char *name, cairo_fill_rule_t fill_rule,
+      int n, int k)
+{
+    int i;
+
+    s->name = name;
+    s->fill_rule = fill_rule;
+    s->num_points = n;
+    for (i = 0; i < n; i++) {
+	double theta = 2 * M_PI * i * k / n;
+
+	s->points[i][0] = SIZE / 2. + 7.6 * sin (theta);
+	s->points[i][1] = SIZE / 2. - 7.6 * cos (theta);
+    }
+}
+
+static cairo_bool_t
+inside (const void *closure, double x, double y)
+{
+    const struct shape *s = closure;
+    int i, w = 0;
+
+    for (i = 0; i < s->num_points; i++) {
+	const double *p = s->points[i];
+	const double *q = s->points[(i + 1) % s->num_points];
+	double cross = (q[0] - p[0]) * (y - p[1]) - (x - p[0]) * (q[1] - p[1]);
+
+	if (p[1] <= y && q[1] > y && cross > 0)
+	    w++;
+	else if (q[1] <= y && p[1] > y && cross < 0)
+	    w--;
+    }
+
+    return s->fill_rule == CAIRO_FILL_RULE_WINDING ? w != 0 : w & 1;
+}
+
+static cairo_test_status_t
+check_shape (cairo_test_context_t *ctx,
+	     const struct shape *s,
+	     cairo_antialias_t antialias)
+{
+    cairo_test_status_t ret;
+    cairo_surface_t *surface;
+    cairo_t *cr;
+    char *name;
+    int i;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_A8, SIZE, SIZE);
+    cr = cairo_create (surface);
+    cairo_set_antialias (cr, antialias);
+    cairo_set_fill_rule (cr, s->fill_rule);
+    for (i = 0; i < s->num_points; i++)
+	cairo_line_to (cr, s->points[i][0], s->points[i][1]);
+    cairo_close_path (cr);
+    cairo_fill (cr);
+    cairo_destroy (cr);
+
+    xasprintf (&name, "%s (%s, antialias %d)",
+	       s->name,
+	       s->fill_rule == CAIRO_FILL_RULE_WINDING ? "winding" : "even-odd",
+	       antialias);
+    ret = coverage_check (ctx, name, surface, inside, s,
+			  SAMPLES, TOLERANCE);
+    free (name);
+
+    cairo_surface_destroy (surface);
+    return ret;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    static struct shape stars[4];
+    int i;
+
+    star (&stars[0], "{61/30} star", CAIRO_FILL_RULE_WINDING, 61, 30);
+    star (&stars[1], "{61/30} star", CAIRO_FILL_RULE_EVEN_ODD, 61, 30);
+    star (&stars[2], "{255/127} star", CAIRO_FILL_RULE_WINDING, 255, 127);
+    star (&stars[3], "{255/127} star", CAIRO_FILL_RULE_EVEN_ODD, 255, 127);
+
+    for (i = 0; i < ARRAY_LENGTH (shapes); i++) {
+	if (check_shape (ctx, &shapes[i], CAIRO_ANTIALIAS_GOOD))
+	    ret = CAIRO_TEST_FAILURE;
+	if (check_shape (ctx, &shapes[i], CAIRO_ANTIALIAS_BEST))
+	    ret = CAIRO_TEST_FAILURE;
+    }
+
+    for (i = 0; i < ARRAY_LENGTH (stars); i++) {
+	if (check_shape (ctx, &stars[i], CAIRO_ANTIALIAS_GOOD))
+	    ret = CAIRO_TEST_FAILURE;
+	if (check_shape (ctx, &stars[i], CAIRO_ANTIALIAS_BEST))
+	    ret = CAIRO_TEST_FAILURE;
+    }
+
+    return ret;
+}
+
+CAIRO_TEST (fill_antialias_best,
+	    "Check the exact area coverage of antialiased fills",
+	    "fill, antialias", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
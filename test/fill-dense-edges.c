@@ -0,0 +1,116 @@
+/*
+ * Copyright © 2026 the cairo authors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "cairo-test.h"
+
+/* Rasterising a path with many edges per pixel row may accumulate
+ * coverage in dense rows rather than in a sparse list of cells.  Fill
+ * a block of small triangles as a single path, and compare it to
+ * filling each triangle along with a far away pixel, which makes the
+ * rows too sparse for dense accumulation.  The coverage of each
+ * pixel is computed exactly either way, so the results must match.
+ */
+
+#define WIDTH 1024
+#define CELL 8
+#define CELLS 8
+
+static void
+triangle (cairo_t *cr, int i, int j)
+{
+    double x = i * CELL + .5, y = j * CELL + .5;
+    double s = CELL - 1;
+
+    cairo_move_to (cr, x + s * ((i * 5 + j * 3) % 7) / 6., y);
+    cairo_line_to (cr, x + s, y + s * ((i + j * 7) % 5) / 4.);
+    cairo_line_to (cr, x + s * ((i * 3 + j) % 4) / 3. * .7, y + s);
+    cairo_close_path (cr);
+}
+
+static cairo_surface_t *
+draw (cairo_bool_t single_path)
+{
+    cairo_surface_t *surface;
+    cairo_t *cr;
+    int i, j;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_RGB24,
+					  WIDTH, CELL * CELLS);
+    cr = cairo_create (surface);
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+    cairo_set_source_rgb (cr, 0, 0, 0);
+
+    for (j = 0; j < CELLS; j++) {
+	for (i = 0; i < CELLS; i++) {
+	    triangle (cr, i, j);
+	    if (! single_path) {
+		cairo_rectangle (cr, WIDTH - 1, j * CELL, 1, 1);
+		cairo_fill (cr);
+	    }
+	}
+    }
+    if (single_path)
+	cairo_fill (cr);
+
+    cairo_destroy (cr);
+    return surface;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_surface_t *dense, *sparse;
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    const uint32_t *pa, *pb;
+    int x, y, stride;
+
+    dense = draw (TRUE);
+    sparse = draw (FALSE);
+
+    pa = (const uint32_t *) cairo_image_surface_get_data (sparse);
+    pb = (const uint32_t *) cairo_image_surface_get_data (dense);
+    stride = cairo_image_surface_get_stride (dense) / sizeof (uint32_t);
+    for (y = 0; y < CELL * CELLS && ret == CAIRO_TEST_SUCCESS; y++) {
+	for (x = 0; x < CELL * CELLS; x++) {
+	    if (pa[y * stride + x] != pb[y * stride + x]) {
+		cairo_test_log (ctx,
+				"Error: pixel (%d, %d) is 0x%08x, expected 0x%08x\n",
+				x, y, pb[y * stride + x], pa[y * stride + x]);
+		ret = CAIRO_TEST_FAILURE;
+		break;
+	    }
+	}
+    }
+
+    cairo_surface_destroy (dense);
+    cairo_surface_destroy (sparse);
+    return ret;
+}
+
+CAIRO_TEST (fill_dense_edges,
+	    "Check fills accumulated in dense rows against sparse fills",
+	    "fill", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
@@ -0,0 +1,164 @@
+/*
+ * Copyright © 2026 the cairo authors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "cairo-test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* With CAIRO_RENDER_THREADS set, large fills are scan converted in
+ * horizontal bands on the thread pool.  Check that the result is
+ * bit-identical to rendering the same fill serially, which we force
+ * by clipping to strips too short to be split.
+ */
+
+#define SIZE 600
+#define STRIP 100
+
+static void
+draw_fill (cairo_t *cr, cairo_antialias_t antialias, cairo_bool_t gradient)
+{
+    cairo_pattern_t *pattern;
+    int i;
+
+    cairo_set_antialias (cr, antialias);
+
+    if (gradient) {
+	pattern = cairo_pattern_create_linear (0, 0, SIZE, 0);
+	cairo_pattern_add_color_stop_rgba (pattern, 0, 1, 0, 0, .9);
+	cairo_pattern_add_color_stop_rgba (pattern, 1, 0, 0, 1, .6);
+	cairo_set_source (cr, pattern);
+	cairo_pattern_destroy (pattern);
+    } else {
+	cairo_set_source_rgba (cr, 0, .5, 0, .8);
+    }
+
+    /* a star of long thin spikes, crossing every band */
+    for (i = 0; i < 23; i++) {
+	double a = i * 11 * 2 * M_PI / 23;
+
+	cairo_line_to (cr,
+		       SIZE / 2. + .3 + (SIZE / 2. - 7) * sin (a),
+		       SIZE / 2. - .2 - (SIZE / 2. - 5) * cos (a));
+    }
+    cairo_close_path (cr);
+    cairo_new_sub_path (cr);
+    cairo_arc (cr, SIZE / 3., SIZE / 2., SIZE / 4. + .7, 0, 2 * M_PI);
+    cairo_fill (cr);
+}
+
+static cairo_surface_t *
+draw (cairo_antialias_t antialias, cairo_bool_t gradient, cairo_bool_t strips)
+{
+    cairo_surface_t *image;
+    cairo_t *cr;
+    int y;
+
+    image = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, SIZE, SIZE);
+    cr = cairo_create (image);
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+
+    if (strips) {
+	for (y = 0; y < SIZE; y += STRIP) {
+	    cairo_save (cr);
+	    cairo_rectangle (cr, 0, y, SIZE, STRIP);
+	    cairo_clip (cr);
+	    draw_fill (cr, antialias, gradient);
+	    cairo_restore (cr);
+	}
+    } else {
+	draw_fill (cr, antialias, gradient);
+    }
+
+    cairo_destroy (cr);
+    return image;
+}
+
+static cairo_bool_t
+compare (cairo_test_context_t *ctx,
+	 cairo_surface_t *a,
+	 cairo_surface_t *b,
+	 cairo_antialias_t antialias,
+	 cairo_bool_t gradient)
+{
+    const uint8_t *pa, *pb;
+    int stride, y;
+
+    cairo_surface_flush (a);
+    cairo_surface_flush (b);
+    pa = cairo_image_surface_get_data (a);
+    pb = cairo_image_surface_get_data (b);
+    stride = cairo_image_surface_get_stride (a);
+    for (y = 0; y < SIZE; y++) {
+	if (memcmp (pa + y * stride, pb + y * stride, 4 * SIZE)) {
+	    cairo_test_log (ctx,
+			    "Error: row %d differs from the serial fill (antialias %d, %s source)\n",
+			    y, antialias, gradient ? "gradient" : "solid");
+	    return FALSE;
+	}
+    }
+
+    return TRUE;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    static const cairo_antialias_t modes[] = {
+	CAIRO_ANTIALIAS_DEFAULT,
+	CAIRO_ANTIALIAS_GOOD,
+	CAIRO_ANTIALIAS_BEST,
+    };
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    unsigned int i, gradient;
+
+#ifndef _WIN32
+    /* the pool is sized on first use; keep any setting of the user */
+    setenv ("CAIRO_RENDER_THREADS", "4", 0);
+#endif
+
+    for (i = 0; i < ARRAY_LENGTH (modes); i++) {
+	for (gradient = 0; gradient <= 1; gradient++) {
+	    cairo_surface_t *serial, *banded;
+
+	    serial = draw (modes[i], gradient, TRUE);
+	    banded = draw (modes[i], gradient, FALSE);
+
+	    if (! compare (ctx, serial, banded, modes[i], gradient))
+		ret = CAIRO_TEST_FAILURE;
+
+	    cairo_surface_destroy (serial);
+	    cairo_surface_destroy (banded);
+	}
+    }
+
+    return ret;
+}
+
+CAIRO_TEST (fill_threaded_bands,
+	    "Check that fills split into bands match serial rendering",
+	    "fill, thread", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
@@ -0,0 +1,112 @@
+/*
+ * Copyright © 2026 the cairo authors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "cairo-test.h"
+
+/* Exercise the byte budget of the global glyph cache: glyphs that are no
+ * longer in use must be released as soon as the budget is lowered, and
+ * showing the same text twice must be served from the cache.
+ */
+
+#define TEXT "the five boxing wizards jump quickly"
+
+static void
+show_text (cairo_t *cr)
+{
+    cairo_select_font_face (cr, CAIRO_TEST_FONT_FAMILY " Sans",
+			    CAIRO_FONT_SLANT_NORMAL,
+			    CAIRO_FONT_WEIGHT_NORMAL);
+    cairo_set_font_size (cr, 12);
+    cairo_move_to (cr, 1, 12);
+    cairo_show_text (cr, TEXT);
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t status = CAIRO_TEST_SUCCESS;
+    cairo_glyph_cache_statistics_t before, after;
+    unsigned long max_size;
+    cairo_surface_t *surface;
+    cairo_t *cr;
+
+    max_size = cairo_glyph_cache_get_max_size ();
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, 256, 16);
+    cr = cairo_create (surface);
+
+    show_text (cr);
+    cairo_glyph_cache_get_statistics (&before);
+    show_text (cr);
+    cairo_glyph_cache_get_statistics (&after);
+
+    if (after.misses != before.misses) {
+	cairo_test_log (ctx, "Repeated text missed the glyph cache %lu times\n",
+			after.misses - before.misses);
+	status = CAIRO_TEST_FAILURE;
+	goto done;
+    }
+
+    if (after.size == 0) {
+	cairo_test_log (ctx, "Glyph cache is empty after showing text\n");
+	status = CAIRO_TEST_FAILURE;
+	goto done;
+    }
+
+    cairo_glyph_cache_set_max_size (0);
+    if (cairo_glyph_cache_get_max_size () != 0) {
+	cairo_test_log (ctx, "Glyph cache budget was not updated\n");
+	status = CAIRO_TEST_FAILURE;
+	goto done;
+    }
+
+    cairo_glyph_cache_get_statistics (&after);
+    if (after.size != 0 || after.evictions == before.evictions) {
+	cairo_test_log (ctx, "Glyph cache still holds %lu bytes (%lu evictions) after emptying its budget\n",
+			after.size, after.evictions - before.evictions);
+	status = CAIRO_TEST_FAILURE;
+	goto done;
+    }
+
+    /* Rendering must keep working with no budget at all. */
+    show_text (cr);
+    if (cairo_status (cr)) {
+	status = cairo_test_status_from_status (ctx, cairo_status (cr));
+	goto done;
+    }
+
+done:
+    cairo_glyph_cache_set_max_size (max_size);
+
+    cairo_destroy (cr);
+    cairo_surface_destroy (surface);
+
+    return status;
+}
+
+CAIRO_TEST (glyph_cache_budget,
+	    "Check the byte budget and statistics of the global glyph cache",
+	    "font", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
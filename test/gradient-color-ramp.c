@@ -0,0 +1,166 @@
+/*
+ * Copyright © 2026 the cairo authors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "cairo-test.h"
+
+/* Small linear and concentric radial gradients with the FAST filter are
+ * drawn from a color ramp rather than by pixman.  Check them against
+ * pixman, which draws the same gradients with the default filter, in
+ * particular that a hard stop on a long gradient stays where it is.
+ */
+
+#define WIDTH 1100
+#define HEIGHT 300
+#define STRIP 100
+#define TOLERANCE 2
+
+struct gradient {
+    const char *name;
+    cairo_bool_t radial;
+    double length;
+    int num_stops;
+    double stops[4][4]; /* offset, red, green, blue */
+};
+
+static const struct gradient gradients[] = {
+    { "long hard stop", FALSE, WIDTH, 4,
+      { { 0, 1, 0, 0 }, { .5, 1, 1, 0 }, { .5, 0, 0, 1 }, { 1, 0, 1, 1 } } },
+    { "long", FALSE, WIDTH, 3,
+      { { 0, 1, 0, 0 }, { .4, 0, 1, 0 }, { 1, 0, 0, 1 } } },
+    { "short", FALSE, 300, 3,
+      { { 0, 1, 0, 0 }, { .4, 0, 1, 0 }, { 1, 0, 0, 1 } } },
+    { "radial", TRUE, 280, 2,
+      { { 0, 1, 1, 1 }, { 1, 0, 0, 0 } } },
+};
+
+static void
+draw_gradient (cairo_t *cr, const struct gradient *g, cairo_filter_t filter)
+{
+    cairo_pattern_t *pattern;
+    int i;
+
+    if (g->radial)
+	pattern = cairo_pattern_create_radial (WIDTH / 2., HEIGHT / 2., 0,
+					       WIDTH / 2., HEIGHT / 2., g->length);
+    else
+	pattern = cairo_pattern_create_linear (0, 0, g->length, HEIGHT / 7.);
+    cairo_pattern_set_extend (pattern, CAIRO_EXTEND_REFLECT);
+    cairo_pattern_set_filter (pattern, filter);
+    for (i = 0; i < g->num_stops; i++) {
+	cairo_pattern_add_color_stop_rgb (pattern, g->stops[i][0],
+					  g->stops[i][1],
+					  g->stops[i][2],
+					  g->stops[i][3]);
+    }
+
+    cairo_set_source (cr, pattern);
+    cairo_paint (cr);
+    cairo_pattern_destroy (pattern);
+}
+
+static cairo_surface_t *
+draw (const struct gradient *g, cairo_bool_t strips)
+{
+    cairo_surface_t *image;
+    cairo_t *cr;
+    int y;
+
+    image = cairo_image_surface_create (CAIRO_FORMAT_RGB24, WIDTH, HEIGHT);
+    cr = cairo_create (image);
+
+    if (strips) {
+	/* each strip is small enough to be drawn from the ramp */
+	for (y = 0; y < HEIGHT; y += STRIP) {
+	    cairo_save (cr);
+	    cairo_rectangle (cr, 0, y, WIDTH, STRIP);
+	    cairo_clip (cr);
+	    draw_gradient (cr, g, CAIRO_FILTER_FAST);
+	    cairo_restore (cr);
+	}
+    } else {
+	draw_gradient (cr, g, CAIRO_FILTER_GOOD);
+    }
+
+    cairo_destroy (cr);
+    return image;
+}
+
+static cairo_test_status_t
+check_gradient (cairo_test_context_t *ctx, const struct gradient *g)
+{
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    cairo_surface_t *expected, *ramp;
+    const uint32_t *pa, *pb;
+    int stride, x, y, c;
+
+    expected = draw (g, FALSE);
+    ramp = draw (g, TRUE);
+
+    cairo_surface_flush (expected);
+    cairo_surface_flush (ramp);
+    pa = (const uint32_t *) cairo_image_surface_get_data (expected);
+    pb = (const uint32_t *) cairo_image_surface_get_data (ramp);
+    stride = cairo_image_surface_get_stride (expected) / sizeof (uint32_t);
+    for (y = 0; y < HEIGHT && ret == CAIRO_TEST_SUCCESS; y++) {
+	for (x = 0; x < WIDTH; x++) {
+	    uint32_t va = pa[y * stride + x], vb = pb[y * stride + x];
+
+	    for (c = 0; c < 24; c += 8) {
+		if (abs ((int) ((va >> c) & 0xff) - (int) ((vb >> c) & 0xff)) > TOLERANCE)
+		    break;
+	    }
+	    if (c < 24) {
+		cairo_test_log (ctx,
+				"Error: %s gradient: pixel (%d, %d) is 0x%06x, expected 0x%06x\n",
+				g->name, x, y, vb & 0xffffff, va & 0xffffff);
+		ret = CAIRO_TEST_FAILURE;
+		break;
+	    }
+	}
+    }
+
+    cairo_surface_destroy (expected);
+    cairo_surface_destroy (ramp);
+    return ret;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_LENGTH (gradients); i++) {
+	if (check_gradient (ctx, &gradients[i]))
+	    ret = CAIRO_TEST_FAILURE;
+    }
+
+    return ret;
+}
+
+CAIRO_TEST (gradient_color_ramp,
+	    "Check gradients drawn from a color ramp against pixman",
+	    "gradient, linear, radial", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
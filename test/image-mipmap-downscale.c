@@ -0,0 +1,128 @@
+/*
+ * Copyright © 2026 the cairo authors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "cairo-test.h"
+
+/* Check that heavy GOOD/BEST downscales of an image average the whole
+ * source (rather than aliasing as a clamped convolution would), and that
+ * the cached reduction is discarded when the source is modified.
+ */
+
+#define SRC_SIZE 1024
+#define DST_SIZE 16
+
+/* Half white, half black vertical stripes with a period of the scale
+ * factor, placed such that a convolution clamped to 16 pixels around
+ * each sample only sees white. */
+static cairo_surface_t *
+create_stripes (void)
+{
+    cairo_surface_t *image;
+    uint32_t *data;
+    int stride, x, y;
+
+    image = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, SRC_SIZE, SRC_SIZE);
+    cairo_surface_flush (image);
+    data = (uint32_t *) cairo_image_surface_get_data (image);
+    stride = cairo_image_surface_get_stride (image) / sizeof (uint32_t);
+    for (y = 0; y < SRC_SIZE; y++) {
+	for (x = 0; x < SRC_SIZE; x++)
+	    data[y * stride + x] = ((x + 16) & 63) < 32 ? 0xff000000 : 0xffffffff;
+    }
+    cairo_surface_mark_dirty (image);
+
+    return image;
+}
+
+static cairo_bool_t
+check_result (cairo_test_context_t *ctx,
+	      cairo_surface_t *source,
+	      cairo_filter_t filter,
+	      int expected)
+{
+    cairo_surface_t *result;
+    cairo_t *cr;
+    uint32_t *data;
+    int stride, x, y;
+    cairo_bool_t ok = TRUE;
+
+    result = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, DST_SIZE, DST_SIZE);
+    cr = cairo_create (result);
+    cairo_scale (cr, (double) DST_SIZE / SRC_SIZE, (double) DST_SIZE / SRC_SIZE);
+    cairo_set_source_surface (cr, source, 0, 0);
+    cairo_pattern_set_filter (cairo_get_source (cr), filter);
+    cairo_paint (cr);
+    cairo_destroy (cr);
+
+    cairo_surface_flush (result);
+    data = (uint32_t *) cairo_image_surface_get_data (result);
+    stride = cairo_image_surface_get_stride (result) / sizeof (uint32_t);
+    for (y = 0; y < DST_SIZE && ok; y++) {
+	for (x = 0; x < DST_SIZE && ok; x++) {
+	    uint32_t pixel = data[y * stride + x];
+	    int green = (pixel >> 8) & 0xff;
+
+	    if (abs (green - expected) > 2) {
+		cairo_test_log (ctx,
+				"Error: pixel (%d, %d) is 0x%08x, expected green %d (filter %d)\n",
+				x, y, pixel, expected, filter);
+		ok = FALSE;
+	    }
+	}
+    }
+
+    cairo_surface_destroy (result);
+    return ok;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_surface_t *source;
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    cairo_t *cr;
+
+    source = create_stripes ();
+    if (! check_result (ctx, source, CAIRO_FILTER_GOOD, 0x80) ||
+	! check_result (ctx, source, CAIRO_FILTER_BEST, 0x80))
+	ret = CAIRO_TEST_FAILURE;
+
+    /* Modifying the source must invalidate the reduced copies. */
+    cr = cairo_create (source);
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+    cairo_destroy (cr);
+
+    if (! check_result (ctx, source, CAIRO_FILTER_GOOD, 0xff))
+	ret = CAIRO_TEST_FAILURE;
+
+    cairo_surface_destroy (source);
+    return ret;
+}
+
+CAIRO_TEST (image_mipmap_downscale,
+	    "Check heavy downscales of images with the GOOD and BEST filters",
+	    "image, filter", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
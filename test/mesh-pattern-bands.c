@@ -0,0 +1,153 @@
+/*
+ * Copyright © 2026 the cairo authors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "cairo-test.h"
+
+/* With CAIRO_RENDER_THREADS set, tall meshes are rasterized in bands
+ * of rows on the thread pool.  Check a mesh drawn at once, and so in
+ * bands, against the same mesh drawn through clips too short to be
+ * split.  The strips are rasterized over their own extents, which may
+ * round a color differently, hence the tolerance.
+ */
+
+#define WIDTH 300
+#define HEIGHT 256
+#define STRIP 30
+#define TOLERANCE 1
+
+static void
+draw_mesh (cairo_t *cr)
+{
+    cairo_pattern_t *pattern;
+    int k;
+
+    pattern = cairo_pattern_create_mesh ();
+    for (k = 0; k < 2; k++) {
+	cairo_mesh_pattern_begin_patch (pattern);
+	cairo_mesh_pattern_move_to (pattern, 10 + 90 * k, -20);
+	cairo_mesh_pattern_curve_to (pattern,
+				     70 + 90 * k, 10,
+				     130 + 90 * k, -30,
+				     190 + 90 * k, 5);
+	cairo_mesh_pattern_curve_to (pattern,
+				     200 + 90 * k, 90,
+				     170 + 90 * k, 180,
+				     195 + 90 * k, 270);
+	cairo_mesh_pattern_curve_to (pattern,
+				     130 + 90 * k, 250,
+				     70 + 90 * k, 290,
+				     5 + 90 * k, 265);
+	cairo_mesh_pattern_curve_to (pattern,
+				     25 + 90 * k, 180,
+				     -5 + 90 * k, 90,
+				     10 + 90 * k, -20);
+	cairo_mesh_pattern_set_corner_color_rgba (pattern, 0, 1, 0, .2 + .5 * k, .6);
+	cairo_mesh_pattern_set_corner_color_rgba (pattern, 1, 0, 1, .2 + .5 * k, .7);
+	cairo_mesh_pattern_set_corner_color_rgba (pattern, 2, 1, .7, .2 + .5 * k, .8);
+	cairo_mesh_pattern_set_corner_color_rgba (pattern, 3, 0, .7, .2 + .5 * k, .9);
+	cairo_mesh_pattern_end_patch (pattern);
+    }
+
+    cairo_set_source (cr, pattern);
+    cairo_paint (cr);
+    cairo_pattern_destroy (pattern);
+}
+
+static cairo_surface_t *
+draw (cairo_bool_t strips)
+{
+    cairo_surface_t *image;
+    cairo_t *cr;
+    int y;
+
+    image = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, WIDTH, HEIGHT);
+    cr = cairo_create (image);
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+
+    if (strips) {
+	for (y = 0; y < HEIGHT; y += STRIP) {
+	    cairo_save (cr);
+	    cairo_rectangle (cr, 0, y, WIDTH, STRIP);
+	    cairo_clip (cr);
+	    draw_mesh (cr);
+	    cairo_restore (cr);
+	}
+    } else {
+	draw_mesh (cr);
+    }
+
+    cairo_destroy (cr);
+    return image;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    cairo_surface_t *banded, *serial;
+    const uint32_t *pa, *pb;
+    int stride, x, y, c;
+
+#ifndef _WIN32
+    /* the pool is sized on first use; keep any setting of the user */
+    setenv ("CAIRO_RENDER_THREADS", "4", 0);
+#endif
+
+    banded = draw (FALSE);
+    serial = draw (TRUE);
+
+    cairo_surface_flush (banded);
+    cairo_surface_flush (serial);
+    pa = (const uint32_t *) cairo_image_surface_get_data (serial);
+    pb = (const uint32_t *) cairo_image_surface_get_data (banded);
+    stride = cairo_image_surface_get_stride (serial) / sizeof (uint32_t);
+    for (y = 0; y < HEIGHT && ret == CAIRO_TEST_SUCCESS; y++) {
+	for (x = 0; x < WIDTH; x++) {
+	    uint32_t va = pa[y * stride + x], vb = pb[y * stride + x];
+
+	    for (c = 0; c < 32; c += 8) {
+		if (abs ((int) ((va >> c) & 0xff) - (int) ((vb >> c) & 0xff)) > TOLERANCE)
+		    break;
+	    }
+	    if (c < 32) {
+		cairo_test_log (ctx,
+				"Error: pixel (%d, %d) is 0x%08x, expected 0x%08x\n",
+				x, y, vb, va);
+		ret = CAIRO_TEST_FAILURE;
+		break;
+	    }
+	}
+    }
+
+    cairo_surface_destroy (banded);
+    cairo_surface_destroy (serial);
+    return ret;
+}
+
+CAIRO_TEST (mesh_pattern_bands,
+	    "Check meshes rasterized in bands against unbanded rasterization",
+	    "mesh, pattern, thread", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
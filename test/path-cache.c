@@ -0,0 +1,158 @@
+/*
+ * Copyright © 2026 the cairo authors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "cairo-test.h"
+
+/* Check that fills served from the path cache match those rasterised
+ * afresh, for shapes repeated at both whole and fractional pixel
+ * offsets, with bounded and unbounded operators and under a clip.
+ */
+
+#define SIZE 96
+#define STEP 24
+
+static void
+marker (cairo_t *cr, double x, double y)
+{
+    cairo_move_to (cr, x + 8, y);
+    cairo_curve_to (cr, x + 20, y, x + 20, y + 12, x + 8, y + 20);
+    cairo_curve_to (cr, x - 4, y + 12, x - 4, y, x + 8, y);
+    cairo_close_path (cr);
+    cairo_move_to (cr, x + 8, y + 4);
+    cairo_line_to (cr, x + 12, y + 10);
+    cairo_line_to (cr, x + 4, y + 10);
+    cairo_close_path (cr);
+}
+
+static cairo_surface_t *
+draw (cairo_antialias_t antialias)
+{
+    cairo_surface_t *image;
+    cairo_t *cr;
+    int i, j;
+
+    image = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, SIZE, SIZE);
+    cr = cairo_create (image);
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+
+    cairo_set_antialias (cr, antialias);
+    cairo_set_fill_rule (cr, CAIRO_FILL_RULE_EVEN_ODD);
+    for (j = 0; j < 3; j++) {
+	for (i = 0; i < 4; i++) {
+	    /* every other column is offset by a fraction of a pixel */
+	    marker (cr, 4 + i * STEP + (i & 1) * .25, 4 + j * STEP + (i & 1) * .5);
+	    cairo_set_source_rgba (cr, 0, 0, 1, .75);
+	    cairo_fill (cr);
+	}
+    }
+
+    /* an unbounded operator, limited by a pixel-aligned clip */
+    cairo_rectangle (cr, 0, 3 * STEP, 3 * STEP, STEP);
+    cairo_clip (cr);
+    cairo_set_operator (cr, CAIRO_OPERATOR_IN);
+    cairo_set_source_rgba (cr, 1, 0, 0, .5);
+    marker (cr, 4 + STEP, 4 + 3 * STEP);
+    cairo_fill (cr);
+
+    cairo_destroy (cr);
+    return image;
+}
+
+static cairo_bool_t
+compare (cairo_test_context_t *ctx,
+	 cairo_surface_t *a,
+	 cairo_surface_t *b,
+	 cairo_antialias_t antialias)
+{
+    const uint32_t *pa, *pb;
+    int stride, x, y, c;
+
+    cairo_surface_flush (a);
+    cairo_surface_flush (b);
+    pa = (const uint32_t *) cairo_image_surface_get_data (a);
+    pb = (const uint32_t *) cairo_image_surface_get_data (b);
+    stride = cairo_image_surface_get_stride (a) / sizeof (uint32_t);
+    for (y = 0; y < SIZE; y++) {
+	for (x = 0; x < SIZE; x++) {
+	    uint32_t va = pa[y * stride + x], vb = pb[y * stride + x];
+
+	    /* allow for rounding in flattening the translated curves */
+	    for (c = 0; c < 32; c += 8) {
+		if (abs ((int) ((va >> c) & 0xff) - (int) ((vb >> c) & 0xff)) > 2) {
+		    cairo_test_log (ctx,
+				    "Error: pixel (%d, %d) is 0x%08x, expected 0x%08x (antialias %d)\n",
+				    x, y, vb, va, antialias);
+		    return FALSE;
+		}
+	    }
+	}
+    }
+
+    return TRUE;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    static const cairo_antialias_t modes[] = {
+	CAIRO_ANTIALIAS_DEFAULT,
+	CAIRO_ANTIALIAS_NONE,
+	CAIRO_ANTIALIAS_FAST,
+    };
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    unsigned long max_size;
+    unsigned int n;
+
+    max_size = cairo_path_cache_get_max_size ();
+
+    for (n = 0; n < ARRAY_LENGTH (modes); n++) {
+	cairo_surface_t *expected, *cached;
+
+	cairo_path_cache_set_max_size (0);
+	expected = draw (modes[n]);
+
+	cairo_path_cache_set_max_size (1 << 20);
+	if (cairo_path_cache_get_max_size () != 1 << 20) {
+	    cairo_test_log (ctx, "Error: path cache budget was not updated\n");
+	    ret = CAIRO_TEST_FAILURE;
+	}
+	cached = draw (modes[n]);
+
+	if (! compare (ctx, expected, cached, modes[n]))
+	    ret = CAIRO_TEST_FAILURE;
+
+	cairo_surface_destroy (expected);
+	cairo_surface_destroy (cached);
+    }
+
+    cairo_path_cache_set_max_size (max_size);
+    return ret;
+}
+
+CAIRO_TEST (path_cache,
+	    "Check fills of repeated paths served from the path cache",
+	    "fill, path", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
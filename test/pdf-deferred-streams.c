@@ -0,0 +1,238 @@
+/*
+ * Copyright © 2026 the cairo authors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "cairo-test.h"
+
+#include <cairo-pdf.h>
+
+#include "pdf-objects.h"
+
+/* Write the same multi-page document with CAIRO_RENDER_THREADS set to
+ * 1 and to 4.  With more than one render thread the PDF surface defers
+ * compressing its streams to the thread pool and writes them out later,
+ * so the objects may be laid out in a different order, but every object
+ * must still be where the cross-reference table says it is and must be
+ * byte-for-byte identical to the one written serially.
+ */
+
+#define BASENAME "pdf-deferred-streams.out"
+#define NUM_PAGES 4
+#define IMAGE_SIZE 64
+
+static cairo_surface_t *
+create_image (int page)
+{
+    cairo_surface_t *image;
+    unsigned char *data;
+    int stride, x, y;
+
+    image = cairo_image_surface_create (CAIRO_FORMAT_RGB24,
+					IMAGE_SIZE, IMAGE_SIZE);
+    cairo_surface_flush (image);
+    data = cairo_image_surface_get_data (image);
+    stride = cairo_image_surface_get_stride (image);
+    for (y = 0; y < IMAGE_SIZE; y++) {
+	uint32_t *row = (uint32_t *) (data + y * stride);
+
+	for (x = 0; x < IMAGE_SIZE; x++)
+	    row[x] = (x * 4) << 16 | (y * 4) << 8 | ((x ^ y) * (page + 1) & 0xff);
+    }
+    cairo_surface_mark_dirty (image);
+
+    return image;
+}
+
+static cairo_status_t
+render (const char *filename)
+{
+    cairo_surface_t *surface;
+    cairo_t *cr;
+    cairo_status_t status;
+    int page, i;
+
+    surface = cairo_pdf_surface_create (filename, 200, 200);
+    cr = cairo_create (surface);
+    cairo_select_font_face (cr, CAIRO_TEST_FONT_FAMILY " Sans",
+			    CAIRO_FONT_SLANT_NORMAL,
+			    CAIRO_FONT_WEIGHT_NORMAL);
+    cairo_set_font_size (cr, 12);
+
+    for (page = 0; page < NUM_PAGES; page++) {
+	cairo_surface_t *image;
+	char text[64];
+
+	image = create_image (page);
+	cairo_set_source_surface (cr, image, 10, 10);
+	cairo_paint (cr);
+	cairo_surface_destroy (image);
+
+	for (i = 0; i < 50; i++) {
+	    cairo_move_to (cr, 100 + (i * 7 % 90), 10 + (i * 13 % 90));
+	    cairo_line_to (cr, 100 + (i * 11 % 90), 100 + (i * 3 % 90));
+	}
+	cairo_set_source_rgb (cr, 0, 0, page / (double) NUM_PAGES);
+	cairo_stroke (cr);
+
+	snprintf (text, sizeof (text), "Page %d of %d", page + 1, NUM_PAGES);
+	cairo_move_to (cr, 10, 150);
+	cairo_show_text (cr, text);
+	cairo_show_page (cr);
+    }
+    status = cairo_status (cr);
+    cairo_destroy (cr);
+
+    cairo_surface_finish (surface);
+    if (status == CAIRO_STATUS_SUCCESS)
+	status = cairo_surface_status (surface);
+    cairo_surface_destroy (surface);
+
+    return status;
+}
+
+static cairo_test_status_t
+compare (const cairo_test_context_t *ctx,
+	 const char *serial_filename,
+	 const char *threaded_filename)
+{
+    pdf_file_t serial, threaded;
+    cairo_test_status_t result = CAIRO_TEST_FAILURE;
+    cairo_bool_t compressed = FALSE;
+    int i;
+
+    if (! pdf_file_load (ctx, serial_filename, &serial))
+	return CAIRO_TEST_FAILURE;
+    if (! pdf_file_load (ctx, threaded_filename, &threaded)) {
+	pdf_file_fini (&serial);
+	return CAIRO_TEST_FAILURE;
+    }
+
+    if (serial.num_objects != threaded.num_objects) {
+	cairo_test_log (ctx, "%s has %d objects, expected %d\n",
+			threaded_filename,
+			threaded.num_objects, serial.num_objects);
+	goto out;
+    }
+
+    for (i = 1; i < serial.num_objects; i++) {
+	unsigned long length;
+
+	if ((serial.offsets[i] == 0) != (threaded.offsets[i] == 0)) {
+	    cairo_test_log (ctx, "Object %d is free in only one output\n", i);
+	    goto out;
+	}
+	if (serial.offsets[i] == 0)
+	    continue;
+
+	length = serial.ends[i] - serial.offsets[i];
+	if (threaded.ends[i] - threaded.offsets[i] != length ||
+	    memcmp (serial.data + serial.offsets[i],
+		    threaded.data + threaded.offsets[i],
+		    length) != 0)
+	{
+	    cairo_test_log (ctx, "Object %d differs between %s and %s\n",
+			    i, serial_filename, threaded_filename);
+	    goto out;
+	}
+
+	if (pdf_object_dict_contains (&serial, i, "/Filter /FlateDecode"))
+	    compressed = TRUE;
+    }
+
+    if (! compressed) {
+	cairo_test_log (ctx, "%s has no compressed streams\n", serial_filename);
+	goto out;
+    }
+
+    result = CAIRO_TEST_SUCCESS;
+
+out:
+    pdf_file_fini (&serial);
+    pdf_file_fini (&threaded);
+    return result;
+}
+
+static cairo_status_t
+render_with_threads (const char *threads, const char *filename)
+{
+    /* The thread pool reads CAIRO_RENDER_THREADS when it is first used
+     * and is torn down, and so reconfigured, by resetting the static
+     * data; each PDF surface decides whether to defer compression when
+     * it is created. */
+    setenv ("CAIRO_RENDER_THREADS", threads, 1);
+    cairo_debug_reset_static_data ();
+
+    return render (filename);
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t result;
+    cairo_status_t status;
+    char *serial, *threaded, *saved = NULL;
+    const char *path = cairo_test_mkdir (CAIRO_TEST_OUTPUT_DIR) ? CAIRO_TEST_OUTPUT_DIR : ".";
+
+    if (! cairo_test_is_target_enabled (ctx, "pdf"))
+	return CAIRO_TEST_UNTESTED;
+
+#ifdef _WIN32
+    return CAIRO_TEST_UNTESTED;
+#else
+    xasprintf (&serial, "%s/%s.serial.pdf", path, BASENAME);
+    xasprintf (&threaded, "%s/%s.threaded.pdf", path, BASENAME);
+
+    if (getenv ("CAIRO_RENDER_THREADS") != NULL)
+	saved = strdup (getenv ("CAIRO_RENDER_THREADS"));
+
+    status = render_with_threads ("1", serial);
+    if (status == CAIRO_STATUS_SUCCESS)
+	status = render_with_threads ("4", threaded);
+
+    if (saved != NULL) {
+	setenv ("CAIRO_RENDER_THREADS", saved, 1);
+	free (saved);
+    } else {
+	unsetenv ("CAIRO_RENDER_THREADS");
+    }
+    cairo_debug_reset_static_data ();
+
+    if (status) {
+	cairo_test_log (ctx, "Failed to write pdf: %s\n",
+			cairo_status_to_string (status));
+	result = CAIRO_TEST_FAILURE;
+    } else {
+	result = compare (ctx, serial, threaded);
+    }
+
+    free (serial);
+    free (threaded);
+    return result;
+#endif
+}
+
+CAIRO_TEST (pdf_deferred_streams,
+	    "Check that deferring stream compression to render threads writes the same objects",
+	    "pdf, thread", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
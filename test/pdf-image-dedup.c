@@ -0,0 +1,153 @@
+/*
+ * Copyright © 2026 the cairo authors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "cairo-test.h"
+
+#include <cairo-pdf.h>
+
+#include "pdf-objects.h"
+
+/* Check that with image deduplication enabled, distinct source
+ * surfaces with identical pixels are embedded as a single image, while
+ * different pixels still produce separate images.
+ */
+
+#define BASENAME "pdf-image-dedup.out"
+#define SIZE 16
+
+static cairo_surface_t *
+create_image (double red)
+{
+    cairo_surface_t *image;
+    cairo_t *cr;
+
+    image = cairo_image_surface_create (CAIRO_FORMAT_RGB24, SIZE, SIZE);
+    cr = cairo_create (image);
+    cairo_set_source_rgb (cr, red, 0, 1);
+    cairo_paint (cr);
+    cairo_set_source_rgb (cr, 0, 1, 0);
+    cairo_rectangle (cr, 2, 2, SIZE / 2, SIZE / 2);
+    cairo_fill (cr);
+    cairo_destroy (cr);
+
+    return image;
+}
+
+/* Counts the objects whose dictionaries declare an image XObject. */
+static int
+count_images (const cairo_test_context_t *ctx, const char *filename)
+{
+    pdf_file_t pdf;
+    int i, count = 0;
+
+    if (! pdf_file_load (ctx, filename, &pdf))
+	return -1;
+
+    for (i = 0; i < pdf.num_ordered; i++) {
+	if (pdf_object_dict_contains (&pdf, pdf.order[i], "/Subtype /Image"))
+	    count++;
+    }
+    pdf_file_fini (&pdf);
+
+    return count;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_surface_t *surface, *shared;
+    cairo_t *cr;
+    cairo_status_t status;
+    char *filename;
+    int page, num_images;
+    const char *path = cairo_test_mkdir (CAIRO_TEST_OUTPUT_DIR) ? CAIRO_TEST_OUTPUT_DIR : ".";
+
+    if (! cairo_test_is_target_enabled (ctx, "pdf"))
+	return CAIRO_TEST_UNTESTED;
+
+    xasprintf (&filename, "%s/%s.pdf", path, BASENAME);
+    surface = cairo_pdf_surface_create (filename, 4 * SIZE, SIZE);
+    cairo_pdf_surface_set_image_deduplication (surface, TRUE);
+
+    cr = cairo_create (surface);
+    shared = create_image (1);
+    for (page = 0; page < 3; page++) {
+	cairo_surface_t *image;
+
+	/* A fresh copy of the same image on every page... */
+	image = page == 0 ? cairo_surface_reference (shared) : create_image (1);
+	cairo_set_source_surface (cr, image, 0, 0);
+	cairo_paint (cr);
+	cairo_surface_destroy (image);
+
+	/* ...and a different one. */
+	image = create_image (0.5);
+	cairo_set_source_surface (cr, image, 2 * SIZE, 0);
+	cairo_paint (cr);
+	cairo_surface_destroy (image);
+
+	cairo_show_page (cr);
+
+	/* ...which must still match the first image once the surface it
+	 * was painted from has been drawn over. */
+	if (page == 0) {
+	    cairo_t *cr2 = cairo_create (shared);
+	    cairo_set_source_rgb (cr2, 1, 1, 1);
+	    cairo_paint (cr2);
+	    cairo_destroy (cr2);
+	}
+    }
+    cairo_surface_destroy (shared);
+    status = cairo_status (cr);
+    cairo_destroy (cr);
+
+    cairo_surface_finish (surface);
+    if (status == CAIRO_STATUS_SUCCESS)
+	status = cairo_surface_status (surface);
+    cairo_surface_destroy (surface);
+
+    if (status) {
+	cairo_test_log (ctx, "Failed to write pdf surface to %s: %s\n",
+			filename, cairo_status_to_string (status));
+	free (filename);
+	return CAIRO_TEST_FAILURE;
+    }
+
+    num_images = count_images (ctx, filename);
+    if (num_images != 2) {
+	cairo_test_log (ctx, "Expected 2 images in %s, found %d\n",
+			filename, num_images);
+	free (filename);
+	return CAIRO_TEST_FAILURE;
+    }
+
+    free (filename);
+    return CAIRO_TEST_SUCCESS;
+}
+
+CAIRO_TEST (pdf_image_dedup,
+	    "Check that identical images are embedded once",
+	    "pdf", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
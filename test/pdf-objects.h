@@ -0,0 +1,229 @@
+/*
+ * Copyright © 2026 the cairo authors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Helpers shared by the tests that inspect the objects of a PDF file
+ * written by cairo, located through its cross-reference table.
+ */
+
+#ifndef PDF_OBJECTS_H
+#define PDF_OBJECTS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct _pdf_file {
+    unsigned char *data;
+    unsigned long length;
+
+    /* Indexed by object number; the offset of a free object is 0. */
+    int num_objects;
+    unsigned long *offsets;
+    unsigned long *ends;
+
+    /* The numbers of the objects in use, in the order they appear. */
+    int num_ordered;
+    int *order;
+} pdf_file_t;
+
+static const unsigned char *
+pdf_find (const unsigned char *data, unsigned long from, unsigned long to,
+	  const char *needle)
+{
+    unsigned long n = strlen (needle);
+
+    for (; from + n <= to; from++) {
+	if (memcmp (data + from, needle, n) == 0)
+	    return data + from;
+    }
+    return NULL;
+}
+
+static void
+pdf_file_fini (pdf_file_t *pdf)
+{
+    free (pdf->data);
+    free (pdf->offsets);
+    free (pdf->ends);
+    free (pdf->order);
+    memset (pdf, 0, sizeof (*pdf));
+}
+
+/* Reads the cross-reference table and checks that each object in use
+ * starts at its offset and ends with "endobj" before the next object,
+ * or the table itself, begins. */
+static cairo_bool_t
+pdf_file_parse (const cairo_test_context_t *ctx,
+		const char *filename,
+		pdf_file_t *pdf)
+{
+    unsigned long xref;
+    const char *s;
+    char *end;
+    long i;
+    int j, first;
+
+    for (i = (long) pdf->length - 9; i >= 0; i--) {
+	if (memcmp (pdf->data + i, "startxref", 9) == 0)
+	    break;
+    }
+    if (i < 0) {
+	cairo_test_log (ctx, "%s: no startxref\n", filename);
+	return FALSE;
+    }
+
+    xref = strtoul ((const char *) pdf->data + i + 9, NULL, 10);
+    if (xref + 4 > pdf->length || memcmp (pdf->data + xref, "xref", 4) != 0) {
+	cairo_test_log (ctx, "%s: startxref does not point at a cross-reference table\n",
+			filename);
+	return FALSE;
+    }
+
+    s = (const char *) pdf->data + xref + 4;
+    first = strtol (s, &end, 10);
+    pdf->num_objects = strtol (end, &end, 10);
+    while (*end == '\r' || *end == '\n' || *end == ' ')
+	end++;
+    if (first != 0 || pdf->num_objects <= 1 ||
+	(unsigned long) (end - (const char *) pdf->data) +
+	20 * pdf->num_objects > pdf->length)
+    {
+	cairo_test_log (ctx, "%s: malformed cross-reference table\n", filename);
+	return FALSE;
+    }
+
+    pdf->offsets = xcalloc (pdf->num_objects, sizeof (unsigned long));
+    pdf->ends = xcalloc (pdf->num_objects, sizeof (unsigned long));
+    pdf->order = xcalloc (pdf->num_objects, sizeof (int));
+    for (j = 1; j < pdf->num_objects; j++) {
+	const char *entry = end + 20 * j;
+	int k;
+
+	if (entry[17] == 'f')
+	    continue;
+	if (entry[17] != 'n') {
+	    cairo_test_log (ctx, "%s: malformed cross-reference entry %d\n",
+			    filename, j);
+	    return FALSE;
+	}
+
+	pdf->offsets[j] = strtoul (entry, NULL, 10);
+	if (pdf->offsets[j] == 0 || pdf->offsets[j] >= xref) {
+	    cairo_test_log (ctx, "%s: object %d is outside the file\n",
+			    filename, j);
+	    return FALSE;
+	}
+
+	for (k = pdf->num_ordered++;
+	     k > 0 && pdf->offsets[pdf->order[k - 1]] > pdf->offsets[j];
+	     k--)
+	{
+	    pdf->order[k] = pdf->order[k - 1];
+	}
+	pdf->order[k] = j;
+    }
+
+    for (j = 0; j < pdf->num_ordered; j++) {
+	int num = pdf->order[j];
+	unsigned long start = pdf->offsets[num];
+	unsigned long stop = j + 1 < pdf->num_ordered ?
+			     pdf->offsets[pdf->order[j + 1]] : xref;
+	char header[32];
+
+	snprintf (header, sizeof (header), "%d 0 obj", num);
+	if (pdf_find (pdf->data, start, start + strlen (header), header) == NULL) {
+	    cairo_test_log (ctx, "%s: object %d is not at its offset %lu\n",
+			    filename, num, start);
+	    return FALSE;
+	}
+
+	while (stop >= start + 6 &&
+	       memcmp (pdf->data + stop - 6, "endobj", 6) != 0)
+	    stop--;
+	if (stop < start + 6) {
+	    cairo_test_log (ctx, "%s: object %d is not terminated\n",
+			    filename, num);
+	    return FALSE;
+	}
+	pdf->ends[num] = stop;
+    }
+
+    return TRUE;
+}
+
+/* Reads and parses @filename, logging why on failure. */
+static cairo_bool_t
+pdf_file_load (const cairo_test_context_t *ctx,
+	       const char *filename,
+	       pdf_file_t *pdf)
+{
+    FILE *file;
+    long length;
+
+    memset (pdf, 0, sizeof (*pdf));
+
+    file = fopen (filename, "rb");
+    if (file == NULL) {
+	cairo_test_log (ctx, "Failed to open %s\n", filename);
+	return FALSE;
+    }
+
+    if (fseek (file, 0, SEEK_END) == 0 && (length = ftell (file)) > 0) {
+	pdf->data = xmalloc (length);
+	rewind (file);
+	if (fread (pdf->data, 1, length, file) == (size_t) length)
+	    pdf->length = length;
+    }
+    fclose (file);
+
+    if (pdf->length == 0) {
+	cairo_test_log (ctx, "Failed to read %s\n", filename);
+	pdf_file_fini (pdf);
+	return FALSE;
+    }
+
+    if (! pdf_file_parse (ctx, filename, pdf)) {
+	pdf_file_fini (pdf);
+	return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* Returns whether the dictionary of object @num, the part before any
+ * stream data, contains @needle. */
+static cairo_bool_t
+pdf_object_dict_contains (const pdf_file_t *pdf, int num, const char *needle)
+{
+    unsigned long start = pdf->offsets[num];
+    unsigned long stop = pdf->ends[num];
+    const unsigned char *stream;
+
+    stream = pdf_find (pdf->data, start, stop, "stream");
+    if (stream != NULL)
+	stop = stream - pdf->data;
+
+    return pdf_find (pdf->data, start, stop, needle) != NULL;
+}
+
+#endif /* PDF_OBJECTS_H */
@@ -0,0 +1,145 @@
+/*
+ * Copyright © 2026 the cairo authors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "cairo-test.h"
+
+#include <cairo-pdf.h>
+
+#include "pdf-objects.h"
+
+/* Check that a PDF written with a resource flush interval is complete,
+ * and that its fonts are written out after every interval, between the
+ * page objects, rather than once at the end.
+ */
+
+#define BASENAME "pdf-resource-flush.out"
+#define NUM_PAGES 7
+#define INTERVAL 3
+
+/* Walks the objects in file order, noting how many pages had been
+ * written when each font was.  Every interval must be followed by fonts
+ * of its own, before the next page, and no fonts may precede the end
+ * of the first interval. */
+static cairo_test_status_t
+check_fonts (const cairo_test_context_t *ctx, const char *filename)
+{
+    pdf_file_t pdf;
+    int fonts_after[NUM_PAGES + 1];
+    int i, num_pages = 0;
+    cairo_test_status_t result = CAIRO_TEST_SUCCESS;
+
+    if (! pdf_file_load (ctx, filename, &pdf))
+	return CAIRO_TEST_FAILURE;
+
+    memset (fonts_after, 0, sizeof (fonts_after));
+    for (i = 0; i < pdf.num_ordered; i++) {
+	int num = pdf.order[i];
+
+	if (pdf_object_dict_contains (&pdf, num, "/Type /Page\n"))
+	    num_pages++;
+	else if (pdf_object_dict_contains (&pdf, num, "/Type /Font\n") &&
+		 num_pages <= NUM_PAGES)
+	    fonts_after[num_pages]++;
+    }
+    pdf_file_fini (&pdf);
+
+    if (num_pages != NUM_PAGES) {
+	cairo_test_log (ctx, "Expected %d pages in %s, found %d\n",
+			NUM_PAGES, filename, num_pages);
+	return CAIRO_TEST_FAILURE;
+    }
+
+    for (i = 0; i <= NUM_PAGES; i++) {
+	cairo_bool_t flushed = i > 0 && (i % INTERVAL == 0 || i == NUM_PAGES);
+
+	if (flushed && fonts_after[i] == 0) {
+	    cairo_test_log (ctx, "%s: no fonts were written after page %d\n",
+			    filename, i);
+	    result = CAIRO_TEST_FAILURE;
+	} else if (! flushed && fonts_after[i] != 0) {
+	    cairo_test_log (ctx, "%s: %d fonts were written after page %d, between flushes\n",
+			    filename, fonts_after[i], i);
+	    result = CAIRO_TEST_FAILURE;
+	}
+    }
+
+    return result;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_surface_t *surface;
+    cairo_t *cr;
+    cairo_status_t status;
+    char *filename;
+    cairo_test_status_t result;
+    int page;
+    const char *path = cairo_test_mkdir (CAIRO_TEST_OUTPUT_DIR) ? CAIRO_TEST_OUTPUT_DIR : ".";
+
+    if (! cairo_test_is_target_enabled (ctx, "pdf"))
+	return CAIRO_TEST_UNTESTED;
+
+    xasprintf (&filename, "%s/%s.pdf", path, BASENAME);
+    surface = cairo_pdf_surface_create (filename, 200, 50);
+    cairo_pdf_surface_set_resource_flush_interval (surface, INTERVAL);
+
+    cr = cairo_create (surface);
+    cairo_select_font_face (cr, CAIRO_TEST_FONT_FAMILY " Sans",
+			    CAIRO_FONT_SLANT_NORMAL,
+			    CAIRO_FONT_WEIGHT_NORMAL);
+    cairo_set_font_size (cr, 12);
+    for (page = 0; page < NUM_PAGES; page++) {
+	char text[64];
+
+	snprintf (text, sizeof (text), "Page %d of %d", page + 1, NUM_PAGES);
+	cairo_move_to (cr, 10, 30);
+	cairo_show_text (cr, text);
+	cairo_show_page (cr);
+    }
+    status = cairo_status (cr);
+    cairo_destroy (cr);
+
+    cairo_surface_finish (surface);
+    if (status == CAIRO_STATUS_SUCCESS)
+	status = cairo_surface_status (surface);
+    cairo_surface_destroy (surface);
+
+    if (status) {
+	cairo_test_log (ctx, "Failed to write pdf surface to %s: %s\n",
+			filename, cairo_status_to_string (status));
+	free (filename);
+	return CAIRO_TEST_FAILURE;
+    }
+
+    result = check_fonts (ctx, filename);
+    free (filename);
+    return result;
+}
+
+CAIRO_TEST (pdf_resource_flush,
+	    "Check that fonts are written out at each resource flush interval",
+	    "pdf", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
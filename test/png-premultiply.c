@@ -0,0 +1,219 @@
+/*
+ * Copyright © 2026 the cairo authors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "cairo-test.h"
+
+#include <string.h>
+
+/* Writing a PNG unpremultiplies every pixel and reading it back
+ * premultiplies it again, both in vector kernels where the CPU has
+ * them.  Round trip every combination of alpha and channel value,
+ * including the invalid ones where a channel exceeds alpha, and check
+ * the result against the scalar arithmetic.  The width is odd so that
+ * the scalar loops finish each row after the vector kernels.
+ */
+
+#define WIDTH 259
+#define HEIGHT 256
+
+typedef struct _png_buffer {
+    unsigned char *data;
+    unsigned int length;
+    unsigned int size;
+    unsigned int offset;
+} png_buffer_t;
+
+static cairo_status_t
+write_png (void *closure, const unsigned char *data, unsigned int length)
+{
+    png_buffer_t *buffer = closure;
+
+    if (buffer->length + length > buffer->size) {
+	unsigned int size = 2 * buffer->size + length;
+	unsigned char *tmp;
+
+	tmp = realloc (buffer->data, size);
+	if (tmp == NULL)
+	    return CAIRO_STATUS_NO_MEMORY;
+
+	buffer->data = tmp;
+	buffer->size = size;
+    }
+
+    memcpy (buffer->data + buffer->length, data, length);
+    buffer->length += length;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+read_png (void *closure, unsigned char *data, unsigned int length)
+{
+    png_buffer_t *buffer = closure;
+
+    if (buffer->offset + length > buffer->length)
+	return CAIRO_STATUS_READ_ERROR;
+
+    memcpy (data, buffer->data + buffer->offset, length);
+    buffer->offset += length;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static uint8_t
+unpremultiply (uint8_t c, uint8_t a)
+{
+    return (c * 255 + a / 2) / a;
+}
+
+static uint8_t
+premultiply (uint8_t c, uint8_t a)
+{
+    int t = a * c + 0x80;
+    return (t + (t >> 8)) >> 8;
+}
+
+static uint32_t
+round_trip (uint32_t pixel, cairo_format_t format)
+{
+    uint8_t a = pixel >> 24;
+    uint8_t r = pixel >> 16;
+    uint8_t g = pixel >> 8;
+    uint8_t b = pixel;
+
+    if (format == CAIRO_FORMAT_RGB24)
+	return pixel | 0xff000000;
+
+    if (a == 0)
+	return 0;
+
+    r = unpremultiply (r, a);
+    g = unpremultiply (g, a);
+    b = unpremultiply (b, a);
+    if (a != 0xff) {
+	r = premultiply (r, a);
+	g = premultiply (g, a);
+	b = premultiply (b, a);
+    }
+
+    return (uint32_t) a << 24 | r << 16 | g << 8 | b;
+}
+
+static cairo_test_status_t
+check_format (cairo_test_context_t *ctx, cairo_format_t format)
+{
+    cairo_surface_t *surface, *result;
+    png_buffer_t buffer = { NULL, 0, 0, 0 };
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    cairo_status_t status;
+    uint8_t *data;
+    int stride, x, y;
+
+    surface = cairo_image_surface_create (format, WIDTH, HEIGHT);
+    data = cairo_image_surface_get_data (surface);
+    stride = cairo_image_surface_get_stride (surface);
+    for (y = 0; y < HEIGHT; y++) {
+	uint32_t *row = (uint32_t *) (data + y * stride);
+
+	for (x = 0; x < WIDTH; x++) {
+	    uint8_t c = x;
+
+	    row[x] = (uint32_t) y << 24 | c << 16 |
+		     (uint8_t) (7 * x + y) << 8 | (uint8_t) ~c;
+	    if (format == CAIRO_FORMAT_RGB24)
+		row[x] &= 0x00ffffff;
+	}
+    }
+    cairo_surface_mark_dirty (surface);
+
+    status = cairo_surface_write_to_png_stream (surface, write_png, &buffer);
+    if (status) {
+	cairo_test_log (ctx, "Error writing PNG: %s\n",
+			cairo_status_to_string (status));
+	cairo_surface_destroy (surface);
+	free (buffer.data);
+	return cairo_test_status_from_status (ctx, status);
+    }
+
+    result = cairo_image_surface_create_from_png_stream (read_png, &buffer);
+    free (buffer.data);
+    status = cairo_surface_status (result);
+    if (status) {
+	cairo_test_log (ctx, "Error reading PNG: %s\n",
+			cairo_status_to_string (status));
+	cairo_surface_destroy (result);
+	cairo_surface_destroy (surface);
+	return cairo_test_status_from_status (ctx, status);
+    }
+
+    if (cairo_image_surface_get_format (result) != format ||
+	cairo_image_surface_get_width (result) != WIDTH ||
+	cairo_image_surface_get_height (result) != HEIGHT)
+    {
+	cairo_test_log (ctx, "Error: PNG read back with the wrong format or size\n");
+	ret = CAIRO_TEST_FAILURE;
+    }
+
+    for (y = 0; ret == CAIRO_TEST_SUCCESS && y < HEIGHT; y++) {
+	const uint32_t *in, *out;
+
+	in = (const uint32_t *) (data + y * stride);
+	out = (const uint32_t *) (cairo_image_surface_get_data (result) +
+				  y * cairo_image_surface_get_stride (result));
+	for (x = 0; x < WIDTH; x++) {
+	    uint32_t expected = round_trip (in[x], format);
+
+	    if (out[x] != expected) {
+		cairo_test_log (ctx,
+				"Error: pixel %08x at (%d, %d) read back as %08x, expected %08x\n",
+				in[x], x, y, out[x], expected);
+		ret = CAIRO_TEST_FAILURE;
+		break;
+	    }
+	}
+    }
+
+    cairo_surface_destroy (result);
+    cairo_surface_destroy (surface);
+
+    return ret;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t ret;
+
+    ret = check_format (ctx, CAIRO_FORMAT_ARGB32);
+    if (ret == CAIRO_TEST_SUCCESS)
+	ret = check_format (ctx, CAIRO_FORMAT_RGB24);
+
+    return ret;
+}
+
+CAIRO_TEST (png_premultiply,
+	    "Check the PNG premultiply and unpremultiply conversions against the scalar arithmetic",
+	    "png", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
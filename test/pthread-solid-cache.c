@@ -0,0 +1,134 @@
+/*
+ * Copyright © 2026 the cairo authors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "cairo-test.h"
+
+#include <pthread.h>
+
+/* Solid sources are drawn from a lock-free cache of pixman images
+ * hashed by color, shared between threads or kept per thread.  Have
+ * several threads add thousands of distinct opaque colors, each in its
+ * own order so that they contend for and evict each other's slots, and
+ * then repeat them so that they hit the cache, and check that every
+ * pixel ends up with its own color.
+ */
+
+#define N_THREADS 8
+#define SIZE 64
+
+typedef struct {
+    cairo_surface_t *target;
+    int id;
+    cairo_bool_t ok;
+} thread_data_t;
+
+static uint32_t
+color_for_index (int i)
+{
+    return 0xff000000 | (i & 0xf) << 20 | (i >> 4 & 0xf) << 12 | (i >> 8) << 4 | 0x0a0b0c;
+}
+
+static void *
+draw_thread (void *arg)
+{
+    thread_data_t *data = arg;
+    int pass, i, n;
+
+    data->ok = TRUE;
+    for (pass = 0; pass < 2 && data->ok; pass++) {
+	cairo_t *cr;
+
+	cr = cairo_create (data->target);
+	cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
+	cairo_paint (cr);
+
+	/* ADD is not reduced to a fill, so each box takes a solid image */
+	cairo_set_operator (cr, CAIRO_OPERATOR_ADD);
+	for (n = 0; n < SIZE * SIZE; n++) {
+	    uint32_t color;
+
+	    i = (n * (2 * data->id + 1) + data->id) % (SIZE * SIZE);
+	    color = color_for_index (i);
+	    cairo_set_source_rgb (cr,
+				  (color >> 16 & 0xff) / 255.,
+				  (color >> 8 & 0xff) / 255.,
+				  (color & 0xff) / 255.);
+	    cairo_rectangle (cr, i % SIZE, i / SIZE, 1, 1);
+	    cairo_fill (cr);
+	}
+	cairo_destroy (cr);
+
+	cairo_surface_flush (data->target);
+	for (i = 0; i < SIZE * SIZE; i++) {
+	    const uint32_t *row;
+
+	    row = (const uint32_t *)
+		(cairo_image_surface_get_data (data->target) +
+		 i / SIZE * cairo_image_surface_get_stride (data->target));
+	    if (row[i % SIZE] != color_for_index (i)) {
+		data->ok = FALSE;
+		break;
+	    }
+	}
+    }
+
+    return NULL;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    pthread_t threads[N_THREADS];
+    thread_data_t data[N_THREADS];
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    int i, n;
+
+    for (n = 0; n < N_THREADS; n++) {
+	data[n].target = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+						     SIZE, SIZE);
+	data[n].id = n;
+	if (pthread_create (&threads[n], NULL, draw_thread, &data[n]) != 0) {
+	    cairo_surface_destroy (data[n].target);
+	    ret = CAIRO_TEST_FAILURE;
+	    break;
+	}
+    }
+
+    for (i = 0; i < n; i++) {
+	pthread_join (threads[i], NULL);
+	if (! data[i].ok) {
+	    cairo_test_log (ctx, "Error: thread %d drew the wrong colors\n", i);
+	    ret = CAIRO_TEST_FAILURE;
+	}
+	cairo_surface_destroy (data[i].target);
+    }
+
+    return ret;
+}
+
+CAIRO_TEST (pthread_solid_cache,
+	    "Check the solid image cache when many threads draw many colors",
+	    "threads", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
@@ -0,0 +1,174 @@
+/*
+ * Copyright © 2026 the cairo authors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "cairo-test.h"
+
+#include <string.h>
+
+/* A recording surface allocates its commands, their paths and their
+ * glyphs from an arena that grows in chunks.  Record a path too large
+ * for a single chunk alongside many small paths, strokes and glyphs,
+ * replay it onto an image and also into a second recording that outlives
+ * the first, and check both against drawing the same operations
+ * directly.
+ */
+
+#define SIZE 256
+#define LONG_PATH 40000
+
+static void
+draw (cairo_t *cr)
+{
+    int i;
+
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+
+    /* A polyline spiralling around the centre, larger than a chunk */
+    cairo_move_to (cr, SIZE / 2, SIZE / 2);
+    for (i = 0; i < LONG_PATH; i++) {
+	double r = 4 + (SIZE / 2 - 8) * i / (double) LONG_PATH;
+	double t = i * .05;
+
+	cairo_line_to (cr, SIZE / 2 + r * cos (t), SIZE / 2 + r * sin (t));
+    }
+    cairo_set_source_rgba (cr, 0, 0, 1, .5);
+    cairo_set_line_width (cr, .5);
+    cairo_stroke (cr);
+
+    for (i = 0; i < 2000; i++) {
+	cairo_set_source_rgba (cr, (i % 3) / 2., (i % 5) / 4., (i % 7) / 6., .3);
+	cairo_rectangle (cr, (i * 37) % SIZE, (i * 91) % SIZE, 3.5, 2.5);
+	if (i % 2)
+	    cairo_fill (cr);
+	else
+	    cairo_stroke (cr);
+    }
+
+    cairo_select_font_face (cr, CAIRO_TEST_FONT_FAMILY " Sans",
+			    CAIRO_FONT_SLANT_NORMAL,
+			    CAIRO_FONT_WEIGHT_NORMAL);
+    cairo_set_font_size (cr, 8);
+    cairo_set_source_rgb (cr, 0, 0, 0);
+    for (i = 0; i < 30; i++) {
+	cairo_move_to (cr, 2, 8 * (i + 1));
+	cairo_show_text (cr,
+			 "The quick brown fox jumps over the lazy dog, "
+			 "the quick brown fox jumps over the lazy dog.");
+    }
+}
+
+static cairo_surface_t *
+record (void)
+{
+    cairo_surface_t *recording;
+    cairo_t *cr;
+
+    recording = cairo_recording_surface_create (CAIRO_CONTENT_COLOR_ALPHA, NULL);
+    cr = cairo_create (recording);
+    draw (cr);
+    cairo_destroy (cr);
+
+    return recording;
+}
+
+static cairo_bool_t
+replay_matches (cairo_surface_t *recording, cairo_surface_t *reference)
+{
+    cairo_surface_t *image;
+    cairo_bool_t same = TRUE;
+    cairo_t *cr;
+    int row;
+
+    image = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, SIZE, SIZE);
+    cr = cairo_create (image);
+    cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+    cairo_set_source_surface (cr, recording, 0, 0);
+    cairo_paint (cr);
+    cairo_destroy (cr);
+
+    cairo_surface_flush (image);
+    for (row = 0; same && row < SIZE; row++) {
+	same = memcmp (cairo_image_surface_get_data (image) +
+		       row * cairo_image_surface_get_stride (image),
+		       cairo_image_surface_get_data (reference) +
+		       row * cairo_image_surface_get_stride (reference),
+		       4 * SIZE) == 0;
+    }
+
+    cairo_surface_destroy (image);
+
+    return same;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_surface_t *reference, *recording, *copy;
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    cairo_t *cr;
+
+    reference = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, SIZE, SIZE);
+    cr = cairo_create (reference);
+    draw (cr);
+    cairo_destroy (cr);
+    cairo_surface_flush (reference);
+
+    recording = record ();
+    if (cairo_surface_status (recording)) {
+	ret = cairo_test_status_from_status (ctx, cairo_surface_status (recording));
+	goto out;
+    }
+
+    if (! replay_matches (recording, reference)) {
+	cairo_test_log (ctx, "Error: the replayed recording differs\n");
+	ret = CAIRO_TEST_FAILURE;
+    }
+
+    /* Copy the commands into a second recording and release the first */
+    copy = cairo_recording_surface_create (CAIRO_CONTENT_COLOR_ALPHA, NULL);
+    cr = cairo_create (copy);
+    cairo_set_source_surface (cr, recording, 0, 0);
+    cairo_paint (cr);
+    cairo_destroy (cr);
+
+    cairo_surface_finish (recording);
+    cairo_surface_destroy (recording);
+
+    if (ret == CAIRO_TEST_SUCCESS && ! replay_matches (copy, reference)) {
+	cairo_test_log (ctx, "Error: the copied recording differs\n");
+	ret = CAIRO_TEST_FAILURE;
+    }
+    cairo_surface_destroy (copy);
+
+out:
+    cairo_surface_destroy (reference);
+    return ret;
+}
+
+CAIRO_TEST (recording_surface_arena,
+	    "Check recordings whose commands outgrow the chunks of their arena",
+	    "recording", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
@@ -0,0 +1,156 @@
+/*
+ * Copyright © 2026 the cairo authors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "cairo-test.h"
+
+#include <string.h>
+
+/* A recording replayed onto a small target only replays the commands
+ * whose extents the R-tree index reports as visible, and any recorded
+ * since the index was built are scanned linearly.  Replay a recording of
+ * many overlapping translucent shapes into small tiles, after building
+ * the index, after appending a short tail and after appending enough to
+ * rebuild it, and compare each tile with drawing every command directly.
+ */
+
+#define SIZE 512
+#define TILE 48
+
+static void
+draw_shape (cairo_t *cr, int i)
+{
+    unsigned int seed = i * 2654435761u;
+    double x, y, w, h;
+
+    x = seed % SIZE;
+    y = (seed >> 9) % SIZE;
+    w = 2 + (seed >> 18) % 60;
+    h = 2 + (seed >> 24) % 60;
+
+    cairo_set_source_rgba (cr, (i % 5) / 4., (i % 7) / 6., (i % 3) / 2., .6);
+    if (i % 4 == 0) {
+	cairo_arc (cr, x, y, w / 2, 0, 2 * M_PI);
+	cairo_fill (cr);
+    } else if (i % 4 == 1) {
+	cairo_move_to (cr, x, y);
+	cairo_line_to (cr, x + w, y + h);
+	cairo_set_line_width (cr, 3);
+	cairo_stroke (cr);
+    } else {
+	cairo_rectangle (cr, x, y, w, h);
+	cairo_fill (cr);
+    }
+}
+
+static cairo_test_status_t
+compare_tiles (cairo_test_context_t *ctx,
+	       cairo_surface_t *recording,
+	       int num_shapes)
+{
+    cairo_surface_t *replay, *direct;
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    int x, y, i;
+
+    replay = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, TILE, TILE);
+    direct = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, TILE, TILE);
+
+    /* Offset the tiles so that they do not line up with the shapes */
+    for (y = -TILE / 3; ret == CAIRO_TEST_SUCCESS && y < SIZE; y += TILE) {
+	for (x = -TILE / 5; ret == CAIRO_TEST_SUCCESS && x < SIZE; x += TILE) {
+	    cairo_t *cr;
+	    int row;
+
+	    cr = cairo_create (replay);
+	    cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+	    cairo_set_source_surface (cr, recording, -x, -y);
+	    cairo_paint (cr);
+	    cairo_destroy (cr);
+
+	    cr = cairo_create (direct);
+	    cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
+	    cairo_paint (cr);
+	    cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
+	    cairo_translate (cr, -x, -y);
+	    for (i = 0; i < num_shapes; i++)
+		draw_shape (cr, i);
+	    cairo_destroy (cr);
+
+	    cairo_surface_flush (replay);
+	    cairo_surface_flush (direct);
+	    for (row = 0; row < TILE; row++) {
+		if (memcmp (cairo_image_surface_get_data (replay) +
+			    row * cairo_image_surface_get_stride (replay),
+			    cairo_image_surface_get_data (direct) +
+			    row * cairo_image_surface_get_stride (direct),
+			    4 * TILE))
+		{
+		    cairo_test_log (ctx,
+				    "Error: tile at (%d, %d) of %d shapes differs in row %d\n",
+				    x, y, num_shapes, row);
+		    ret = CAIRO_TEST_FAILURE;
+		    break;
+		}
+	    }
+	}
+    }
+
+    cairo_surface_destroy (direct);
+    cairo_surface_destroy (replay);
+
+    return ret;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    /* Build the index, append a tail shorter than the rebuild
+     * threshold, then append enough to force a rebuild. */
+    static const int counts[] = { 400, 440, 900 };
+    cairo_surface_t *recording;
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    cairo_t *cr;
+    unsigned int n;
+    int i = 0;
+
+    recording = cairo_recording_surface_create (CAIRO_CONTENT_COLOR_ALPHA, NULL);
+    cr = cairo_create (recording);
+
+    for (n = 0; ret == CAIRO_TEST_SUCCESS && n < ARRAY_LENGTH (counts); n++) {
+	for (; i < counts[n]; i++)
+	    draw_shape (cr, i);
+
+	ret = compare_tiles (ctx, recording, counts[n]);
+    }
+
+    cairo_destroy (cr);
+    cairo_surface_destroy (recording);
+
+    return ret;
+}
+
+CAIRO_TEST (recording_surface_index,
+	    "Check that replaying a recording into small tiles replays every visible command in order",
+	    "recording", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
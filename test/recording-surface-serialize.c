@@ -0,0 +1,417 @@
+/*
+ * Copyright © 2026 the cairo authors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#define _ISOC99_SOURCE	/* for INFINITY and NAN */
+
+#include "cairo-test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(INFINITY)
+#define INFINITY HUGE_VAL
+#endif
+
+#if !defined(NAN)
+#define NAN (INFINITY - INFINITY)
+#endif
+
+/* Check that a recording surface written with
+ * cairo_recording_surface_write_to_stream() or _to_file() replays
+ * identically once loaded back, both when drawn directly and when the
+ * loaded surface is drawn onto further, and that invalid stroke
+ * parameters and excessively nested recordings are rejected.
+ */
+
+#define BASENAME "recording-surface-serialize.out"
+#define SIZE 64
+#define DEPTH 100
+
+typedef struct _buffer {
+    unsigned char *data;
+    unsigned int length;
+} buffer_t;
+
+static cairo_status_t
+write_buffer (void *closure, const unsigned char *data, unsigned int length)
+{
+    buffer_t *buf = closure;
+    unsigned char *grown;
+
+    grown = realloc (buf->data, buf->length + length);
+    if (grown == NULL)
+	return CAIRO_STATUS_NO_MEMORY;
+
+    memcpy (grown + buf->length, data, length);
+    buf->data = grown;
+    buf->length += length;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_surface_t *
+create_image (void)
+{
+    cairo_surface_t *image;
+    cairo_t *cr;
+
+    image = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, 8, 8);
+    cr = cairo_create (image);
+    cairo_set_source_rgba (cr, 0, 0, 1, .5);
+    cairo_paint (cr);
+    cairo_set_source_rgb (cr, 1, 1, 0);
+    cairo_rectangle (cr, 0, 0, 4, 4);
+    cairo_rectangle (cr, 4, 4, 4, 4);
+    cairo_fill (cr);
+    cairo_destroy (cr);
+
+    return image;
+}
+
+static cairo_surface_t *
+create_recording (void)
+{
+    cairo_surface_t *recording, *nested, *image;
+    cairo_pattern_t *gradient;
+    cairo_rectangle_t extents = { 0, 0, SIZE, SIZE };
+    double dash[] = { 4, 2 };
+    cairo_t *cr;
+
+    nested = cairo_recording_surface_create (CAIRO_CONTENT_COLOR_ALPHA, NULL);
+    cr = cairo_create (nested);
+    cairo_set_source_rgb (cr, 1, 0, 1);
+    cairo_arc (cr, 8, 8, 6, 0, 2 * M_PI);
+    cairo_fill (cr);
+    cairo_destroy (cr);
+
+    recording = cairo_recording_surface_create (CAIRO_CONTENT_COLOR_ALPHA, &extents);
+    cr = cairo_create (recording);
+
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+
+    gradient = cairo_pattern_create_linear (0, 0, SIZE, 0);
+    cairo_pattern_add_color_stop_rgb (gradient, 0, 1, 0, 0);
+    cairo_pattern_add_color_stop_rgb (gradient, .5, 0, 1, 0);
+    cairo_pattern_add_color_stop_rgba (gradient, 1, 0, 0, 1, .5);
+    cairo_set_source (cr, gradient);
+    cairo_pattern_destroy (gradient);
+    cairo_rectangle (cr, 0, 0, SIZE, SIZE / 4);
+    cairo_fill (cr);
+
+    image = create_image ();
+    cairo_save (cr);
+    cairo_translate (cr, 4, 20);
+    cairo_scale (cr, 2, 2);
+    cairo_set_source_surface (cr, image, 0, 0);
+    cairo_paint (cr);
+    cairo_restore (cr);
+    cairo_surface_destroy (image);
+
+    cairo_save (cr);
+    cairo_arc (cr, 44, 36, 14, 0, 2 * M_PI);
+    cairo_clip (cr);
+    cairo_set_source_surface (cr, nested, 32, 24);
+    cairo_paint (cr);
+    cairo_set_source_rgba (cr, 0, .5, 0, .5);
+    cairo_paint_with_alpha (cr, .5);
+    cairo_restore (cr);
+    cairo_surface_destroy (nested);
+
+    cairo_set_source_rgb (cr, 0, 0, 0);
+    cairo_set_line_width (cr, 3);
+    cairo_set_line_cap (cr, CAIRO_LINE_CAP_ROUND);
+    cairo_set_dash (cr, dash, 2, 1);
+    cairo_move_to (cr, 4, 56);
+    cairo_curve_to (cr, 20, 40, 40, 70, 60, 52);
+    cairo_stroke (cr);
+
+    cairo_destroy (cr);
+    return recording;
+}
+
+static cairo_surface_t *
+render (cairo_surface_t *recording, cairo_bool_t overdraw)
+{
+    cairo_surface_t *image;
+    cairo_t *cr;
+
+    if (overdraw) {
+	/* Drawing onto a loaded surface first decodes its records */
+	cr = cairo_create (recording);
+	cairo_set_source_rgb (cr, 0, 1, 1);
+	cairo_rectangle (cr, 24, 24, 8, 8);
+	cairo_fill (cr);
+	cairo_destroy (cr);
+    }
+
+    image = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, SIZE, SIZE);
+    cr = cairo_create (image);
+    cairo_set_source_surface (cr, recording, 0, 0);
+    cairo_paint (cr);
+    cairo_destroy (cr);
+
+    return image;
+}
+
+static cairo_bool_t
+compare (cairo_test_context_t *ctx,
+	 cairo_surface_t *original,
+	 cairo_surface_t *loaded,
+	 cairo_bool_t overdraw,
+	 const char *what)
+{
+    cairo_surface_t *a, *b;
+    const unsigned char *pa, *pb;
+    int y, stride;
+    cairo_bool_t ok = TRUE;
+
+    if (cairo_surface_status (loaded)) {
+	cairo_test_log (ctx, "Error: loading the %s failed: %s\n", what,
+			cairo_status_to_string (cairo_surface_status (loaded)));
+	return FALSE;
+    }
+
+    a = render (original, overdraw);
+    b = render (loaded, overdraw);
+
+    cairo_surface_flush (a);
+    cairo_surface_flush (b);
+    pa = cairo_image_surface_get_data (a);
+    pb = cairo_image_surface_get_data (b);
+    stride = cairo_image_surface_get_stride (a);
+    for (y = 0; y < SIZE && ok; y++) {
+	if (memcmp (pa + y * stride, pb + y * stride, 4 * SIZE)) {
+	    cairo_test_log (ctx, "Error: row %d of the %s differs\n", y, what);
+	    ok = FALSE;
+	}
+    }
+
+    cairo_surface_destroy (a);
+    cairo_surface_destroy (b);
+    return ok;
+}
+
+/* Replays @data once any corruption has been applied, and reports
+ * whether that failed */
+static cairo_bool_t
+is_rejected (const unsigned char *data, unsigned int length)
+{
+    cairo_surface_t *loaded, *image;
+    cairo_status_t status;
+    cairo_t *cr;
+
+    loaded = cairo_recording_surface_create_for_data (data, length);
+    image = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, SIZE, SIZE);
+    cr = cairo_create (image);
+    cairo_set_source_surface (cr, loaded, 0, 0);
+    cairo_paint (cr);
+    status = cairo_status (cr);
+    if (status == CAIRO_STATUS_SUCCESS)
+	status = cairo_surface_status (loaded);
+    cairo_destroy (cr);
+    cairo_surface_destroy (image);
+    cairo_surface_destroy (loaded);
+
+    return status != CAIRO_STATUS_SUCCESS;
+}
+
+/* Returns the offset of the doubles @values within @buf, or -1 */
+static long
+find_doubles (const buffer_t *buf, const double *values, int n)
+{
+    unsigned int offset;
+
+    for (offset = 0; offset + n * sizeof (double) <= buf->length; offset += 8) {
+	if (memcmp (buf->data + offset, values, n * sizeof (double)) == 0)
+	    return offset;
+    }
+
+    return -1;
+}
+
+static cairo_bool_t
+check_stroke_rejected (cairo_test_context_t *ctx, const buffer_t *buf)
+{
+    /* The tolerance, line width, miter limit and dash offset of the
+     * stroke, which follow its matrix and its inverse */
+    static const double style[] = { .1, 3, 10, 1 };
+    static const double dashes[] = { 4, 2 };
+    const struct {
+	const char *what;
+	int field; /* relative to the tolerance, in doubles */
+	double value;
+    } corruptions[] = {
+	{ "a NaN line width", 1, NAN },
+	{ "a negative line width", 1, -3 },
+	{ "a zero tolerance", 0, 0 },
+	{ "an infinite tolerance", 0, INFINITY },
+	{ "a zero miter limit", 2, 0 },
+	{ "an infinite dash offset", 3, INFINITY },
+	{ "an inverse that does not match the matrix", -6, 5 },
+	{ "a negative dash", 6, -4 },
+	{ "a NaN dash", 6, NAN },
+    };
+    unsigned char *data;
+    cairo_bool_t ok = TRUE;
+    long offset;
+    unsigned int i;
+
+    offset = find_doubles (buf, style, ARRAY_LENGTH (style));
+    if (offset < 0 || find_doubles (buf, dashes, 2) != offset + 48) {
+	cairo_test_log (ctx, "Error: the stroke was not found in the data\n");
+	return FALSE;
+    }
+
+    data = malloc (buf->length);
+    for (i = 0; i < ARRAY_LENGTH (corruptions); i++) {
+	double value = corruptions[i].value;
+
+	memcpy (data, buf->data, buf->length);
+	memcpy (data + offset + 8 * corruptions[i].field, &value, sizeof (value));
+	if (! is_rejected (data, buf->length)) {
+	    cairo_test_log (ctx, "Error: a stroke with %s was not rejected\n",
+			    corruptions[i].what);
+	    ok = FALSE;
+	}
+    }
+
+    /* All of the dashes being zero */
+    memcpy (data, buf->data, buf->length);
+    memset (data + offset + 48, 0, sizeof (dashes));
+    if (! is_rejected (data, buf->length)) {
+	cairo_test_log (ctx, "Error: a stroke with zero dashes was not rejected\n");
+	ok = FALSE;
+    }
+
+    free (data);
+    return ok;
+}
+
+static cairo_bool_t
+check_nesting_rejected (cairo_test_context_t *ctx)
+{
+    cairo_rectangle_t extents = { 0, 0, 4, 4 };
+    cairo_surface_t *recording, *nested;
+    buffer_t buf = { NULL, 0 };
+    cairo_bool_t ok = TRUE;
+    cairo_t *cr;
+    int i;
+
+    recording = cairo_recording_surface_create (CAIRO_CONTENT_COLOR_ALPHA, &extents);
+    cr = cairo_create (recording);
+    cairo_set_source_rgb (cr, 1, 0, 0);
+    cairo_paint (cr);
+    cairo_destroy (cr);
+
+    for (i = 0; i < DEPTH; i++) {
+	nested = recording;
+	recording = cairo_recording_surface_create (CAIRO_CONTENT_COLOR_ALPHA, &extents);
+	cr = cairo_create (recording);
+	cairo_set_source_surface (cr, nested, 0, 0);
+	cairo_paint (cr);
+	cairo_destroy (cr);
+	cairo_surface_destroy (nested);
+    }
+
+    if (cairo_recording_surface_write_to_stream (recording, write_buffer, &buf) ||
+	! is_rejected (buf.data, buf.length))
+    {
+	cairo_test_log (ctx, "Error: %d nested recordings were not rejected\n", DEPTH);
+	ok = FALSE;
+    }
+
+    free (buf.data);
+    cairo_surface_destroy (recording);
+    return ok;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_surface_t *original, *loaded;
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    cairo_status_t status;
+    buffer_t buf = { NULL, 0 };
+    char *filename;
+    const char *path = cairo_test_mkdir (CAIRO_TEST_OUTPUT_DIR) ? CAIRO_TEST_OUTPUT_DIR : ".";
+
+    original = create_recording ();
+
+    status = cairo_recording_surface_write_to_stream (original, write_buffer, &buf);
+    if (status) {
+	cairo_test_log (ctx, "Error: writing to a stream failed: %s\n",
+			cairo_status_to_string (status));
+	ret = CAIRO_TEST_FAILURE;
+	goto BAIL;
+    }
+
+    loaded = cairo_recording_surface_create_for_data (buf.data, buf.length);
+    if (! compare (ctx, original, loaded, FALSE, "stream"))
+	ret = CAIRO_TEST_FAILURE;
+    cairo_surface_destroy (loaded);
+
+    /* Truncated data must be rejected rather than replayed */
+    loaded = cairo_recording_surface_create_for_data (buf.data, buf.length / 2);
+    if (cairo_surface_status (loaded) != CAIRO_STATUS_READ_ERROR) {
+	cairo_test_log (ctx, "Error: truncated data was not rejected\n");
+	ret = CAIRO_TEST_FAILURE;
+    }
+    cairo_surface_destroy (loaded);
+
+    if (! check_stroke_rejected (ctx, &buf))
+	ret = CAIRO_TEST_FAILURE;
+
+    if (! check_nesting_rejected (ctx))
+	ret = CAIRO_TEST_FAILURE;
+
+    xasprintf (&filename, "%s/%s.rec", path, BASENAME);
+    status = cairo_recording_surface_write_to_file (original, filename);
+    if (status) {
+	cairo_test_log (ctx, "Error: writing %s failed: %s\n", filename,
+			cairo_status_to_string (status));
+	ret = CAIRO_TEST_FAILURE;
+    } else {
+	loaded = cairo_recording_surface_create_from_file (filename);
+	if (! compare (ctx, original, loaded, FALSE, "file"))
+	    ret = CAIRO_TEST_FAILURE;
+	cairo_surface_destroy (loaded);
+
+	loaded = cairo_recording_surface_create_from_file (filename);
+	if (! compare (ctx, original, loaded, TRUE, "modified file"))
+	    ret = CAIRO_TEST_FAILURE;
+	cairo_surface_destroy (loaded);
+    }
+    free (filename);
+
+BAIL:
+    free (buf.data);
+    cairo_surface_destroy (original);
+    return ret;
+}
+
+CAIRO_TEST (recording_surface_serialize,
+	    "Check that recording surfaces replay the same once serialized",
+	    "recording", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
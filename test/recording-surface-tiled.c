@@ -0,0 +1,200 @@
+/*
+ * Copyright © 2026 the cairo authors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "cairo-test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* With CAIRO_RENDER_THREADS set, a recording replayed onto an image is
+ * split into tiles rendered concurrently.  Check that the result is
+ * bit-identical to drawing the same operations serially, both for
+ * sources that allow tiling and for transformed gradients and meshes,
+ * which must not be tiled.
+ */
+
+#define SIZE 400
+
+static void
+set_source (cairo_t *cr, int i, cairo_bool_t transformed)
+{
+    cairo_pattern_t *pattern;
+    cairo_matrix_t matrix;
+
+    switch (i % 3) {
+    case 0:
+	cairo_set_source_rgba (cr, (i % 5) / 4., .5, 1 - (i % 7) / 6., .7);
+	return;
+
+    case 1:
+	pattern = cairo_pattern_create_linear (0, 0, SIZE, SIZE / 3.);
+	cairo_pattern_add_color_stop_rgba (pattern, 0, 1, 0, 0, .9);
+	cairo_pattern_add_color_stop_rgba (pattern, 1, 0, 0, 1, .5);
+	break;
+
+    default:
+	if (transformed) {
+	    pattern = cairo_pattern_create_mesh ();
+	    cairo_mesh_pattern_begin_patch (pattern);
+	    cairo_mesh_pattern_move_to (pattern, 0, 0);
+	    cairo_mesh_pattern_line_to (pattern, SIZE, 0);
+	    cairo_mesh_pattern_line_to (pattern, SIZE, SIZE);
+	    cairo_mesh_pattern_line_to (pattern, 0, SIZE);
+	    cairo_mesh_pattern_set_corner_color_rgb (pattern, 0, 1, 0, 0);
+	    cairo_mesh_pattern_set_corner_color_rgb (pattern, 1, 0, 1, 0);
+	    cairo_mesh_pattern_set_corner_color_rgb (pattern, 2, 0, 0, 1);
+	    cairo_mesh_pattern_set_corner_color_rgb (pattern, 3, 1, 1, 0);
+	    cairo_mesh_pattern_end_patch (pattern);
+	    cairo_set_source (cr, pattern);
+	    cairo_pattern_destroy (pattern);
+	    return;
+	}
+
+	pattern = cairo_pattern_create_radial (SIZE / 2., SIZE / 3., 5,
+					       SIZE / 2., SIZE / 2., SIZE / 2.);
+	cairo_pattern_add_color_stop_rgb (pattern, 0, 1, 1, 0);
+	cairo_pattern_add_color_stop_rgb (pattern, 1, 0, .5, .5);
+	break;
+    }
+
+    if (transformed) {
+	cairo_matrix_init_rotate (&matrix, .3);
+	cairo_matrix_scale (&matrix, 1.7, .6);
+	cairo_pattern_set_matrix (pattern, &matrix);
+    }
+
+    cairo_set_source (cr, pattern);
+    cairo_pattern_destroy (pattern);
+}
+
+static void
+draw_operations (cairo_t *cr, cairo_bool_t transformed)
+{
+    int i;
+
+    for (i = 0; i < 24; i++) {
+	set_source (cr, i, transformed);
+
+	cairo_move_to (cr, (i * 37) % SIZE + .3, 3.7);
+	cairo_line_to (cr, SIZE - (i * 53) % SIZE + .6, SIZE - 2.2);
+	cairo_line_to (cr, (i * 71) % SIZE + .5, SIZE / 2. + i);
+	cairo_close_path (cr);
+	if (i & 1) {
+	    cairo_set_line_width (cr, 1 + i / 3.);
+	    cairo_stroke (cr);
+	} else {
+	    cairo_fill (cr);
+	}
+    }
+}
+
+static cairo_surface_t *
+draw (cairo_bool_t transformed, cairo_bool_t recorded)
+{
+    cairo_surface_t *image, *recording;
+    cairo_rectangle_t extents = { 0, 0, SIZE, SIZE };
+    cairo_t *cr;
+
+    image = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, SIZE, SIZE);
+
+    if (recorded) {
+	recording = cairo_recording_surface_create (CAIRO_CONTENT_COLOR_ALPHA,
+						    &extents);
+	cr = cairo_create (recording);
+	draw_operations (cr, transformed);
+	cairo_destroy (cr);
+
+	/* the replay into the source image is what gets tiled */
+	cr = cairo_create (image);
+	cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+	cairo_set_source_surface (cr, recording, 0, 0);
+	cairo_paint (cr);
+	cairo_surface_destroy (recording);
+    } else {
+	cr = cairo_create (image);
+	draw_operations (cr, transformed);
+    }
+
+    cairo_destroy (cr);
+    return image;
+}
+
+static cairo_bool_t
+compare (cairo_test_context_t *ctx,
+	 cairo_surface_t *a,
+	 cairo_surface_t *b,
+	 cairo_bool_t transformed)
+{
+    const uint8_t *pa, *pb;
+    int stride, y;
+
+    cairo_surface_flush (a);
+    cairo_surface_flush (b);
+    pa = cairo_image_surface_get_data (a);
+    pb = cairo_image_surface_get_data (b);
+    stride = cairo_image_surface_get_stride (a);
+    for (y = 0; y < SIZE; y++) {
+	if (memcmp (pa + y * stride, pb + y * stride, 4 * SIZE)) {
+	    cairo_test_log (ctx,
+			    "Error: row %d of the replay differs from the serial drawing (%s sources)\n",
+			    y, transformed ? "transformed" : "untransformed");
+	    return FALSE;
+	}
+    }
+
+    return TRUE;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    unsigned int transformed;
+
+#ifndef _WIN32
+    /* the pool is sized on first use; keep any setting of the user */
+    setenv ("CAIRO_RENDER_THREADS", "4", 0);
+#endif
+
+    for (transformed = 0; transformed <= 1; transformed++) {
+	cairo_surface_t *serial, *replayed;
+
+	serial = draw (transformed, FALSE);
+	replayed = draw (transformed, TRUE);
+
+	if (! compare (ctx, serial, replayed, transformed))
+	    ret = CAIRO_TEST_FAILURE;
+
+	cairo_surface_destroy (serial);
+	cairo_surface_destroy (replayed);
+    }
+
+    return ret;
+}
+
+CAIRO_TEST (recording_surface_tiled,
+	    "Check that recordings replayed in tiles match serial drawing",
+	    "recording, thread", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
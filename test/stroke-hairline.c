@@ -0,0 +1,267 @@
+/*
+ * Copyright © 2026 the cairo authors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "cairo-test.h"
+#include "coverage-check.h"
+
+/* Strokes no wider than a pixel, drawn with CAIRO_ANTIALIAS_FAST, are
+ * swept straight into coverage by the hairline stroker.  Check the
+ * coverage of polylines with each kind of join and cap, closed paths,
+ * paths that cross themselves and paths that turn straight back,
+ * against a fine supersampling of the stroke.
+ *
+ * Paths that cross themselves and caps that fold back over the
+ * stroke are left to the polygon stroker, which would fill them on
+ * tor22's coarse grid, so the paths that do so are drawn with
+ * CAIRO_ANTIALIAS_BEST instead and held to the exact coverage.
+ */
+
+#define SIZE 24
+#define SAMPLES 64
+#define TOLERANCE 3
+
+#define MAX_POINTS 8
+
+struct polyline {
+    const char *name;
+    double line_width;
+    cairo_line_join_t join;
+    cairo_line_cap_t cap;
+    cairo_bool_t closed;
+    cairo_antialias_t antialias;
+    int num_points;
+    double points[MAX_POINTS][2];
+};
+
+static const struct polyline polylines[] = {
+    { "shallow", 1., CAIRO_LINE_JOIN_ROUND, CAIRO_LINE_CAP_BUTT, FALSE,
+      CAIRO_ANTIALIAS_FAST, 6,
+      { { 1.5, 12.2 }, { 5.3, 10.9 }, { 9.8, 13.6 }, { 14.1, 11.4 },
+	{ 18.7, 12.1 }, { 22.6, 9.3 } } },
+    { "series", .5, CAIRO_LINE_JOIN_ROUND, CAIRO_LINE_CAP_BUTT, FALSE,
+      CAIRO_ANTIALIAS_FAST, 8,
+      { { 1.2, 20.3 }, { 4.1, 3.7 }, { 6.9, 15.2 }, { 9.6, 6.4 },
+	{ 12.8, 21.1 }, { 15.3, 2.6 }, { 18.9, 12.8 }, { 22.4, 8.1 } } },
+    { "steep", .8, CAIRO_LINE_JOIN_ROUND, CAIRO_LINE_CAP_BUTT, FALSE,
+      CAIRO_ANTIALIAS_FAST, 4,
+      { { 3.4, 1.6 }, { 6.1, 22.3 }, { 17.2, 20.5 }, { 20.7, 2.2 } } },
+    /* the tips of the miters reach a couple of pixels beyond the path */
+    { "miter", 1., CAIRO_LINE_JOIN_MITER, CAIRO_LINE_CAP_BUTT, FALSE,
+      CAIRO_ANTIALIAS_FAST, 5,
+      { { 2.3, 20.6 }, { 6.2, 3.4 }, { 10.1, 20.2 }, { 14.4, 3.7 },
+	{ 18.6, 20.4 } } },
+    { "bevel", 1., CAIRO_LINE_JOIN_BEVEL, CAIRO_LINE_CAP_BUTT, FALSE,
+      CAIRO_ANTIALIAS_FAST, 5,
+      { { 2.3, 20.6 }, { 6.2, 3.4 }, { 10.1, 20.2 }, { 14.4, 3.7 },
+	{ 18.6, 20.4 } } },
+    { "square caps", .9, CAIRO_LINE_JOIN_BEVEL, CAIRO_LINE_CAP_SQUARE, FALSE,
+      CAIRO_ANTIALIAS_FAST, 3,
+      { { 3.6, 4.2 }, { 19.7, 9.1 }, { 6.3, 19.8 } } },
+    { "closed", 1., CAIRO_LINE_JOIN_MITER, CAIRO_LINE_CAP_BUTT, TRUE,
+      CAIRO_ANTIALIAS_FAST, 4,
+      { { 4.3, 5.1 }, { 19.2, 3.8 }, { 17.6, 19.3 }, { 5.7, 16.2 } } },
+    { "crossing", 1., CAIRO_LINE_JOIN_BEVEL, CAIRO_LINE_CAP_SQUARE, FALSE,
+      CAIRO_ANTIALIAS_BEST, 4,
+      { { 3.2, 3.6 }, { 20.4, 20.7 }, { 20.6, 3.3 }, { 3.5, 20.2 } } },
+    { "reversal", .8, CAIRO_LINE_JOIN_ROUND, CAIRO_LINE_CAP_BUTT, FALSE,
+      CAIRO_ANTIALIAS_FAST, 3,
+      { { 4, 6 }, { 20, 14 }, { 8, 8 } } },
+    { "reversal", 1., CAIRO_LINE_JOIN_MITER, CAIRO_LINE_CAP_SQUARE, FALSE,
+      CAIRO_ANTIALIAS_BEST, 3,
+      { { 3.3, 18.7 }, { 19.5, 5.2 }, { 8.7, 14.2 } } },
+};
+
+static double
+cross (double ax, double ay, double bx, double by)
+{
+    return ax * by - ay * bx;
+}
+
+/* Whether (x, y) lies within the convex polygon @pts */
+static cairo_bool_t
+inside_convex (const double pts[][2], int n, double x, double y)
+{
+    int i, sign = 0;
+
+    for (i = 0; i < n; i++) {
+	const double *p = pts[i], *q = pts[(i + 1) % n];
+	double c = cross (q[0] - p[0], q[1] - p[1], x - p[0], y - p[1]);
+
+	if (c == 0)
+	    continue;
+	if (sign == 0)
+	    sign = c > 0 ? 1 : -1;
+	else if ((c > 0) != (sign > 0))
+	    return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* Whether (x, y) lies within the join at @v of the segments from @u
+ * to @v and from @v to @w */
+static cairo_bool_t
+inside_join (const struct polyline *l,
+	     const double *u, const double *v, const double *w,
+	     double x, double y)
+{
+    double r = l->line_width / 2;
+    double dx1 = v[0] - u[0], dy1 = v[1] - u[1];
+    double dx2 = w[0] - v[0], dy2 = w[1] - v[1];
+    double len1 = sqrt (dx1 * dx1 + dy1 * dy1);
+    double len2 = sqrt (dx2 * dx2 + dy2 * dy2);
+    double nx1, ny1, nx2, ny2, pts[4][2];
+    int n;
+
+    if (l->join == CAIRO_LINE_JOIN_ROUND)
+	return (x - v[0]) * (x - v[0]) + (y - v[1]) * (y - v[1]) <= r * r;
+
+    dx1 /= len1; dy1 /= len1;
+    dx2 /= len2; dy2 /= len2;
+
+    /* the normals on the outside of the turn */
+    nx1 = -dy1; ny1 = dx1;
+    if (nx1 * dx2 + ny1 * dy2 > 0) {
+	nx1 = -nx1;
+	ny1 = -ny1;
+    }
+    nx2 = -dy2; ny2 = dx2;
+    if (nx2 * dx1 + ny2 * dy1 < 0) {
+	nx2 = -nx2;
+	ny2 = -ny2;
+    }
+
+    n = 0;
+    pts[n][0] = v[0];
+    pts[n][1] = v[1];
+    n++;
+    pts[n][0] = v[0] + r * nx1;
+    pts[n][1] = v[1] + r * ny1;
+    n++;
+    /* the miter limit is 10, the default */
+    if (l->join == CAIRO_LINE_JOIN_MITER &&
+	2 <= 100 * (1 + dx1 * dx2 + dy1 * dy2))
+    {
+	double k = r / (1 + nx1 * nx2 + ny1 * ny2);
+
+	pts[n][0] = v[0] + k * (nx1 + nx2);
+	pts[n][1] = v[1] + k * (ny1 + ny2);
+	n++;
+    }
+    pts[n][0] = v[0] + r * nx2;
+    pts[n][1] = v[1] + r * ny2;
+    n++;
+
+    return inside_convex (pts, n, x, y);
+}
+
+/* The rectangle of each segment, lengthened at the ends of an open
+ * path by square caps, and the joins between them */
+static cairo_bool_t
+inside (const void *closure, double x, double y)
+{
+    const struct polyline *l = closure;
+    double r = l->line_width / 2;
+    int n = l->num_points;
+    int i, num_segments = l->closed ? n : n - 1;
+
+    for (i = 0; i < num_segments; i++) {
+	const double *p = l->points[i], *q = l->points[(i + 1) % n];
+	double dx = q[0] - p[0], dy = q[1] - p[1];
+	double len = sqrt (dx * dx + dy * dy);
+	double t = ((x - p[0]) * dx + (y - p[1]) * dy) / len;
+	double d = cross (dx, dy, x - p[0], y - p[1]) / len;
+	double t0 = 0, t1 = len;
+
+	if (l->cap == CAIRO_LINE_CAP_SQUARE && ! l->closed) {
+	    if (i == 0)
+		t0 = -r;
+	    if (i == num_segments - 1)
+		t1 = len + r;
+	}
+	if (t >= t0 && t <= t1 && fabs (d) <= r)
+	    return TRUE;
+    }
+
+    for (i = l->closed ? 0 : 1; i < (l->closed ? n : n - 1); i++) {
+	if (inside_join (l,
+			 l->points[(i + n - 1) % n],
+			 l->points[i],
+			 l->points[(i + 1) % n],
+			 x, y))
+	{
+	    return TRUE;
+	}
+    }
+
+    return FALSE;
+}
+
+static cairo_test_status_t
+check_polyline (cairo_test_context_t *ctx, const struct polyline *l)
+{
+    cairo_test_status_t ret;
+    cairo_surface_t *surface;
+    cairo_t *cr;
+    int i;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_A8, SIZE, SIZE);
+    cr = cairo_create (surface);
+    cairo_set_antialias (cr, l->antialias);
+    cairo_set_line_width (cr, l->line_width);
+    cairo_set_line_join (cr, l->join);
+    cairo_set_line_cap (cr, l->cap);
+    for (i = 0; i < l->num_points; i++)
+	cairo_line_to (cr, l->points[i][0], l->points[i][1]);
+    if (l->closed)
+	cairo_close_path (cr);
+    cairo_stroke (cr);
+    cairo_destroy (cr);
+
+    ret = coverage_check (ctx, l->name, surface, inside, l,
+			  SAMPLES, TOLERANCE);
+
+    cairo_surface_destroy (surface);
+    return ret;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    int i;
+
+    for (i = 0; i < ARRAY_LENGTH (polylines); i++) {
+	if (check_polyline (ctx, &polylines[i]))
+	    ret = CAIRO_TEST_FAILURE;
+    }
+
+    return ret;
+}
+
+CAIRO_TEST (stroke_hairline,
+	    "Check the coverage of strokes no wider than a pixel",
+	    "stroke", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)